@@ -6,6 +6,10 @@
 using namespace std;
 using namespace neueda;
 
+#ifdef GWC_STATIC_CONNECTORS
+GWC_REGISTER_CONNECTOR (millennium);
+#endif
+
 class sessionCallbacks : public gwcSessionCallbacks
 {
 public:
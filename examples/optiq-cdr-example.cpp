@@ -7,6 +7,10 @@
 using namespace std;
 using namespace neueda;
 
+#ifdef GWC_STATIC_CONNECTORS
+GWC_REGISTER_CONNECTOR (optiq);
+#endif
+
 static int64_t gOrderId;
 
 class sessionCallbacks : public gwcSessionCallbacks
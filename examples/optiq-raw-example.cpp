@@ -9,6 +9,10 @@
 using namespace std;
 using namespace neueda;
 
+#ifdef GWC_STATIC_CONNECTORS
+GWC_REGISTER_CONNECTOR (optiq);
+#endif
+
 class sessionCallbacks : public gwcSessionCallbacks
 {
 public:
@@ -7,6 +7,10 @@
 using namespace std;
 using namespace neueda;
 
+#ifdef GWC_STATIC_CONNECTORS
+GWC_REGISTER_CONNECTOR (swx);
+#endif
+
 class sessionCallbacks : public gwcSessionCallbacks
 {
 public:
@@ -0,0 +1,474 @@
+/** Order round trip benchmark against the loopback simulators **/
+
+#include "gwcConnector.h"
+#include "gwcLatency.h"
+#include "utils.h"
+
+#include "gwcSimVenue.h"
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace neueda;
+
+#ifdef GWC_STATIC_CONNECTORS
+GWC_REGISTER_CONNECTOR (millennium);
+GWC_REGISTER_CONNECTOR (fix);
+GWC_REGISTER_CONNECTOR (eti);
+GWC_REGISTER_CONNECTOR (optiq);
+GWC_REGISTER_CONNECTOR (swx);
+#endif
+
+/* Run parameters */
+struct benchConfig
+{
+    string   mVenue;
+    uint64_t mOrders;
+    uint64_t mWarmup;
+    uint64_t mRate;        /* orders per second, 0 as fast as possible */
+    double   mCancelRatio; /* share of acked orders that are cancelled */
+    uint64_t mCallbackNs;  /* busy time added to each callback */
+    int64_t  mTimeout;     /* seconds to wait for responses */
+    string   mOutput;
+};
+
+class benchSession : public gwcSessionCallbacks
+{
+public:
+    benchSession (gwcSimVenue* venue) :
+        mVenue (venue),
+        mLoggedOn (0),
+        mError (0)
+    {
+    }
+
+    void onLoggingOn (cdr& msg)
+    {
+        mVenue->onLoggingOn (msg);
+    }
+
+    bool onError (const string& err)
+    {
+        __sync_fetch_and_add (&mError, 1);
+        return false;
+    }
+
+    void onLoggedOn (uint64_t seqno, const cdr& msg)
+    {
+        __sync_lock_test_and_set (&mLoggedOn, 1);
+    }
+
+    void onLoggedOff (uint64_t seqno, const cdr& msg)
+    {
+        __sync_lock_test_and_set (&mLoggedOn, 0);
+    }
+
+    gwcSimVenue* mVenue;
+    volatile int mLoggedOn;
+    volatile int mError;
+};
+
+/* Orders use ids 1..N and their cancels N+1..2N so either id maps back to
+   the order index without a lookup */
+class benchMessages : public gwcMessageCallbacks
+{
+public:
+    benchMessages (gwcSimVenue* venue, const benchConfig& config) :
+        mVenue (venue),
+        mConfig (config),
+        mGwc (NULL),
+        mOrderSent (config.mOrders + 1, 0),
+        mCancelSent (config.mOrders + 1, 0),
+        mAcks (0),
+        mDones (0),
+        mCancels (0),
+        mReceived (0),
+        mRejects (0)
+    {
+    }
+
+    /* True if order i is cancelled once acked, spread evenly */
+    bool cancelled (uint64_t i) const
+    {
+        uint64_t scaled = (uint64_t)(mConfig.mCancelRatio * 1000);
+        return (i * scaled) / 1000 != ((i - 1) * scaled) / 1000;
+    }
+
+    void sendOrder (uint64_t i)
+    {
+        gwcOrder order;
+        order.setPrice (1234);
+        order.setQty (100);
+        order.setTif (GWC_TIF_DAY);
+        order.setSide (GWC_SIDE_BUY);
+        order.setOrderType (GWC_ORDER_TYPE_LIMIT);
+        mVenue->order (order, i);
+
+        mOrderSent[i] = gwcLatency_now ();
+        if (!mGwc->sendOrder (order))
+            __sync_fetch_and_add (&mRejects, 1);
+    }
+
+    void onOrderAck (uint64_t seqno, const cdr& msg)
+    {
+        uint64_t now = gwcLatency_now ();
+        uint64_t i = index (msg);
+
+        receive ();
+        if (i == 0)
+            return;
+        if (i > mConfig.mWarmup)
+            mOrderToAck.record (now - mOrderSent[i]);
+        __sync_fetch_and_add (&mAcks, 1);
+
+        if (!cancelled (i))
+            return;
+
+        cdr cancel;
+        mVenue->cancel (cancel, i + mConfig.mOrders, i);
+        mCancelSent[i] = gwcLatency_now ();
+        __sync_fetch_and_add (&mCancels, 1);
+        if (!mGwc->sendCancel (cancel))
+            __sync_fetch_and_add (&mRejects, 1);
+    }
+
+    void onOrderDone (uint64_t seqno, const cdr& msg)
+    {
+        done (msg);
+    }
+
+    void onMsg (uint64_t seqno, const cdr& msg)
+    {
+        if (mVenue->isCancelDone (msg))
+            done (msg);
+        else
+            receive ();
+    }
+
+    void onOrderRejected (uint64_t seqno, const cdr& msg)
+    {
+        receive ();
+        __sync_fetch_and_add (&mRejects, 1);
+    }
+
+    void onCancelRejected (uint64_t seqno, const cdr& msg)
+    {
+        receive ();
+        __sync_fetch_and_add (&mRejects, 1);
+    }
+
+    void onAdmin (uint64_t seqno, const cdr& msg)
+    {
+        receive ();
+    }
+
+    void onOrderFill (uint64_t seqno, const cdr& msg)
+    {
+        receive ();
+    }
+
+    gwcSimVenue*        mVenue;
+    const benchConfig&  mConfig;
+    gwcConnector*       mGwc;
+    vector<uint64_t>    mOrderSent;
+    vector<uint64_t>    mCancelSent;
+    gwcLatencyHistogram mOrderToAck;
+    gwcLatencyHistogram mCancelToDone;
+    volatile uint64_t   mAcks;
+    volatile uint64_t   mDones;
+    volatile uint64_t   mCancels;
+    volatile uint64_t   mReceived;
+    volatile uint64_t   mRejects;
+
+private:
+    /* Order index for an echoed order or cancel id, 0 if not ours */
+    uint64_t index (const cdr& msg) const
+    {
+        uint64_t id = mVenue->id (msg);
+        if (id > mConfig.mOrders)
+            id -= mConfig.mOrders;
+        return id > mConfig.mOrders ? 0 : id;
+    }
+
+    void done (const cdr& msg)
+    {
+        uint64_t now = gwcLatency_now ();
+        uint64_t i = index (msg);
+
+        receive ();
+        if (i == 0 || mCancelSent[i] == 0)
+            return;
+        if (i > mConfig.mWarmup)
+            mCancelToDone.record (now - mCancelSent[i]);
+        __sync_fetch_and_add (&mDones, 1);
+    }
+
+    /* Every callback pays the configured cost */
+    void receive ()
+    {
+        __sync_fetch_and_add (&mReceived, 1);
+        if (mConfig.mCallbackNs == 0)
+            return;
+
+        uint64_t until = gwcLatency_now () + mConfig.mCallbackNs;
+        while (gwcLatency_now () < until)
+            ;
+    }
+};
+
+static void
+usage ()
+{
+    fprintf (stderr,
+             "usage: fosdk-bench <venue> [key=value ...]\n"
+             "venues: lse fix xetra optiq swx\n"
+             "keys: orders (100000) warmup (1000) rate (0, unpaced)\n"
+             "      cancel_ratio (1.0) callback_ns (0) timeout (30)\n"
+             "      output (stdout) data_dictionary (fix) log_level\n"
+             "      and any connector option, e.g. dispatch_mode\n");
+    exit (1);
+}
+
+static uint64_t
+getNumber (const properties& props, const string& key, const string& dflt)
+{
+    string  v;
+    int64_t n;
+
+    props.get (key, dflt, v);
+    if (!utils_parseNumber (v, n) || n < 0)
+        errx (1, "invalid %s %s", key.c_str (), v.c_str ());
+    return (uint64_t)n;
+}
+
+static void
+writeStat (FILE* f, const char* name, const gwcLatencyHistogram& h)
+{
+    gwcLatencyStat s;
+    h.snapshot (s);
+
+    fprintf (f,
+             "  \"%s\": {\"count\": %llu, \"min\": %llu, \"mean\": %llu, "
+             "\"p50\": %llu, \"p99\": %llu, \"p999\": %llu, "
+             "\"max\": %llu},\n",
+             name,
+             (unsigned long long)s.mCount,
+             (unsigned long long)s.mMin,
+             (unsigned long long)s.mMean,
+             (unsigned long long)s.mP50,
+             (unsigned long long)s.mP99,
+             (unsigned long long)s.mP999,
+             (unsigned long long)s.mMax);
+}
+
+static void
+writeResults (FILE* f,
+              const benchConfig& config,
+              const benchMessages& msgs,
+              uint64_t sendNs,
+              uint64_t totalNs,
+              const gwcLatencyStats& stages)
+{
+    uint64_t sent = config.mOrders + msgs.mCancels;
+
+    fprintf (f, "{\n");
+    fprintf (f, "  \"venue\": \"%s\",\n", config.mVenue.c_str ());
+    fprintf (f, "  \"orders\": %llu,\n", (unsigned long long)config.mOrders);
+    fprintf (f, "  \"warmup\": %llu,\n", (unsigned long long)config.mWarmup);
+    fprintf (f, "  \"rate\": %llu,\n", (unsigned long long)config.mRate);
+    fprintf (f, "  \"cancel_ratio\": %.3f,\n", config.mCancelRatio);
+    fprintf (f,
+             "  \"callback_ns\": %llu,\n",
+             (unsigned long long)config.mCallbackNs);
+    fprintf (f, "  \"acks\": %llu,\n", (unsigned long long)msgs.mAcks);
+    fprintf (f, "  \"cancels\": %llu,\n", (unsigned long long)msgs.mCancels);
+    fprintf (f, "  \"dones\": %llu,\n", (unsigned long long)msgs.mDones);
+    fprintf (f, "  \"rejects\": %llu,\n", (unsigned long long)msgs.mRejects);
+    fprintf (f, "  \"elapsed_ns\": %llu,\n", (unsigned long long)totalNs);
+    fprintf (f,
+             "  \"orders_per_sec\": %.0f,\n",
+             sendNs ? config.mOrders * 1e9 / sendNs : 0.0);
+    fprintf (f,
+             "  \"msgs_per_sec\": %.0f,\n",
+             totalNs ? (sent + msgs.mReceived) * 1e9 / totalNs : 0.0);
+    writeStat (f, "order_to_ack_ns", msgs.mOrderToAck);
+    writeStat (f, "cancel_to_done_ns", msgs.mCancelToDone);
+
+    /* connector stages across all message types */
+    fprintf (f, "  \"stages_ns\": [");
+    bool first = true;
+    for (size_t i = 0; i < stages.size (); i++)
+    {
+        const gwcLatencyStat& s = stages[i];
+        if (!s.mMsgType.empty () || s.mCount == 0)
+            continue;
+        fprintf (f,
+                 "%s\n    {\"stage\": \"%s\", \"count\": %llu, "
+                 "\"mean\": %llu, \"p50\": %llu, \"p99\": %llu, "
+                 "\"p999\": %llu, \"max\": %llu}",
+                 first ? "" : ",",
+                 gwcLatency_stageName (s.mStage),
+                 (unsigned long long)s.mCount,
+                 (unsigned long long)s.mMean,
+                 (unsigned long long)s.mP50,
+                 (unsigned long long)s.mP99,
+                 (unsigned long long)s.mP999,
+                 (unsigned long long)s.mMax);
+        first = false;
+    }
+    fprintf (f, "\n  ]\n}\n");
+}
+
+int
+main (int argc, char** argv)
+{
+    if (argc < 2)
+        usage ();
+
+    benchConfig config;
+    config.mVenue = argv[1];
+
+    properties p;
+    properties opts (p, "bench", config.mVenue, "local");
+    properties props (p, "gwc", config.mVenue, "bench");
+    for (int i = 2; i < argc; i++)
+    {
+        string arg (argv[i]);
+        size_t eq = arg.find ('=');
+        if (eq == string::npos || eq == 0)
+            usage ();
+        opts.setProperty (arg.substr (0, eq), arg.substr (eq + 1));
+        props.setProperty (arg.substr (0, eq), arg.substr (eq + 1));
+    }
+
+    config.mOrders = getNumber (opts, "orders", "100000");
+    config.mWarmup = getNumber (opts, "warmup", "1000");
+    config.mRate = getNumber (opts, "rate", "0");
+    config.mCallbackNs = getNumber (opts, "callback_ns", "0");
+    config.mTimeout = getNumber (opts, "timeout", "30");
+    opts.get ("output", "", config.mOutput);
+
+    string v;
+    opts.get ("cancel_ratio", "1.0", v);
+    if (!utils_parseNumber (v, config.mCancelRatio) ||
+        config.mCancelRatio < 0 ||
+        config.mCancelRatio > 1)
+        errx (1, "invalid cancel_ratio %s", v.c_str ());
+    if (config.mOrders == 0 || config.mWarmup >= config.mOrders)
+        errx (1, "orders must be more than warmup");
+
+    string level;
+    opts.get ("log_level", "warn", level);
+    p.setProperty ("lh.console.level", level);
+
+    string errorMessage;
+    if (!logService::get ().configure (p, errorMessage))
+        errx (1, "failed to configure logger: %s", errorMessage.c_str ());
+    logger* log = logService::getLogger ("FOSDK_BENCH");
+
+    gwcSimVenue* venue = NULL;
+    if (config.mVenue == "lse")
+        venue = new gwcSimVenueMillennium (log);
+    else if (config.mVenue == "fix")
+        venue = new gwcSimVenueFix (log);
+    else if (config.mVenue == "xetra")
+        venue = new gwcSimVenueEti (log);
+    else if (config.mVenue == "optiq")
+        venue = new gwcSimVenueOptiq (log);
+    else if (config.mVenue == "swx")
+        venue = new gwcSimVenueSwx (log);
+    else
+        usage ();
+
+    /* round trips need the order to stay open until it's cancelled, and
+       every run starts from empty seqno caches */
+    string cache = "fosdk-bench." + config.mVenue + ".cache";
+    unlink (cache.c_str ());
+    opts.setProperty ("auto_fill", "false");
+    props.setProperty ("seqno_cache", cache);
+    props.setProperty ("applMsgId_cache", cache);
+    props.setProperty ("latency_stats", "true");
+    if (!venue->start (opts, props, errorMessage))
+        errx (1, "failed to start simulator: %s", errorMessage.c_str ());
+
+    benchSession  sessionCbs (venue);
+    benchMessages messageCbs (venue, config);
+
+    gwcConnector* gwc = gwcConnectorFactory::get (log, venue->type (), props);
+    if (gwc == NULL)
+        errx (1, "failed to get connector %s", venue->type ());
+    messageCbs.mGwc = gwc;
+
+    if (!gwc->init (&sessionCbs, &messageCbs, props))
+        errx (1, "failed to initialise connector");
+    if (!gwc->start (false))
+        errx (1, "failed to start connector");
+
+    time_t deadline = time (NULL) + config.mTimeout;
+    while (!sessionCbs.mLoggedOn && !sessionCbs.mError)
+    {
+        if (time (NULL) > deadline)
+            errx (1, "timed out waiting for logon");
+        usleep (1000);
+    }
+    if (sessionCbs.mError)
+        errx (1, "connector failed to logon");
+
+    /* open loop, order i goes at start + i / rate whatever the responses */
+    uint64_t start = gwcLatency_now ();
+    uint64_t interval = config.mRate ? 1000000000ULL / config.mRate : 0;
+    for (uint64_t i = 1; i <= config.mOrders; i++)
+    {
+        if (interval)
+        {
+            uint64_t due = start + (i - 1) * interval;
+            while (gwcLatency_now () < due)
+                ;
+        }
+        messageCbs.sendOrder (i);
+    }
+    uint64_t sent = gwcLatency_now ();
+
+    uint64_t cancels = 0;
+    for (uint64_t i = 1; i <= config.mOrders; i++)
+    {
+        if (messageCbs.cancelled (i))
+            cancels++;
+    }
+
+    deadline = time (NULL) + config.mTimeout;
+    while (messageCbs.mAcks < config.mOrders || messageCbs.mDones < cancels)
+    {
+        if (time (NULL) > deadline || sessionCbs.mError)
+        {
+            log->warn ("stopped waiting with %llu acks and %llu dones",
+                       (unsigned long long)messageCbs.mAcks,
+                       (unsigned long long)messageCbs.mDones);
+            break;
+        }
+        usleep (100);
+    }
+    uint64_t finished = gwcLatency_now ();
+
+    gwcLatencyStats stages = gwc->getLatencyStats ();
+    gwc->stop ();
+
+    FILE* f = stdout;
+    if (!config.mOutput.empty ())
+    {
+        f = fopen (config.mOutput.c_str (), "w");
+        if (f == NULL)
+            err (1, "failed to open %s", config.mOutput.c_str ());
+    }
+    writeResults (f, config, messageCbs, sent - start, finished - start, stages);
+    if (f != stdout)
+        fclose (f);
+
+    delete venue;
+    unlink (cache.c_str ());
+    return 0;
+}
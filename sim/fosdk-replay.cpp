@@ -0,0 +1,283 @@
+/** Replays a journal through a connector's read path **/
+
+#include "gwcConnector.h"
+#include "gwcReplay.h"
+#include "utils.h"
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace neueda;
+
+#ifdef GWC_STATIC_CONNECTORS
+GWC_REGISTER_CONNECTOR (millennium);
+GWC_REGISTER_CONNECTOR (fix);
+GWC_REGISTER_CONNECTOR (eti);
+GWC_REGISTER_CONNECTOR (optiq);
+GWC_REGISTER_CONNECTOR (swx);
+#endif
+
+/* Never reconnects, replay has nothing to connect to */
+class replaySession : public gwcSessionCallbacks
+{
+public:
+    bool onError (const string& error)
+    {
+        return false;
+    }
+
+    void onLoggedOn (uint64_t seqno, const cdr& msg) {}
+
+    void onLoggedOff (uint64_t seqno, const cdr& msg) {}
+};
+
+class replayMessages : public gwcMessageCallbacks
+{
+public:
+    replayMessages (uint64_t callbackNs) :
+        mCallbackNs (callbackNs),
+        mReceived (0)
+    {
+    }
+
+    void onAdmin (uint64_t seqno, const cdr& msg)
+    {
+        receive ();
+    }
+
+    void onOrderAck (uint64_t seqno, const cdr& msg)
+    {
+        receive ();
+    }
+
+    void onOrderRejected (uint64_t seqno, const cdr& msg)
+    {
+        receive ();
+    }
+
+    void onOrderDone (uint64_t seqno, const cdr& msg)
+    {
+        receive ();
+    }
+
+    void onOrderFill (uint64_t seqno, const cdr& msg)
+    {
+        receive ();
+    }
+
+    void onModifyAck (uint64_t seqno, const cdr& msg)
+    {
+        receive ();
+    }
+
+    void onModifyRejected (uint64_t seqno, const cdr& msg)
+    {
+        receive ();
+    }
+
+    void onCancelRejected (uint64_t seqno, const cdr& msg)
+    {
+        receive ();
+    }
+
+    void onMsg (uint64_t seqno, const cdr& msg)
+    {
+        receive ();
+    }
+
+    void onRawMsg (uint64_t seqno, const void* ptr, size_t len)
+    {
+        receive ();
+    }
+
+    uint64_t          mCallbackNs;
+    volatile uint64_t mReceived;
+
+private:
+    /* Every callback pays the configured cost */
+    void receive ()
+    {
+        __sync_fetch_and_add (&mReceived, 1);
+        if (mCallbackNs == 0)
+            return;
+
+        uint64_t until = gwcLatency_now () + mCallbackNs;
+        while (gwcLatency_now () < until)
+            ;
+    }
+};
+
+static void
+usage ()
+{
+    fprintf (stderr,
+             "usage: fosdk-replay <type> <journal> [journal ...] [key=value ...]\n"
+             "types: millennium fix eti optiq swx\n"
+             "journals: rolled files oldest first, e.g. gwc.jnl.2 gwc.jnl.1 gwc.jnl\n"
+             "keys: session (the only one) speed (0, unpaced) repeat (1)\n"
+             "      callback_ns (0) output (stdout) log_level\n"
+             "      and the connector options the journal was recorded with,\n"
+             "      e.g. venue or data_dictionary\n");
+    exit (1);
+}
+
+static uint64_t
+getNumber (const properties& props, const string& key, const string& dflt)
+{
+    string  v;
+    int64_t n;
+
+    props.get (key, dflt, v);
+    if (!utils_parseNumber (v, n) || n < 0)
+        errx (1, "invalid %s %s", key.c_str (), v.c_str ());
+    return (uint64_t)n;
+}
+
+static void
+writeStat (FILE* f, const char* name, const gwcLatencyStat& s)
+{
+    fprintf (f,
+             "  \"%s\": {\"count\": %llu, \"min\": %llu, \"mean\": %llu, "
+             "\"p50\": %llu, \"p99\": %llu, \"p999\": %llu, "
+             "\"max\": %llu}\n",
+             name,
+             (unsigned long long)s.mCount,
+             (unsigned long long)s.mMin,
+             (unsigned long long)s.mMean,
+             (unsigned long long)s.mP50,
+             (unsigned long long)s.mP99,
+             (unsigned long long)s.mP999,
+             (unsigned long long)s.mMax);
+}
+
+static void
+writeResults (FILE* f,
+              const string& type,
+              const string& session,
+              double speed,
+              uint64_t callbacks,
+              const gwcReplayStats& stats)
+{
+    fprintf (f, "{\n");
+    fprintf (f, "  \"type\": \"%s\",\n", type.c_str ());
+    fprintf (f, "  \"session\": \"%s\",\n", session.c_str ());
+    fprintf (f, "  \"speed\": %.3f,\n", speed);
+    fprintf (f, "  \"messages\": %llu,\n", (unsigned long long)stats.mMessages);
+    fprintf (f, "  \"bytes\": %llu,\n", (unsigned long long)stats.mBytes);
+    fprintf (f, "  \"errors\": %llu,\n", (unsigned long long)stats.mErrors);
+    fprintf (f, "  \"callbacks\": %llu,\n", (unsigned long long)callbacks);
+    fprintf (f,
+             "  \"elapsed_ns\": %llu,\n",
+             (unsigned long long)stats.mElapsedNs);
+    fprintf (f, "  \"msgs_per_sec\": %.0f,\n", stats.mMsgsPerSec);
+    fprintf (f, "  \"bytes_per_sec\": %.0f,\n", stats.mBytesPerSec);
+    writeStat (f, "read_ns", stats.mLatency);
+    fprintf (f, "}\n");
+}
+
+int
+main (int argc, char** argv)
+{
+    if (argc < 3)
+        usage ();
+
+    string         type (argv[1]);
+    vector<string> journals;
+
+    properties p;
+    properties opts (p, "replay", type, "local");
+    properties props (p, "gwc", type, "replay");
+    for (int i = 2; i < argc; i++)
+    {
+        string arg (argv[i]);
+        size_t eq = arg.find ('=');
+        if (eq == 0)
+            usage ();
+        if (eq == string::npos)
+        {
+            journals.push_back (arg);
+            continue;
+        }
+        opts.setProperty (arg.substr (0, eq), arg.substr (eq + 1));
+        props.setProperty (arg.substr (0, eq), arg.substr (eq + 1));
+    }
+    if (journals.empty ())
+        usage ();
+
+    string session;
+    string output;
+    opts.get ("session", "", session);
+    opts.get ("output", "", output);
+    uint64_t repeat = getNumber (opts, "repeat", "1");
+    uint64_t callbackNs = getNumber (opts, "callback_ns", "0");
+    if (repeat == 0)
+        errx (1, "repeat must be at least 1");
+
+    string v;
+    double speed;
+    opts.get ("speed", "0", v);
+    if (!utils_parseNumber (v, speed) || speed < 0)
+        errx (1, "invalid speed %s", v.c_str ());
+
+    string level;
+    opts.get ("log_level", "warn", level);
+    p.setProperty ("lh.console.level", level);
+
+    string errorMessage;
+    if (!logService::get ().configure (p, errorMessage))
+        errx (1, "failed to configure logger: %s", errorMessage.c_str ());
+    logger* log = logService::getLogger ("FOSDK_REPLAY");
+
+    /* the connector is never started so hosts are only parsed, and replay
+       must not touch the caches of the session that was recorded */
+    const char* hosts[] = {"host", "real_time_host", "recovery_host"};
+    for (size_t i = 0; i < sizeof hosts / sizeof hosts[0]; i++)
+    {
+        if (!props.get (hosts[i], v))
+            props.setProperty (hosts[i], "127.0.0.1:1");
+    }
+    string cache = "fosdk-replay." + type + ".cache";
+    unlink (cache.c_str ());
+    props.setProperty ("seqno_cache", cache);
+    props.setProperty ("applMsgId_cache", cache);
+
+    replaySession  sessionCbs;
+    replayMessages messageCbs (callbackNs);
+
+    gwcConnector* gwc = gwcConnectorFactory::get (log, type, props);
+    if (gwc == NULL)
+        errx (1, "failed to get connector %s", type.c_str ());
+    if (!gwc->init (&sessionCbs, &messageCbs, props))
+        errx (1, "failed to initialise connector");
+
+    gwcReplay replay (gwc);
+    if (!replay.load (journals, session, errorMessage))
+        errx (1, "failed to load journal: %s", errorMessage.c_str ());
+    log->info ("replaying %llu messages",
+               (unsigned long long)replay.getMessages ());
+
+    /* later passes run with warm caches, report the last */
+    gwcReplayStats stats;
+    for (uint64_t i = 0; i < repeat; i++)
+    {
+        messageCbs.mReceived = 0;
+        replay.run (speed, stats);
+    }
+
+    FILE* f = stdout;
+    if (!output.empty ())
+    {
+        f = fopen (output.c_str (), "w");
+        if (f == NULL)
+            err (1, "failed to open %s", output.c_str ());
+    }
+    writeResults (f, type, session, speed, messageCbs.mReceived, stats);
+    if (f != stdout)
+        fclose (f);
+
+    unlink (cache.c_str ());
+    return 0;
+}
@@ -0,0 +1,143 @@
+/** Standalone loopback exchange simulator **/
+
+#include "gwcSimEti.h"
+#include "gwcSimFix.h"
+#include "gwcSimMillennium.h"
+#include "gwcSimOptiq.h"
+#include "gwcSimSwx.h"
+#include "utils.h"
+
+#include <err.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace std;
+using namespace neueda;
+
+static void
+usage ()
+{
+    fprintf (stderr,
+             "usage: fosdk-sim <venue> [key=value ...]\n"
+             "venues: fix xetra eurex optiq lse oslo turquoise swx\n"
+             "keys: host port recovery_port auto_fill log_level and the\n"
+             "      venue options (data_dictionary, partition_id, app_id,\n"
+             "      session)\n");
+    exit (1);
+}
+
+static uint16_t
+getPort (const properties& props, const string& key, const string& dflt)
+{
+    string  v;
+    int64_t port;
+
+    props.get (key, dflt, v);
+    if (!utils_parseNumber (v, port) || port < 0 || port > 65535)
+        errx (1, "invalid %s %s", key.c_str (), v.c_str ());
+    return (uint16_t)port;
+}
+
+template <typename SimT>
+static void
+run (SimT& sim, const properties& props, const string& host, uint16_t port)
+{
+    string err;
+
+    if (!sim.init (props, err))
+        errx (1, "failed to init simulator: %s", err.c_str ());
+    if (!sim.start (host, port, err))
+        errx (1, "failed to start simulator: %s", err.c_str ());
+}
+
+template <typename CodecT>
+static void
+runMillennium (gwcSimMillennium<CodecT>& sim,
+               const properties& props,
+               const string& host,
+               uint16_t port)
+{
+    string err;
+
+    if (!sim.init (props, err))
+        errx (1, "failed to init simulator: %s", err.c_str ());
+    if (!sim.start (host,
+                    port,
+                    getPort (props, "recovery_port", "10000"),
+                    err))
+        errx (1, "failed to start simulator: %s", err.c_str ());
+}
+
+int
+main (int argc, char** argv)
+{
+    if (argc < 2)
+        usage ();
+    string venue (argv[1]);
+
+    properties p;
+    properties props (p, "sim", venue, "local");
+    for (int i = 2; i < argc; i++)
+    {
+        string arg (argv[i]);
+        size_t eq = arg.find ('=');
+        if (eq == string::npos || eq == 0)
+            usage ();
+        props.setProperty (arg.substr (0, eq), arg.substr (eq + 1));
+    }
+
+    string level;
+    props.get ("log_level", "info", level);
+    p.setProperty ("lh.console.level", level);
+    p.setProperty ("lh.console.color", "true");
+
+    string errorMessage;
+    if (!logService::get ().configure (p, errorMessage))
+        errx (1, "failed to configure logger: %s", errorMessage.c_str ());
+    logger* log = logService::getLogger ("FOSDK_SIM");
+
+    string host;
+    props.get ("host", "127.0.0.1", host);
+    uint16_t port = getPort (props, "port", "9899");
+
+    /* block before the simulator threads start so only sigwait sees them */
+    sigset_t signals;
+    sigemptyset (&signals);
+    sigaddset (&signals, SIGINT);
+    sigaddset (&signals, SIGTERM);
+    pthread_sigmask (SIG_BLOCK, &signals, NULL);
+
+    gwcSimFix                        fix (log);
+    gwcSimEti<xetraCodec>            xetra (log, "xetra");
+    gwcSimEti<eurexCodec>            eurex (log, "eurex");
+    gwcSimOptiq                      optiq (log);
+    gwcSimMillennium<lseCodec>       lse (log, "lse");
+    gwcSimMillennium<osloCodec>      oslo (log, "oslo");
+    gwcSimMillennium<turquoiseCodec> turquoise (log, "turquoise");
+    gwcSimSwx                        swx (log);
+
+    if (venue == "fix")
+        run (fix, props, host, port);
+    else if (venue == "xetra")
+        run (xetra, props, host, port);
+    else if (venue == "eurex")
+        run (eurex, props, host, port);
+    else if (venue == "optiq")
+        run (optiq, props, host, port);
+    else if (venue == "lse")
+        runMillennium (lse, props, host, port);
+    else if (venue == "oslo")
+        runMillennium (oslo, props, host, port);
+    else if (venue == "turquoise")
+        runMillennium (turquoise, props, host, port);
+    else if (venue == "swx")
+        run (swx, props, host, port);
+    else
+        usage ();
+
+    int sig;
+    sigwait (&signals, &sig);
+    log->info ("stopping simulator...");
+    return 0;
+}
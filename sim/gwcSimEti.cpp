@@ -0,0 +1,409 @@
+#include "gwcSimEti.h"
+#include "fields.h"
+#include "utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+/* ApplMsgID is 16 bytes, big endian counter in the low 8 so ids compare
+   in order */
+static string
+toApplMsgId (uint64_t seqno)
+{
+    char id[16];
+
+    memset (id, 0, sizeof id);
+    for (int i = 0; i < 8; i++)
+        id[15 - i] = (char)((seqno >> (8 * i)) & 0xff);
+    return string (id, sizeof id);
+}
+
+static uint64_t
+fromApplMsgId (const string& id)
+{
+    uint64_t seqno = 0;
+
+    for (size_t i = id.size () > 8 ? id.size () - 8 : 0; i < id.size (); i++)
+        seqno = (seqno << 8) | (unsigned char)id[i];
+    return seqno;
+}
+
+static int64_t
+getNanos ()
+{
+    struct timeval tv;
+
+    gettimeofday (&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000000LL + (int64_t)tv.tv_usec * 1000;
+}
+
+template <typename CodecT>
+gwcSimEti<CodecT>::gwcSimEti (logger* log, const string& name) :
+    gwcSimServer (log, name),
+    mPartitionId (1),
+    mSeqNo (0),
+    mSinceHb (0),
+    mLoggedOn (false)
+{
+}
+
+template <typename CodecT>
+gwcSimEti<CodecT>::~gwcSimEti ()
+{
+    stop ();
+}
+
+template <typename CodecT>
+bool
+gwcSimEti<CodecT>::init (const properties& props, string& err)
+{
+    string v;
+
+    if (!gwcSimServer::init (props, err))
+        return false;
+
+    props.get ("partition_id", "1", v);
+    if (!utils_parseNumber (v, mPartitionId))
+    {
+        err = "failed to parse partition_id as number";
+        return false;
+    }
+    return true;
+}
+
+template <typename CodecT>
+void
+gwcSimEti<CodecT>::onConnect ()
+{
+    mLoggedOn = false;
+    mSeqNo = 0;
+    mSinceHb = 0;
+}
+
+template <typename CodecT>
+size_t
+gwcSimEti<CodecT>::onRead (const void* data, size_t size)
+{
+    const char* p = (const char*)data;
+    size_t      left = size;
+    cdr         msg;
+
+    while (left > 0)
+    {
+        size_t used = 0;
+        switch (mCodec.decode (msg, p, left, used))
+        {
+        case GW_CODEC_SHORT:
+            return size - left;
+
+        case GW_CODEC_SUCCESS:
+            mLog->debug ("%s simulator msg in..", mName.c_str ());
+            mLog->debug ("%s", msg.toString ().c_str ());
+            handleMsg (msg);
+            break;
+
+        default:
+            mLog->err ("%s simulator failed to decode [%s]",
+                       mName.c_str (),
+                       mCodec.getLastError ().c_str ());
+            disconnect ();
+            return size;
+        }
+        p += used;
+        left -= used;
+        msg.clear ();
+    }
+    return size - left;
+}
+
+template <typename CodecT>
+void
+gwcSimEti<CodecT>::onTimer ()
+{
+    /* the connector heartbeats every 10 seconds, match it */
+    if (!mLoggedOn || ++mSinceHb < 10)
+        return;
+
+    cdr hb;
+    hb.setInteger (TemplateID, 10023);
+    sendResponse (hb);
+}
+
+template <typename CodecT>
+void
+gwcSimEti<CodecT>::handleMsg (cdr& msg)
+{
+    int64_t templateId = 0;
+    int64_t seqno = 0;
+
+    msg.getInteger (TemplateID, templateId);
+    msg.getInteger (MsgSeqNum, seqno);
+
+    /* heartbeats don't take a seqno */
+    if (templateId != 10011)
+        mSeqNo = seqno;
+
+    if (!mLoggedOn && templateId != 10000)
+    {
+        sendReject (100, "not logged on");
+        disconnect ();
+        return;
+    }
+
+    switch (templateId)
+    {
+    case 10000: // logon
+    {
+        mLoggedOn = true;
+
+        cdr logon;
+        logon.setInteger (TemplateID, 10001);
+        logon.setInteger (HeartBtInt, 10000);
+        logon.setString (DefaultCstmApplVerID, "7.1");
+        sendResponse (logon);
+    }
+        break;
+    case 10018: // trader logon
+    {
+        cdr logon;
+        logon.setInteger (TemplateID, 10019);
+        sendResponse (logon);
+    }
+        break;
+    case 10029: // trader logoff
+    {
+        cdr logoff;
+        logoff.setInteger (TemplateID, 10030);
+        sendResponse (logoff);
+    }
+        break;
+    case 10002: // logoff
+    {
+        cdr logoff;
+        logoff.setInteger (TemplateID, 10003);
+        sendResponse (logoff);
+        mLoggedOn = false;
+        disconnect ();
+    }
+        break;
+    case 10011: // heartbeat
+        break;
+    case 10026:
+        handleRetransRequest (msg);
+        break;
+    case 10100:
+        handleNewOrder (msg);
+        break;
+    case 10106:
+        handleModify (msg);
+        break;
+    case 10109:
+        handleDelete (msg);
+        break;
+    default:
+        mLog->warn ("%s simulator ignoring template %lld",
+                    mName.c_str (),
+                    (long long)templateId);
+        break;
+    }
+}
+
+template <typename CodecT>
+void
+gwcSimEti<CodecT>::handleRetransRequest (cdr& msg)
+{
+    string   begin;
+    uint64_t from = 0;
+    uint64_t end = mJournal.last ();
+    int64_t  count = 0;
+
+    if (msg.getString (ApplBegMsgID, begin))
+        from = fromApplMsgId (begin) + 1;
+    if (from == 0)
+        from = 1;
+    if (from <= end)
+        count = end - from + 1;
+
+    cdr response;
+    response.setInteger (TemplateID, 10027);
+    response.setInteger (ApplTotalMessageCount, count);
+    response.setString (ApplEndMsgID, toApplMsgId (end));
+    sendResponse (response);
+
+    for (uint64_t seqno = from; seqno <= end; seqno++)
+    {
+        const cdr* sent = mJournal.find (seqno);
+        if (sent == NULL)
+            continue;
+
+        cdr resend (*sent);
+        resend.setInteger (ApplResendFlag, 1);
+        sendMsg (mCodec, resend);
+    }
+}
+
+template <typename CodecT>
+void
+gwcSimEti<CodecT>::handleNewOrder (cdr& msg)
+{
+    int64_t clOrdId = 0;
+    int64_t qty = 0;
+    char    key[32];
+
+    msg.getInteger (ClOrdID, clOrdId);
+    qty = (int64_t)gwcSim_getNumber (msg, OrderQty);
+    snprintf (key, sizeof key, "%lld", (long long)clOrdId);
+
+    if (findOrder (key) != NULL || qty <= 0)
+    {
+        sendReject (10000, "invalid order");
+        return;
+    }
+
+    gwcSimOrder& order = addOrder (key, qty, gwcSim_getNumber (msg, Price));
+    sendExecution (10101, order, "0", "0", 0);
+
+    if (mAutoFill)
+    {
+        order.mCumQty = order.mQty;
+        order.mOpen = false;
+        sendExecution (10104, order, "2", "F", 0);
+    }
+}
+
+template <typename CodecT>
+void
+gwcSimEti<CodecT>::handleDelete (cdr& msg)
+{
+    int64_t clOrdId = 0;
+    int64_t origClOrdId = 0;
+    char    key[32];
+
+    msg.getInteger (ClOrdID, clOrdId);
+    msg.getInteger (OrigClOrdID, origClOrdId);
+    snprintf (key, sizeof key, "%lld", (long long)origClOrdId);
+
+    gwcSimOrder* order = findOrder (key);
+    if (order == NULL)
+    {
+        sendReject (10000, "order not found");
+        return;
+    }
+
+    order->mOpen = false;
+    gwcSimOrder deleted = *order;
+    snprintf (key, sizeof key, "%lld", (long long)clOrdId);
+    deleted.mClOrdId = key;
+    sendExecution (10110, deleted, "4", "4", origClOrdId);
+}
+
+template <typename CodecT>
+void
+gwcSimEti<CodecT>::handleModify (cdr& msg)
+{
+    int64_t clOrdId = 0;
+    int64_t origClOrdId = 0;
+    char    key[32];
+
+    msg.getInteger (ClOrdID, clOrdId);
+    msg.getInteger (OrigClOrdID, origClOrdId);
+    snprintf (key, sizeof key, "%lld", (long long)origClOrdId);
+
+    gwcSimOrder* order = findOrder (key);
+    int64_t      qty = (int64_t)gwcSim_getNumber (msg, OrderQty);
+    if (order == NULL || qty <= order->mCumQty)
+    {
+        sendReject (10000, "order not found");
+        return;
+    }
+
+    gwcSimOrder modified = *order;
+    order->mOpen = false;
+    snprintf (key, sizeof key, "%lld", (long long)clOrdId);
+    modified.mClOrdId = key;
+    modified.mQty = qty;
+    if (msg.contains (Price))
+        modified.mPrice = gwcSim_getNumber (msg, Price);
+    mOrders[key] = modified;
+
+    sendExecution (10107, modified, "0", "5", origClOrdId);
+}
+
+template <typename CodecT>
+void
+gwcSimEti<CodecT>::sendReject (int64_t reason, const string& text)
+{
+    cdr reject;
+    reject.setInteger (TemplateID, 10010);
+    reject.setInteger (SessionRejectReason, reason);
+    reject.setInteger (SessionStatus, 0);
+    reject.setString (VarText, text);
+    sendResponse (reject);
+}
+
+template <typename CodecT>
+void
+gwcSimEti<CodecT>::sendExecution (int64_t templateId,
+                                  const gwcSimOrder& order,
+                                  const string& ordStatus,
+                                  const string& execType,
+                                  int64_t origClOrdId)
+{
+    int64_t now = getNanos ();
+
+    cdr exec;
+    exec.setInteger (TemplateID, templateId);
+    exec.setInteger (OrderID, order.mOrderId);
+    exec.setInteger (ClOrdID, strtoll (order.mClOrdId.c_str (), NULL, 10));
+    if (origClOrdId != 0)
+        exec.setInteger (OrigClOrdID, origClOrdId);
+    exec.setInteger (ExecID, nextExecId ());
+    exec.setString (OrdStatus, ordStatus);
+    exec.setString (ExecType, execType);
+    exec.setInteger (CumQty, order.mCumQty);
+    exec.setInteger (LeavesQty,
+                     order.mOpen ? order.mQty - order.mCumQty : 0);
+    exec.setInteger (CxlQty,
+                     order.mOpen ? 0 : order.mQty - order.mCumQty);
+    exec.setInteger (TrdRegTSTimeIn, now);
+    exec.setInteger (TrdRegTSTimeOut, now);
+    sendApp (exec);
+}
+
+template <typename CodecT>
+void
+gwcSimEti<CodecT>::sendResponse (cdr& msg)
+{
+    msg.setInteger (MsgSeqNum, mSeqNo);
+    msg.setInteger (SendingTime, getNanos ());
+    mSinceHb = 0;
+    sendMsg (mCodec, msg);
+}
+
+template <typename CodecT>
+void
+gwcSimEti<CodecT>::sendApp (cdr& msg)
+{
+    int64_t  templateId = 0;
+    uint64_t seqno = mJournal.last () + 1;
+
+    msg.getInteger (TemplateID, templateId);
+    msg.setInteger (PartitionID, mPartitionId);
+    msg.setInteger (ApplID, 4);
+    msg.setString (ApplMsgID, toApplMsgId (seqno));
+    msg.setInteger (ApplResendFlag, 0);
+
+    /* book fills are unsolicited so carry no request seqno */
+    msg.setInteger (MsgSeqNum, templateId == 10104 ? 0 : mSeqNo);
+    msg.setInteger (SendingTime, getNanos ());
+    mJournal.add (seqno, msg);
+    mSinceHb = 0;
+    sendMsg (mCodec, msg);
+}
+
+// xetra
+template class gwcSimEti<neueda::xetraCodec>;
+
+// eurex
+template class gwcSimEti<neueda::eurexCodec>;
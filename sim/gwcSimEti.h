@@ -0,0 +1,54 @@
+#pragma once
+/*
+ * ETI venue for xetra and eurex, session and trader logon/logoff, heartbeat
+ * notifications, retransmission of execution messages by ApplMsgID and
+ * acks, book fills, modifies and deletes for single orders. Responses echo
+ * the request MsgSeqNum as the connector takes its seqno from them.
+ */
+
+#include "gwcSimServer.h"
+#include "xetraCodec.h"
+#include "eurexCodec.h"
+
+template <typename CodecT>
+class gwcSimEti : public gwcSimServer
+{
+public:
+    gwcSimEti (logger* log, const string& name);
+    ~gwcSimEti ();
+
+    /* partition_id defaults to 1 */
+    bool init (const properties& props, string& err);
+
+protected:
+    void onConnect ();
+    size_t onRead (const void* data, size_t size);
+    void onTimer ();
+
+private:
+    void handleMsg (cdr& msg);
+    void handleRetransRequest (cdr& msg);
+    void handleNewOrder (cdr& msg);
+    void handleDelete (cdr& msg);
+    void handleModify (cdr& msg);
+
+    void sendReject (int64_t reason, const string& text);
+    void sendExecution (int64_t templateId,
+                        const gwcSimOrder& order,
+                        const string& ordStatus,
+                        const string& execType,
+                        int64_t origClOrdId);
+
+    /* Respond with the request seqno */
+    void sendResponse (cdr& msg);
+
+    /* Execution messages get the next ApplMsgID and are journaled */
+    void sendApp (cdr& msg);
+
+    CodecT        mCodec;
+    int64_t       mPartitionId;
+    int64_t       mSeqNo;
+    int64_t       mSinceHb;
+    bool          mLoggedOn;
+    gwcSimJournal mJournal;
+};
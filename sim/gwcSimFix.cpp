@@ -0,0 +1,465 @@
+#include "gwcSimFix.h"
+#include "fields.h"
+
+#include <sys/time.h>
+#include <time.h>
+
+static const string FixHeartbeat = "0";
+static const string FixTestRequest = "1";
+static const string FixResendRequest = "2";
+static const string FixSequenceReset = "4";
+static const string FixLogout = "5";
+static const string FixExecutionReport = "8";
+static const string FixOrderCancelReject = "9";
+static const string FixLogon = "A";
+static const string FixNewOrderSingle = "D";
+static const string FixOrderCancelRequest = "F";
+static const string FixOrderCancelReplaceRequest = "G";
+
+static void
+getTime (cdrDateTime& dt)
+{
+    struct timeval tv;
+    struct tm      tm;
+
+    gettimeofday (&tv, NULL);
+    gmtime_r (&tv.tv_sec, &tm);
+
+    dt.mYear = 1900 + tm.tm_year;
+    dt.mMonth = 1 + tm.tm_mon;
+    dt.mDay = tm.tm_mday;
+    dt.mHour = tm.tm_hour;
+    dt.mMinute = tm.tm_min;
+    dt.mSecond = tm.tm_sec;
+    dt.mNanosecond = (int)tv.tv_usec * 1000;
+}
+
+gwcSimFix::gwcSimFix (logger* log) :
+    gwcSimServer (log, "fix"),
+    mBeginString ("FIX.4.2"),
+    mHeartBtInt (30),
+    mSinceHb (0),
+    mInSeq (1),
+    mOutSeq (1),
+    mLoggedOn (false)
+{
+}
+
+gwcSimFix::~gwcSimFix ()
+{
+    stop ();
+}
+
+bool
+gwcSimFix::init (const properties& props, string& err)
+{
+    string dictionary;
+
+    if (!gwcSimServer::init (props, err))
+        return false;
+
+    if (!props.get ("data_dictionary", dictionary))
+    {
+        err = "missing property data_dictionary";
+        return false;
+    }
+    if (!mCodec.loadDataDictionary (dictionary.c_str (), err))
+        return false;
+
+    props.get ("begin_string", "FIX.4.2", mBeginString);
+    return true;
+}
+
+void
+gwcSimFix::onConnect ()
+{
+    mLoggedOn = false;
+    mSinceHb = 0;
+}
+
+size_t
+gwcSimFix::onRead (const void* data, size_t size)
+{
+    const char* p = (const char*)data;
+    size_t      left = size;
+    cdr         msg;
+
+    while (left > 0)
+    {
+        size_t used = 0;
+        switch (mCodec.decode (msg, p, left, used))
+        {
+        case GW_CODEC_SHORT:
+            return size - left;
+
+        case GW_CODEC_SUCCESS:
+            mLog->debug ("fix simulator msg in..");
+            mLog->debug ("%s", msg.toString ().c_str ());
+            handleMsg (msg);
+            break;
+
+        default:
+            mLog->err ("fix simulator failed to decode [%s]",
+                       mCodec.getLastError ().c_str ());
+            disconnect ();
+            return size;
+        }
+        p += used;
+        left -= used;
+        msg.clear ();
+    }
+    return size - left;
+}
+
+void
+gwcSimFix::onTimer ()
+{
+    if (!mLoggedOn || ++mSinceHb < mHeartBtInt)
+        return;
+
+    cdr hb;
+    hb.setString (MsgType, FixHeartbeat);
+    sendSession (hb);
+}
+
+void
+gwcSimFix::handleMsg (cdr& msg)
+{
+    string  msgType;
+    string  possDup;
+    int64_t seqno = 0;
+
+    msg.getString (MsgType, msgType);
+    msg.getInteger (MsgSeqNum, seqno);
+
+    if (msgType == FixLogon)
+    {
+        handleLogon (msg);
+        return;
+    }
+    if (!mLoggedOn)
+    {
+        mLog->warn ("fix simulator message before logon");
+        disconnect ();
+        return;
+    }
+
+    /* a reset moves the expected seqno without a gap check */
+    if (msgType == FixSequenceReset)
+    {
+        int64_t newSeqNo = 0;
+        if (msg.getInteger (NewSeqNo, newSeqNo))
+            mInSeq = newSeqNo;
+        return;
+    }
+
+    msg.getString (PossDupFlag, possDup);
+    if (seqno < mInSeq && possDup != "Y")
+    {
+        mLog->err ("fix simulator seqno too low, expected %lld got %lld",
+                   (long long)mInSeq,
+                   (long long)seqno);
+        disconnect ();
+        return;
+    }
+    if (seqno > mInSeq)
+    {
+        cdr resend;
+        resend.setString (MsgType, FixResendRequest);
+        resend.setInteger (BeginSeqNo, mInSeq);
+        resend.setInteger (EndSeqNo, 0);
+        sendSession (resend);
+    }
+    if (seqno >= mInSeq)
+        mInSeq = seqno + 1;
+
+    if (msgType == FixHeartbeat)
+        return;
+    else if (msgType == FixTestRequest)
+    {
+        string testReqId;
+        msg.getString (TestReqID, testReqId);
+
+        cdr hb;
+        hb.setString (MsgType, FixHeartbeat);
+        hb.setString (TestReqID, testReqId);
+        sendSession (hb);
+    }
+    else if (msgType == FixResendRequest)
+        handleResendRequest (msg);
+    else if (msgType == FixLogout)
+    {
+        cdr logout;
+        logout.setString (MsgType, FixLogout);
+        sendSession (logout);
+        mLoggedOn = false;
+        disconnect ();
+    }
+    else if (msgType == FixNewOrderSingle)
+        handleNewOrder (msg);
+    else if (msgType == FixOrderCancelRequest)
+        handleCancel (msg);
+    else if (msgType == FixOrderCancelReplaceRequest)
+        handleReplace (msg);
+    else
+        mLog->warn ("fix simulator ignoring msg type %s", msgType.c_str ());
+}
+
+void
+gwcSimFix::handleLogon (cdr& msg)
+{
+    string  reset;
+    int64_t seqno = 0;
+
+    /* reply with the comp ids reversed */
+    msg.getString (SenderCompID, mTargetCompID);
+    msg.getString (TargetCompID, mSenderCompID);
+    msg.getInteger (HeartBtInt, mHeartBtInt);
+    msg.getInteger (MsgSeqNum, seqno);
+    if (mHeartBtInt <= 0)
+        mHeartBtInt = 30;
+
+    msg.getString (ResetSeqNumFlag, reset);
+    if (reset == "Y")
+    {
+        mInSeq = 1;
+        mOutSeq = 1;
+        mJournal.clear ();
+    }
+
+    int64_t expected = mInSeq;
+    mInSeq = seqno + 1;
+    mLoggedOn = true;
+
+    cdr logon;
+    logon.setString (MsgType, FixLogon);
+    logon.setInteger (EncryptMethod, 0);
+    logon.setInteger (HeartBtInt, mHeartBtInt);
+    if (reset == "Y")
+        logon.setString (ResetSeqNumFlag, "Y");
+    sendSession (logon);
+
+    if (seqno > expected)
+    {
+        cdr resend;
+        resend.setString (MsgType, FixResendRequest);
+        resend.setInteger (BeginSeqNo, expected);
+        resend.setInteger (EndSeqNo, 0);
+        sendSession (resend);
+    }
+}
+
+void
+gwcSimFix::handleResendRequest (cdr& msg)
+{
+    int64_t begin = 0;
+    int64_t end = 0;
+    int64_t gapStart = 0;
+
+    msg.getInteger (BeginSeqNo, begin);
+    msg.getInteger (EndSeqNo, end);
+    if (end == 0 || end >= mOutSeq)
+        end = mOutSeq - 1;
+
+    for (int64_t seqno = begin; seqno <= end + 1; seqno++)
+    {
+        const cdr* sent = seqno <= end ? mJournal.find (seqno) : NULL;
+        if (sent == NULL && seqno <= end)
+        {
+            if (gapStart == 0)
+                gapStart = seqno;
+            continue;
+        }
+
+        /* session messages are replaced by a single gap fill */
+        if (gapStart != 0)
+        {
+            cdr gap;
+            gap.setString (MsgType, FixSequenceReset);
+            gap.setString (GapFillFlag, "Y");
+            gap.setInteger (NewSeqNo, seqno);
+            setHeader (gap, gapStart);
+            gap.setString (PossDupFlag, "Y");
+            sendMsg (mCodec, gap);
+            gapStart = 0;
+        }
+        if (sent == NULL)
+            continue;
+
+        cdr resend (*sent);
+        cdrDateTime orig;
+        if (sent->getDateTime (SendingTime, orig))
+            resend.setDateTime (OrigSendingTime, orig);
+        setHeader (resend, seqno);
+        resend.setString (PossDupFlag, "Y");
+        sendMsg (mCodec, resend);
+    }
+}
+
+void
+gwcSimFix::handleNewOrder (cdr& msg)
+{
+    string  clOrdId;
+    int64_t qty = 0;
+
+    msg.getString (ClOrdID, clOrdId);
+    msg.getInteger (OrderQty, qty);
+
+    if (findOrder (clOrdId) != NULL || qty <= 0)
+    {
+        gwcSimOrder rejected;
+        rejected.mClOrdId = clOrdId;
+        rejected.mOrderId = 0;
+        rejected.mQty = qty;
+        rejected.mCumQty = 0;
+        rejected.mPrice = gwcSim_getNumber (msg, Price);
+        rejected.mOpen = false;
+        sendExecution (rejected, "8", "8", "", 0);
+        return;
+    }
+
+    gwcSimOrder& order = addOrder (clOrdId, qty, gwcSim_getNumber (msg, Price));
+    sendExecution (order, "0", "0", "", 0);
+
+    if (mAutoFill)
+    {
+        int64_t lastQty = order.mQty - order.mCumQty;
+        order.mCumQty = order.mQty;
+        order.mOpen = false;
+        sendExecution (order, "2", "2", "", lastQty);
+    }
+}
+
+void
+gwcSimFix::handleCancel (cdr& msg)
+{
+    string clOrdId;
+    string origClOrdId;
+
+    msg.getString (ClOrdID, clOrdId);
+    msg.getString (OrigClOrdID, origClOrdId);
+
+    gwcSimOrder* order = findOrder (origClOrdId);
+    if (order == NULL)
+    {
+        sendCancelReject (msg, "1");
+        return;
+    }
+
+    order->mOpen = false;
+    gwcSimOrder cancelled = *order;
+    cancelled.mClOrdId = clOrdId;
+    sendExecution (cancelled, "4", "4", origClOrdId, 0);
+}
+
+void
+gwcSimFix::handleReplace (cdr& msg)
+{
+    string  clOrdId;
+    string  origClOrdId;
+    int64_t qty = 0;
+
+    msg.getString (ClOrdID, clOrdId);
+    msg.getString (OrigClOrdID, origClOrdId);
+    msg.getInteger (OrderQty, qty);
+
+    gwcSimOrder* order = findOrder (origClOrdId);
+    if (order == NULL || qty <= order->mCumQty)
+    {
+        sendCancelReject (msg, "2");
+        return;
+    }
+
+    /* the order moves to its new client order id */
+    gwcSimOrder replaced = *order;
+    order->mOpen = false;
+    replaced.mClOrdId = clOrdId;
+    replaced.mQty = qty;
+    if (msg.contains (Price))
+        replaced.mPrice = gwcSim_getNumber (msg, Price);
+    mOrders[clOrdId] = replaced;
+
+    sendExecution (replaced, "5", "0", origClOrdId, 0);
+}
+
+void
+gwcSimFix::sendExecution (const gwcSimOrder& order,
+                          const string& execType,
+                          const string& ordStatus,
+                          const string& origClOrdId,
+                          int64_t lastQty)
+{
+    cdr exec;
+    exec.setString (MsgType, FixExecutionReport);
+    exec.setString (OrderID, "%llu", (unsigned long long)order.mOrderId);
+    exec.setString (ClOrdID, order.mClOrdId);
+    if (!origClOrdId.empty ())
+        exec.setString (OrigClOrdID, origClOrdId);
+    exec.setString (ExecID, "%llu", (unsigned long long)nextExecId ());
+    exec.setString (ExecTransType, "0");
+    exec.setString (ExecType, execType);
+    exec.setString (OrdStatus, ordStatus);
+    exec.setInteger (OrderQty, order.mQty);
+    exec.setInteger (CumQty, order.mCumQty);
+    exec.setInteger (LeavesQty,
+                     order.mOpen ? order.mQty - order.mCumQty : 0);
+    exec.setDouble (AvgPx, order.mCumQty > 0 ? order.mPrice : 0);
+    if (lastQty > 0)
+    {
+        exec.setInteger (LastShares, lastQty);
+        exec.setDouble (LastPx, order.mPrice);
+    }
+    sendApp (exec);
+}
+
+void
+gwcSimFix::sendCancelReject (cdr& msg, const string& responseTo)
+{
+    string clOrdId;
+    string origClOrdId;
+
+    msg.getString (ClOrdID, clOrdId);
+    msg.getString (OrigClOrdID, origClOrdId);
+
+    cdr reject;
+    reject.setString (MsgType, FixOrderCancelReject);
+    reject.setString (OrderID, "NONE");
+    reject.setString (ClOrdID, clOrdId);
+    reject.setString (OrigClOrdID, origClOrdId);
+    reject.setString (OrdStatus, "8");
+    reject.setString (CxlRejResponseTo, responseTo);
+    reject.setString (Text, "unknown order");
+    sendApp (reject);
+}
+
+void
+gwcSimFix::sendSession (cdr& msg)
+{
+    setHeader (msg, mOutSeq++);
+    mSinceHb = 0;
+    sendMsg (mCodec, msg);
+}
+
+void
+gwcSimFix::sendApp (cdr& msg)
+{
+    int64_t seqno = mOutSeq++;
+
+    setHeader (msg, seqno);
+    mJournal.add (seqno, msg);
+    mSinceHb = 0;
+    sendMsg (mCodec, msg);
+}
+
+void
+gwcSimFix::setHeader (cdr& msg, int64_t seqno)
+{
+    msg.setString (BeginString, mBeginString);
+    msg.setString (SenderCompID, mSenderCompID);
+    msg.setString (TargetCompID, mTargetCompID);
+    msg.setInteger (MsgSeqNum, seqno);
+
+    cdrDateTime dt;
+    getTime (dt);
+    msg.setDateTime (SendingTime, dt);
+}
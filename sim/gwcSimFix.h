@@ -0,0 +1,55 @@
+#pragma once
+/*
+ * FIX acceptor, logon/logout, heartbeats and test requests, resend
+ * requests answered from the journal with gap fills for session messages,
+ * and acks, fills, cancels and replaces for single orders.
+ */
+
+#include "gwcSimServer.h"
+#include "fixCodec.h"
+
+class gwcSimFix : public gwcSimServer
+{
+public:
+    gwcSimFix (logger* log);
+    ~gwcSimFix ();
+
+    /* data_dictionary is required, begin_string defaults to FIX.4.2 */
+    bool init (const properties& props, string& err);
+
+protected:
+    void onConnect ();
+    size_t onRead (const void* data, size_t size);
+    void onTimer ();
+
+private:
+    void handleMsg (cdr& msg);
+    void handleLogon (cdr& msg);
+    void handleResendRequest (cdr& msg);
+    void handleNewOrder (cdr& msg);
+    void handleCancel (cdr& msg);
+    void handleReplace (cdr& msg);
+
+    void sendExecution (const gwcSimOrder& order,
+                        const string& execType,
+                        const string& ordStatus,
+                        const string& origClOrdId,
+                        int64_t lastQty);
+    void sendCancelReject (cdr& msg, const string& responseTo);
+
+    /* Session messages aren't journaled, resends gap fill over them */
+    void sendSession (cdr& msg);
+    void sendApp (cdr& msg);
+    void setHeader (cdr& msg, int64_t seqno);
+
+    fixCodec      mCodec;
+    string        mBeginString;
+    string        mSenderCompID;
+    string        mTargetCompID;
+    int64_t       mHeartBtInt;
+    int64_t       mSinceHb;
+    int64_t       mInSeq;
+    int64_t       mOutSeq;
+    bool          mLoggedOn;
+    gwcSimJournal mJournal;
+};
@@ -0,0 +1,431 @@
+#include "gwcSimMillennium.h"
+#include "fields.h"
+#include "utils.h"
+
+#include <stdio.h>
+
+#define GW_MILLENNIUM_LOGON "A"
+#define GW_MILLENNIUM_LOGON_REPLY "B"
+#define GW_MILLENNIUM_LOGOUT "5"
+#define GW_MILLENNIUM_HEARTBEAT "0"
+#define GW_MILLENNIUM_MISSED_MESSAGE_REQUEST "M"
+#define GW_MILLENNIUM_MISSED_MESSAGE_REQUEST_ACK "N"
+#define GW_MILLENNIUM_MISSED_MESSAGE_REPORT "P"
+#define GW_MILLENNIUM_REJECT "3"
+#define GW_MILLENNIUM_NEW_ORDER "D"
+#define GW_MILLENNIUM_ORDER_CANCEL_REQUEST "F"
+#define GW_MILLENNIUM_ORDER_CANCEL_REPLACE_REQUEST "G"
+#define GW_MILLENNIUM_EXECUTION_REPORT "8"
+#define GW_MILLENNIUM_ORDER_CANCEL_REJECT "9"
+
+/* Seconds between server heartbeats, inside the connector's 10 second
+   check */
+#define GWC_SIM_MILLENNIUM_HB 3
+
+template <typename CodecT>
+gwcSimMillenniumPort<CodecT>::gwcSimMillenniumPort (
+    gwcSimMillennium<CodecT>* sim,
+    logger* log,
+    const string& name,
+    bool recovery) :
+    gwcSimServer (log, name),
+    mSim (sim),
+    mRecovery (recovery),
+    mLoggedOn (false),
+    mSinceHb (0)
+{
+}
+
+template <typename CodecT>
+gwcSimMillenniumPort<CodecT>::~gwcSimMillenniumPort ()
+{
+    stop ();
+}
+
+template <typename CodecT>
+void
+gwcSimMillenniumPort<CodecT>::sendMsg (cdr& msg)
+{
+    mSinceHb = 0;
+    gwcSimServer::sendMsg (mCodec, msg);
+}
+
+template <typename CodecT>
+void
+gwcSimMillenniumPort<CodecT>::onConnect ()
+{
+    mLoggedOn = false;
+    mSinceHb = 0;
+}
+
+template <typename CodecT>
+size_t
+gwcSimMillenniumPort<CodecT>::onRead (const void* data, size_t size)
+{
+    const char* p = (const char*)data;
+    size_t      left = size;
+    cdr         msg;
+
+    while (left > 0)
+    {
+        size_t used = 0;
+        switch (mCodec.decode (msg, p, left, used))
+        {
+        case GW_CODEC_SHORT:
+            return size - left;
+
+        case GW_CODEC_SUCCESS:
+            mLog->debug ("%s simulator msg in..", mName.c_str ());
+            mLog->debug ("%s", msg.toString ().c_str ());
+            mSim->handleMsg (*this, msg);
+            break;
+
+        default:
+            mLog->err ("%s simulator failed to decode [%s]",
+                       mName.c_str (),
+                       mCodec.getLastError ().c_str ());
+            disconnect ();
+            return size;
+        }
+        p += used;
+        left -= used;
+        msg.clear ();
+    }
+    return size - left;
+}
+
+template <typename CodecT>
+void
+gwcSimMillenniumPort<CodecT>::onTimer ()
+{
+    if (!mLoggedOn || ++mSinceHb < GWC_SIM_MILLENNIUM_HB)
+        return;
+
+    cdr hb;
+    hb.setString (MessageType, GW_MILLENNIUM_HEARTBEAT);
+    sendMsg (hb);
+}
+
+template <typename CodecT>
+gwcSimMillennium<CodecT>::gwcSimMillennium (logger* log, const string& name) :
+    mLog (log),
+    mAppId (1),
+    mRealTime (this, log, name, false),
+    mRecovery (this, log, name + "-recovery", true)
+{
+    pthread_mutex_init (&mJournalLock, NULL);
+}
+
+template <typename CodecT>
+gwcSimMillennium<CodecT>::~gwcSimMillennium ()
+{
+    stop ();
+    pthread_mutex_destroy (&mJournalLock);
+}
+
+template <typename CodecT>
+bool
+gwcSimMillennium<CodecT>::init (const properties& props, string& err)
+{
+    string v;
+
+    if (!mRealTime.init (props, err))
+        return false;
+
+    props.get ("app_id", "1", v);
+    if (!utils_parseNumber (v, mAppId))
+    {
+        err = "failed to parse app_id as number";
+        return false;
+    }
+    return true;
+}
+
+template <typename CodecT>
+bool
+gwcSimMillennium<CodecT>::start (const string& host,
+                                 uint16_t port,
+                                 uint16_t recoveryPort,
+                                 string& err)
+{
+    if (!mRealTime.start (host, port, err))
+        return false;
+    if (!mRecovery.start (host, recoveryPort, err))
+    {
+        mRealTime.stop ();
+        return false;
+    }
+    return true;
+}
+
+template <typename CodecT>
+void
+gwcSimMillennium<CodecT>::stop ()
+{
+    mRealTime.stop ();
+    mRecovery.stop ();
+}
+
+template <typename CodecT>
+void
+gwcSimMillennium<CodecT>::handleMsg (gwcSimMillenniumPort<CodecT>& port,
+                                     cdr& msg)
+{
+    string type;
+    msg.getString (MessageType, type);
+
+    if (type == GW_MILLENNIUM_LOGON)
+    {
+        port.mLoggedOn = true;
+
+        cdr reply;
+        reply.setString (MessageType, GW_MILLENNIUM_LOGON_REPLY);
+        reply.setInteger (RejectCode, 0);
+        reply.setInteger (PasswordExpiryDayCount, 30);
+        port.sendMsg (reply);
+        return;
+    }
+    if (!port.mLoggedOn)
+    {
+        mLog->warn ("%s simulator message before logon",
+                    port.mName.c_str ());
+        port.disconnect ();
+        return;
+    }
+
+    if (type == GW_MILLENNIUM_HEARTBEAT)
+        return;
+    else if (type == GW_MILLENNIUM_LOGOUT)
+    {
+        cdr logout;
+        logout.setString (MessageType, GW_MILLENNIUM_LOGOUT);
+        logout.setString (Reason, "logout");
+        port.sendMsg (logout);
+        port.mLoggedOn = false;
+        port.disconnect ();
+    }
+    else if (port.mRecovery && type == GW_MILLENNIUM_MISSED_MESSAGE_REQUEST)
+        handleMissedMessageRequest (port, msg);
+    else if (!port.mRecovery && type == GW_MILLENNIUM_NEW_ORDER)
+        handleNewOrder (port, msg);
+    else if (!port.mRecovery && type == GW_MILLENNIUM_ORDER_CANCEL_REQUEST)
+        handleCancel (port, msg);
+    else if (!port.mRecovery &&
+             type == GW_MILLENNIUM_ORDER_CANCEL_REPLACE_REQUEST)
+        handleReplace (port, msg);
+    else
+    {
+        cdr reject;
+        reject.setString (MessageType, GW_MILLENNIUM_REJECT);
+        reject.setInteger (RejectCode, 1);
+        reject.setString (RejectReason, "unsupported message");
+        reject.setString (RejectedMessageType, type);
+        port.sendMsg (reject);
+    }
+}
+
+template <typename CodecT>
+void
+gwcSimMillennium<CodecT>::handleMissedMessageRequest (
+    gwcSimMillenniumPort<CodecT>& port,
+    cdr& msg)
+{
+    int64_t appId = 0;
+    int64_t last = 0;
+
+    msg.getInteger (AppID, appId);
+    msg.getInteger (LastMsgSeqNum, last);
+
+    /* unknown partitions get a non zero ack and no download */
+    cdr ack;
+    ack.setString (MessageType, GW_MILLENNIUM_MISSED_MESSAGE_REQUEST_ACK);
+    ack.setInteger (ResponseType, appId == mAppId ? 0 : 1);
+    port.sendMsg (ack);
+    if (appId != mAppId)
+        return;
+
+    pthread_mutex_lock (&mJournalLock);
+    uint64_t end = mJournal.last ();
+    for (uint64_t seqno = last + 1; seqno <= end; seqno++)
+    {
+        const cdr* sent = mJournal.find (seqno);
+        if (sent == NULL)
+            continue;
+
+        cdr resend (*sent);
+        port.sendMsg (resend);
+    }
+    pthread_mutex_unlock (&mJournalLock);
+
+    cdr report;
+    report.setString (MessageType, GW_MILLENNIUM_MISSED_MESSAGE_REPORT);
+    report.setInteger (ResponseType, 0);
+    port.sendMsg (report);
+}
+
+template <typename CodecT>
+void
+gwcSimMillennium<CodecT>::handleNewOrder (gwcSimMillenniumPort<CodecT>& port,
+                                          cdr& msg)
+{
+    string  clOrdId;
+    int64_t qty = 0;
+
+    msg.getString (ClientOrderID, clOrdId);
+    msg.getInteger (OrderQty, qty);
+
+    if (port.findOrder (clOrdId) != NULL || qty <= 0)
+    {
+        gwcSimOrder rejected;
+        rejected.mClOrdId = clOrdId;
+        rejected.mOrderId = 0;
+        rejected.mQty = qty;
+        rejected.mCumQty = 0;
+        rejected.mPrice = gwcSim_getNumber (msg, LimitPrice);
+        rejected.mOpen = false;
+        sendExecution (port, rejected, '8', '8', "", 0);
+        return;
+    }
+
+    gwcSimOrder& order = port.addOrder (clOrdId,
+                                        qty,
+                                        gwcSim_getNumber (msg, LimitPrice));
+    sendExecution (port, order, '0', '0', "", 0);
+
+    if (port.mAutoFill)
+    {
+        int64_t lastQty = order.mQty - order.mCumQty;
+        order.mCumQty = order.mQty;
+        order.mOpen = false;
+        sendExecution (port, order, 'F', '2', "", lastQty);
+    }
+}
+
+template <typename CodecT>
+void
+gwcSimMillennium<CodecT>::handleCancel (gwcSimMillenniumPort<CodecT>& port,
+                                        cdr& msg)
+{
+    string clOrdId;
+    string origClOrdId;
+
+    msg.getString (ClientOrderID, clOrdId);
+    msg.getString (OriginalClientOrderID, origClOrdId);
+
+    gwcSimOrder* order = port.findOrder (origClOrdId);
+    if (order == NULL)
+    {
+        sendCancelReject (port, msg);
+        return;
+    }
+
+    order->mOpen = false;
+    gwcSimOrder cancelled = *order;
+    cancelled.mClOrdId = clOrdId;
+    sendExecution (port, cancelled, '4', '4', origClOrdId, 0);
+}
+
+template <typename CodecT>
+void
+gwcSimMillennium<CodecT>::handleReplace (gwcSimMillenniumPort<CodecT>& port,
+                                         cdr& msg)
+{
+    string  clOrdId;
+    string  origClOrdId;
+    int64_t qty = 0;
+
+    msg.getString (ClientOrderID, clOrdId);
+    msg.getString (OriginalClientOrderID, origClOrdId);
+    msg.getInteger (OrderQty, qty);
+
+    gwcSimOrder* order = port.findOrder (origClOrdId);
+    if (order == NULL || qty <= order->mCumQty)
+    {
+        sendCancelReject (port, msg);
+        return;
+    }
+
+    gwcSimOrder replaced = *order;
+    order->mOpen = false;
+    replaced.mClOrdId = clOrdId;
+    replaced.mQty = qty;
+    if (msg.contains (LimitPrice))
+        replaced.mPrice = gwcSim_getNumber (msg, LimitPrice);
+    port.mOrders[clOrdId] = replaced;
+
+    sendExecution (port, replaced, '5', '0', origClOrdId, 0);
+}
+
+template <typename CodecT>
+void
+gwcSimMillennium<CodecT>::sendExecution (gwcSimMillenniumPort<CodecT>& port,
+                                         const gwcSimOrder& order,
+                                         char execType,
+                                         char orderStatus,
+                                         const string& origClOrdId,
+                                         int64_t lastQty)
+{
+    cdr exec;
+    exec.setString (MessageType, GW_MILLENNIUM_EXECUTION_REPORT);
+    exec.setString (ExecutionID,
+                    "%llu",
+                    (unsigned long long)port.nextExecId ());
+    exec.setString (ClientOrderID, order.mClOrdId);
+    if (!origClOrdId.empty ())
+        exec.setString (OriginalClientOrderID, origClOrdId);
+    exec.setString (OrderID, "%llu", (unsigned long long)order.mOrderId);
+    exec.setInteger (ExecType, execType);
+    exec.setInteger (OrderStatus, orderStatus);
+    exec.setInteger (LeavesQty,
+                     order.mOpen ? order.mQty - order.mCumQty : 0);
+    if (lastQty > 0)
+    {
+        exec.setInteger (ExecutedQty, lastQty);
+        exec.setDouble (ExecutedPrice, order.mPrice);
+    }
+    sendApp (port, exec);
+}
+
+template <typename CodecT>
+void
+gwcSimMillennium<CodecT>::sendCancelReject (gwcSimMillenniumPort<CodecT>& port,
+                                            cdr& msg)
+{
+    string clOrdId;
+
+    msg.getString (ClientOrderID, clOrdId);
+
+    cdr reject;
+    reject.setString (MessageType, GW_MILLENNIUM_ORDER_CANCEL_REJECT);
+    reject.setString (ClientOrderID, clOrdId);
+    reject.setString (OrderID, "NONE");
+    reject.setInteger (CancelRejectReason, 2000); // unknown order
+    sendApp (port, reject);
+}
+
+template <typename CodecT>
+void
+gwcSimMillennium<CodecT>::sendApp (gwcSimMillenniumPort<CodecT>& port,
+                                   cdr& msg)
+{
+    pthread_mutex_lock (&mJournalLock);
+    uint64_t seqno = mJournal.last () + 1;
+    msg.setInteger (AppID, mAppId);
+    msg.setInteger (SequenceNo, seqno);
+    mJournal.add (seqno, msg);
+    pthread_mutex_unlock (&mJournalLock);
+
+    port.sendMsg (msg);
+}
+
+// lse
+template class gwcSimMillenniumPort<neueda::lseCodec>;
+template class gwcSimMillennium<neueda::lseCodec>;
+
+// oslo
+template class gwcSimMillenniumPort<neueda::osloCodec>;
+template class gwcSimMillennium<neueda::osloCodec>;
+
+// turquoise
+template class gwcSimMillenniumPort<neueda::turquoiseCodec>;
+template class gwcSimMillennium<neueda::turquoiseCodec>;
@@ -0,0 +1,97 @@
+#pragma once
+/*
+ * Millennium venue for lse, oslo and turquoise, a real-time port taking
+ * logons, heartbeats and orders and a recovery port answering missed
+ * message requests from the execution reports the real-time port sent.
+ */
+
+#include "gwcSimServer.h"
+#include "lseCodec.h"
+#include "osloCodec.h"
+#include "turquoiseCodec.h"
+
+template <typename CodecT> class gwcSimMillennium;
+
+template <typename CodecT>
+class gwcSimMillenniumPort : public gwcSimServer
+{
+public:
+    gwcSimMillenniumPort (gwcSimMillennium<CodecT>* sim,
+                          logger* log,
+                          const string& name,
+                          bool recovery);
+    ~gwcSimMillenniumPort ();
+
+    void sendMsg (cdr& msg);
+
+protected:
+    void onConnect ();
+    size_t onRead (const void* data, size_t size);
+    void onTimer ();
+
+private:
+    friend class gwcSimMillennium<CodecT>;
+
+    gwcSimMillennium<CodecT>* mSim;
+    CodecT                    mCodec;
+    bool                      mRecovery;
+    bool                      mLoggedOn;
+    int                       mSinceHb;
+};
+
+template <typename CodecT>
+class gwcSimMillennium
+{
+public:
+    gwcSimMillennium (logger* log, const string& name);
+    ~gwcSimMillennium ();
+
+    /* app_id defaults to 1, auto_fill as gwcSimServer */
+    bool init (const properties& props, string& err);
+
+    /* Real-time and recovery ports, 0 picks a free one */
+    bool start (const string& host,
+                uint16_t port,
+                uint16_t recoveryPort,
+                string& err);
+    void stop ();
+
+    uint16_t getPort () const
+    {
+        return mRealTime.getPort ();
+    }
+
+    uint16_t getRecoveryPort () const
+    {
+        return mRecovery.getPort ();
+    }
+
+private:
+    friend class gwcSimMillenniumPort<CodecT>;
+
+    void handleMsg (gwcSimMillenniumPort<CodecT>& port, cdr& msg);
+    void handleMissedMessageRequest (gwcSimMillenniumPort<CodecT>& port,
+                                     cdr& msg);
+    void handleNewOrder (gwcSimMillenniumPort<CodecT>& port, cdr& msg);
+    void handleCancel (gwcSimMillenniumPort<CodecT>& port, cdr& msg);
+    void handleReplace (gwcSimMillenniumPort<CodecT>& port, cdr& msg);
+
+    void sendExecution (gwcSimMillenniumPort<CodecT>& port,
+                        const gwcSimOrder& order,
+                        char execType,
+                        char orderStatus,
+                        const string& origClOrdId,
+                        int64_t lastQty);
+    void sendCancelReject (gwcSimMillenniumPort<CodecT>& port, cdr& msg);
+
+    /* Execution reports take the next SequenceNo and are journaled, the
+       recovery port reads the journal from its own thread */
+    void sendApp (gwcSimMillenniumPort<CodecT>& port, cdr& msg);
+
+    logger*                      mLog;
+    int64_t                      mAppId;
+    gwcSimMillenniumPort<CodecT> mRealTime;
+    gwcSimMillenniumPort<CodecT> mRecovery;
+    pthread_mutex_t              mJournalLock;
+    gwcSimJournal                mJournal;
+};
@@ -0,0 +1,307 @@
+#include "gwcSimOptiq.h"
+#include "fields.h"
+#include "optiqConstants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+gwcSimOptiq::gwcSimOptiq (logger* log) :
+    gwcSimServer (log, "optiq"),
+    mLastClMsgSeqNum (0),
+    mLoggedOn (false),
+    mSent (false)
+{
+}
+
+gwcSimOptiq::~gwcSimOptiq ()
+{
+    stop ();
+}
+
+void
+gwcSimOptiq::onConnect ()
+{
+    mLoggedOn = false;
+    mSent = false;
+}
+
+size_t
+gwcSimOptiq::onRead (const void* data, size_t size)
+{
+    const char* p = (const char*)data;
+    size_t      left = size;
+    cdr         msg;
+
+    while (left > 0)
+    {
+        size_t used = 0;
+        switch (mCodec.decode (msg, p, left, used))
+        {
+        case GW_CODEC_SHORT:
+            return size - left;
+
+        case GW_CODEC_SUCCESS:
+            mLog->debug ("optiq simulator msg in..");
+            mLog->debug ("%s", msg.toString ().c_str ());
+            handleMsg (msg);
+            break;
+
+        default:
+            mLog->err ("optiq simulator failed to decode [%s]",
+                       mCodec.getLastError ().c_str ());
+            disconnect ();
+            return size;
+        }
+        p += used;
+        left -= used;
+        msg.clear ();
+    }
+    return size - left;
+}
+
+void
+gwcSimOptiq::onTimer ()
+{
+    /* sbe sessions heartbeat every second when idle */
+    if (mLoggedOn && !mSent)
+    {
+        cdr hb;
+        hb.setInteger (TemplateId, OptiqHeartbeatTemplateId);
+        sendMsg (mCodec, hb);
+    }
+    mSent = false;
+}
+
+void
+gwcSimOptiq::handleMsg (cdr& msg)
+{
+    int64_t templateId = 0;
+    int64_t seqno = 0;
+
+    msg.getInteger (TemplateId, templateId);
+
+    if (templateId == OptiqLogonTemplateId)
+    {
+        handleLogon (msg);
+        return;
+    }
+    if (!mLoggedOn)
+    {
+        mLog->warn ("optiq simulator message before logon");
+        disconnect ();
+        return;
+    }
+
+    if (msg.getInteger (ClMsgSeqNum, seqno) && seqno > 0)
+        mLastClMsgSeqNum = seqno;
+
+    switch (templateId)
+    {
+    case OptiqHeartbeatTemplateId:
+        break;
+    case OptiqTestRequestTemplateId:
+    {
+        cdr hb;
+        hb.setInteger (TemplateId, OptiqHeartbeatTemplateId);
+        sendMsg (mCodec, hb);
+        mSent = true;
+    }
+        break;
+    case OptiqLogoutTemplateId:
+    {
+        cdr logout;
+        logout.setInteger (TemplateId, OptiqLogoutTemplateId);
+        logout.setInteger (LogOutReasonCode,
+                           OPTIQ_LOGOUTREASONCODE_REGULAR_LOGOUT);
+        sendMsg (mCodec, logout);
+        mLoggedOn = false;
+        disconnect ();
+    }
+        break;
+    case OptiqNewOrderTemplateId:
+        handleNewOrder (msg);
+        break;
+    case OptiqCancelRequestTemplateId:
+        handleCancel (msg);
+        break;
+    case OptiqCancelReplaceTemplateId:
+        handleReplace (msg);
+        break;
+    default:
+        mLog->warn ("optiq simulator ignoring template %lld",
+                    (long long)templateId);
+        break;
+    }
+}
+
+void
+gwcSimOptiq::handleLogon (cdr& msg)
+{
+    int64_t  lastMsgSeqNum = -1;
+    uint64_t end = mJournal.last ();
+
+    mLoggedOn = true;
+
+    cdr ack;
+    ack.setInteger (TemplateId, OptiqLogonAckTemplateId);
+    ack.setInteger (SchemaId, 0);
+    ack.setInteger (Version, 0);
+    ack.setInteger (LastClMsgSeqNum, mLastClMsgSeqNum);
+    sendMsg (mCodec, ack);
+    mSent = true;
+
+    /* no LastMsgSeqNum means the client doesn't want a replay */
+    if (!msg.getInteger (LastMsgSeqNum, lastMsgSeqNum) || lastMsgSeqNum < 0)
+        return;
+
+    for (uint64_t seqno = lastMsgSeqNum + 1; seqno <= end; seqno++)
+    {
+        const cdr* sent = mJournal.find (seqno);
+        if (sent == NULL)
+            continue;
+
+        cdr resend (*sent);
+        sendMsg (mCodec, resend);
+    }
+}
+
+void
+gwcSimOptiq::handleNewOrder (cdr& msg)
+{
+    int64_t clOrdId = 0;
+    int64_t qty = 0;
+    char    key[32];
+
+    msg.getInteger (ClientOrderID, clOrdId);
+    msg.getInteger (OrderQty, qty);
+    snprintf (key, sizeof key, "%lld", (long long)clOrdId);
+
+    if (findOrder (key) != NULL || qty <= 0)
+    {
+        sendReject (OptiqNewOrderTemplateId, msg);
+        return;
+    }
+
+    gwcSimOrder& order = addOrder (key, qty, gwcSim_getNumber (msg, OrderPx));
+
+    cdr ack;
+    ack.setInteger (TemplateId, OptiqAckTemplateId);
+    ack.setInteger (AckType, OPTIQ_ACKTYPE_NEW_ORDER_ACK);
+    ack.setInteger (ClientOrderID, clOrdId);
+    ack.setInteger (OrderID, order.mOrderId);
+    ack.setInteger (OrderPx, (int64_t)order.mPrice);
+    ack.setInteger (OrderQty, order.mQty);
+    sendApp (ack);
+
+    if (mAutoFill)
+    {
+        int64_t lastQty = order.mQty - order.mCumQty;
+        order.mCumQty = order.mQty;
+        order.mOpen = false;
+        sendExecution (OptiqFillTemplateId, order, lastQty);
+    }
+}
+
+void
+gwcSimOptiq::handleCancel (cdr& msg)
+{
+    int64_t origClOrdId = 0;
+    char    key[32];
+
+    msg.getInteger (OrigClientOrderID, origClOrdId);
+    snprintf (key, sizeof key, "%lld", (long long)origClOrdId);
+
+    gwcSimOrder* order = findOrder (key);
+    if (order == NULL)
+    {
+        sendReject (OptiqCancelRequestTemplateId, msg);
+        return;
+    }
+
+    order->mOpen = false;
+    sendExecution (OptiqKillTemplateId, *order, 0);
+}
+
+void
+gwcSimOptiq::handleReplace (cdr& msg)
+{
+    int64_t clOrdId = 0;
+    int64_t origClOrdId = 0;
+    int64_t qty = 0;
+    char    key[32];
+
+    msg.getInteger (ClientOrderID, clOrdId);
+    msg.getInteger (OrigClientOrderID, origClOrdId);
+    msg.getInteger (OrderQty, qty);
+    snprintf (key, sizeof key, "%lld", (long long)origClOrdId);
+
+    gwcSimOrder* order = findOrder (key);
+    if (order == NULL || qty <= order->mCumQty)
+    {
+        sendReject (OptiqCancelReplaceTemplateId, msg);
+        return;
+    }
+
+    gwcSimOrder replaced = *order;
+    order->mOpen = false;
+    snprintf (key, sizeof key, "%lld", (long long)clOrdId);
+    replaced.mClOrdId = key;
+    replaced.mQty = qty;
+    if (msg.contains (OrderPx))
+        replaced.mPrice = gwcSim_getNumber (msg, OrderPx);
+    mOrders[key] = replaced;
+
+    cdr ack;
+    ack.setInteger (TemplateId, OptiqAckTemplateId);
+    ack.setInteger (AckType, OPTIQ_ACKTYPE_REPLACE_ACK);
+    ack.setInteger (ClientOrderID, clOrdId);
+    ack.setInteger (OrderID, replaced.mOrderId);
+    ack.setInteger (OrderPx, (int64_t)replaced.mPrice);
+    ack.setInteger (OrderQty, replaced.mQty);
+    sendApp (ack);
+}
+
+void
+gwcSimOptiq::sendExecution (int64_t templateId,
+                            const gwcSimOrder& order,
+                            int64_t lastQty)
+{
+    cdr exec;
+    exec.setInteger (TemplateId, templateId);
+    exec.setInteger (ClientOrderID, strtoll (order.mClOrdId.c_str (), NULL, 10));
+    exec.setInteger (OrderID, order.mOrderId);
+    if (lastQty > 0)
+    {
+        exec.setInteger (LastTradedQuantity, lastQty);
+        exec.setInteger (LastTradedPx, (int64_t)order.mPrice);
+        exec.setInteger (LeavesQuantity, order.mQty - order.mCumQty);
+    }
+    sendApp (exec);
+}
+
+void
+gwcSimOptiq::sendReject (int64_t rejectedId, cdr& msg)
+{
+    int64_t clOrdId = 0;
+
+    msg.getInteger (ClientOrderID, clOrdId);
+
+    cdr reject;
+    reject.setInteger (TemplateId, OptiqRejectTemplateId);
+    reject.setInteger (RejectedMessageID, rejectedId);
+    reject.setInteger (ClientOrderID, clOrdId);
+    sendApp (reject);
+}
+
+void
+gwcSimOptiq::sendApp (cdr& msg)
+{
+    uint64_t seqno = mJournal.last () + 1;
+
+    msg.setInteger (SchemaId, 0);
+    msg.setInteger (Version, 0);
+    msg.setInteger (MsgSeqNum, seqno);
+    mJournal.add (seqno, msg);
+    mSent = true;
+    sendMsg (mCodec, msg);
+}
@@ -0,0 +1,42 @@
+#pragma once
+/*
+ * Optiq OEG, logon acks carrying the last ClMsgSeqNum seen, replay of
+ * execution messages after the LastMsgSeqNum on the logon, one second
+ * heartbeats and acks, fills, kills and rejects for single orders.
+ */
+
+#include "gwcSimServer.h"
+#include "optiqCodec.h"
+
+class gwcSimOptiq : public gwcSimServer
+{
+public:
+    gwcSimOptiq (logger* log);
+    ~gwcSimOptiq ();
+
+protected:
+    void onConnect ();
+    size_t onRead (const void* data, size_t size);
+    void onTimer ();
+
+private:
+    void handleMsg (cdr& msg);
+    void handleLogon (cdr& msg);
+    void handleNewOrder (cdr& msg);
+    void handleCancel (cdr& msg);
+    void handleReplace (cdr& msg);
+
+    void sendExecution (int64_t templateId,
+                        const gwcSimOrder& order,
+                        int64_t lastQty);
+    void sendReject (int64_t rejectedId, cdr& msg);
+
+    /* Execution messages get the next MsgSeqNum and are journaled */
+    void sendApp (cdr& msg);
+
+    optiqCodec    mCodec;
+    int64_t       mLastClMsgSeqNum;
+    bool          mLoggedOn;
+    bool          mSent;
+    gwcSimJournal mJournal;
+};
@@ -0,0 +1,372 @@
+#include "gwcSimServer.h"
+#include "utils.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Read buffer, grows for messages that don't fit */
+#define GWC_SIM_BUFFER_SIZE 65536
+
+double
+gwcSim_getNumber (const cdr& msg, int key)
+{
+    double  d = 0;
+    int64_t i = 0;
+
+    if (msg.getDouble (key, d))
+        return d;
+    if (msg.getInteger (key, i))
+        return (double)i;
+    return 0;
+}
+
+gwcSimServer::gwcSimServer (logger* log, const string& name) :
+    mLog (log),
+    mName (name),
+    mAutoFill (true),
+    mListenFd (-1),
+    mFd (-1),
+    mPort (0),
+    mRunning (false),
+    mStarted (false),
+    mDisconnect (false),
+    mBuffer (GWC_SIM_BUFFER_SIZE),
+    mBuffered (0),
+    mOrderId (0),
+    mExecId (0)
+{
+    pthread_mutex_init (&mSendLock, NULL);
+}
+
+gwcSimServer::~gwcSimServer ()
+{
+    stop ();
+    pthread_mutex_destroy (&mSendLock);
+}
+
+bool
+gwcSimServer::init (const properties& props, string& err)
+{
+    string v;
+
+    props.get ("auto_fill", "true", v);
+    if (!utils_parseBool (v, mAutoFill))
+    {
+        err = "failed to parse auto_fill as bool";
+        return false;
+    }
+    return true;
+}
+
+bool
+gwcSimServer::start (const string& host, uint16_t port, string& err)
+{
+    struct sockaddr_in addr;
+    socklen_t          len = sizeof addr;
+    int                on = 1;
+
+    memset (&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons (port);
+    if (inet_pton (AF_INET, host.c_str (), &addr.sin_addr) != 1)
+    {
+        err = "invalid host " + host;
+        return false;
+    }
+
+    mListenFd = socket (AF_INET, SOCK_STREAM, 0);
+    if (mListenFd < 0)
+    {
+        err = string ("failed to create socket: ") + strerror (errno);
+        return false;
+    }
+    setsockopt (mListenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on);
+
+    if (bind (mListenFd, (struct sockaddr*)&addr, sizeof addr) != 0 ||
+        listen (mListenFd, 1) != 0 ||
+        getsockname (mListenFd, (struct sockaddr*)&addr, &len) != 0)
+    {
+        err = string ("failed to listen: ") + strerror (errno);
+        ::close (mListenFd);
+        mListenFd = -1;
+        return false;
+    }
+    mPort = ntohs (addr.sin_port);
+
+    mRunning = true;
+    if (pthread_create (&mThread, NULL, gwcSimServer::runCb, this) != 0)
+    {
+        err = "failed to start simulator thread";
+        mRunning = false;
+        ::close (mListenFd);
+        mListenFd = -1;
+        return false;
+    }
+    mStarted = true;
+
+    mLog->info ("%s simulator listening on %s:%u",
+                mName.c_str (),
+                host.c_str (),
+                mPort);
+    return true;
+}
+
+void
+gwcSimServer::stop ()
+{
+    if (!mStarted)
+        return;
+
+    mRunning = false;
+    pthread_join (mThread, NULL);
+    mStarted = false;
+
+    close ();
+    ::close (mListenFd);
+    mListenFd = -1;
+}
+
+bool
+gwcSimServer::send (const void* data, size_t len)
+{
+    const char* p = (const char*)data;
+
+    pthread_mutex_lock (&mSendLock);
+    if (mFd < 0)
+    {
+        pthread_mutex_unlock (&mSendLock);
+        return false;
+    }
+
+    while (len > 0)
+    {
+        ssize_t n = ::send (mFd, p, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+        {
+            mLog->warn ("%s simulator write failed: %s",
+                        mName.c_str (),
+                        strerror (errno));
+            pthread_mutex_unlock (&mSendLock);
+            return false;
+        }
+        p += n;
+        len -= n;
+    }
+
+    pthread_mutex_unlock (&mSendLock);
+    return true;
+}
+
+bool
+gwcSimServer::sendMsg (codec& c, cdr& msg)
+{
+    char   space[1024];
+    size_t used;
+
+    if (c.encode (msg, space, sizeof space, used) != GW_CODEC_SUCCESS)
+    {
+        mLog->err ("%s simulator failed to encode [%s]",
+                   mName.c_str (),
+                   c.getLastError ().c_str ());
+        return false;
+    }
+
+    mLog->debug ("%s simulator msg out..", mName.c_str ());
+    mLog->debug ("%s", msg.toString ().c_str ());
+    return send (space, used);
+}
+
+void
+gwcSimServer::disconnect ()
+{
+    mDisconnect = true;
+}
+
+gwcSimOrder&
+gwcSimServer::addOrder (const string& clOrdId, int64_t qty, double price)
+{
+    gwcSimOrder& order = mOrders[clOrdId];
+
+    order.mClOrdId = clOrdId;
+    order.mOrderId = ++mOrderId;
+    order.mQty = qty;
+    order.mCumQty = 0;
+    order.mPrice = price;
+    order.mOpen = true;
+    return order;
+}
+
+gwcSimOrder*
+gwcSimServer::findOrder (const string& clOrdId)
+{
+    gwcSimOrders::iterator itr = mOrders.find (clOrdId);
+    if (itr == mOrders.end () || !itr->second.mOpen)
+        return NULL;
+    return &itr->second;
+}
+
+void*
+gwcSimServer::runCb (void* closure)
+{
+    gwcSimServer* server = reinterpret_cast<gwcSimServer*>(closure);
+    server->run ();
+    return NULL;
+}
+
+void
+gwcSimServer::run ()
+{
+    time_t last = time (NULL);
+
+    while (mRunning)
+    {
+        struct pollfd fds[2];
+        nfds_t        n = 0;
+
+        fds[n].fd = mListenFd;
+        fds[n].events = POLLIN;
+        n++;
+        if (mFd >= 0)
+        {
+            fds[n].fd = mFd;
+            fds[n].events = POLLIN;
+            n++;
+        }
+
+        /* short timeout so stop is noticed */
+        int ready = poll (fds, n, 100);
+        if (ready < 0 && errno != EINTR)
+        {
+            mLog->err ("%s simulator poll failed: %s",
+                       mName.c_str (),
+                       strerror (errno));
+            break;
+        }
+
+        if (ready > 0 && (fds[0].revents & POLLIN))
+            accept ();
+
+        if (ready > 0 && n > 1 && fds[1].revents != 0)
+        {
+            if (!read ())
+                close ();
+        }
+
+        if (mDisconnect)
+            close ();
+
+        time_t now = time (NULL);
+        if (now != last)
+        {
+            last = now;
+            if (mFd >= 0)
+                onTimer ();
+        }
+    }
+}
+
+void
+gwcSimServer::accept ()
+{
+    int fd = ::accept (mListenFd, NULL, NULL);
+    if (fd < 0)
+        return;
+
+    /* a venue port serves one session */
+    if (mFd >= 0)
+    {
+        mLog->warn ("%s simulator already has a session, rejecting",
+                    mName.c_str ());
+        ::close (fd);
+        return;
+    }
+
+    int on = 1;
+    setsockopt (fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof on);
+
+    pthread_mutex_lock (&mSendLock);
+    mFd = fd;
+    pthread_mutex_unlock (&mSendLock);
+
+    mBuffered = 0;
+    mDisconnect = false;
+
+    mLog->info ("%s simulator session connected", mName.c_str ());
+    onConnect ();
+}
+
+bool
+gwcSimServer::read ()
+{
+    if (mBuffered == mBuffer.size ())
+        mBuffer.resize (mBuffer.size () * 2);
+
+    ssize_t n = recv (mFd,
+                      &mBuffer[mBuffered],
+                      mBuffer.size () - mBuffered,
+                      0);
+    if (n < 0 && (errno == EINTR || errno == EAGAIN))
+        return true;
+    if (n <= 0)
+        return false;
+    mBuffered += n;
+
+    size_t used = onRead (&mBuffer[0], mBuffered);
+    if (used > mBuffered)
+        used = mBuffered;
+
+    memmove (&mBuffer[0], &mBuffer[used], mBuffered - used);
+    mBuffered -= used;
+    return true;
+}
+
+void
+gwcSimServer::close ()
+{
+    if (mFd < 0)
+        return;
+
+    pthread_mutex_lock (&mSendLock);
+    ::close (mFd);
+    mFd = -1;
+    pthread_mutex_unlock (&mSendLock);
+
+    mDisconnect = false;
+    mBuffered = 0;
+
+    mLog->info ("%s simulator session disconnected", mName.c_str ());
+    onDisconnect ();
+}
+
+void
+gwcSimJournal::add (uint64_t seqno, const cdr& msg)
+{
+    mMsgs[seqno] = msg;
+}
+
+const cdr*
+gwcSimJournal::find (uint64_t seqno) const
+{
+    map<uint64_t, cdr>::const_iterator itr = mMsgs.find (seqno);
+    if (itr == mMsgs.end ())
+        return NULL;
+    return &itr->second;
+}
+
+uint64_t
+gwcSimJournal::last () const
+{
+    if (mMsgs.empty ())
+        return 0;
+    return mMsgs.rbegin ()->first;
+}
@@ -0,0 +1,136 @@
+#pragma once
+/*
+ * Loopback venue for one session at a time. The listener and the session
+ * run on one thread, protocol simulators derive from gwcSimServer and
+ * handle reads, timers and sends on it.
+ */
+
+#include "codec.h"
+#include "cdr.h"
+#include "logger.h"
+#include "properties.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace neueda;
+
+/* Order state shared by the simulators, fills are for the full quantity at
+   the order price unless auto fill is off */
+struct gwcSimOrder
+{
+    string   mClOrdId;
+    uint64_t mOrderId;
+    int64_t  mQty;
+    int64_t  mCumQty;
+    double   mPrice;
+    bool     mOpen;
+};
+
+typedef map<string, gwcSimOrder> gwcSimOrders;
+
+/* Numeric field as a double whether the codec holds a float or an integer,
+   0 if missing */
+double gwcSim_getNumber (const cdr& msg, int key);
+
+class gwcSimServer
+{
+public:
+    gwcSimServer (logger* log, const string& name);
+    virtual ~gwcSimServer ();
+
+    /* Options common to the simulators, auto_fill defaults to true */
+    virtual bool init (const properties& props, string& err);
+
+    /* Listen on host:port, port 0 picks a free one, see getPort */
+    bool start (const string& host, uint16_t port, string& err);
+    void stop ();
+
+    uint16_t getPort () const
+    {
+        return mPort;
+    }
+
+    bool isConnected () const
+    {
+        return mFd >= 0;
+    }
+
+    /* Write to the connected session, false if there isn't one */
+    bool send (const void* data, size_t len);
+
+    /* Encode and write msg */
+    bool sendMsg (codec& c, cdr& msg);
+
+protected:
+    /* Session connected or gone, on the server thread */
+    virtual void onConnect () {}
+    virtual void onDisconnect () {}
+
+    /* Bytes read, returns how many were used */
+    virtual size_t onRead (const void* data, size_t size) = 0;
+
+    /* About once a second while a session is connected */
+    virtual void onTimer () {}
+
+    /* Drop the session once pending writes are done */
+    void disconnect ();
+
+    /* Orders by client order id */
+    gwcSimOrder& addOrder (const string& clOrdId, int64_t qty, double price);
+    gwcSimOrder* findOrder (const string& clOrdId);
+
+    uint64_t nextExecId ()
+    {
+        return ++mExecId;
+    }
+
+    logger*      mLog;
+    string       mName;
+    bool         mAutoFill;
+    gwcSimOrders mOrders;
+
+private:
+    static void* runCb (void* closure);
+    void run ();
+    void accept ();
+    bool read ();
+    void close ();
+
+    int             mListenFd;
+    int             mFd;
+    uint16_t        mPort;
+    volatile bool   mRunning;
+    bool            mStarted;
+    bool            mDisconnect;
+    pthread_t       mThread;
+    pthread_mutex_t mSendLock;
+    vector<char>    mBuffer;
+    size_t          mBuffered;
+    uint64_t        mOrderId;
+    uint64_t        mExecId;
+};
+
+/* Sequenced messages a simulator has sent, kept for replay */
+class gwcSimJournal
+{
+public:
+    void add (uint64_t seqno, const cdr& msg);
+
+    /* Message sent with seqno, NULL if it wasn't an application message */
+    const cdr* find (uint64_t seqno) const;
+
+    uint64_t last () const;
+
+    void clear ()
+    {
+        mMsgs.clear ();
+    }
+
+private:
+    map<uint64_t, cdr> mMsgs;
+};
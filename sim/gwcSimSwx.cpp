@@ -0,0 +1,346 @@
+#include "gwcSimSwx.h"
+#include "fields.h"
+#include "swxCodecConstants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define GWC_SOUP_BIN_LOGIN_ACCEPTED_MESSAGE_TYPE 'A'
+#define GWC_SOUP_BIN_LOGIN_REJECTED_MESSAGE_TYPE 'J'
+#define GWC_SOUP_BIN_CLIENT_HEART_BEAT_MESSAGE_TYPE 'R'
+#define GWC_SOUP_BIN_SERVER_HEART_BEAT_MESSAGE_TYPE 'H'
+#define GWC_SOUP_BIN_LOGIN_REQUEST_MESSAGE_TYPE 'L'
+#define GWC_SOUP_BIN_LOGOUT_REQUEST_MESSAGE_TYPE 'O'
+#define GWC_SOUP_BIN_SEQUENCED_MESSAGE_TYPE 'S'
+#define GWC_SOUP_BIN_UNSEQUENCED_MESSAGE_TYPE 'U'
+
+/* Order tokens are numbers on the wire, orders are kept by their decimal
+   string */
+static string
+getToken (const cdr& msg, int key)
+{
+    int64_t token = 0;
+    char    s[32];
+
+    msg.getInteger (key, token);
+    snprintf (s, sizeof s, "%lld", (long long)token);
+    return s;
+}
+
+gwcSimSwx::gwcSimSwx (logger* log) :
+    gwcSimServer (log, "swx"),
+    mSession ("SIM"),
+    mLoggedOn (false),
+    mSent (false)
+{
+}
+
+gwcSimSwx::~gwcSimSwx ()
+{
+    stop ();
+}
+
+bool
+gwcSimSwx::init (const properties& props, string& err)
+{
+    if (!gwcSimServer::init (props, err))
+        return false;
+
+    props.get ("session", "SIM", mSession);
+    if (mSession.size () > 10)
+    {
+        err = "session must be at most 10 characters";
+        return false;
+    }
+    return true;
+}
+
+void
+gwcSimSwx::onConnect ()
+{
+    mLoggedOn = false;
+    mSent = false;
+}
+
+size_t
+gwcSimSwx::onRead (const void* data, size_t size)
+{
+    const char* p = (const char*)data;
+    size_t      left = size;
+    cdr         msg;
+
+    while (left > 0)
+    {
+        size_t used = 0;
+        switch (mCodec.decode (msg, p, left, used))
+        {
+        case GW_CODEC_SHORT:
+            return size - left;
+
+        case GW_CODEC_SUCCESS:
+            mLog->debug ("swx simulator msg in..");
+            mLog->debug ("%s", msg.toString ().c_str ());
+            handleMsg (msg);
+            break;
+
+        default:
+            mLog->err ("swx simulator failed to decode [%s]",
+                       mCodec.getLastError ().c_str ());
+            disconnect ();
+            return size;
+        }
+        p += used;
+        left -= used;
+        msg.clear ();
+    }
+    return size - left;
+}
+
+void
+gwcSimSwx::onTimer ()
+{
+    if (mLoggedOn && !mSent)
+        sendSession (GWC_SOUP_BIN_SERVER_HEART_BEAT_MESSAGE_TYPE);
+    mSent = false;
+}
+
+void
+gwcSimSwx::handleMsg (cdr& msg)
+{
+    string messageType;
+    string type;
+
+    msg.getString (MessageType, messageType);
+    if (messageType.empty ())
+        return;
+
+    if (messageType[0] == GWC_SOUP_BIN_LOGIN_REQUEST_MESSAGE_TYPE)
+    {
+        handleLogin (msg);
+        return;
+    }
+    if (!mLoggedOn)
+    {
+        mLog->warn ("swx simulator message before login");
+        disconnect ();
+        return;
+    }
+
+    switch (messageType[0])
+    {
+    case GWC_SOUP_BIN_CLIENT_HEART_BEAT_MESSAGE_TYPE:
+        return;
+
+    case GWC_SOUP_BIN_LOGOUT_REQUEST_MESSAGE_TYPE:
+        /* soupbin servers just close the session */
+        mLoggedOn = false;
+        disconnect ();
+        return;
+
+    case GWC_SOUP_BIN_UNSEQUENCED_MESSAGE_TYPE:
+        break;
+
+    default:
+        mLog->warn ("swx simulator ignoring message type %s",
+                    messageType.c_str ());
+        return;
+    }
+
+    msg.getString (Type, type);
+    if (type.empty ())
+        return;
+
+    switch (type[0])
+    {
+    case SWX_ENTER_ORDER_MESSAGE_TYPE:
+        handleEnterOrder (msg);
+        break;
+    case SWX_CANCEL_ORDER_MESSAGE_TYPE:
+        handleCancelOrder (msg);
+        break;
+    case SWX_REPLACE_ORDER_MESSAGE_TYPE:
+        handleReplaceOrder (msg);
+        break;
+    default:
+        mLog->warn ("swx simulator ignoring type %s", type.c_str ());
+        break;
+    }
+}
+
+void
+gwcSimSwx::handleLogin (cdr& msg)
+{
+    string  session;
+    int64_t requested = 0;
+
+    msg.getString (RequestedSession, session);
+    msg.getInteger (RequestedSequenceNumber, requested);
+
+    /* blank session means the current one */
+    size_t end = session.find_last_not_of (' ');
+    session = end == string::npos ? "" : session.substr (0, end + 1);
+    if (!session.empty () && session != mSession)
+    {
+        cdr reject;
+        reject.setString (MessageType,
+                          "%c",
+                          GWC_SOUP_BIN_LOGIN_REJECTED_MESSAGE_TYPE);
+        reject.setString (RejectReasonCode, "S");
+        sendMsg (mCodec, reject);
+        disconnect ();
+        return;
+    }
+
+    mLoggedOn = true;
+
+    cdr accepted;
+    accepted.setString (MessageType,
+                        "%c",
+                        GWC_SOUP_BIN_LOGIN_ACCEPTED_MESSAGE_TYPE);
+    accepted.setString (Session, mSession);
+    accepted.setInteger (SequenceNumber, requested + 1);
+    sendMsg (mCodec, accepted);
+    mSent = true;
+
+    uint64_t last = mJournal.last ();
+    for (uint64_t seqno = requested + 1; seqno <= last; seqno++)
+    {
+        const cdr* sent = mJournal.find (seqno);
+        if (sent == NULL)
+            continue;
+
+        cdr resend (*sent);
+        sendMsg (mCodec, resend);
+    }
+}
+
+void
+gwcSimSwx::handleEnterOrder (cdr& msg)
+{
+    string  token = getToken (msg, OrderToken);
+    int64_t qty = 0;
+
+    msg.getInteger (OrderQuantity, qty);
+
+    if (findOrder (token) != NULL || qty <= 0)
+    {
+        cdr rejected;
+        rejected.setString (Type, "%c", SWX_REJECTED_ORDER_MESSAGE_TYPE);
+        rejected.setInteger (OrderToken,
+                             strtoll (token.c_str (), NULL, 10));
+        rejected.setString (Reason, "D");
+        sendSequenced (rejected);
+        return;
+    }
+
+    gwcSimOrder& order = addOrder (token,
+                                   qty,
+                                   gwcSim_getNumber (msg, OrderPrice));
+    sendOrder (SWX_ACCEPTED_MESSAGE_TYPE, order);
+
+    if (mAutoFill)
+    {
+        int64_t lastQty = order.mQty - order.mCumQty;
+        order.mCumQty = order.mQty;
+        order.mOpen = false;
+
+        cdr executed;
+        executed.setString (Type, "%c", SWX_EXECUTED_ORDER_MESSAGE_TYPE);
+        executed.setInteger (OrderToken,
+                             strtoll (order.mClOrdId.c_str (), NULL, 10));
+        executed.setInteger (ExecutedQuantity, lastQty);
+        executed.setInteger (ExecutionPrice, (int64_t)order.mPrice);
+        executed.setInteger (MatchNumber, nextExecId ());
+        sendSequenced (executed);
+    }
+}
+
+void
+gwcSimSwx::handleCancelOrder (cdr& msg)
+{
+    string token = getToken (msg, OriginalOrderToken);
+
+    gwcSimOrder* order = findOrder (token);
+    if (order == NULL)
+    {
+        mLog->warn ("swx simulator cancel for unknown order %s",
+                    token.c_str ());
+        return;
+    }
+
+    order->mOpen = false;
+
+    cdr cancelled;
+    cancelled.setString (Type, "%c", SWX_CANCELLED_MESSAGE_TYPE);
+    cancelled.setInteger (OrderToken, strtoll (token.c_str (), NULL, 10));
+    cancelled.setInteger (DecrementQuantity, order->mQty - order->mCumQty);
+    cancelled.setString (Reason, "U");
+    sendSequenced (cancelled);
+}
+
+void
+gwcSimSwx::handleReplaceOrder (cdr& msg)
+{
+    string  existing = getToken (msg, ExistingOrderToken);
+    string  replacement = getToken (msg, ReplacementOrderToken);
+    int64_t qty = 0;
+
+    msg.getInteger (OrderQuantity, qty);
+
+    gwcSimOrder* order = findOrder (existing);
+    if (order == NULL || qty <= order->mCumQty)
+    {
+        mLog->warn ("swx simulator replace for unknown order %s",
+                    existing.c_str ());
+        return;
+    }
+
+    gwcSimOrder replaced = *order;
+    order->mOpen = false;
+    replaced.mClOrdId = replacement;
+    replaced.mQty = qty;
+    if (msg.contains (OrderPrice))
+        replaced.mPrice = gwcSim_getNumber (msg, OrderPrice);
+    mOrders[replacement] = replaced;
+
+    cdr ack;
+    ack.setString (Type, "%c", SWX_REPLACED_MESSAGE_TYPE);
+    ack.setInteger (ReplacementOrderToken,
+                    strtoll (replacement.c_str (), NULL, 10));
+    ack.setInteger (PreviousOrderToken,
+                    strtoll (existing.c_str (), NULL, 10));
+    ack.setInteger (OrderQuantity, replaced.mQty);
+    ack.setInteger (OrderPrice, (int64_t)replaced.mPrice);
+    sendSequenced (ack);
+}
+
+void
+gwcSimSwx::sendSession (char type)
+{
+    cdr msg;
+    msg.setString (MessageType, "%c", type);
+    sendMsg (mCodec, msg);
+    mSent = true;
+}
+
+void
+gwcSimSwx::sendOrder (char type, const gwcSimOrder& order)
+{
+    cdr msg;
+    msg.setString (Type, "%c", type);
+    msg.setInteger (OrderToken,
+                    strtoll (order.mClOrdId.c_str (), NULL, 10));
+    msg.setInteger (OrderQuantity, order.mQty);
+    msg.setInteger (OrderPrice, (int64_t)order.mPrice);
+    msg.setInteger (OrderReferenceNumber, order.mOrderId);
+    sendSequenced (msg);
+}
+
+void
+gwcSimSwx::sendSequenced (cdr& msg)
+{
+    msg.setString (MessageType, "%c", GWC_SOUP_BIN_SEQUENCED_MESSAGE_TYPE);
+    mJournal.add (mJournal.last () + 1, msg);
+    sendMsg (mCodec, msg);
+    mSent = true;
+}
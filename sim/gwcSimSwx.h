@@ -0,0 +1,44 @@
+#pragma once
+/*
+ * SoupBin session with SWX OUCH orders, logins are accepted and replay the
+ * sequenced messages after RequestedSequenceNumber, which like the
+ * connector counts messages already received. Server heartbeats every
+ * second when idle, orders are accepted, executed, cancelled and replaced.
+ */
+
+#include "gwcSimServer.h"
+#include "swxCodec.h"
+
+class gwcSimSwx : public gwcSimServer
+{
+public:
+    gwcSimSwx (logger* log);
+    ~gwcSimSwx ();
+
+    /* session defaults to SIM */
+    bool init (const properties& props, string& err);
+
+protected:
+    void onConnect ();
+    size_t onRead (const void* data, size_t size);
+    void onTimer ();
+
+private:
+    void handleMsg (cdr& msg);
+    void handleLogin (cdr& msg);
+    void handleEnterOrder (cdr& msg);
+    void handleCancelOrder (cdr& msg);
+    void handleReplaceOrder (cdr& msg);
+
+    void sendSession (char type);
+    void sendOrder (char type, const gwcSimOrder& order);
+
+    /* Sequenced messages are journaled for login replays */
+    void sendSequenced (cdr& msg);
+
+    swxCodec      mCodec;
+    string        mSession;
+    bool          mLoggedOn;
+    bool          mSent;
+    gwcSimJournal mJournal;
+};
@@ -0,0 +1,386 @@
+#pragma once
+/*
+ * Connector side of each simulator, starts it on a free loopback port and
+ * fills in the connector properties, logon and the venue specific order
+ * and cancel fields. Shared by fosdk-bench and the round trip tests.
+ */
+
+#include "gwcCommon.h"
+#include "fields.h"
+#include "optiqConstants.h"
+#include "swxCodecConstants.h"
+
+#include "gwcSimEti.h"
+#include "gwcSimFix.h"
+#include "gwcSimMillennium.h"
+#include "gwcSimOptiq.h"
+#include "gwcSimSwx.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Order and cancel ids are numbers on every venue */
+class gwcSimVenue
+{
+public:
+    virtual ~gwcSimVenue () {}
+
+    /* Connector type for gwcConnectorFactory */
+    virtual const char* type () const = 0;
+
+    /* Start the simulator and point the connector at it */
+    virtual bool start (const properties& opts,
+                        properties& props,
+                        string& err) = 0;
+
+    virtual void onLoggingOn (cdr& msg) {}
+
+    virtual void order (gwcOrder& order, uint64_t id) = 0;
+    virtual void cancel (cdr& cancel, uint64_t id, uint64_t origId) = 0;
+
+    /* Order or cancel id the venue echoes back */
+    virtual uint64_t id (const cdr& msg) const = 0;
+
+    /* Venues that report a cancel through onMsg */
+    virtual bool isCancelDone (const cdr& msg) const
+    {
+        return false;
+    }
+
+protected:
+    static string host (uint16_t port)
+    {
+        char s[32];
+        snprintf (s, sizeof s, "127.0.0.1:%u", port);
+        return s;
+    }
+
+    static string str (uint64_t id)
+    {
+        char s[32];
+        snprintf (s, sizeof s, "%llu", (unsigned long long)id);
+        return s;
+    }
+
+    static uint64_t strId (const cdr& msg, int key)
+    {
+        string s;
+        msg.getString (key, s);
+        return strtoull (s.c_str (), NULL, 10);
+    }
+
+    static uint64_t intId (const cdr& msg, int key)
+    {
+        int64_t id = 0;
+        msg.getInteger (key, id);
+        return id;
+    }
+};
+
+class gwcSimVenueMillennium : public gwcSimVenue
+{
+public:
+    gwcSimVenueMillennium (logger* log) : mSim (log, "lse") {}
+
+    const char* type () const
+    {
+        return "millennium";
+    }
+
+    bool start (const properties& opts, properties& props, string& err)
+    {
+        if (!mSim.init (opts, err) || !mSim.start ("127.0.0.1", 0, 0, err))
+            return false;
+        props.setProperty ("venue", "lse");
+        props.setProperty ("real_time_host", host (mSim.getPort ()));
+        props.setProperty ("recovery_host", host (mSim.getRecoveryPort ()));
+        return true;
+    }
+
+    void onLoggingOn (cdr& msg)
+    {
+        msg.setString (UserName, "FOSDK");
+        msg.setString (Password, "FOSDK");
+    }
+
+    void order (gwcOrder& order, uint64_t id)
+    {
+        order.setString (ClientOrderID, str (id));
+        order.setInteger (InstrumentID, 133215);
+        order.setInteger (AutoCancel, 1);
+        order.setString (TraderID, "TX1");
+        order.setString (Account, "account");
+        order.setInteger (ClearingAccount, 1);
+        order.setInteger (ExpireDateTime, 0);
+        order.setInteger (DisplayQty, 0);
+        order.setInteger (Capacity, 1);
+        order.setInteger (OrderSubType, 0);
+        order.setInteger (Anonymity, 0);
+        order.setDouble (StopPrice, 0.0);
+        order.setInteger (PassiveOnlyOrder, 0);
+        order.setInteger (ClientID, 1234);
+        order.setInteger (MinimumQuantity, 0);
+    }
+
+    void cancel (cdr& cancel, uint64_t id, uint64_t origId)
+    {
+        cancel.setString (ClientOrderID, str (id));
+        cancel.setString (OriginalClientOrderID, str (origId));
+        cancel.setInteger (InstrumentID, 133215);
+        cancel.setInteger (Side, 1);
+        cancel.setString (RfqID, "XXXX");
+        cancel.setInteger (ReservedField1, 0);
+        cancel.setInteger (ReservedField2, 0);
+    }
+
+    uint64_t id (const cdr& msg) const
+    {
+        return strId (msg, ClientOrderID);
+    }
+
+private:
+    gwcSimMillennium<lseCodec> mSim;
+};
+
+class gwcSimVenueFix : public gwcSimVenue
+{
+public:
+    gwcSimVenueFix (logger* log) : mSim (log) {}
+
+    const char* type () const
+    {
+        return "fix";
+    }
+
+    bool start (const properties& opts, properties& props, string& err)
+    {
+        string dictionary;
+
+        if (!opts.get ("data_dictionary", dictionary))
+        {
+            err = "fix needs data_dictionary";
+            return false;
+        }
+        if (!mSim.init (opts, err) || !mSim.start ("127.0.0.1", 0, err))
+            return false;
+        props.setProperty ("host", host (mSim.getPort ()));
+        props.setProperty ("sender_comp_id", "FOSDK");
+        props.setProperty ("target_comp_id", "SIM");
+        props.setProperty ("data_dictionary", dictionary);
+        props.setProperty ("reset_sequence_number", "true");
+        return true;
+    }
+
+    void order (gwcOrder& order, uint64_t id)
+    {
+        order.setString (ClOrdID, str (id));
+        order.setString (Symbol, "VOD");
+    }
+
+    void cancel (cdr& cancel, uint64_t id, uint64_t origId)
+    {
+        cancel.setString (ClOrdID, str (id));
+        cancel.setString (OrigClOrdID, str (origId));
+        cancel.setString (Symbol, "VOD");
+        cancel.setString (Side, "1");
+    }
+
+    uint64_t id (const cdr& msg) const
+    {
+        return strId (msg, ClOrdID);
+    }
+
+private:
+    gwcSimFix mSim;
+};
+
+class gwcSimVenueEti : public gwcSimVenue
+{
+public:
+    gwcSimVenueEti (logger* log) : mSim (log, "xetra") {}
+
+    const char* type () const
+    {
+        return "eti";
+    }
+
+    bool start (const properties& opts, properties& props, string& err)
+    {
+        if (!mSim.init (opts, err) || !mSim.start ("127.0.0.1", 0, err))
+            return false;
+        props.setProperty ("venue", "xetra");
+        props.setProperty ("host", host (mSim.getPort ()));
+        return true;
+    }
+
+    void onLoggingOn (cdr& msg)
+    {
+        msg.setInteger (PartyIDSessionID, 123456789);
+        msg.setString (Password, "password");
+        msg.setString (ApplicationSystemName, "fosdk");
+        msg.setString (ApplicationSystemVersion, "1.0");
+        msg.setString (ApplicationSystemVendor, "Blucorner");
+    }
+
+    void order (gwcOrder& order, uint64_t id)
+    {
+        order.setInteger (SenderSubID, 123456789);
+        order.setInteger (ClOrdID, id);
+        order.setInteger (SecurityID, 2504860);
+        order.setInteger (PartyIDClientID, 0);
+        order.setInteger (PartyIdInvestmentDecisionMaker, 2000000003);
+        order.setInteger (ExecutingTrader, 2000005140);
+        order.setInteger (MarketSegmentID, 52767);
+        order.setInteger (ApplSeqIndicator, 0);
+        order.setInteger (PriceValidityCheckType, 0);
+        order.setInteger (ValueCheckTypeValue, 0);
+        order.setInteger (ValueCheckTypeQuantity, 0);
+        order.setInteger (OrderAttributeLiquidityProvision, 0);
+        order.setInteger (ExecInst, 2);
+        order.setInteger (TradingCapacity, 5);
+        order.setInteger (PartyIdInvestmentDecisionMakerQualifier, 24);
+        order.setInteger (ExecutingTraderQualifier, 24);
+    }
+
+    void cancel (cdr& cancel, uint64_t id, uint64_t origId)
+    {
+        cancel.setInteger (SenderSubID, 123456789);
+        cancel.setInteger (ClOrdID, id);
+        cancel.setInteger (OrigClOrdID, origId);
+        cancel.setInteger (SecurityID, 2504860);
+        cancel.setInteger (MarketSegmentID, 52767);
+        cancel.setInteger (TargetPartyIDSessionID, 0);
+    }
+
+    uint64_t id (const cdr& msg) const
+    {
+        return intId (msg, ClOrdID);
+    }
+
+    /* delete order responses go to onMsg */
+    bool isCancelDone (const cdr& msg) const
+    {
+        return intId (msg, TemplateID) == 10110;
+    }
+
+private:
+    gwcSimEti<xetraCodec> mSim;
+};
+
+class gwcSimVenueOptiq : public gwcSimVenue
+{
+public:
+    gwcSimVenueOptiq (logger* log) : mSim (log) {}
+
+    const char* type () const
+    {
+        return "optiq";
+    }
+
+    bool start (const properties& opts, properties& props, string& err)
+    {
+        if (!mSim.init (opts, err) || !mSim.start ("127.0.0.1", 0, err))
+            return false;
+        props.setProperty ("host", host (mSim.getPort ()));
+        props.setProperty ("partition", "1");
+        props.setProperty ("accessId", "1");
+        return true;
+    }
+
+    void onLoggingOn (cdr& msg)
+    {
+        msg.setString (SoftwareProvider, "BLUCNR");
+        msg.setInteger (QueueingIndicator, 1);
+    }
+
+    void order (gwcOrder& order, uint64_t id)
+    {
+        order.setString (FirmID, "00099022");
+        order.setInteger (SendingTime, 0);
+        order.setInteger (ClientOrderID, id);
+        order.setInteger (SymbolIndex, 1110000);
+        order.setInteger (EMM, OPTIQ_EMM_CASH_AND_DERIVATIVE_CENTRAL_ORDER_BOOK);
+        order.setInteger (ExecutionWithinFirmShortCode, 3);
+        order.setInteger (TradingCapacity,
+                          OPTIQ_TRADINGCAPACITY_DEALING_ON_OWN_ACCOUNT);
+        order.setInteger (AccountType, OPTIQ_ACCOUNTTYPE_CLIENT);
+        order.setInteger (LPRole, OPTIQ_LPROLE_RETAIL_LIQUIDITY_PROVIDER);
+        order.setInteger (ExecutionInstruction,
+                          OPTIQ_EXECUTIONINSTRUCTION_STPRESTINGORDER);
+        order.setInteger (DarkExecutionInstruction,
+                          OPTIQ_DARKEXECUTIONINSTRUCTION_DARKINDICATOR);
+        order.setInteger (MiFIDIndicators,
+                          OPTIQ_MIFIDINDICATORS_EXECUTIONALGOINDICATOR);
+    }
+
+    void cancel (cdr& cancel, uint64_t id, uint64_t origId)
+    {
+        cancel.setInteger (SendingTime, 0);
+        cancel.setString (FirmID, "00099022");
+        cancel.setInteger (ClientOrderID, id);
+        cancel.setInteger (OrigClientOrderID, origId);
+        cancel.setInteger (SymbolIndex, 1110000);
+        cancel.setInteger (EMM, OPTIQ_EMM_CASH_AND_DERIVATIVE_CENTRAL_ORDER_BOOK);
+        cancel.setInteger (OrderSide, OPTIQ_SIDE_BUY);
+        cancel.setInteger (OrderType, OPTIQ_ORDERTYPE_LIMIT);
+    }
+
+    uint64_t id (const cdr& msg) const
+    {
+        return intId (msg, ClientOrderID);
+    }
+
+private:
+    gwcSimOptiq mSim;
+};
+
+class gwcSimVenueSwx : public gwcSimVenue
+{
+public:
+    gwcSimVenueSwx (logger* log) : mSim (log) {}
+
+    const char* type () const
+    {
+        return "swx";
+    }
+
+    bool start (const properties& opts, properties& props, string& err)
+    {
+        if (!mSim.init (opts, err) || !mSim.start ("127.0.0.1", 0, err))
+            return false;
+        props.setProperty ("host", host (mSim.getPort ()));
+        return true;
+    }
+
+    void onLoggingOn (cdr& msg)
+    {
+        msg.setString (Username, "fosdk");
+        msg.setString (Password, "fosdk");
+    }
+
+    void order (gwcOrder& order, uint64_t id)
+    {
+        order.setInteger (OrderToken, id);
+        order.setString (BankInternalReference, "FOSDK");
+        order.setInteger (OrderBook, 1147);
+        order.setInteger (PrincipalId, 9999);
+        order.setInteger (SecondaryQuantity, 0);
+        order.setString (OrderPlacement, "C");
+        order.setInteger (AlgoID, 1);
+    }
+
+    void cancel (cdr& cancel, uint64_t id, uint64_t origId)
+    {
+        cancel.setInteger (OrderToken, id);
+        cancel.setInteger (OriginalOrderToken, origId);
+        cancel.setInteger (OrderQuantity, 0);
+    }
+
+    uint64_t id (const cdr& msg) const
+    {
+        return intId (msg, OrderToken);
+    }
+
+private:
+    gwcSimSwx mSim;
+};
@@ -7,6 +7,11 @@
 
 #include "cdr.h"
 #include "gwcCommon.h"
+#include "gwcLatency.h"
+#include "gwcThrottle.h"
+#include "gwcOrderCache.h"
+#include "gwcRisk.h"
+#include "gwcOrderTemplate.h"
 #include "gwcConnector.h"
 
 #include "bindings/codecBuffer.h"
@@ -38,6 +43,20 @@
 %feature("director") gwcMessageCallbacks;
 %feature("director") gwcConnector;
 
+// internal to connectors
+%ignore neueda::gwcConnectorOutboundDelegate;
+%ignore neueda::gwcLatencyMessageCallbacks;
+%ignore neueda::gwcLatencyHistogram;
+%ignore neueda::gwcLatency;
+%ignore neueda::gwcLatencyScope;
+%ignore neueda::gwcLatency_key;
+%ignore neueda::gwcLatency_now;
+%ignore neueda::gwcConnectorThrottleDelegate;
+%ignore neueda::gwcThrottleDelegate;
+%ignore neueda::gwcThrottle;
+%ignore neueda::gwcOrderCacheCallbacks;
+%ignore neueda::gwcRiskCallbacks;
+
 %extend neueda::gwcConnector {
     bool sendBuffer(neueda::Buffer* buffer)
     {
@@ -48,4 +67,11 @@
 
 // include
 %include "gwcCommon.h"
+%include "gwcLatency.h"
+%include "gwcThrottle.h"
+%include "gwcOrderCache.h"
+%include "gwcRisk.h"
+%include "gwcOrderTemplate.h"
 %include "gwcConnector.h"
+
+%template(LatencyStats) std::vector<neueda::gwcLatencyStat>;
@@ -4,6 +4,7 @@
 #include "fields.h"
 
 #include <sstream>
+#include <vector>
 
 template <typename CodecT>
 gwcEtiTcpConnectionDelegate<CodecT>::gwcEtiTcpConnectionDelegate (gwcEti<CodecT>* gwc)
@@ -34,7 +35,7 @@ gwcEtiTcpConnectionDelegate<CodecT>::onRead (void* data, size_t size)
 }
 
 extern "C" gwcConnector*
-getConnector (neueda::logger* log, const neueda::properties& props)
+GWC_CONNECTOR_ENTRY (eti) (neueda::logger* log, const neueda::properties& props)
 {
     string venue;
     if (!props.get ("venue", venue))
@@ -57,7 +58,6 @@ gwcEti<CodecT>::gwcEti (neueda::logger* log) :
     gwcConnector (log),
     mTcpConnection (NULL),
     mTcpConnectionDelegate (this),
-    mCacheFile (NULL),
     mCacheItem (NULL),        
     mMw (NULL),
     mQueue (NULL),
@@ -76,14 +76,15 @@ gwcEti<CodecT>::gwcEti (neueda::logger* log) :
 template <typename CodecT>
 gwcEti<CodecT>::~gwcEti ()
 {
+    stopLog ();
+    stopThrottle ();
     if (mReconnectTimer)
         sbfTimer_destroy (mReconnectTimer);
     if (mHb)
         sbfTimer_destroy (mHb);
     if (mTcpConnection)
         delete mTcpConnection;
-    if (mCacheFile)
-        sbfCacheFile_close (mCacheFile);
+    mSeqnumStore.close ();
     if (mQueue)
         sbfQueue_destroy (mQueue);
     if (mDispatching)
@@ -145,8 +146,9 @@ gwcEti<CodecT>::updateApplMsgId (uint64_t partId, string& sMsgId)
     if (itr != mCacheMap.end ())
     {
         memcpy (itr->second->mData.mApplMsgId, sMsgId.c_str (), sizeof itr->second->mData.mApplMsgId);
-        sbfCacheFile_write (itr->second->mItem, &itr->second->mData);
-        sbfCacheFile_flush (mCacheFile);
+        mSeqnumStore.write (itr->second->mItem,
+                            &itr->second->mData,
+                            sizeof itr->second->mData);
         return;
     }
 
@@ -154,10 +156,9 @@ gwcEti<CodecT>::updateApplMsgId (uint64_t partId, string& sMsgId)
     gwcXetraCacheItem* ci = new gwcXetraCacheItem ();
     ci->mData.mParitionId = partId;
     memcpy (ci->mData.mApplMsgId, sMsgId.c_str (), sizeof ci->mData.mApplMsgId);
-    ci->mItem = sbfCacheFile_add (mCacheFile, &ci->mData);
+    ci->mItem = mSeqnumStore.add (&ci->mData);
 
     mCacheMap[partId] = ci;
-    sbfCacheFile_flush (mCacheFile);
 } 
 
 template <typename CodecT>
@@ -195,6 +196,7 @@ gwcEti<CodecT>::onTcpConnectionReady ()
     }
 
     mTcpConnection->send (space, used);
+    journalOut (space, used);
 }
 
 template <typename CodecT>
@@ -208,12 +210,14 @@ template <typename CodecT>
 size_t 
 gwcEti<CodecT>::onTcpConnectionRead (void* data, size_t size)
 {
-    size_t left = size;
-    cdr    msg;
+    size_t   left = size;
+    cdr&     msg = mInboundMsg;
+    uint64_t read = mLatency ? gwcLatency_now () : 0;
 
     for (;;)
     {
         size_t used;
+        msg.clear ();
         switch (mCodec.decode (msg, data, left, used))
         {
         case GW_CODEC_ERROR:
@@ -228,7 +232,18 @@ gwcEti<CodecT>::onTcpConnectionRead (void* data, size_t size)
             return size;
 
         case GW_CODEC_SUCCESS:
+            journalIn (data, used);
+            logMsg (GWC_LOG_LEVEL_DEBUG, "msg in..", msg, data, used);
+            if (mLatency)
+            {
+                int64_t templateId = 0;
+                msg.getInteger (TemplateID, templateId);
+                mLatency->inboundDecoded (gwcLatency_key ((uint32_t)templateId),
+                                          read);
+            }
             handleTcpMsg (msg);
+            if (mLatency)
+                mLatency->inboundDone ();
             left -= used;
             break;
         }
@@ -273,12 +288,10 @@ gwcEti<CodecT>::updateSeqNo (uint64_t seqno)
     mSeqNo = seqno;
     if(mCacheItem == NULL)
     {
-        mCacheItem = sbfCacheFile_add (mCacheFile, &mSeqNo);    
-        sbfCacheFile_flush (mCacheFile);
+        mCacheItem = mSeqnumStore.add (&mSeqNo);
         return;
     }
-    sbfCacheFile_write (mCacheItem, &mSeqNo);
-    sbfCacheFile_flush (mCacheFile);
+    mSeqnumStore.write (mCacheItem, &mSeqNo, sizeof mSeqNo);
 }
 
 template <typename CodecT>
@@ -286,7 +299,7 @@ void*
 gwcEti<CodecT>::dispatchCb (void* closure)
 {
     gwcEti* gwc = reinterpret_cast<gwcEti*>(closure);
-    sbfQueue_dispatch (gwc->mQueue);
+    gwc->dispatch (gwc->mQueue);
     return NULL;
 }
 
@@ -352,9 +365,6 @@ gwcEti<CodecT>::handleTcpMsg (cdr& msg)
         updateSeqNo(seqno);
     }
 
-    mLog->info ("msg in..");
-    mLog->info ("%s", msg.toString ().c_str ());
-
     /* any message counts as a hb */
     mSeenHb = true;
 
@@ -364,11 +374,21 @@ gwcEti<CodecT>::handleTcpMsg (cdr& msg)
         return;
     }
 
+    /* a replayed logon response is passed on as it was when recorded but
+       nothing logs on */
+    if (mReplaying && templateId == 10001)
+    {
+        mMessageCbs->onAdmin (1, msg);
+        return;
+    }
+
     if (mState == GWC_CONNECTOR_CONNECTED)
     {
         /* can be reject or LogonResponse */
         if (templateId == 10001)
         {
+            if (mOutboundRing)
+                mOutboundRing->reset (mSeqNo + 1);
             mState = GWC_CONNECTOR_READY;
             mLog->info ("session logon complete");
             mMessageCbs->onAdmin (1, msg);
@@ -428,7 +448,7 @@ gwcEti<CodecT>::handleTcpMsg (cdr& msg)
     {        
     case 10019:
         handleTraderLogon (msg);
-        if(!mCacheMap.empty())
+        if(!mReplaying && !mCacheMap.empty())
         {
             /* send retrans request */
             sendRetransRequest ();
@@ -512,6 +532,8 @@ gwcEti<CodecT>::handleLogoffResponse (cdr& msg)
     int64_t seqnum = 0;
     msg.getInteger (MsgSeqNum, seqnum);
     mMessageCbs->onAdmin (seqnum, msg);
+    if (mReplaying)
+        return;
 
     // where we in a state to expect a logout
     if (mState != GWC_CONNECTOR_WAITING_LOGOFF)
@@ -575,7 +597,13 @@ gwcEti<CodecT>::init (gwcSessionCallbacks* sessionCbs,
                 const neueda::properties& props)
 {
     mSessionsCbs = sessionCbs;
-    mMessageCbs = messageCbs;
+    if (!initLatency (props, messageCbs))
+        return false;
+
+    if (!initOrderCache (props))
+        return false;
+    if (!initRisk (props))
+        return false;
 
     string v;
     if (!props.get ("host", v))
@@ -598,16 +626,19 @@ gwcEti<CodecT>::init (gwcSessionCallbacks* sessionCbs,
     string cacheFileName;
     props.get ("applMsgId_cache", v + ".applMsgId.cache", cacheFileName);
     
+    if (!initSeqnumStore (props))
+        return false;
+
     int created;
-    mCacheFile = sbfCacheFile_open (cacheFileName.c_str (),
-                                    16,
-                                    0,
-                                    &created,
-                                    cacheFileItemCb,
-                                    this);
-    if (mCacheFile == NULL)
+    string err;
+    if (!mSeqnumStore.open (cacheFileName,
+                            16,
+                            &created,
+                            cacheFileItemCb,
+                            this,
+                            err))
     {
-        mLog->err ("failed to create applMsgId cache file");
+        mLog->err ("failed to create applMsgId cache file: %s", err.c_str ());
         return false;
     }
     if (created)
@@ -626,16 +657,25 @@ gwcEti<CodecT>::init (gwcSessionCallbacks* sessionCbs,
         mRawEnabled = true;
     } 
 
-    sbfKeyValue kv = sbfKeyValue_create ();
-    mMw = sbfMw_create (mSbfLog, kv);
-    sbfKeyValue_destroy (kv);
+    if (!initOutboundRing (props))
+        return false;
+
+    if (!initDispatch (props))
+        return false;
+
+    if (!initLog (props, true))
+        return false;
+
+    if (!initJournal (props, cacheFileName))
+        return false;
+
+    mMw = createMw ();
     if (mMw == NULL)
     {
         mLog->err ("failed to create mw");
         return false;
     }
 
-    // could add a prop to make queue spin for max performance
     mQueue = sbfQueue_create (mMw, "default");
     if (mQueue == NULL)
     {
@@ -643,6 +683,9 @@ gwcEti<CodecT>::init (gwcSessionCallbacks* sessionCbs,
         return false;
     }
 
+    if (!initThrottle (props, mMw, mQueue))
+        return false;
+
     // start to dispatch 
     if (sbfThread_create (&mThread, gwcEti::dispatchCb, this) != 0)
     {
@@ -784,6 +827,8 @@ template <typename CodecT>
 bool
 gwcEti<CodecT>::sendOrder (gwcOrder& order)
 {
+    gwcLatencyScope latency (mLatency);
+
     if (!mapOrderFields (order))
         return false;
 
@@ -793,15 +838,26 @@ gwcEti<CodecT>::sendOrder (gwcOrder& order)
 template <typename CodecT>
 bool 
 gwcEti<CodecT>::sendOrder (cdr& order)
+{
+    gwcLatencyScope latency (mLatency);
+
+    prepareOrder (order);
+    return sendChecked (order);
+}
+
+template <typename CodecT>
+void
+gwcEti<CodecT>::prepareOrder (cdr& order)
 {
     order.setInteger (TemplateID, 10100);
-    return sendMsg (order);
 }
 
 template <typename CodecT>
 bool
 gwcEti<CodecT>::sendCancel (gwcOrder& cancel)
 {
+    gwcLatencyScope latency (mLatency);
+
     if (!mapOrderFields (cancel))
         return false;
 
@@ -811,15 +867,26 @@ gwcEti<CodecT>::sendCancel (gwcOrder& cancel)
 template <typename CodecT>
 bool 
 gwcEti<CodecT>::sendCancel (cdr& cancel)
+{
+    gwcLatencyScope latency (mLatency);
+
+    prepareCancel (cancel);
+    return sendPaced (cancel);
+}
+
+template <typename CodecT>
+void
+gwcEti<CodecT>::prepareCancel (cdr& cancel)
 {
     cancel.setInteger (TemplateID, 10109);
-    return sendMsg (cancel);
 }
 
 template <typename CodecT>
 bool
 gwcEti<CodecT>::sendModify (gwcOrder& modify)
 {
+    gwcLatencyScope latency (mLatency);
+
     if (!mapOrderFields (modify))
         return false;
 
@@ -829,16 +896,30 @@ gwcEti<CodecT>::sendModify (gwcOrder& modify)
 template <typename CodecT>
 bool 
 gwcEti<CodecT>::sendModify (cdr& modify)
+{
+    gwcLatencyScope latency (mLatency);
+
+    prepareModify (modify);
+    return sendModifyChecked (modify);
+}
+
+template <typename CodecT>
+void
+gwcEti<CodecT>::prepareModify (cdr& modify)
 {
     //TODO need to set TemplateID
     //modify.setString (MessageType, GW_XETRA_ORDER_CANCEL_REPLACE_REQUEST);
-    return sendMsg (modify);
 }
 
 template <typename CodecT>
 bool 
 gwcEti<CodecT>::sendMsg (cdr& msg)
 {
+    gwcLatencyScope latency (mLatency);
+
+    if (mOutboundRing)
+        return sendMsgRing (msg);
+
     char space[1024];
     size_t used;
     bool hb = false;
@@ -860,6 +941,9 @@ gwcEti<CodecT>::sendMsg (cdr& msg)
     if (!hb)
         mSeqNo++;
     msg.setInteger (MsgSeqNum, mSeqNo);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_SEQUENCED, 
+                                gwcLatency_key ((uint32_t)templateId));
     if (codec.encode (msg, space, sizeof space, used) != GW_CODEC_SUCCESS)
     {
         mLog->err ("failed to construct message [%s]", 
@@ -869,21 +953,318 @@ gwcEti<CodecT>::sendMsg (cdr& msg)
         unlock ();
         return false;
     }    
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_ENCODED);
     mTcpConnection->send (space, used);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN);
+    journalOut (space, used);
+    unlock ();
+    return true;
+}
+
+template <typename CodecT>
+bool 
+gwcEti<CodecT>::sendMsgs (cdr** msgs, size_t n)
+{
+    gwcLatencyScope latency (mLatency);
+
+    if (mOutboundRing)
+        return sendMsgsRing (msgs, n);
+
+    vector<char> space (n * GWC_BATCH_MSG_SIZE);
+    vector<size_t> sizes (n);
+    size_t total = 0;
+    size_t used;
+    // use a codec from the stack gets around threading issues
+    CodecT codec;
+
+    lock ();
+    if (mState != GWC_CONNECTOR_READY)
+    {
+        mLog->warn ("gwc not ready to send messages");
+        unlock ();
+        return false;
+    }
+
+    /* seqnums are contiguous across the batch, all are rolled back if a 
+       message fails to encode as nothing will be sent */
+    uint64_t seqNo = mSeqNo;
+    for (size_t i = 0; i < n; i++)
+    {
+        cdr& msg = *msgs[i];
+        int64_t templateId = 0;
+
+        msg.getInteger (TemplateID, templateId);
+        if (templateId != 10011)
+            mSeqNo++;
+        msg.setInteger (MsgSeqNum, mSeqNo);
+        if (mLatency && i == 0)
+            mLatency->outboundMark (GWC_LATENCY_OUT_SEQUENCED, 
+                                    gwcLatency_key ((uint32_t)templateId));
+
+        if (codec.encode (msg, 
+                          &space[total], 
+                          space.size () - total, 
+                          used) != GW_CODEC_SUCCESS)
+        {
+            mLog->err ("failed to construct batch message [%s]", 
+                       codec.getLastError ().c_str ());
+            mSeqNo = seqNo;
+            unlock ();
+            return false;
+        }
+        sizes[i] = used;
+        total += used;
+    }
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_ENCODED);
+
+    mTcpConnection->send (&space[0], total);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN);
+    size_t offset = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        journalOut (&space[offset], sizes[i]);
+        offset += sizes[i];
+    }
     unlock ();
     return true;
 }
 
+template <typename CodecT>
+bool
+gwcEti<CodecT>::encodeOutbound (CodecT& codec,
+                                cdr& msg,
+                                char* space,
+                                size_t size,
+                                size_t& used,
+                                size_t& offset)
+{
+    int64_t templateId = 0;
+    msg.getInteger (TemplateID, templateId);
+
+    /* encode with a placeholder seqnum so nothing is claimed for a message
+       that fails to encode, the real one is patched in afterwards */
+    msg.setInteger (MsgSeqNum, 0);
+    if (codec.encode (msg, space, size, used) != GW_CODEC_SUCCESS)
+    {
+        mLog->err ("failed to construct message [%s]", 
+                   codec.getLastError ().c_str ());
+        return false;
+    }
+
+    if (!mSeqnumOffsets.find (codec, 
+                              msg, 
+                              (uint16_t)templateId, 
+                              MsgSeqNum, 
+                              4, 
+                              offset))
+    {
+        mLog->err ("failed to construct message [no MsgSeqNum]");
+        return false;
+    }
+
+    return true;
+}
+
+template <typename CodecT>
+bool
+gwcEti<CodecT>::sendMsgRing (cdr& msg)
+{
+    char space[GWC_OUTBOUND_SLOT_SIZE];
+    size_t used;
+    size_t offset;
+    int64_t templateId = 0;
+    CodecT codec;
+
+    if (mState != GWC_CONNECTOR_READY)
+    {
+        mLog->warn ("gwc not ready to send messages");
+        return false;
+    }
+
+    /* heartbeats don't take a seqnum, send with the last one claimed */
+    msg.getInteger (TemplateID, templateId);
+    if (templateId == 10011)
+    {
+        msg.setInteger (MsgSeqNum, mOutboundRing->next () - 1);
+        if (codec.encode (msg, space, sizeof space, used) != GW_CODEC_SUCCESS)
+        {
+            mLog->err ("failed to construct message [%s]", 
+                       codec.getLastError ().c_str ());
+            return false;
+        }
+        mOutboundRing->sendDirect (space, used);
+        return true;
+    }
+
+    if (!encodeOutbound (codec, msg, space, sizeof space, used, offset))
+        return false;
+
+    /* encoded once the claimed seqnum is patched in */
+    uint64_t ticket = mOutboundRing->claim ();
+    uint64_t seqNo = gwcOutboundRing::seqnum (ticket);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_SEQUENCED, 
+                                gwcLatency_key ((uint32_t)templateId));
+    gwcSeqnumOffsets::patch (space, offset, 4, seqNo);
+    msg.setInteger (MsgSeqNum, seqNo);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_ENCODED);
+
+    if (!mOutboundRing->publish (ticket, space, used))
+    {
+        mLog->warn ("session reset before message could be sent");
+        return false;
+    }
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN);
+    return true;
+}
+
+template <typename CodecT>
+bool
+gwcEti<CodecT>::sendMsgsRing (cdr** msgs, size_t n)
+{
+    vector<char> space (n * GWC_OUTBOUND_SLOT_SIZE);
+    vector<size_t> sizes (n);
+    vector<size_t> offsets (n);
+    CodecT codec;
+
+    if (mState != GWC_CONNECTOR_READY)
+    {
+        mLog->warn ("gwc not ready to send messages");
+        return false;
+    }
+
+    /* heartbeats don't take a seqnum so can't be part of a contiguous 
+       claim */
+    for (size_t i = 0; i < n; i++)
+    {
+        int64_t templateId = 0;
+        msgs[i]->getInteger (TemplateID, templateId);
+        if (templateId == 10011)
+            return gwcConnector::sendMsgs (msgs, n);
+    }
+
+    /* encode all first so nothing is claimed or sent if one fails */
+    for (size_t i = 0; i < n; i++)
+    {
+        if (!encodeOutbound (codec, 
+                             *msgs[i], 
+                             &space[i * GWC_OUTBOUND_SLOT_SIZE],
+                             GWC_OUTBOUND_SLOT_SIZE,
+                             sizes[i],
+                             offsets[i]))
+        {
+            return false;
+        }
+    }
+
+    uint64_t ticket = mOutboundRing->claim (n);
+    uint64_t seqNo = gwcOutboundRing::seqnum (ticket);
+    if (mLatency)
+    {
+        int64_t templateId = 0;
+        msgs[0]->getInteger (TemplateID, templateId);
+        mLatency->outboundMark (GWC_LATENCY_OUT_SEQUENCED, 
+                                gwcLatency_key ((uint32_t)templateId));
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        gwcSeqnumOffsets::patch (&space[i * GWC_OUTBOUND_SLOT_SIZE], 
+                                 offsets[i], 
+                                 4, 
+                                 seqNo + i);
+        msgs[i]->setInteger (MsgSeqNum, seqNo + i);
+    }
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_ENCODED);
+
+    /* every ticket is published, the rest fail too once one has */
+    bool ok = true;
+    for (size_t i = 0; i < n; i++)
+    {
+        ok = mOutboundRing->publish (ticket + i, 
+                                     &space[i * GWC_OUTBOUND_SLOT_SIZE], 
+                                     sizes[i]) && ok;
+    }
+    if (!ok)
+    {
+        mLog->warn ("session reset before messages could be sent");
+        return false;
+    }
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN);
+    return true;
+}
+
+template <typename CodecT>
+size_t
+gwcEti<CodecT>::onReplay (void* data, size_t size)
+{
+    return mTcpConnectionDelegate.onRead (data, size);
+}
+
+template <typename CodecT>
+void
+gwcEti<CodecT>::onOutboundSend (const void* data, size_t size)
+{
+    lock ();
+    if (mTcpConnection)
+        mTcpConnection->send ((void*)data, size);
+    unlock ();
+}
+
+template <typename CodecT>
+void
+gwcEti<CodecT>::onOutboundSent (uint64_t seq, const void* data, size_t size)
+{
+    journalOut (data, size);
+}
+
+template <typename CodecT>
+bool
+gwcEti<CodecT>::formatLogMsg (const void* data, size_t size, std::string& out)
+{
+    cdr    msg;
+    size_t used = 0;
+
+    if (mLogCodec.decode (msg, data, size, used) != GW_CODEC_SUCCESS)
+        return false;
+    out = msg.toString ();
+    return true;
+}
+
 template <typename CodecT>
 bool
 gwcEti<CodecT>::sendRaw (void* data, size_t len)
 {
+    gwcLatencyScope latency (mLatency);
+
     if (!mRawEnabled)
     {
         mLog->warn ("raw send interface not enabled");
         return false;
     }    
 
+    if (mOutboundRing)
+    {
+        if (mState != GWC_CONNECTOR_READY)
+        {
+            mLog->warn ("gwc not ready to send messages");
+            return false;
+        }
+        mOutboundRing->sendDirect (data, len);
+        if (mLatency)
+            mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN, 0);
+        journalOut (data, len);
+        return true;
+    }
+
     lock ();
     if (mState != GWC_CONNECTOR_READY)
     {
@@ -893,6 +1274,163 @@ gwcEti<CodecT>::sendRaw (void* data, size_t len)
     }
  
     mTcpConnection->send (data, len);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN, 0);
+    journalOut (data, len);
+    unlock ();
+    return true;
+}
+
+template <typename CodecT>
+bool
+gwcEti<CodecT>::getClOrdId (const cdr& msg, bool orig, std::string& id) const
+{
+    return getIdField (msg, orig ? OrigClOrdID : ClOrdID, id);
+}
+
+template <typename CodecT>
+void
+gwcEti<CodecT>::getOrderFields (const cdr& msg, gwcOrderFields& fields) const
+{
+    getIdField (msg, OrderID, fields.mOrderId);
+    fields.mHasOrderQty = getNumberField (msg, OrderQty, fields.mOrderQty);
+    fields.mHasLeavesQty = getNumberField (msg, LeavesQty, fields.mLeavesQty);
+    fields.mHasCumQty = getNumberField (msg, CumQty, fields.mCumQty);
+    fields.mHasLastQty = getNumberField (msg, LastQty, fields.mLastQty);
+    fields.mHasLastPx = getNumberField (msg, LastPx, fields.mLastPx);
+}
+
+template <typename CodecT>
+void
+gwcEti<CodecT>::getRiskFields (const cdr& msg, gwcRiskFields& fields) const
+{
+    int64_t side;
+
+    getIdField (msg, SecurityID, fields.mInstrument);
+    getIdField (msg, Account, fields.mAccount);
+    fields.mHasSide = msg.getInteger (Side, side);
+    fields.mBuy = fields.mHasSide && side == 1;
+    fields.mHasQty = getNumberField (msg, OrderQty, fields.mQty);
+    fields.mHasPrice = getNumberField (msg, Price, fields.mPrice);
+}
+
+template <typename CodecT>
+bool
+gwcEti<CodecT>::createTemplate (gwcOrderTemplateType type,
+                                gwcOrder& msg,
+                                gwcOrderTemplate& tmpl)
+{
+    if (!mapOrderFields (msg))
+        return false;
+
+    switch (type)
+    {
+    case GWC_TEMPLATE_ORDER:
+        msg.setInteger (TemplateID, 10100);
+        break;
+    case GWC_TEMPLATE_CANCEL:
+        msg.setInteger (TemplateID, 10109);
+        break;
+    case GWC_TEMPLATE_MODIFY:
+        // as sendModify the TemplateID is set by the caller
+        break;
+    }
+    msg.setInteger (MsgSeqNum, 0);
+
+    /* quantities are passed through unscaled as in mapOrderFields */
+    CodecT codec;
+    tmpl.reset (this, type);
+    tmpl.setSideValues (1, 2);
+    if (!tmpl.encode (codec, msg) ||
+        !tmpl.locate (codec, msg, GWC_TEMPLATE_FIELD_PRICE, Price,
+                      GWC_TEMPLATE_ENCODING_LE, 8, 100000000.0, 100000000.0) ||
+        !tmpl.locate (codec, msg, GWC_TEMPLATE_FIELD_QTY, OrderQty,
+                      GWC_TEMPLATE_ENCODING_LE, 8, 10000.0, 1) ||
+        !tmpl.locate (codec, msg, GWC_TEMPLATE_FIELD_SIDE, Side,
+                      GWC_TEMPLATE_ENCODING_LE, 1, 0, 1) ||
+        !tmpl.locate (codec, msg, GWC_TEMPLATE_FIELD_CLORDID, ClOrdID,
+                      GWC_TEMPLATE_ENCODING_LE, 8, 0, 1) ||
+        !tmpl.locate (codec, msg, GWC_TEMPLATE_FIELD_ORIG_CLORDID, OrigClOrdID,
+                      GWC_TEMPLATE_ENCODING_LE, 8, 0, 1) ||
+        !tmpl.locate (codec, msg, GWC_TEMPLATE_FIELD_SEQNUM, MsgSeqNum,
+                      GWC_TEMPLATE_ENCODING_LE, 4, 0, 1))
+    {
+        mLog->err ("failed to construct template [%s]",
+                   tmpl.getLastError ().c_str ());
+        tmpl.reset (NULL, type);
+        return false;
+    }
+
+    if (!tmpl.hasField (GWC_TEMPLATE_FIELD_SEQNUM))
+    {
+        mLog->err ("failed to construct template [no MsgSeqNum]");
+        tmpl.reset (NULL, type);
+        return false;
+    }
+
+    return true;
+}
+
+template <typename CodecT>
+bool
+gwcEti<CodecT>::sendTemplate (gwcOrderTemplate& tmpl)
+{
+    gwcLatencyScope latency (mLatency);
+
+    if (!tmpl.isOwner (this))
+    {
+        mLog->warn ("template not created by this connector");
+        return false;
+    }
+
+    if (!riskTemplate ())
+        return false;
+
+    if (!throttleTemplate ())
+        return false;
+
+    if (mOutboundRing)
+    {
+        if (mState != GWC_CONNECTOR_READY)
+        {
+            mLog->warn ("gwc not ready to send messages");
+            return false;
+        }
+
+        uint64_t ticket = mOutboundRing->claim ();
+        if (mLatency)
+            mLatency->outboundMark (GWC_LATENCY_OUT_SEQUENCED, 0);
+        tmpl.patchInteger (GWC_TEMPLATE_FIELD_SEQNUM, gwcOutboundRing::seqnum (ticket));
+        if (mLatency)
+            mLatency->outboundMark (GWC_LATENCY_OUT_ENCODED);
+        if (!mOutboundRing->publish (ticket, tmpl.getData (), tmpl.getSize ()))
+        {
+            mLog->warn ("session reset before message could be sent");
+            return false;
+        }
+        if (mLatency)
+            mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN);
+        return true;
+    }
+
+    lock ();
+    if (mState != GWC_CONNECTOR_READY)
+    {
+        mLog->warn ("gwc not ready to send messages");
+        unlock ();
+        return false;
+    }
+
+    mSeqNo++;
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_SEQUENCED, 0);
+    tmpl.patchInteger (GWC_TEMPLATE_FIELD_SEQNUM, mSeqNo);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_ENCODED);
+    mTcpConnection->send (tmpl.getData (), tmpl.getSize ());
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN);
+    journalOut (tmpl.getData (), tmpl.getSize ());
     unlock ();
     return true;
 }
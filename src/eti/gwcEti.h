@@ -79,11 +79,30 @@ public:
     virtual bool sendMsg (cdr& msg);
     virtual bool sendRaw (void* data, size_t len);
 
+    virtual bool getClOrdId (const cdr& msg, bool orig, std::string& id) const;
+
+    virtual void getOrderFields (const cdr& msg, gwcOrderFields& fields) const;
+
+    virtual void getRiskFields (const cdr& msg, gwcRiskFields& fields) const;
+
+    virtual bool createTemplate (gwcOrderTemplateType type,
+                                 gwcOrder& msg,
+                                 gwcOrderTemplate& tmpl);
+    virtual bool sendTemplate (gwcOrderTemplate& tmpl);
+
 protected: 
+    virtual void prepareOrder (cdr& order);
+    virtual void prepareCancel (cdr& cancel);
+    virtual void prepareModify (cdr& modify);
+    virtual bool sendMsgs (cdr** msgs, size_t n);
+    virtual size_t onReplay (void* data, size_t size);
+    virtual void onOutboundSend (const void* data, size_t size);
+    virtual void onOutboundSent (uint64_t seq, const void* data, size_t size);
+    virtual bool formatLogMsg (const void* data, size_t size, std::string& out);
+
     SbfTcpConnection*             mTcpConnection;
     gwcEtiTcpConnectionDelegate<CodecT> mTcpConnectionDelegate;
 
-    sbfCacheFile                  mCacheFile;
     sbfCacheFileItem              mCacheItem;
     sbfMw                         mMw;
     sbfQueue                      mQueue;
@@ -97,6 +116,14 @@ private:
     void error (const string& err);
     void sendRetransRequest ();
     bool mapOrderFields (gwcOrder& gwc);
+    bool encodeOutbound (CodecT& codec, 
+                         cdr& msg, 
+                         char* space, 
+                         size_t size,
+                         size_t& used,
+                         size_t& offset);
+    bool sendMsgRing (cdr& msg);
+    bool sendMsgsRing (cdr** msgs, size_t n);
 
     // handle state
     void onTcpConnectionReady ();
@@ -131,11 +158,14 @@ private:
     sbfTimer                mHb;
     sbfTimer                mReconnectTimer;
     CodecT                  mCodec;
+    CodecT                  mLogCodec;
+    cdr                     mInboundMsg;
     bool                    mSeenHb;
     int                     mMissedHb;
     uint64_t                mSeqNo;
     char                    mLastApplMsgId[16];
     char                    mCurrentRecoveryEnd[16];
     int64_t                 mRecoveryMsgCnt;
+    gwcSeqnumOffsets        mSeqnumOffsets;
 };
 
@@ -4,6 +4,15 @@
 #include "fields.h"
 
 #include <sstream>
+#include <vector>
+
+#ifdef WIN32
+#include <windows.h>
+#define gwcFix_casPtr(p, o, n) \
+    (InterlockedCompareExchangePointer ((PVOID volatile*)(p), (PVOID)(n), (PVOID)(o)) == (PVOID)(o))
+#else
+#define gwcFix_casPtr(p, o, n) __sync_bool_compare_and_swap ((p), (o), (n))
+#endif
 
 const string gwcFix::FixHeartbeat = "0";
 const string gwcFix::FixTestRequest = "1";
@@ -19,6 +28,25 @@ const string gwcFix::FixOrderCancelRequest = "F";
 const string gwcFix::FixOrderCancelReplaceRequest = "G";
 const string gwcFix::FixBusinessMessageReject = "j";
 
+gwcFix::msgHandlers::msgHandlers ()
+{
+    for (size_t i = 0; i < 256; i++)
+        mHandlers[i] = NULL;
+
+    mHandlers[GW_FIX_HEARTBEAT_C] = &gwcFix::handleHeartbeatMsg;
+    mHandlers[GW_FIX_TEST_REQUEST_C] = &gwcFix::handleTestRequestMsg;
+    mHandlers[GW_FIX_RESEND_REQUEST_C] = &gwcFix::handleResendRequestMsg;
+    mHandlers[GW_FIX_REJECT_C] = &gwcFix::handleRejectMsg;
+    mHandlers[GW_FIX_LOGOUT_C] = &gwcFix::handleLogoutMsg;
+    mHandlers[GW_FIX_EXECUTION_REPORT_C] = &gwcFix::handleExecutionReportMsg;
+    mHandlers[GW_FIX_ORDER_CANCEL_REJECT_C] = 
+        &gwcFix::handleOrderCancelRejectMsg;
+    mHandlers[GW_FIX_BUSINESS_MESSAGE_REJECT_C] = 
+        &gwcFix::handleBusinessRejectMsg;
+}
+
+const gwcFix::msgHandlers gwcFix::sHandlers;
+
 gwcFixTcpConnectionDelegate::gwcFixTcpConnectionDelegate (gwcFix* gwc)
     : SbfTcpConnectionDelegate (),
       mGwc (gwc)
@@ -44,7 +72,7 @@ gwcFixTcpConnectionDelegate::onRead (void* data, size_t size)
 }
 
 extern "C" gwcConnector*
-getConnector (neueda::logger* log, const neueda::properties& props)
+GWC_CONNECTOR_ENTRY (fix) (neueda::logger* log, const neueda::properties& props)
 {
     return new gwcFix (log);
 }
@@ -53,7 +81,6 @@ gwcFix::gwcFix (neueda::logger* log) :
     gwcConnector (log),
     mTcpConnection (NULL),
     mTcpConnectionDelegate (this),
-    mCacheFile (NULL),
     mCacheItem (NULL),        
     mMw (NULL),
     mQueue (NULL),
@@ -71,35 +98,35 @@ gwcFix::gwcFix (neueda::logger* log) :
     mSeenHb (false),
     mMissedHb (0),
     mEncryptMethod (0),
-    mSetNextExpSeqNum (false)
+    mSetNextExpSeqNum (false),
+    mTypedCbs (NULL)
 {
     mSeqnums.mInbound = 1;
     mSeqnums.mOutbound = 1;
 
-    mMsgInWriter = NULL;
-    mMsgOutWriter = NULL;
+    for (size_t i = 0; i < GWC_FIX_CODECS; i++)
+        mCodecs[i] = NULL;
 }
 
 gwcFix::~gwcFix ()
 {
+    stopLog ();
+    stopThrottle ();
     if (mReconnectTimer)
         sbfTimer_destroy (mReconnectTimer);
     if (mHb)
         sbfTimer_destroy (mHb);
     if (mTcpConnection)
         delete mTcpConnection;
-    if (mCacheFile)
-        sbfCacheFile_close (mCacheFile);
+    mSeqnumStore.close ();
     if (mQueue)
         sbfQueue_destroy (mQueue);
     if (mDispatching)
         sbfThread_join (mThread);
     if (mMw)
         sbfMw_destroy (mMw);
-    if (mMsgInWriter)
-        mMsgInWriter->teardown ();
-    if (mMsgOutWriter)
-        mMsgOutWriter->teardown ();
+    for (size_t i = 0; i < GWC_FIX_CODECS; i++)
+        delete mCodecs[i];
 }
 
 sbfError
@@ -154,19 +181,16 @@ gwcFix::onTcpConnectionReady ()
         return;
     }
 
-    mLog->debug ("msg out..");
-    mLog->debug ("%s", d.toString ().c_str ());
+    logMsg (GWC_LOG_LEVEL_DEBUG, "msg out..", d, space, used);
 
     mTcpConnection->send (space, used);
-
-    if (mMsgInWriter)
-        mMsgInWriter->write (space, used);
+    journalOut (space, used);
 
     lock ();
 
+    mMessageStore.add (mSeqnums.mOutbound, space, used);
     mSeqnums.mOutbound++;
-    sbfCacheFile_write (mCacheItem, &mSeqnums);
-    sbfCacheFile_flush (mCacheFile);
+    mSeqnumStore.write (mCacheItem, &mSeqnums, sizeof mSeqnums);
 
     unlock ();
 }
@@ -180,12 +204,39 @@ gwcFix::onTcpConnectionError ()
 size_t 
 gwcFix::onTcpConnectionRead (void* data, size_t size)
 {
-    size_t left = size;
-    cdr    msg;
+    size_t   left = size;
+    cdr&     msg = mInboundMsg;
+    uint64_t read = mLatency ? gwcLatency_now () : 0;
 
     while (left > 0)
     {
+        /* framing and CheckSum are checked before anything is decoded,
+           fields are only indexed when typed callbacks can use them */
         size_t used = 0;
+        switch (gwcFix_scan ((const char*)data, left, mTypedCbs != NULL, mScanMsg, used))
+        {
+        case GWC_FIX_SCAN_SHORT:
+            return size - left;
+
+        case GWC_FIX_SCAN_GARBLED:
+            mLog->warn ("dropping garbled message of %lu bytes",
+                        (unsigned long)used);
+            left -= used;
+            data = (char*)data + used;
+            continue;
+
+        case GWC_FIX_SCAN_OK:
+            break;
+        }
+
+        if (mTypedCbs != NULL && handleTypedMsg (mScanMsg, read))
+        {
+            left -= used;
+            data = (char*)data + used;
+            continue;
+        }
+
+        msg.clear ();
         switch (mCodec.decode (msg, data, left, used))
         {
         case GW_CODEC_ERROR:
@@ -200,14 +251,20 @@ gwcFix::onTcpConnectionRead (void* data, size_t size)
             return size;
 
         case GW_CODEC_SUCCESS:
-            if (mMsgInWriter)
-                mMsgInWriter->write (data, used);
-            handleTcpMsg (msg);
+        {
+            journalIn (data, used);
+            logMsg (GWC_LOG_LEVEL_DEBUG, "msg in..", msg, data, used);
+            uint32_t msgType = gwcFix_msgType (data, used);
+            if (mLatency)
+                mLatency->inboundDecoded (gwcLatency_textKey (msgType), read);
+            handleTcpMsg (msgType, msg);
+            if (mLatency)
+                mLatency->inboundDone ();
             left -= used;
             break;
         }
+        }
         data = (char*)data + used; 
-        msg.clear ();
     }
 
     return size - left;
@@ -246,7 +303,7 @@ void*
 gwcFix::dispatchCb (void* closure)
 {
     gwcFix* gwc = reinterpret_cast<gwcFix*>(closure);
-    sbfQueue_dispatch (gwc->mQueue);
+    gwc->dispatch (gwc->mQueue);
     return NULL;
 }
 
@@ -295,25 +352,25 @@ gwcFix::error (const string& err)
 }
 
 void
-gwcFix::getTime (cdrDateTime& dt)
+gwcFix::setTime (cdr& d, int field)
 {
-    time_t t;
-    struct tm* tmp;
-    struct timeval tv;
+    struct timespec ts;
+    clock_gettime (CLOCK_REALTIME, &ts);
 
-    t = time(NULL);
-    tmp = gmtime (&t);
+    time_t    t = ts.tv_sec;
+    struct tm tm;
+    gmtime_r (&t, &tm);
 
-    dt.mYear = 1900 + tmp->tm_year;
-    dt.mMonth = 1 + tmp->tm_mon;
-    dt.mDay = tmp->tm_mday;
-
-    dt.mHour = tmp->tm_hour;
-    dt.mMinute = tmp->tm_min;
-    dt.mSecond = tmp->tm_sec;
-
-    if (gettimeofday (&tv, NULL) == 0)
-        dt.mNanosecond = (int)tv.tv_usec * 1000;
+    /* stays a date time for callers reading it back, the codec formats it */
+    cdrDateTime dt;
+    dt.mYear = 1900 + tm.tm_year;
+    dt.mMonth = 1 + tm.tm_mon;
+    dt.mDay = tm.tm_mday;
+    dt.mHour = tm.tm_hour;
+    dt.mMinute = tm.tm_min;
+    dt.mSecond = tm.tm_sec;
+    dt.mNanosecond = (int)ts.tv_nsec;
+    d.setDateTime (field, dt);
 }
 
 void
@@ -323,34 +380,29 @@ gwcFix::setHeader (cdr& d)
     d.setString (SenderCompID, mSenderCompID);
     d.setString (TargetCompID, mTargetCompID);
     d.setInteger (MsgSeqNum, mSeqnums.mOutbound);
-
-    cdrDateTime dt;
-    getTime (dt);
-    d.setDateTime (SendingTime, dt);
+    setTime (d, SendingTime);
 }
 
 void 
-gwcFix::handleTcpMsg (cdr& msg)
+gwcFix::handleTcpMsg (uint32_t msgType, cdr& msg)
 {
-    mLog->debug ("msg in..");
-    mLog->debug ("%s", msg.toString ().c_str ());
     /* any message counts as a hb */
     mSeenHb = true;
 
-    string msgType;
     int64_t seqnum;
-    msg.getString (MsgType, msgType);
     msg.getInteger (MsgSeqNum, seqnum);
 
     if (mState == GWC_CONNECTOR_CONNECTED)
     {
-        if (msgType != FixLogon  && 
-            msgType != FixLogout &&
-            msgType != FixResendRequest)
+        if (msgType != GW_FIX_LOGON_C  && 
+            msgType != GW_FIX_LOGOUT_C &&
+            msgType != GW_FIX_RESEND_REQUEST_C)
             return error ("invalid response after logon");
 
-        if (msgType == FixLogon)
+        if (msgType == GW_FIX_LOGON_C)
         {
+            if (mOutboundRing)
+                mOutboundRing->reset (mSeqnums.mOutbound);
             mState = GWC_CONNECTOR_READY;
             mHb = sbfTimer_create (sbfMw_getDefaultThread (mMw),
                                    mQueue,
@@ -376,8 +428,7 @@ gwcFix::handleTcpMsg (cdr& msg)
 
                 mSeqnums.mInbound = seqnum;
 
-                sbfCacheFile_write (mCacheItem, &mSeqnums);
-                sbfCacheFile_flush (mCacheFile);
+                mSeqnumStore.write (mCacheItem, &mSeqnums, sizeof mSeqnums);
 
                 unlock ();
             }
@@ -386,7 +437,7 @@ gwcFix::handleTcpMsg (cdr& msg)
             mSessionsCbs->onLoggedOn (seqnum, msg);
             loggedOnEvent ();         
         }
-        else if (msgType == FixLogout) /* logon reject */
+        else if (msgType == GW_FIX_LOGOUT_C) /* logon reject */
         {
             error ("logon rejected");
             return;
@@ -394,14 +445,31 @@ gwcFix::handleTcpMsg (cdr& msg)
     }
 
     // skip seqnum checking on sequence reset
-    if (msgType == FixSequenceReset)
+    if (msgType == GW_FIX_SEQUENCE_RESET_C)
     {
         handleSequenceResetMsg (seqnum, msg);
         return;
     }
 
+    if (!checkSeqnum (seqnum))
+        return;
+
+    msgHandler handler = msgType < 256 ? sHandlers.mHandlers[msgType] : NULL;
+    if (handler != NULL)
+        (this->*handler) (seqnum, msg);
+    else
+        mMessageCbs->onMsg (seqnum, msg);
+}
+
+bool
+gwcFix::checkSeqnum (int64_t seqnum)
+{
     lock ();
 
+    /* replayed messages carry the sequence they were recorded with */
+    if (mReplaying)
+        mSeqnums.mInbound = seqnum;
+
     if (seqnum > mSeqnums.mInbound)
     {
         mLog->warn ("gap detected, got %ld expected: %ld",
@@ -415,7 +483,7 @@ gwcFix::handleTcpMsg (cdr& msg)
         unlock ();
 
         sendMsg (resend);
-        return;
+        return false;
     }
     else if (seqnum < mSeqnums.mInbound)
     {
@@ -425,38 +493,69 @@ gwcFix::handleTcpMsg (cdr& msg)
 
         unlock ();
 
-        return;
+        return false;
     }
 
     mSeqnums.mInbound = seqnum + 1;
 
-    sbfCacheFile_write (mCacheItem, &mSeqnums);
-    sbfCacheFile_flush (mCacheFile);
+    mSeqnumStore.write (mCacheItem, &mSeqnums, sizeof mSeqnums);
 
     unlock ();
 
-    if (msgType == FixHeartbeat)
-        mMessageCbs->onAdmin (seqnum, msg);
-    else if (msgType == FixTestRequest)
-        handleTestRequestMsg (seqnum, msg);
-    else if (msgType == FixResendRequest)
-        handleResendRequestMsg (seqnum, msg);
-    else if (msgType == FixReject)
-        handleRejectMsg (seqnum, msg);
-    else if (msgType == FixLogout)
-        handleLogoutMsg (seqnum, msg);
-    else if (msgType == FixExecutionReport)
-        handleExecutionReportMsg (seqnum, msg);
-    else if (msgType == FixOrderCancelReject)
-        handleOrderCancelRejectMsg (seqnum, msg);
-    else if (msgType == FixBusinessMessageReject)
-        handleBusinessRejectMsg (seqnum, msg);
-    else if (msgType == FixLogon  &&
-             msgType == FixLogout &&
-             msgType == FixResendRequest)
-        mMessageCbs->onAdmin (seqnum, msg);
-    else
-        mMessageCbs->onMsg (seqnum, msg);
+    return true;
+}
+
+bool
+gwcFix::handleTypedMsg (const gwcFixMessage& msg, uint64_t read)
+{
+    /* session messages and anything the scan couldn't index go through
+       the codec */
+    if (mState != GWC_CONNECTOR_READY || !msg.isIndexed ())
+        return false;
+
+    uint32_t msgType = msg.getMsgType ();
+    if (msgType != GW_FIX_EXECUTION_REPORT_C &&
+        msgType != GW_FIX_ORDER_CANCEL_REJECT_C &&
+        msgType != GW_FIX_BUSINESS_MESSAGE_REJECT_C)
+        return false;
+
+    int64_t seqnum;
+    if (!msg.getInteger (MsgSeqNum, seqnum))
+        return false;
+
+    journalIn (msg.getData (), msg.getSize ());
+
+    /* any message counts as a hb */
+    mSeenHb = true;
+
+    if (!checkSeqnum (seqnum))
+        return true;
+
+    if (mLatency)
+        mLatency->inboundDecoded (gwcLatency_textKey (msgType), read);
+
+    switch (msgType)
+    {
+    case GW_FIX_EXECUTION_REPORT_C:
+        mTypedCbs->onExecutionReport (seqnum, msg);
+        break;
+    case GW_FIX_ORDER_CANCEL_REJECT_C:
+        mTypedCbs->onOrderCancelReject (seqnum, msg);
+        break;
+    case GW_FIX_BUSINESS_MESSAGE_REJECT_C:
+        mTypedCbs->onBusinessReject (seqnum, msg);
+        break;
+    }
+
+    if (mLatency)
+        mLatency->inboundDone ();
+    return true;
+}
+
+void
+gwcFix::handleHeartbeatMsg (int64_t seqno, cdr& msg)
+{
+    mMessageCbs->onAdmin (seqno, msg);
 }
 
 void
@@ -495,16 +594,88 @@ void
 gwcFix::handleResendRequestMsg (int64_t seqno, cdr& msg)
 {    
     mMessageCbs->onAdmin (seqno, msg);
+    if (mReplaying)
+        return;
 
-    string testreqid;
-    if (!msg.getString (TestReqID, testreqid))
+    int64_t begin;
+    int64_t end;
+    if (!msg.getInteger (BeginSeqNo, begin) || !msg.getInteger (EndSeqNo, end))
+    {
+        mLog->warn ("resend request without BeginSeqNo and EndSeqNo");
+        return;
+    }
+
+    lock ();
+    int64_t last = mSeqnums.mOutbound - 1;
+    unlock ();
+
+    if (!gwcFixResend::range (begin, end, last))
         return;
 
-    /* we won't replay old messages so lets reset seqno */
-    cdr sr;
-    sr.setString (MsgType, FixSequenceReset);
-    sr.setInteger (NewSeqNo, mSeqnums.mOutbound + 1);
-    sendMsg (sr);
+    mLog->info ("resending %ld to %ld", begin, end);
+    resend (begin, end);
+}
+
+void
+gwcFix::resend (int64_t begin, int64_t end)
+{
+    char           now[GWC_FIX_TIME_SIZE];
+    size_t         nowSize = mClock.now (now);
+    vector<char>   out;
+    vector<size_t> sizes;
+    size_t         failed = 0;
+
+    /* send in pieces so live messages aren't held up behind a large
+       resend */
+    out.reserve (GWC_FIX_RESEND_SIZE + 2 * GWC_FIX_STORE_MSG_SIZE);
+    while (begin <= end)
+    {
+        begin = mResend.build (mMessageStore,
+                               begin,
+                               end,
+                               now,
+                               nowSize,
+                               out,
+                               sizes,
+                               failed);
+        sendResend (out, sizes);
+        out.clear ();
+        sizes.clear ();
+    }
+
+    if (failed > 0)
+        mLog->warn ("failed to resend %lu messages, gap filled", (unsigned long)failed);
+}
+
+void
+gwcFix::sendResend (const vector<char>& data, const vector<size_t>& sizes)
+{
+    if (data.empty ())
+        return;
+
+    /* resent messages keep their seqnums, nothing is claimed */
+    if (mOutboundRing)
+        mOutboundRing->sendDirect (&data[0], data.size ());
+    else
+    {
+        lock ();
+        if (mState != GWC_CONNECTOR_CONNECTED &&
+            mState != GWC_CONNECTOR_READY)
+        {
+            mLog->warn ("gwc not connected to resend messages");
+            unlock ();
+            return;
+        }
+        mTcpConnection->send ((void*)&data[0], data.size ());
+        unlock ();
+    }
+
+    size_t offset = 0;
+    for (size_t i = 0; i < sizes.size (); i++)
+    {
+        journalOut (&data[offset], sizes[i]);
+        offset += sizes[i];
+    }
 }
 
 void
@@ -516,13 +687,12 @@ gwcFix::handleSequenceResetMsg (int64_t seqno, cdr& msg)
     if (!msg.getInteger (NewSeqNo, newseqno))
         return;
 
-    mLog->debug ("sequence reset: %ld", newseqno);
+    GWC_LOG_DEBUG ("sequence reset: %ld", newseqno);
 
     lock ();
 
     mSeqnums.mInbound = newseqno;
-    sbfCacheFile_write (mCacheItem, &mSeqnums);
-    sbfCacheFile_flush (mCacheFile);
+    mSeqnumStore.write (mCacheItem, &mSeqnums, sizeof mSeqnums);
 
     unlock ();
 }
@@ -599,7 +769,15 @@ gwcFix::init (gwcSessionCallbacks* sessionCbs,
                 const neueda::properties& props)
 {
     mSessionsCbs = sessionCbs;
-    mMessageCbs = messageCbs;
+    if (!initLatency (props, messageCbs))
+        return false;
+
+    if (!initOrderCache (props))
+        return false;
+    if (!initRisk (props))
+        return false;
+    if (mTypedCbs != NULL && !typedCallbacksAllowed ())
+        return false;
 
     string v;
     if (!props.get ("host", v))
@@ -664,6 +842,14 @@ gwcFix::init (gwcSessionCallbacks* sessionCbs,
         return false;
     }
 
+    if (!mHeader.init (mBeginString, mSenderCompID, mTargetCompID) ||
+        !mResend.init (mBeginString, mSenderCompID, mTargetCompID))
+    {
+        mLog->err ("sender_comp_id and target_comp_id are too long");
+        return false;
+    }
+    mLog->info ("inbound messages scanned with %s", gwcFix_simdName ());
+
     if (!props.get ("data_dictionary", mDataDictionary))
     {
         mLog->err ("missing property data_dictionary");
@@ -676,28 +862,34 @@ gwcFix::init (gwcSessionCallbacks* sessionCbs,
         mLog->err ("failed to load data_dictionary %s", err.c_str ());
         return false;
     }   
+    if (!mLogCodec.loadDataDictionary (mDataDictionary.c_str (), err))
+    {
+        mLog->err ("failed to load data_dictionary %s", err.c_str ());
+        return false;
+    }
 
     string cacheFileName;
     props.get ("seqno_cache", "fix.seqno.cache", cacheFileName);
     
+    if (!initSeqnumStore (props))
+        return false;
+
     int created;
-    mCacheFile = sbfCacheFile_open (cacheFileName.c_str (),
-                                    sizeof (gwcFixSeqnums),
-                                    0,
-                                    &created,
-                                    cacheFileItemCb,
-                                    this);
-    if (mCacheFile == NULL)
-    {
-        mLog->err ("failed to create fix seqno cache file");
+    if (!mSeqnumStore.open (cacheFileName,
+                            sizeof (gwcFixSeqnums),
+                            &created,
+                            cacheFileItemCb,
+                            this,
+                            err))
+    {
+        mLog->err ("failed to create fix seqno cache file: %s", err.c_str ());
         return false;
     }
 
     if (created)
     {
         mLog->info ("created seqno cachefile %s", cacheFileName.c_str ());
-        mCacheItem = sbfCacheFile_add (mCacheFile, &mSeqnums);
-        sbfCacheFile_flush (mCacheFile);
+        mCacheItem = mSeqnumStore.add (&mSeqnums);
     }
 
     string enableRaw;
@@ -708,101 +900,96 @@ gwcFix::init (gwcSessionCallbacks* sessionCbs,
         return false;
     }
 
-    sbfKeyValue kv = sbfKeyValue_create ();
-    mMw = sbfMw_create (mSbfLog, kv);
-    sbfKeyValue_destroy (kv);
-    if (mMw == NULL)
-    {
-        mLog->err ("failed to create mw");
+    if (!initOutboundRing (props))
         return false;
-    }
 
-    // could add a prop to make queue spin for max performance
-    mQueue = sbfQueue_create (mMw, "default");
-    if (mQueue == NULL)
+    /* first producer finds a codec ready */
+    if (mOutboundRing)
     {
-        mLog->err ("failed to create queue");
-        return false;
+        fixCodec* codec = takeCodec ();
+        if (codec == NULL)
+            return false;
+        giveCodec (codec);
     }
 
-    // start to dispatch 
-    if (sbfThread_create (&mThread, gwcFix::dispatchCb, this) != 0)
-    {
-        mLog->err ("failed to start dispatch queue");
+    if (!initDispatch (props))
         return false;
-    }
-
-    int fileCount = 0;
-    int maxSize = 0;
-    string messagesIn;
-    if (props.get ("messages_in", messagesIn))
-    {
-        mLog->info ("inbound messages file: %s", messagesIn.c_str ());
 
+    if (!initLog (props, true))
+        return false;
 
-        if (props.get ("messages_in_count", fileCount, valid))
+    /* the old message files become the journal, which holds both ways */
+    std::string messages;
+    if (props.get ("messages_in", messages) || props.get ("messages_out", messages))
+    {
+        if (props.get ("journal", v))
         {
-            if (!valid)
-            {
-                mLog->err ("failed to parse messages_in_count");
-                return false;
-            }
+            mLog->warn ("messages_in and messages_out ignored, journal is set");
+            messages.clear ();
         }
-
-        if (props.get ("messages_in_maxsize", maxSize, valid))
+        else
         {
-            if (!valid)
-            {
-                mLog->err ("failed to parse messages_in_maxsize");
-                return false;
-            }
+            mLog->warn ("messages_in and messages_out are replaced by journal, "
+                        "journalling both ways to %s",
+                        messages.c_str ());
         }
+    }
 
-        mMsgInWriter = new msgWriter (messagesIn, maxSize, fileCount);
-        if (!mMsgInWriter->setup (err))
+    if (!initJournal (props, cacheFileName, messages))
+        return false;
+
+    if (props.get ("sending_time_precision", v))
+    {
+        gwcFixTimePrecision precision;
+        if (!gwcFixClock_parsePrecision (v, precision))
         {
-            mLog->err ("%s", err.c_str ());
+            mLog->err ("invalid sending_time_precision %s", v.c_str ());
             return false;
         }
+        mClock.setPrecision (precision);
     }
 
-    string messagesOut;
-    if (props.get ("messages_out", messagesOut))
+    if (props.get ("message_store", v))
     {
-        fileCount = 0;
-        maxSize = 0;
-        mLog->info ("outbound messages file: %s", messagesOut.c_str ());
-
-        if (props.get ("messages_out_count", fileCount, valid))
+        int slots = GWC_FIX_STORE_SIZE;
+        if (props.get ("message_store_size", slots, valid))
         {
-            if (!valid)
+            if (!valid || slots <= 0)
             {
-                mLog->err ("failed to parse messages_out_count");
+                mLog->err ("failed to parse message_store_size");
                 return false;
             }
         }
 
-        if (props.get ("messages_out_maxsize", maxSize, valid))
+        if (!mMessageStore.open (v, slots, err))
         {
-            if (!valid)
-            {
-                mLog->err ("failed to parse messages_out_maxsize");
-                return false;
-            }
+            mLog->err ("failed to open message_store: %s", err.c_str ());
+            return false;
         }
+    }
 
-        // same messages file, share writer
-        if (!messagesIn.empty () && messagesIn == messagesOut)
-            mMsgOutWriter = mMsgInWriter;
-        else
-        {
-            mMsgOutWriter = new msgWriter (messagesOut, maxSize, fileCount);
-            if (!mMsgOutWriter->setup (err))
-            {
-                mLog->err ("%s", err.c_str ());
-                return false;
-            }
-        }
+    mMw = createMw ();
+    if (mMw == NULL)
+    {
+        mLog->err ("failed to create mw");
+        return false;
+    }
+
+    mQueue = sbfQueue_create (mMw, "default");
+    if (mQueue == NULL)
+    {
+        mLog->err ("failed to create queue");
+        return false;
+    }
+
+    if (!initThrottle (props, mMw, mQueue))
+        return false;
+
+    // start to dispatch 
+    if (sbfThread_create (&mThread, gwcFix::dispatchCb, this) != 0)
+    {
+        mLog->err ("failed to start dispatch queue");
+        return false;
     }
 
     mDispatching = true;
@@ -826,8 +1013,8 @@ gwcFix::start (bool reset)
         mSeqnums.mInbound = 1;
         mSeqnums.mOutbound = 1;
 
-        sbfCacheFile_write (mCacheItem, &mSeqnums);
-        sbfCacheFile_flush (mCacheFile);
+        mSeqnumStore.write (mCacheItem, &mSeqnums, sizeof mSeqnums);
+        mMessageStore.clear ();
 
         unlock ();
     }
@@ -1018,6 +1205,8 @@ gwcFix::traderLogon (const cdr* msg)
 bool
 gwcFix::sendOrder (gwcOrder& order)
 {
+    gwcLatencyScope latency (mLatency);
+
     if (!mapOrderFields (order))
         return false;
 
@@ -1026,22 +1215,27 @@ gwcFix::sendOrder (gwcOrder& order)
 
 bool 
 gwcFix::sendOrder (cdr& order)
+{
+    gwcLatencyScope latency (mLatency);
+
+    prepareOrder (order);
+    return sendChecked (order);
+}
+
+void
+gwcFix::prepareOrder (cdr& order)
 {
     order.setString (MsgType, FixNewOrderSingle);
 
     if (!order.contains (TransactTime))
-    {
-        cdrDateTime dt;
-        getTime (dt);
-        order.setDateTime (TransactTime, dt);
-    }
-
-    return sendMsg (order);
+        setTime (order, TransactTime);
 }
 
 bool
 gwcFix::sendCancel (gwcOrder& cancel)
 {
+    gwcLatencyScope latency (mLatency);
+
     if (!mapOrderFields (cancel))
         return false;
 
@@ -1050,22 +1244,27 @@ gwcFix::sendCancel (gwcOrder& cancel)
 
 bool 
 gwcFix::sendCancel (cdr& cancel)
+{
+    gwcLatencyScope latency (mLatency);
+
+    prepareCancel (cancel);
+    return sendPaced (cancel);
+}
+
+void
+gwcFix::prepareCancel (cdr& cancel)
 {
     cancel.setString (MsgType, FixOrderCancelRequest);
 
     if (!cancel.contains (TransactTime))
-    {
-        cdrDateTime dt;
-        getTime (dt);
-        cancel.setDateTime (TransactTime, dt);
-    }
-
-    return sendMsg (cancel);
+        setTime (cancel, TransactTime);
 }
 
 bool
 gwcFix::sendModify (gwcOrder& modify)
 {
+    gwcLatencyScope latency (mLatency);
+
     if (!mapOrderFields (modify))
         return false;
 
@@ -1074,23 +1273,32 @@ gwcFix::sendModify (gwcOrder& modify)
 
 bool 
 gwcFix::sendModify (cdr& modify)
+{
+    gwcLatencyScope latency (mLatency);
+
+    prepareModify (modify);
+    return sendModifyChecked (modify);
+}
+
+void
+gwcFix::prepareModify (cdr& modify)
 {
     modify.setString (MsgType, FixOrderCancelReplaceRequest);
 
     if (!modify.contains (TransactTime))
-    {
-        cdrDateTime dt;
-        getTime (dt);
-        modify.setDateTime (TransactTime, dt);
-    }
-
-    return sendMsg (modify);
+        setTime (modify, TransactTime);
 }
 
 bool 
 gwcFix::sendMsg (cdr& msg)
 {
-    char space[1024];
+    gwcLatencyScope latency (mLatency);
+
+    if (mOutboundRing)
+        return sendMsgRing (msg);
+
+    char space[GWC_FIX_HEADER_ROOM + 1024];
+    char* data;
     size_t used = 0;
 
 
@@ -1102,41 +1310,454 @@ gwcFix::sendMsg (cdr& msg)
         return false;
     }
 
-    setHeader (msg);
-
-    if (mCodec.encode (msg, space, sizeof space, used) != GW_CODEC_SUCCESS)
+    /* seqnum is taken for good, and stored, once the message is sent */
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_SEQUENCED, latencyKey (msg));
+    if (!encodeMsg (mCodec, msg, mSeqnums.mOutbound, space, sizeof space, data, used))
     {
-        mLog->err ("failed to construct logon message [%s]",
-                   mCodec.getLastError ().c_str ());
-
         unlock ();
         return false;
     }
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_ENCODED);
 
-    mLog->debug ("msg out..");
-    mLog->debug ("%s", msg.toString ().c_str ());
+    logMsg (GWC_LOG_LEVEL_DEBUG, "msg out..", msg, data, used);
 
-    mTcpConnection->send (space, used);
-    if (mMsgOutWriter)
-        mMsgOutWriter->write ((void*)space, used);
+    mTcpConnection->send (data, used);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN);
+    journalOut (data, used);
+    mMessageStore.add (mSeqnums.mOutbound, data, used);
 
     mSeqnums.mOutbound++;
-    sbfCacheFile_write (mCacheItem, &mSeqnums);
-    sbfCacheFile_flush (mCacheFile);
+    mSeqnumStore.write (mCacheItem, &mSeqnums, sizeof mSeqnums);
+
+    unlock ();
+    return true;
+}
+
+bool 
+gwcFix::sendMsgs (cdr** msgs, size_t n)
+{
+    gwcLatencyScope latency (mLatency);
+
+    if (mOutboundRing)
+        return sendMsgsRing (msgs, n);
+
+    /* a framed message can take the header room as well */
+    vector<char> space (n * (GWC_FIX_HEADER_ROOM + GWC_BATCH_MSG_SIZE));
+    vector<size_t> sizes (n);
+    size_t total = 0;
+
+    lock ();
+    if (mState != GWC_CONNECTOR_READY)
+    {
+        mLog->warn ("gwc not ready to send messages");
+        unlock ();
+        return false;
+    }
+
+    /* seqnums are contiguous across the batch, all are rolled back if a 
+       message fails to encode as nothing will be sent */
+    int64_t outbound = mSeqnums.mOutbound;
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_SEQUENCED, latencyKey (*msgs[0]));
+    for (size_t i = 0; i < n; i++)
+    {
+        cdr& msg = *msgs[i];
+        char encoded[GWC_FIX_HEADER_ROOM + GWC_BATCH_MSG_SIZE];
+        char* data;
+
+        if (!encodeMsg (mCodec,
+                        msg, 
+                        mSeqnums.mOutbound, 
+                        encoded, 
+                        sizeof encoded, 
+                        data, 
+                        sizes[i]))
+        {
+            mSeqnums.mOutbound = outbound;
+            unlock ();
+            return false;
+        }
+        memcpy (&space[total], data, sizes[i]);
+        logMsg (GWC_LOG_LEVEL_DEBUG, "msg out..", msg, &space[total], sizes[i]);
+        total += sizes[i];
+        mSeqnums.mOutbound++;
+    }
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_ENCODED);
+
+    mTcpConnection->send (&space[0], total);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN);
+    size_t offset = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        journalOut (&space[offset], sizes[i]);
+        mMessageStore.add (outbound + i, &space[offset], sizes[i]);
+        offset += sizes[i];
+    }
+
+    mSeqnumStore.write (mCacheItem, &mSeqnums, sizeof mSeqnums);
 
     unlock ();
     return true;
 }
 
+bool
+gwcFix::formatLogMsg (const void* data, size_t size, std::string& out)
+{
+    cdr    msg;
+    size_t used = 0;
+
+    if (mLogCodec.decode (msg, data, size, used) != GW_CODEC_SUCCESS)
+        return false;
+    out = msg.toString ();
+    return true;
+}
+
+uint32_t
+gwcFix::latencyKey (const cdr& msg)
+{
+    string msgType;
+    msg.getString (MsgType, msgType);
+    return gwcLatency_key (msgType);
+}
+
+bool
+gwcFix::encodeBody (fixCodec& codec, 
+                    cdr& msg, 
+                    char* space, 
+                    size_t size, 
+                    size_t& used)
+{
+    /* the codec encodes MsgType and the body, the session header is
+       written in front of it */
+    char* body = space + GWC_FIX_HEADER_ROOM;
+    size_t room = size - GWC_FIX_HEADER_ROOM - GWC_FIX_TRAILER_SIZE;
+
+    used = 0;
+    if (codec.encode (msg, body, room, used) != GW_CODEC_SUCCESS)
+    {
+        mLog->err ("failed to construct message [%s]",
+                   codec.getLastError ().c_str ());
+        return false;
+    }
+    return true;
+}
+
+bool
+gwcFix::frameMsg (char* space, 
+                  size_t size, 
+                  int64_t seqnum, 
+                  char*& data, 
+                  size_t& used)
+{
+    char time[GWC_FIX_TIME_SIZE];
+    size_t timeSize = mClock.now (time);
+
+    data = mHeader.frame (space + GWC_FIX_HEADER_ROOM, used, seqnum, time, timeSize);
+    if (data == NULL || used > size - GWC_FIX_HEADER_ROOM)
+    {
+        mLog->err ("failed to construct message header");
+        return false;
+    }
+    return true;
+}
+
+bool
+gwcFix::encodeMsg (fixCodec& codec,
+                   cdr& msg, 
+                   int64_t seqnum, 
+                   char* space, 
+                   size_t size, 
+                   char*& data, 
+                   size_t& used)
+{
+    return encodeBody (codec, msg, space, size, used) &&
+           frameMsg (space, size, seqnum, data, used);
+}
+
+bool
+gwcFix::frameOutbound (fixCodec& codec,
+                       cdr& msg, 
+                       bool encoded,
+                       uint64_t seqnum, 
+                       char* space, 
+                       size_t size, 
+                       char*& data, 
+                       size_t& used)
+{
+    if (encoded && frameMsg (space, size, (int64_t)seqnum, data, used))
+    {
+        logMsg (GWC_LOG_LEVEL_DEBUG, "msg out..", msg, data, used);
+        return true;
+    }
+
+    /* the seqnum is already claimed, fill the gap so the exchange doesn't
+       see a hole in our sequence */
+    cdr gap;
+    gap.setString (MsgType, FixSequenceReset);
+    gap.setString (GapFillFlag, "Y");
+    gap.setInteger (NewSeqNo, seqnum + 1);
+    if (!encodeMsg (codec, gap, seqnum, space, size, data, used))
+    {
+        mLog->err ("failed to construct gap fill");
+        used = 0;
+    }
+    return false;
+}
+
+fixCodec*
+gwcFix::takeCodec ()
+{
+    /* producers encode with a codec of their own rather than share
+       mCodec, each slot is taken or returned with a single swap */
+    for (size_t i = 0; i < GWC_FIX_CODECS; i++)
+    {
+        fixCodec* codec = mCodecs[i];
+        if (codec != NULL && gwcFix_casPtr (&mCodecs[i], codec, (fixCodec*)NULL))
+            return codec;
+    }
+
+    fixCodec* codec = new fixCodec ();
+    string err;
+    if (!codec->loadDataDictionary (mDataDictionary.c_str (), err))
+    {
+        mLog->err ("failed to load data_dictionary %s", err.c_str ());
+        delete codec;
+        return NULL;
+    }
+    return codec;
+}
+
+void
+gwcFix::giveCodec (fixCodec* codec)
+{
+    for (size_t i = 0; i < GWC_FIX_CODECS; i++)
+    {
+        if (mCodecs[i] == NULL && gwcFix_casPtr (&mCodecs[i], (fixCodec*)NULL, codec))
+            return;
+    }
+    delete codec;
+}
+
+bool
+gwcFix::needsSeqnum (const cdr& msg)
+{
+    string msgType;
+    msg.getString (MsgType, msgType);
+    return msgType == gwcFix::FixSequenceReset && !msg.contains (NewSeqNo);
+}
+
+bool 
+gwcFix::sendMsgRing (cdr& msg)
+{
+    char space[GWC_FIX_HEADER_ROOM + GWC_OUTBOUND_SLOT_SIZE];
+    char* data = space;
+    size_t used = 0;
+
+    if (mState != GWC_CONNECTOR_READY)
+    {
+        mLog->warn ("gwc not ready to send messages");
+        return false;
+    }
+
+    fixCodec* codec = takeCodec ();
+    if (codec == NULL)
+        return false;
+
+    /* encoded before the seqnum is claimed so a message that fails takes
+       none, the header with the seqnum is framed around it afterwards */
+    bool     claimed = needsSeqnum (msg);
+    uint64_t ticket = 0;
+    if (claimed)
+    {
+        ticket = mOutboundRing->claim ();
+        msg.setInteger (NewSeqNo, gwcOutboundRing::seqnum (ticket) + 1);
+    }
+
+    /* the body is capped so the framed message fits a ring slot */
+    size_t limit = sizeof space - mHeader.maxSize ();
+    bool encoded = encodeBody (*codec, msg, space, limit, used);
+    if (!encoded && !claimed)
+    {
+        giveCodec (codec);
+        return false;
+    }
+
+    if (!claimed)
+        ticket = mOutboundRing->claim ();
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_SEQUENCED, latencyKey (msg));
+
+    bool ok = frameOutbound (*codec, 
+                             msg, 
+                             encoded, 
+                             gwcOutboundRing::seqnum (ticket), 
+                             space, 
+                             sizeof space, 
+                             data, 
+                             used);
+    giveCodec (codec);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_ENCODED);
+
+    if (!mOutboundRing->publish (ticket, data, used))
+    {
+        mLog->warn ("session reset before message could be sent");
+        return false;
+    }
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN);
+    return ok;
+}
+
+bool 
+gwcFix::sendMsgsRing (cdr** msgs, size_t n)
+{
+    size_t slot = GWC_FIX_HEADER_ROOM + GWC_OUTBOUND_SLOT_SIZE;
+    size_t limit = slot - mHeader.maxSize ();
+    vector<char> space (n * slot);
+    vector<char*> data (n);
+    vector<size_t> sizes (n);
+    vector<char> encoded (n);
+    bool ok = true;
+
+    if (mState != GWC_CONNECTOR_READY)
+    {
+        mLog->warn ("gwc not ready to send messages");
+        return false;
+    }
+
+    fixCodec* codec = takeCodec ();
+    if (codec == NULL)
+        return false;
+
+    /* seqnums are contiguous across the batch and claimed once all are
+       encoded, unless a SequenceReset needs its seqnum first. Once claimed
+       a message that fails is gap filled */
+    bool claimed = false;
+    for (size_t i = 0; i < n; i++)
+        claimed = claimed || needsSeqnum (*msgs[i]);
+
+    uint64_t ticket = 0;
+    if (claimed)
+    {
+        ticket = mOutboundRing->claim (n);
+        for (size_t i = 0; i < n; i++)
+        {
+            if (needsSeqnum (*msgs[i]))
+                msgs[i]->setInteger (NewSeqNo, gwcOutboundRing::seqnum (ticket) + i + 1);
+        }
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        data[i] = &space[i * slot];
+        encoded[i] = encodeBody (*codec, *msgs[i], &space[i * slot], limit, sizes[i]);
+        if (!encoded[i] && !claimed)
+        {
+            giveCodec (codec);
+            return false;
+        }
+    }
+
+    if (!claimed)
+        ticket = mOutboundRing->claim (n);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_SEQUENCED, latencyKey (*msgs[0]));
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (!frameOutbound (*codec,
+                            *msgs[i],
+                            encoded[i] != 0,
+                            gwcOutboundRing::seqnum (ticket) + i,
+                            &space[i * slot],
+                            slot,
+                            data[i],
+                            sizes[i]))
+        {
+            ok = false;
+        }
+    }
+    giveCodec (codec);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_ENCODED);
+
+    bool published = true;
+    for (size_t i = 0; i < n; i++)
+        published = mOutboundRing->publish (ticket + i, data[i], sizes[i]) && published;
+    if (!published)
+    {
+        mLog->warn ("session reset before messages could be sent");
+        return false;
+    }
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN);
+    return ok;
+}
+
+size_t
+gwcFix::onReplay (void* data, size_t size)
+{
+    return mTcpConnectionDelegate.onRead (data, size);
+}
+
+void
+gwcFix::onOutboundSend (const void* data, size_t size)
+{
+    lock ();
+    if (mTcpConnection)
+        mTcpConnection->send ((void*)data, size);
+    unlock ();
+}
+
+void
+gwcFix::onOutboundSent (uint64_t seq, const void* data, size_t size)
+{
+    journalOut (data, size);
+    mMessageStore.add ((int64_t)seq, data, size);
+}
+
+void
+gwcFix::onOutboundDrained (uint64_t next)
+{
+    /* seqnum cache is written once per drained group rather than per
+       message */
+    lock ();
+    mSeqnums.mOutbound = next;
+    mSeqnumStore.write (mCacheItem, &mSeqnums, sizeof mSeqnums);
+    unlock ();
+}
+
 bool
 gwcFix::sendRaw (void* data, size_t len)
 {
+    gwcLatencyScope latency (mLatency);
+
     if (!mRawEnabled)
     {
         mLog->warn ("raw send interface not enabled");
         return false;
     }    
 
+    if (mOutboundRing)
+    {
+        if (mState != GWC_CONNECTOR_READY)
+        {
+            mLog->warn ("gwc not ready to send messages");
+            return false;
+        }
+        mOutboundRing->sendDirect (data, len);
+        if (mLatency)
+            mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN, 0);
+        journalOut (data, len);
+        return true;
+    }
+
     lock ();
 
     /* XXX need to setup seqnum */
@@ -1148,6 +1769,39 @@ gwcFix::sendRaw (void* data, size_t len)
     }
  
     mTcpConnection->send (data, len);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN, 0);
+    journalOut (data, len);
     unlock ();
     return true;
 }
+
+bool
+gwcFix::getClOrdId (const cdr& msg, bool orig, std::string& id) const
+{
+    return getIdField (msg, orig ? OrigClOrdID : ClOrdID, id);
+}
+
+void
+gwcFix::getOrderFields (const cdr& msg, gwcOrderFields& fields) const
+{
+    getIdField (msg, OrderID, fields.mOrderId);
+    fields.mHasOrderQty = getNumberField (msg, OrderQty, fields.mOrderQty);
+    fields.mHasLeavesQty = getNumberField (msg, LeavesQty, fields.mLeavesQty);
+    fields.mHasCumQty = getNumberField (msg, CumQty, fields.mCumQty);
+    fields.mHasLastQty = getNumberField (msg, LastShares, fields.mLastQty);
+    fields.mHasLastPx = getNumberField (msg, LastPx, fields.mLastPx);
+}
+
+void
+gwcFix::getRiskFields (const cdr& msg, gwcRiskFields& fields) const
+{
+    std::string side;
+
+    getIdField (msg, Symbol, fields.mInstrument);
+    getIdField (msg, Account, fields.mAccount);
+    fields.mHasSide = msg.getString (Side, side) && !side.empty ();
+    fields.mBuy = fields.mHasSide && side[0] == '1';
+    fields.mHasQty = getNumberField (msg, OrderQty, fields.mQty);
+    fields.mHasPrice = getNumberField (msg, Price, fields.mPrice);
+}
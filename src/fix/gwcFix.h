@@ -3,6 +3,11 @@
  * Fix connector 
  */
 #include "gwcConnector.h"
+#include "gwcFixClock.h"
+#include "gwcFixHeader.h"
+#include "gwcFixMessageStore.h"
+#include "gwcFixResend.h"
+#include "gwcFixScanner.h"
 #include "fixCodec.h"
 
 #include "SbfTcpConnection.hpp"
@@ -10,9 +15,9 @@
 #include "sbfMw.h"
 
 #include "fixCodec.h"
-#include "msgWriter.h"
 
 #include <map>
+#include <vector>
 
 using namespace std;
 using namespace neueda;
@@ -31,6 +36,28 @@ extern const string FixBusinessMessageReject;
 extern const string FixOrderCancelRequest;
 extern const string FixOrderCancelReplaceRequest;
 
+/* Codecs kept loaded for producers sending through the outbound ring */
+#define GWC_FIX_CODECS 16
+
+/* Set on a fix connector with setTypedCallbacks to be handed execution
+   reports and rejects as scanned views of the wire message instead of
+   decoded cdrs. The view is only valid for the duration of the callback */
+class gwcFixTypedCallbacks
+{
+public:
+    /* dtor */
+    virtual ~gwcFixTypedCallbacks () {};
+
+    /* On execution report, acks/fills/done/rejects */
+    virtual void onExecutionReport (uint64_t seqno, const gwcFixMessage& msg) {};
+
+    /* On cancel rejected */
+    virtual void onOrderCancelReject (uint64_t seqno, const gwcFixMessage& msg) {};
+
+    /* On business reject */
+    virtual void onBusinessReject (uint64_t seqno, const gwcFixMessage& msg) {};
+};
+
 class gwcFix;
 
 class gwcFixTcpConnectionDelegate : public SbfTcpConnectionDelegate
@@ -97,11 +124,38 @@ public:
     virtual bool sendMsg (cdr& msg);
     virtual bool sendRaw (void* data, size_t len);
 
+    virtual bool getClOrdId (const cdr& msg, bool orig, std::string& id) const;
+
+    virtual void getOrderFields (const cdr& msg, gwcOrderFields& fields) const;
+
+    virtual void getRiskFields (const cdr& msg, gwcRiskFields& fields) const;
+
+    /* Set typed callbacks for execution reports and rejects, NULL to go 
+       back to cdr callbacks. False if the connector has an order cache or
+       risk checks */
+    bool setTypedCallbacks (gwcFixTypedCallbacks* typedCbs)
+    {
+        if (typedCbs != NULL && !typedCallbacksAllowed ())
+            return false;
+
+        mTypedCbs = typedCbs;
+        return true;
+    }
+
 protected:
+    virtual void prepareOrder (cdr& order);
+    virtual void prepareCancel (cdr& cancel);
+    virtual void prepareModify (cdr& modify);
+    virtual bool sendMsgs (cdr** msgs, size_t n);
+    virtual size_t onReplay (void* data, size_t size);
+    virtual void onOutboundSend (const void* data, size_t size);
+    virtual void onOutboundSent (uint64_t seq, const void* data, size_t size);
+    virtual void onOutboundDrained (uint64_t next);
+    virtual bool formatLogMsg (const void* data, size_t size, std::string& out);
+
     SbfTcpConnection*           mTcpConnection;
     gwcFixTcpConnectionDelegate mTcpConnectionDelegate;
 
-    sbfCacheFile                mCacheFile;
     sbfCacheFileItem            mCacheItem;
     sbfMw                       mMw;
     sbfQueue                    mQueue;
@@ -112,17 +166,35 @@ private:
     // utility methods
     void reset ();
     void error (const string& err);
-    void getTime (cdrDateTime& dt);
+    void setTime (cdr& d, int field);
     void setHeader (cdr& d);
+    uint32_t latencyKey (const cdr& msg);
+    bool encodeBody (fixCodec& codec, cdr& msg, char* space, size_t size, size_t& used);
+    bool frameMsg (char* space, size_t size, int64_t seqnum, char*& data, size_t& used);
+    bool encodeMsg (fixCodec& codec, cdr& msg, int64_t seqnum, char* space, size_t size, char*& data, size_t& used);
+    bool frameOutbound (fixCodec& codec, cdr& msg, bool encoded, uint64_t seqnum, char* space, size_t size, char*& data, size_t& used);
+    fixCodec* takeCodec ();
+    /* A SequenceReset without NewSeqNo has it set from its own seqnum */
+    static bool needsSeqnum (const cdr& msg);
+    void giveCodec (fixCodec* codec);
+    bool sendMsgRing (cdr& msg);
+    bool sendMsgsRing (cdr** msgs, size_t n);
     bool mapOrderFields (gwcOrder& o);
 
+    // resend from the message store
+    void resend (int64_t begin, int64_t end);
+    void sendResend (const vector<char>& data, const vector<size_t>& sizes);
+
     // handle state
     void onTcpConnectionReady ();
     void onTcpConnectionError ();
     size_t onTcpConnectionRead (void* data, size_t size);
     
-    // handle messages
-    void handleTcpMsg (cdr& msg);
+    // handle messages, msgType is packed as by gwcFix_msgType
+    void handleTcpMsg (uint32_t msgType, cdr& msg);
+    bool handleTypedMsg (const gwcFixMessage& msg, uint64_t read);
+    bool checkSeqnum (int64_t seqnum);
+    void handleHeartbeatMsg (int64_t seqno, cdr& msg);
     void handleLogoutMsg (int64_t seqno, cdr& msg);
     void handleTestRequestMsg (int64_t seqno, cdr& msg);
     void handleResendRequestMsg (int64_t seqno, cdr& msg);
@@ -132,6 +204,18 @@ private:
     void handleBusinessRejectMsg (int64_t seqno, cdr& msg);
     void handleRejectMsg (int64_t seqno, cdr& msg);
 
+    typedef void (gwcFix::*msgHandler) (int64_t seqno, cdr& msg);
+
+    /* Handlers for single character message types after the seqno check,
+       NULL for types passed to onMsg */
+    struct msgHandlers
+    {
+        msgHandlers ();
+
+        msgHandler mHandlers[256];
+    };
+    static const msgHandlers sHandlers;
+
     static void* dispatchCb (void* closure);
     static sbfError cacheFileItemCb (sbfCacheFile file, 
                                      sbfCacheFileItem item, 
@@ -155,12 +239,19 @@ private:
     sbfTimer                mHb;
     sbfTimer                mReconnectTimer;
     fixCodec                mCodec;
+    fixCodec                mLogCodec;
+    fixCodec* volatile      mCodecs[GWC_FIX_CODECS];
+    cdr                     mInboundMsg;
     bool                    mSeenHb;
     int                     mMissedHb;
     int                     mEncryptMethod;
     bool                    mSetNextExpSeqNum;
     gwcFixSeqnums           mSeqnums;
-    msgWriter*              mMsgInWriter;
-    msgWriter*              mMsgOutWriter;
+    gwcFixMessageStore      mMessageStore;
+    gwcFixResend            mResend;
+    gwcFixClock             mClock;
+    gwcFixHeader            mHeader;
+    gwcFixTypedCallbacks*   mTypedCbs;
+    gwcFixMessage           mScanMsg;
 };
 
@@ -0,0 +1,104 @@
+#include "gwcFixClock.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef WIN32
+#include <windows.h>
+#define gwcFixClock_cas(p, o, n) \
+    (InterlockedCompareExchange64 ((volatile LONG64*)(p), (LONG64)(n), (LONG64)(o)) == (LONG64)(o))
+#define gwcFixClock_barrier() MemoryBarrier ()
+#else
+#define gwcFixClock_cas(p, o, n) __sync_bool_compare_and_swap ((p), (o), (n))
+#define gwcFixClock_barrier() __sync_synchronize ()
+#endif
+
+/* YYYYMMDD-HH:MM:SS. */
+#define GWC_FIX_TIME_PREFIX 18
+
+bool
+gwcFixClock_parsePrecision (const std::string& value,
+                            gwcFixTimePrecision& precision)
+{
+    if (value == "milli")
+        precision = GWC_FIX_TIME_MILLIS;
+    else if (value == "micro")
+        precision = GWC_FIX_TIME_MICROS;
+    else if (value == "nano")
+        precision = GWC_FIX_TIME_NANOS;
+    else
+        return false;
+    return true;
+}
+
+gwcFixClock::gwcFixClock () :
+    mVersion (0),
+    mSecond (-1),
+    mPrecision (GWC_FIX_TIME_MILLIS)
+{
+    memset (mPrefix, 0, sizeof mPrefix);
+}
+
+size_t
+gwcFixClock::now (char* s)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_REALTIME, &ts);
+    return render (ts, s);
+}
+
+size_t
+gwcFixClock::render (const struct timespec& ts, char* s)
+{
+    /* the cached second is only used if it wasn't changing while copied */
+    uint64_t version = mVersion;
+    gwcFixClock_barrier ();
+    bool cached = (version & 1) == 0 && mSecond == (int64_t)ts.tv_sec;
+    if (cached)
+    {
+        memcpy (s, mPrefix, GWC_FIX_TIME_PREFIX);
+        gwcFixClock_barrier ();
+        cached = mVersion == version;
+    }
+
+    if (!cached)
+    {
+        time_t    t = ts.tv_sec;
+        struct tm tm;
+        gmtime_r (&t, &tm);
+
+        char prefix[80];
+        snprintf (prefix,
+                  sizeof prefix,
+                  "%04d%02d%02d-%02d:%02d:%02d.",
+                  1900 + tm.tm_year,
+                  1 + tm.tm_mon,
+                  tm.tm_mday,
+                  tm.tm_hour,
+                  tm.tm_min,
+                  tm.tm_sec);
+        memcpy (s, prefix, GWC_FIX_TIME_PREFIX);
+
+        /* one thread refreshes the cache, the others render their own */
+        if ((version & 1) == 0 && gwcFixClock_cas (&mVersion, version, version + 1))
+        {
+            memcpy (mPrefix, prefix, GWC_FIX_TIME_PREFIX);
+            mSecond = (int64_t)ts.tv_sec;
+            gwcFixClock_barrier ();
+            mVersion = version + 2;
+        }
+    }
+
+    /* fraction digits right to left, truncated to the precision */
+    uint32_t fraction = (uint32_t)ts.tv_nsec;
+    int      digits = mPrecision;
+    for (int i = digits; i < 9; i++)
+        fraction /= 10;
+    for (int i = digits - 1; i >= 0; i--)
+    {
+        s[GWC_FIX_TIME_PREFIX + i] = (char)('0' + fraction % 10);
+        fraction /= 10;
+    }
+    return GWC_FIX_TIME_PREFIX + digits;
+}
@@ -0,0 +1,50 @@
+#pragma once
+/*
+ * UTCTimestamp text for fix headers. The date and time to the second is
+ * rendered once a second and shared between threads, each call reads the
+ * clock once and renders only the fraction.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include <string>
+
+/* Longest timestamp, YYYYMMDD-HH:MM:SS.nnnnnnnnn */
+#define GWC_FIX_TIME_SIZE 27
+
+typedef enum
+{
+    GWC_FIX_TIME_MILLIS = 3,
+    GWC_FIX_TIME_MICROS = 6,
+    GWC_FIX_TIME_NANOS = 9
+} gwcFixTimePrecision;
+
+/* Parse milli, micro or nano */
+bool gwcFixClock_parsePrecision (const std::string& value,
+                                 gwcFixTimePrecision& precision);
+
+class gwcFixClock
+{
+public:
+    gwcFixClock ();
+
+    void setPrecision (gwcFixTimePrecision precision)
+    {
+        mPrecision = precision;
+    }
+
+    /* Render the current time to s, which has room for GWC_FIX_TIME_SIZE
+       bytes, and return its length. Safe from any thread */
+    size_t now (char* s);
+
+    /* Render ts as now does */
+    size_t render (const struct timespec& ts, char* s);
+
+private:
+    /* Rendered second, odd mVersion while being updated */
+    volatile uint64_t   mVersion;
+    volatile int64_t    mSecond;
+    char                mPrefix[20];
+    gwcFixTimePrecision mPrecision;
+};
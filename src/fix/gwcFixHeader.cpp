@@ -0,0 +1,122 @@
+#include "gwcFixHeader.h"
+#include "gwcFixScanner.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* Longest 9=..| plus 34=..|52=..| with a nanosecond SendingTime */
+#define GWC_FIX_HEADER_DYNAMIC 68
+
+gwcFixHeader::gwcFixHeader () :
+    mBeginSize (0),
+    mSessionSize (0)
+{
+}
+
+bool
+gwcFixHeader::init (const std::string& beginString,
+                    const std::string& senderCompID,
+                    const std::string& targetCompID)
+{
+    int n = snprintf (mBegin, sizeof mBegin, "8=%s\001", beginString.c_str ());
+    if (n < 0 || n >= (int)sizeof mBegin)
+        return false;
+    mBeginSize = n;
+
+    n = snprintf (mSession,
+                  sizeof mSession,
+                  "49=%s\001" "56=%s\001",
+                  senderCompID.c_str (),
+                  targetCompID.c_str ());
+    if (n < 0 || n >= (int)sizeof mSession)
+        return false;
+    mSessionSize = n;
+
+    return maxSize () <= GWC_FIX_HEADER_ROOM;
+}
+
+size_t
+gwcFixHeader::maxSize () const
+{
+    return mBeginSize + mSessionSize + GWC_FIX_HEADER_DYNAMIC;
+}
+
+char*
+gwcFixHeader::frame (char* data,
+                     size_t& size,
+                     int64_t seqnum,
+                     const char* time,
+                     size_t timeSize) const
+{
+    char* end = data + size;
+
+    /* MsgType is the first field of the body, after any 8= and 9= */
+    char* type = data;
+    if (size < 3 || memcmp (data, "35=", 3) != 0)
+    {
+        type = NULL;
+        for (char* p = data; p + 4 <= end; p++)
+        {
+            if (p[0] == '\001' && p[1] == '3' && p[2] == '5' && p[3] == '=')
+            {
+                type = p + 1;
+                break;
+            }
+        }
+        if (type == NULL)
+            return NULL;
+    }
+    char* body = (char*)memchr (type, '\001', end - type);
+    if (body == NULL)
+        return NULL;
+    body++;
+
+    char   msgType[16];
+    size_t msgTypeSize = body - type;
+    if (msgTypeSize > sizeof msgType)
+        return NULL;
+    memcpy (msgType, type, msgTypeSize);
+
+    char* trailer = end;
+    if (end - body >= GWC_FIX_TRAILER_SIZE + 1 &&
+        memcmp (end - GWC_FIX_TRAILER_SIZE - 1, "\00110=", 4) == 0)
+        trailer = end - GWC_FIX_TRAILER_SIZE;
+
+    /* the header is written backwards from the body */
+    char dynamic[GWC_FIX_HEADER_DYNAMIC];
+    int  n = snprintf (dynamic,
+                       sizeof dynamic,
+                       "34=%lld\001" "52=%.*s\001",
+                       (long long)seqnum,
+                       (int)timeSize,
+                       time);
+    if (n < 0 || n >= (int)sizeof dynamic)
+        return NULL;
+
+    char* start = body - n;
+    memcpy (start, dynamic, n);
+    start -= mSessionSize;
+    memcpy (start, mSession, mSessionSize);
+    start -= msgTypeSize;
+    memcpy (start, msgType, msgTypeSize);
+
+    char bodyLength[24];
+    n = snprintf (bodyLength,
+                  sizeof bodyLength,
+                  "9=%lu\001",
+                  (unsigned long)(trailer - start));
+    start -= n;
+    memcpy (start, bodyLength, n);
+    start -= mBeginSize;
+    memcpy (start, mBegin, mBeginSize);
+
+    char checkSum[GWC_FIX_TRAILER_SIZE + 1];
+    snprintf (checkSum,
+              sizeof checkSum,
+              "10=%03u\001",
+              gwcFix_checkSum (start, trailer - start));
+    memcpy (trailer, checkSum, GWC_FIX_TRAILER_SIZE);
+
+    size = trailer + GWC_FIX_TRAILER_SIZE - start;
+    return start;
+}
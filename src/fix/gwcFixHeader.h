@@ -0,0 +1,49 @@
+#pragma once
+/*
+ * Session header for outbound fix messages. BeginString, SenderCompID and
+ * TargetCompID are rendered once, the codec encodes only MsgType and the
+ * body, and the header is written in front of that encoding in place with
+ * BodyLength and CheckSum filled in once the length is known.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+/* Space kept in front of an encoding for the header */
+#define GWC_FIX_HEADER_ROOM 256
+
+/* 10=nnn| */
+#define GWC_FIX_TRAILER_SIZE 7
+
+class gwcFixHeader
+{
+public:
+    gwcFixHeader ();
+
+    /* False if the fields leave no room for MsgSeqNum and SendingTime */
+    bool init (const std::string& beginString,
+               const std::string& senderCompID,
+               const std::string& targetCompID);
+
+    /* Frame a codec encoding at data of size bytes, with
+       GWC_FIX_HEADER_ROOM bytes free in front of it and
+       GWC_FIX_TRAILER_SIZE behind. Header fields the encoding carries up
+       to MsgType and any trailer are replaced. Returns the start of the
+       message and sets size to its length, NULL if there is no MsgType */
+    char* frame (char* data,
+                 size_t& size,
+                 int64_t seqnum,
+                 const char* time,
+                 size_t timeSize) const;
+
+    /* Most bytes frame writes in front of an encoding, the framed message
+       is at most this plus the encoding and GWC_FIX_TRAILER_SIZE */
+    size_t maxSize () const;
+
+private:
+    char   mBegin[64];
+    size_t mBeginSize;
+    char   mSession[128];
+    size_t mSessionSize;
+};
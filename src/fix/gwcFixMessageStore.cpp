@@ -0,0 +1,196 @@
+#include "gwcFixMessageStore.h"
+
+#include <string.h>
+
+#ifndef WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define gwcFixMessageStore_barrier() __sync_synchronize ()
+#else
+#include <windows.h>
+#define gwcFixMessageStore_barrier() MemoryBarrier ()
+#endif
+
+#define GWC_FIX_STORE_MAGIC "GWCFIXMS"
+#define GWC_FIX_STORE_VERSION 1
+
+struct gwcFixStoreHeader
+{
+    char     mMagic[8];
+    uint32_t mVersion;
+    uint32_t mSlotSize;
+    uint64_t mSlots;
+    char     mReserved[40];
+};
+
+gwcFixMessageStore::gwcFixMessageStore () :
+    mFd (-1),
+    mBase (NULL),
+    mLength (0),
+    mSlots (NULL),
+    mMask (0)
+{
+}
+
+gwcFixMessageStore::~gwcFixMessageStore ()
+{
+    close ();
+}
+
+bool
+gwcFixMessageStore::open (const std::string& path, size_t slots, std::string& err)
+{
+#ifdef WIN32
+    err = "message store not supported on this platform";
+    return false;
+#else
+    size_t size = 2;
+    while (size < slots)
+        size <<= 1;
+
+    mFd = ::open (path.c_str (), O_RDWR | O_CREAT, 0644);
+    if (mFd < 0)
+    {
+        err = std::string ("failed to open ") + path + ": " + strerror (errno);
+        return false;
+    }
+
+    /* one session per store */
+    if (flock (mFd, LOCK_EX | LOCK_NB) != 0)
+    {
+        err = path + " is in use by another process";
+        close ();
+        return false;
+    }
+
+    struct stat st;
+    if (fstat (mFd, &st) != 0)
+    {
+        err = std::string ("failed to stat ") + path + ": " + strerror (errno);
+        close ();
+        return false;
+    }
+
+    bool created = st.st_size == 0;
+    if (created)
+    {
+        /* allocated up front so storing a message never waits on the
+           filesystem for blocks */
+        mLength = sizeof (gwcFixStoreHeader) + size * sizeof (gwcFixStoreSlot);
+        if (posix_fallocate (mFd, 0, (off_t)mLength) != 0 &&
+            ftruncate (mFd, (off_t)mLength) != 0)
+        {
+            err = std::string ("failed to size ") + path + ": " + strerror (errno);
+            close ();
+            return false;
+        }
+    }
+    else
+        mLength = (size_t)st.st_size;
+
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;
+#endif
+    mBase = mmap (NULL, mLength, PROT_READ | PROT_WRITE, flags, mFd, 0);
+    if (mBase == MAP_FAILED)
+    {
+        mBase = NULL;
+        err = std::string ("failed to map ") + path + ": " + strerror (errno);
+        close ();
+        return false;
+    }
+
+    gwcFixStoreHeader* header = (gwcFixStoreHeader*)mBase;
+    if (created)
+    {
+        memcpy (header->mMagic, GWC_FIX_STORE_MAGIC, sizeof header->mMagic);
+        header->mVersion = GWC_FIX_STORE_VERSION;
+        header->mSlotSize = sizeof (gwcFixStoreSlot);
+        header->mSlots = size;
+    }
+    else if (mLength < sizeof (gwcFixStoreHeader) ||
+             memcmp (header->mMagic, GWC_FIX_STORE_MAGIC, sizeof header->mMagic) != 0 ||
+             header->mVersion != GWC_FIX_STORE_VERSION ||
+             header->mSlotSize != sizeof (gwcFixStoreSlot) ||
+             (header->mSlots & (header->mSlots - 1)) != 0 ||
+             sizeof (gwcFixStoreHeader) + header->mSlots * sizeof (gwcFixStoreSlot) > mLength)
+    {
+        err = path + " is not a fix message store";
+        close ();
+        return false;
+    }
+
+    mSlots = (gwcFixStoreSlot*)((char*)mBase + sizeof (gwcFixStoreHeader));
+    mMask = header->mSlots - 1;
+    return true;
+#endif
+}
+
+void
+gwcFixMessageStore::close ()
+{
+#ifndef WIN32
+    if (mBase != NULL)
+        munmap (mBase, mLength);
+    if (mFd >= 0)
+        ::close (mFd);
+#endif
+    mFd = -1;
+    mBase = NULL;
+    mSlots = NULL;
+}
+
+void
+gwcFixMessageStore::add (int64_t seqnum, const void* data, size_t size)
+{
+    if (mSlots == NULL)
+        return;
+
+    /* readers check the seqnum either side of their copy */
+    gwcFixStoreSlot* slot = &mSlots[(uint64_t)seqnum & mMask];
+    slot->mSeqnum = 0;
+    if (size > sizeof slot->mData)
+        return;
+    gwcFixMessageStore_barrier ();
+
+    memcpy (slot->mData, data, size);
+    slot->mSize = (uint32_t)size;
+    gwcFixMessageStore_barrier ();
+    slot->mSeqnum = seqnum;
+}
+
+bool
+gwcFixMessageStore::get (int64_t seqnum, char* data, size_t& size) const
+{
+    if (mSlots == NULL || seqnum <= 0)
+        return false;
+
+    const gwcFixStoreSlot* slot = &mSlots[(uint64_t)seqnum & mMask];
+    if (slot->mSeqnum != seqnum)
+        return false;
+    gwcFixMessageStore_barrier ();
+
+    size = slot->mSize;
+    if (size > sizeof slot->mData)
+        return false;
+    memcpy (data, slot->mData, size);
+    gwcFixMessageStore_barrier ();
+
+    /* overwritten while copying */
+    return slot->mSeqnum == seqnum;
+}
+
+void
+gwcFixMessageStore::clear ()
+{
+    if (mSlots == NULL)
+        return;
+
+    for (uint64_t i = 0; i <= mMask; i++)
+        mSlots[i].mSeqnum = 0;
+}
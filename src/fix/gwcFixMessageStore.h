@@ -0,0 +1,65 @@
+#pragma once
+/*
+ * Memory mapped store of sent fix messages indexed by MsgSeqNum, used to
+ * answer resend requests. Each sequence number owns a fixed size slot in a
+ * ring of slots so a store is one copy and the oldest messages are
+ * overwritten as the session runs. One thread writes, any thread may read.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+/* Largest message kept, as the encode buffers */
+#define GWC_FIX_STORE_MSG_SIZE 1024
+
+/* Default number of messages kept */
+#define GWC_FIX_STORE_SIZE 65536
+
+struct gwcFixStoreSlot
+{
+    /* 0 while empty or being written */
+    volatile int64_t mSeqnum;
+    uint32_t         mSize;
+    uint32_t         mReserved;
+    char             mData[GWC_FIX_STORE_MSG_SIZE];
+};
+
+class gwcFixMessageStore
+{
+public:
+    gwcFixMessageStore ();
+    ~gwcFixMessageStore ();
+
+    /* Map the store at path, created with room for slots messages if it
+       doesn't exist. An existing store keeps its size */
+    bool open (const std::string& path, size_t slots, std::string& err);
+    void close ();
+
+    bool isOpen () const
+    {
+        return mSlots != NULL;
+    }
+
+    /* Keep message sent as seqnum, a message too large to keep leaves
+       seqnum missing */
+    void add (int64_t seqnum, const void* data, size_t size);
+
+    /* Copy message seqnum to data, which has room for
+       GWC_FIX_STORE_MSG_SIZE bytes. False if it was never kept or has
+       been overwritten */
+    bool get (int64_t seqnum, char* data, size_t& size) const;
+
+    /* Forget every message, on a sequence reset */
+    void clear ();
+
+private:
+    gwcFixMessageStore (const gwcFixMessageStore& obj);
+    gwcFixMessageStore& operator= (const gwcFixMessageStore& obj);
+
+    int              mFd;
+    void*            mBase;
+    size_t           mLength;
+    gwcFixStoreSlot* mSlots;
+    uint64_t         mMask;
+};
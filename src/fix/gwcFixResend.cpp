@@ -0,0 +1,219 @@
+#include "gwcFixResend.h"
+#include "gwcFixScanner.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* Session messages that are gap filled rather than resent */
+static bool
+gwcFixResend_isAdmin (uint32_t msgType)
+{
+    switch (msgType)
+    {
+    case GW_FIX_HEARTBEAT_C:
+    case GW_FIX_TEST_REQUEST_C:
+    case GW_FIX_RESEND_REQUEST_C:
+    case GW_FIX_SEQUENCE_RESET_C:
+    case GW_FIX_LOGOUT_C:
+    case GW_FIX_LOGON_C:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/* Field tag= starting after a SOH in [p, end), NULL if there isn't one */
+static const char*
+gwcFixResend_findField (const char* p, const char* end, const char* tag)
+{
+    size_t n = strlen (tag);
+
+    for (; p + n < end; p++)
+    {
+        if (p[0] == '\001' && memcmp (p + 1, tag, n) == 0)
+            return p + 1 + n;
+    }
+    return NULL;
+}
+
+static void
+gwcFixResend_append (std::vector<char>& out, const void* data, size_t size)
+{
+    const char* p = (const char*)data;
+    out.insert (out.end (), p, p + size);
+}
+
+/* BodyLength field for a body of size bytes */
+static void
+gwcFixResend_appendBodyLength (std::vector<char>& out, size_t size)
+{
+    char s[32];
+    int  n = snprintf (s, sizeof s, "9=%lu\001", (unsigned long)size);
+    gwcFixResend_append (out, s, n);
+}
+
+/* CheckSum field over the message appended from start */
+static void
+gwcFixResend_appendCheckSum (std::vector<char>& out, size_t start)
+{
+    char s[16];
+    int  n = snprintf (s,
+                       sizeof s,
+                       "10=%03u\001",
+                       gwcFix_checkSum (&out[start], out.size () - start));
+    gwcFixResend_append (out, s, n);
+}
+
+gwcFixResend::gwcFixResend () :
+    mBeginSize (0),
+    mSessionSize (0)
+{
+}
+
+bool
+gwcFixResend::init (const std::string& beginString,
+                    const std::string& senderCompID,
+                    const std::string& targetCompID)
+{
+    int n = snprintf (mBegin, sizeof mBegin, "8=%s\001", beginString.c_str ());
+    if (n < 0 || n >= (int)sizeof mBegin)
+        return false;
+    mBeginSize = n;
+
+    n = snprintf (mSession,
+                  sizeof mSession,
+                  "49=%s\001" "56=%s\001",
+                  senderCompID.c_str (),
+                  targetCompID.c_str ());
+    if (n < 0 || n >= (int)sizeof mSession)
+        return false;
+    mSessionSize = n;
+    return true;
+}
+
+bool
+gwcFixResend::range (int64_t& begin, int64_t& end, int64_t last)
+{
+    if (begin < 1)
+        begin = 1;
+    if (end == 0 || end > last)
+        end = last;
+    return begin <= end;
+}
+
+int64_t
+gwcFixResend::build (const gwcFixMessageStore& store,
+                     int64_t begin,
+                     int64_t end,
+                     const char* now,
+                     size_t nowSize,
+                     std::vector<char>& out,
+                     std::vector<size_t>& sizes,
+                     size_t& failed) const
+{
+    char    msg[GWC_FIX_STORE_MSG_SIZE];
+    size_t  size;
+    int64_t gap = 0;
+
+    for (int64_t seqnum = begin; seqnum <= end; seqnum++)
+    {
+        if (!store.get (seqnum, msg, size) ||
+            gwcFixResend_isAdmin (gwcFix_msgType (msg, size)))
+        {
+            if (gap == 0)
+                gap = seqnum;
+            continue;
+        }
+
+        if (gap != 0)
+        {
+            appendGapFill (gap, seqnum, now, nowSize, out, sizes);
+            gap = 0;
+        }
+        if (!appendPossDup (msg, size, now, nowSize, out, sizes))
+        {
+            failed++;
+            gap = seqnum;
+            continue;
+        }
+
+        if (out.size () >= GWC_FIX_RESEND_SIZE)
+            return seqnum + 1;
+    }
+    if (gap != 0)
+        appendGapFill (gap, end + 1, now, nowSize, out, sizes);
+    return end + 1;
+}
+
+bool
+gwcFixResend::appendPossDup (const char* msg,
+                             size_t size,
+                             const char* now,
+                             size_t nowSize,
+                             std::vector<char>& out,
+                             std::vector<size_t>& sizes)
+{
+    /* 8=..|9=..| body 10=nnn| */
+    const char* end = msg + size;
+    const char* trailer = end - 7;
+    const char* soh = (const char*)memchr (msg, '\001', size);
+    if (soh == NULL || size < 16 || memcmp (msg, "8=", 2) != 0)
+        return false;
+    const char* body = gwcFixResend_findField (soh, end, "9=");
+    if (body != soh + 3)
+        return false;
+    body = (const char*)memchr (body, '\001', end - body);
+    if (body == NULL || ++body > trailer || memcmp (trailer, "10=", 3) != 0)
+        return false;
+
+    /* SendingTime becomes now and the original moves to OrigSendingTime */
+    const char* sent = gwcFixResend_findField (body - 1, trailer, "52=");
+    if (sent == NULL)
+        return false;
+    const char* sentEnd = (const char*)memchr (sent, '\001', trailer - sent);
+    if (sentEnd == NULL)
+        return false;
+
+    size_t start = out.size ();
+    gwcFixResend_append (out, msg, soh + 1 - msg);
+    gwcFixResend_appendBodyLength (out, (trailer - body) + nowSize + 10);
+    gwcFixResend_append (out, body, sent - body);
+    gwcFixResend_append (out, now, nowSize);
+    gwcFixResend_append (out, "\00143=Y\001122=", 10);
+    gwcFixResend_append (out, sent, sentEnd - sent);
+    gwcFixResend_append (out, sentEnd, trailer - sentEnd);
+    gwcFixResend_appendCheckSum (out, start);
+
+    sizes.push_back (out.size () - start);
+    return true;
+}
+
+void
+gwcFixResend::appendGapFill (int64_t seqnum,
+                             int64_t newSeqnum,
+                             const char* now,
+                             size_t nowSize,
+                             std::vector<char>& out,
+                             std::vector<size_t>& sizes) const
+{
+    char body[512];
+    int  n = snprintf (body,
+                       sizeof body,
+                       "35=4\001" "%.*s" "34=%ld\001" "43=Y\001"
+                       "52=%.*s\001" "122=%.*s\001" "123=Y\001" "36=%ld\001",
+                       (int)mSessionSize, mSession,
+                       (long)seqnum,
+                       (int)nowSize, now,
+                       (int)nowSize, now,
+                       (long)newSeqnum);
+    if (n < 0 || n >= (int)sizeof body)
+        return;
+
+    size_t start = out.size ();
+    gwcFixResend_append (out, mBegin, mBeginSize);
+    gwcFixResend_appendBodyLength (out, n);
+    gwcFixResend_append (out, body, n);
+    gwcFixResend_appendCheckSum (out, start);
+
+    sizes.push_back (out.size () - start);
+}
@@ -0,0 +1,72 @@
+#pragma once
+/*
+ * Answers resend requests from the message store. Messages still kept go
+ * out again as they were sent with PossDupFlag set, SendingTime updated and
+ * the original in OrigSendingTime. Runs of session messages and of messages
+ * no longer kept become one SequenceReset gap fill each.
+ */
+
+#include "gwcFixMessageStore.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+/* Resent messages are written in pieces of about this many bytes */
+#define GWC_FIX_RESEND_SIZE (64 * 1024)
+
+class gwcFixResend
+{
+public:
+    gwcFixResend ();
+
+    /* False if the fields leave no room in a gap fill */
+    bool init (const std::string& beginString,
+               const std::string& senderCompID,
+               const std::string& targetCompID);
+
+    /* Limit the BeginSeqNo and EndSeqNo of a resend request to the
+       messages sent, last being the highest. EndSeqNo of 0 asks for
+       everything sent. False if nothing is left to resend */
+    static bool range (int64_t& begin, int64_t& end, int64_t last);
+
+    /* Append the messages answering begin to end to out and the size of
+       each to sizes. Stops after the message that takes out to
+       GWC_FIX_RESEND_SIZE and returns the seqnum to carry on from, end + 1
+       once done. failed counts kept messages that were gap filled because
+       they couldn't be resent */
+    int64_t build (const gwcFixMessageStore& store,
+                   int64_t begin,
+                   int64_t end,
+                   const char* now,
+                   size_t nowSize,
+                   std::vector<char>& out,
+                   std::vector<size_t>& sizes,
+                   size_t& failed) const;
+
+    /* Append msg, as it was sent, with PossDupFlag, SendingTime now and
+       OrigSendingTime. False if msg isn't a framed message with a
+       SendingTime */
+    static bool appendPossDup (const char* msg,
+                               size_t size,
+                               const char* now,
+                               size_t nowSize,
+                               std::vector<char>& out,
+                               std::vector<size_t>& sizes);
+
+    /* Append a SequenceReset gap fill sent as seqnum moving on to
+       newSeqnum */
+    void appendGapFill (int64_t seqnum,
+                        int64_t newSeqnum,
+                        const char* now,
+                        size_t nowSize,
+                        std::vector<char>& out,
+                        std::vector<size_t>& sizes) const;
+
+private:
+    char   mBegin[64];
+    size_t mBeginSize;
+    char   mSession[128];
+    size_t mSessionSize;
+};
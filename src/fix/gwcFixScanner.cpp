@@ -0,0 +1,576 @@
+#include "gwcFixScanner.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GWC_FIX_X86
+#include <immintrin.h>
+#endif
+
+#define GWC_FIX_SOH '\001'
+
+/* Longest BeginString field and message accepted, anything larger is
+   taken as garbled rather than waited for */
+#define GWC_FIX_MAX_BEGIN 32
+#define GWC_FIX_MAX_MESSAGE (1024 * 1024)
+
+#define GWC_FIX_LANES 0x00ff00ff00ff00ffULL
+
+typedef size_t (*gwcFixFindSohFn) (const char* data,
+                                   size_t size,
+                                   uint32_t* offsets,
+                                   size_t max);
+typedef uint64_t (*gwcFixSumFn) (const char* data, size_t size);
+
+/* Offsets of up to max SOH bytes, max + 1 if there are more */
+static size_t
+gwcFix_findSohScalar (const char* data, size_t size, uint32_t* offsets, size_t max)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        if (data[i] != GWC_FIX_SOH)
+            continue;
+        if (n == max)
+            return max + 1;
+        offsets[n++] = (uint32_t)i;
+    }
+    return n;
+}
+
+/* Bytes added in four 16 bit lanes, emptied before they can overflow */
+static uint64_t
+gwcFix_sumScalar (const char* data, size_t size)
+{
+    uint64_t sum = 0;
+    size_t   i = 0;
+
+    while (size - i >= 8)
+    {
+        uint64_t lanes = 0;
+        size_t   words = (size - i) / 8;
+        if (words > 128)
+            words = 128;
+
+        for (size_t n = 0; n < words; n++, i += 8)
+        {
+            uint64_t w;
+            memcpy (&w, data + i, sizeof w);
+            lanes += (w & GWC_FIX_LANES) + ((w >> 8) & GWC_FIX_LANES);
+        }
+        sum += (lanes & 0xffff) +
+               ((lanes >> 16) & 0xffff) +
+               ((lanes >> 32) & 0xffff) +
+               (lanes >> 48);
+    }
+    for (; i < size; i++)
+        sum += (unsigned char)data[i];
+    return sum;
+}
+
+#ifdef GWC_FIX_X86
+__attribute__ ((target ("sse2"))) static size_t
+gwcFix_findSohSse2 (const char* data, size_t size, uint32_t* offsets, size_t max)
+{
+    const __m128i soh = _mm_set1_epi8 (GWC_FIX_SOH);
+    size_t        n = 0;
+    size_t        i = 0;
+
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i  v = _mm_loadu_si128 ((const __m128i*)(data + i));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8 (_mm_cmpeq_epi8 (v, soh));
+        while (mask != 0)
+        {
+            if (n == max)
+                return max + 1;
+            offsets[n++] = (uint32_t)(i + __builtin_ctz (mask));
+            mask &= mask - 1;
+        }
+    }
+
+    size_t tail = gwcFix_findSohScalar (data + i, size - i, offsets + n, max - n);
+    if (tail > max - n)
+        return max + 1;
+    for (size_t k = n; k < n + tail; k++)
+        offsets[k] += (uint32_t)i;
+    return n + tail;
+}
+
+__attribute__ ((target ("sse2"))) static uint64_t
+gwcFix_sumSse2 (const char* data, size_t size)
+{
+    const __m128i zero = _mm_setzero_si128 ();
+    __m128i       acc = _mm_setzero_si128 ();
+    size_t        i = 0;
+
+    /* sad against zero sums each 8 bytes into a 64 bit lane */
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i v = _mm_loadu_si128 ((const __m128i*)(data + i));
+        acc = _mm_add_epi64 (acc, _mm_sad_epu8 (v, zero));
+    }
+
+    uint64_t lanes[2];
+    _mm_storeu_si128 ((__m128i*)lanes, acc);
+    return lanes[0] + lanes[1] + gwcFix_sumScalar (data + i, size - i);
+}
+
+__attribute__ ((target ("avx2"))) static size_t
+gwcFix_findSohAvx2 (const char* data, size_t size, uint32_t* offsets, size_t max)
+{
+    const __m256i soh = _mm256_set1_epi8 (GWC_FIX_SOH);
+    size_t        n = 0;
+    size_t        i = 0;
+
+    for (; i + 32 <= size; i += 32)
+    {
+        __m256i  v = _mm256_loadu_si256 ((const __m256i*)(data + i));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8 (_mm256_cmpeq_epi8 (v, soh));
+        while (mask != 0)
+        {
+            if (n == max)
+                return max + 1;
+            offsets[n++] = (uint32_t)(i + __builtin_ctz (mask));
+            mask &= mask - 1;
+        }
+    }
+
+    size_t tail = gwcFix_findSohScalar (data + i, size - i, offsets + n, max - n);
+    if (tail > max - n)
+        return max + 1;
+    for (size_t k = n; k < n + tail; k++)
+        offsets[k] += (uint32_t)i;
+    return n + tail;
+}
+
+__attribute__ ((target ("avx2"))) static uint64_t
+gwcFix_sumAvx2 (const char* data, size_t size)
+{
+    const __m256i zero = _mm256_setzero_si256 ();
+    __m256i       acc = _mm256_setzero_si256 ();
+    size_t        i = 0;
+
+    for (; i + 32 <= size; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256 ((const __m256i*)(data + i));
+        acc = _mm256_add_epi64 (acc, _mm256_sad_epu8 (v, zero));
+    }
+
+    uint64_t lanes[4];
+    _mm256_storeu_si256 ((__m256i*)lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+           gwcFix_sumScalar (data + i, size - i);
+}
+#endif
+
+/* Implementations for this cpu, chosen once at load */
+struct gwcFixSimd
+{
+    gwcFixSimd () :
+        mFindSoh (gwcFix_findSohScalar),
+        mSum (gwcFix_sumScalar),
+        mName ("scalar")
+    {
+#ifdef GWC_FIX_X86
+        /* needed before main */
+        __builtin_cpu_init ();
+        if (__builtin_cpu_supports ("avx2"))
+        {
+            mFindSoh = gwcFix_findSohAvx2;
+            mSum = gwcFix_sumAvx2;
+            mName = "avx2";
+        }
+        else if (__builtin_cpu_supports ("sse2"))
+        {
+            mFindSoh = gwcFix_findSohSse2;
+            mSum = gwcFix_sumSse2;
+            mName = "sse2";
+        }
+#endif
+    }
+
+    gwcFixFindSohFn mFindSoh;
+    gwcFixSumFn     mSum;
+    const char*     mName;
+};
+
+static const gwcFixSimd gwcFix_simd;
+
+uint32_t
+gwcFix_checkSum (const char* data, size_t size)
+{
+    return (uint32_t)(gwcFix_simd.mSum (data, size) & 0xff);
+}
+
+uint32_t
+gwcFix_msgType (const void* data, size_t size)
+{
+    const char* p = (const char*)data;
+    const char* end = p + size;
+
+    /* tag 35 follows BeginString and BodyLength so this stops early */
+    while (p + 4 < end && 
+           (p[0] != '\001' || p[1] != '3' || p[2] != '5' || p[3] != '='))
+        p++;
+    if (p + 4 >= end)
+        return 0;
+
+    uint32_t type = 0;
+    p += 4;
+    for (size_t i = 0; i < 3 && p < end && *p != '\001'; i++, p++)
+        type |= (uint32_t)(unsigned char)*p << (8 * i);
+    return type;
+}
+
+const char*
+gwcFix_simdName ()
+{
+    return gwcFix_simd.mName;
+}
+
+/* Implementations for the named instruction set, false if the cpu lacks it */
+static bool
+gwcFix_simdFor (const char* simd, gwcFixFindSohFn& findSoh, gwcFixSumFn& sum)
+{
+    if (strcmp (simd, "scalar") == 0)
+    {
+        findSoh = gwcFix_findSohScalar;
+        sum = gwcFix_sumScalar;
+        return true;
+    }
+#ifdef GWC_FIX_X86
+    if (strcmp (simd, "sse2") == 0 && __builtin_cpu_supports ("sse2"))
+    {
+        findSoh = gwcFix_findSohSse2;
+        sum = gwcFix_sumSse2;
+        return true;
+    }
+    if (strcmp (simd, "avx2") == 0 && __builtin_cpu_supports ("avx2"))
+    {
+        findSoh = gwcFix_findSohAvx2;
+        sum = gwcFix_sumAvx2;
+        return true;
+    }
+#endif
+    return false;
+}
+
+bool
+gwcFix_checkSumWith (const char* simd, const char* data, size_t size, uint32_t& sum)
+{
+    gwcFixFindSohFn findSohFn;
+    gwcFixSumFn     sumFn;
+    if (!gwcFix_simdFor (simd, findSohFn, sumFn))
+        return false;
+
+    sum = (uint32_t)(sumFn (data, size) & 0xff);
+    return true;
+}
+
+bool
+gwcFix_findSohWith (const char* simd,
+                    const char* data,
+                    size_t size,
+                    uint32_t* offsets,
+                    size_t max,
+                    size_t& n)
+{
+    gwcFixFindSohFn findSohFn;
+    gwcFixSumFn     sumFn;
+    if (!gwcFix_simdFor (simd, findSohFn, sumFn))
+        return false;
+
+    n = findSohFn (data, size, offsets, max);
+    return true;
+}
+
+/* Data field following a length field, 0 if tag isn't a length */
+static uint32_t
+gwcFix_dataTag (uint32_t tag)
+{
+    switch (tag)
+    {
+    case 90:  return 91;
+    case 93:  return 89;
+    case 95:  return 96;
+    case 212: return 213;
+    case 348: return 349;
+    case 350: return 351;
+    case 352: return 353;
+    case 354: return 355;
+    case 356: return 357;
+    case 358: return 359;
+    case 360: return 361;
+    case 362: return 363;
+    case 364: return 365;
+    case 445: return 446;
+    case 618: return 619;
+    case 621: return 622;
+    default:  return 0;
+    }
+}
+
+/* Bytes to drop from a garbled stream, up to the next 8= after a SOH */
+static size_t
+gwcFix_resync (const char* data, size_t size)
+{
+    for (size_t i = 1; i + 2 < size; i++)
+    {
+        if (data[i] == GWC_FIX_SOH && data[i + 1] == '8' && data[i + 2] == '=')
+            return i + 1;
+    }
+    return size;
+}
+
+/* Digits at data up to end, false if there are none */
+static bool
+gwcFix_parseDigits (const char* data, const char* end, uint64_t& value, const char*& next)
+{
+    const char* p = data;
+
+    value = 0;
+    while (p < end && *p >= '0' && *p <= '9')
+    {
+        value = value * 10 + (uint64_t)(*p - '0');
+        p++;
+    }
+    next = p;
+    return p != data;
+}
+
+gwcFixScanResult
+gwcFix_scan (const char* data,
+             size_t size,
+             bool index,
+             gwcFixMessage& msg,
+             size_t& used)
+{
+    const char* end = data + size;
+
+    used = 0;
+    msg.mData = data;
+    msg.mSize = 0;
+    msg.mIndexed = false;
+    msg.mCount = 0;
+
+    /* 8=BeginString|9=BodyLength| */
+    if (size < 2)
+    {
+        if (size == 0 || data[0] == '8')
+            return GWC_FIX_SCAN_SHORT;
+        used = 1;
+        return GWC_FIX_SCAN_GARBLED;
+    }
+    if (data[0] != '8' || data[1] != '=')
+    {
+        used = gwcFix_resync (data, size);
+        return GWC_FIX_SCAN_GARBLED;
+    }
+
+    const char* p = (const char*)memchr (data, GWC_FIX_SOH, size);
+    if (p == NULL)
+    {
+        if (size < GWC_FIX_MAX_BEGIN)
+            return GWC_FIX_SCAN_SHORT;
+        used = gwcFix_resync (data, size);
+        return GWC_FIX_SCAN_GARBLED;
+    }
+    p++;
+    if (end - p < 3)
+        return GWC_FIX_SCAN_SHORT;
+
+    uint64_t bodyLength;
+    if (p[0] != '9' || p[1] != '=' ||
+        !gwcFix_parseDigits (p + 2, end, bodyLength, p) ||
+        bodyLength > GWC_FIX_MAX_MESSAGE)
+    {
+        used = gwcFix_resync (data, size);
+        return GWC_FIX_SCAN_GARBLED;
+    }
+    if (p == end)
+        return GWC_FIX_SCAN_SHORT;
+    if (*p != GWC_FIX_SOH)
+    {
+        used = gwcFix_resync (data, size);
+        return GWC_FIX_SCAN_GARBLED;
+    }
+    p++;
+
+    /* body then 10=nnn| */
+    size_t total = (p - data) + bodyLength + 7;
+    if (size < total)
+        return GWC_FIX_SCAN_SHORT;
+
+    const char* trailer = data + total - 7;
+    uint64_t    checkSum;
+    const char* next;
+    if (trailer[-1] != GWC_FIX_SOH ||
+        memcmp (trailer, "10=", 3) != 0 ||
+        !gwcFix_parseDigits (trailer + 3, trailer + 6, checkSum, next) ||
+        next != trailer + 6 ||
+        trailer[6] != GWC_FIX_SOH)
+    {
+        used = gwcFix_resync (data, size);
+        return GWC_FIX_SCAN_GARBLED;
+    }
+
+    used = total;
+    if (checkSum != gwcFix_checkSum (data, total - 7))
+        return GWC_FIX_SCAN_GARBLED;
+
+    msg.mSize = total;
+    if (!index)
+        return GWC_FIX_SCAN_OK;
+
+    /* every field ends at a SOH, found in one pass. A data field can hold
+       SOH bytes so its length field says where it ends */
+    size_t sohs = gwcFix_simd.mFindSoh (data,
+                                        total,
+                                        msg.mSoh,
+                                        sizeof msg.mSoh / sizeof msg.mSoh[0]);
+    if (sohs > sizeof msg.mSoh / sizeof msg.mSoh[0])
+        return GWC_FIX_SCAN_OK;
+
+    const char* msgEnd = data + total;
+    size_t      start = 0;
+    size_t      s = 0;
+    uint32_t    dataTag = 0;
+    uint64_t    dataLength = 0;
+    while (s < sohs)
+    {
+        uint64_t tag;
+        if (!gwcFix_parseDigits (data + start, msgEnd, tag, next) || *next != '=')
+            return GWC_FIX_SCAN_OK;
+
+        size_t valueStart = next + 1 - data;
+        size_t valueEnd;
+        if (dataTag != 0 && tag == dataTag)
+        {
+            valueEnd = valueStart + dataLength;
+            if (valueEnd >= total || data[valueEnd] != GWC_FIX_SOH)
+                return GWC_FIX_SCAN_OK;
+            while (s < sohs && msg.mSoh[s] < valueEnd)
+                s++;
+        }
+        else
+            valueEnd = msg.mSoh[s];
+
+        if (valueEnd < valueStart || msg.mCount == GWC_FIX_MAX_FIELDS)
+            return GWC_FIX_SCAN_OK;
+
+        gwcFixField& field = msg.mFields[msg.mCount++];
+        field.mTag = (uint32_t)tag;
+        field.mOffset = (uint32_t)valueStart;
+        field.mLength = (uint32_t)(valueEnd - valueStart);
+
+        dataTag = gwcFix_dataTag (field.mTag);
+        if (dataTag != 0 &&
+            (!gwcFix_parseDigits (data + valueStart, data + valueEnd, dataLength, next) ||
+             next != data + valueEnd))
+            return GWC_FIX_SCAN_OK;
+
+        start = valueEnd + 1;
+        s++;
+    }
+
+    msg.mIndexed = true;
+    return GWC_FIX_SCAN_OK;
+}
+
+gwcFixMessage::gwcFixMessage () :
+    mData (NULL),
+    mSize (0),
+    mIndexed (false),
+    mCount (0)
+{
+}
+
+const gwcFixField*
+gwcFixMessage::find (uint32_t tag) const
+{
+    for (size_t i = 0; i < mCount; i++)
+    {
+        if (mFields[i].mTag == tag)
+            return &mFields[i];
+    }
+    return NULL;
+}
+
+bool
+gwcFixMessage::getString (uint32_t tag, const char*& value, size_t& length) const
+{
+    const gwcFixField* field = find (tag);
+    if (field == NULL)
+        return false;
+
+    value = mData + field->mOffset;
+    length = field->mLength;
+    return true;
+}
+
+bool
+gwcFixMessage::getString (uint32_t tag, std::string& value) const
+{
+    const char* p;
+    size_t      length;
+    if (!getString (tag, p, length))
+        return false;
+
+    value.assign (p, length);
+    return true;
+}
+
+bool
+gwcFixMessage::getInteger (uint32_t tag, int64_t& value) const
+{
+    const char* p;
+    size_t      length;
+    if (!getString (tag, p, length) || length == 0)
+        return false;
+
+    const char* end = p + length;
+    bool        negative = *p == '-';
+    if (negative)
+        p++;
+
+    uint64_t    n;
+    const char* next;
+    if (!gwcFix_parseDigits (p, end, n, next) || next != end)
+        return false;
+
+    value = negative ? -(int64_t)n : (int64_t)n;
+    return true;
+}
+
+bool
+gwcFixMessage::getDouble (uint32_t tag, double& value) const
+{
+    const char* p;
+    size_t      length;
+    char        s[64];
+    if (!getString (tag, p, length) || length == 0 || length >= sizeof s)
+        return false;
+
+    memcpy (s, p, length);
+    s[length] = '\0';
+
+    char* next;
+    value = strtod (s, &next);
+    return next == s + length;
+}
+
+uint32_t
+gwcFixMessage::getMsgType () const
+{
+    const char* p;
+    size_t      length;
+    if (!getString (35, p, length))
+        return 0;
+
+    uint32_t type = 0;
+    for (size_t i = 0; i < 3 && i < length; i++)
+        type |= (uint32_t)(unsigned char)p[i] << (8 * i);
+    return type;
+}
@@ -0,0 +1,140 @@
+#pragma once
+/*
+ * Frames inbound fix messages, validates BodyLength and CheckSum and builds
+ * a flat index of tag and value offsets without decoding anything. Field
+ * boundaries are found and bytes summed with AVX2 or SSE2 where the cpu has
+ * them, chosen at load time, and with plain loops otherwise.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+/* Single character message types as dispatched on from the wire */
+#define GW_FIX_HEARTBEAT_C '0'
+#define GW_FIX_TEST_REQUEST_C '1'
+#define GW_FIX_RESEND_REQUEST_C '2'
+#define GW_FIX_REJECT_C '3'
+#define GW_FIX_SEQUENCE_RESET_C '4'
+#define GW_FIX_LOGOUT_C '5'
+#define GW_FIX_EXECUTION_REPORT_C '8'
+#define GW_FIX_ORDER_CANCEL_REJECT_C '9'
+#define GW_FIX_LOGON_C 'A'
+#define GW_FIX_BUSINESS_MESSAGE_REJECT_C 'j'
+
+/* Most fields indexed, larger messages are framed but not indexed */
+#define GWC_FIX_MAX_FIELDS 512
+
+typedef enum
+{
+    GWC_FIX_SCAN_OK,
+    /* not all of the message has arrived */
+    GWC_FIX_SCAN_SHORT,
+    /* bad framing or CheckSum, used bytes should be dropped */
+    GWC_FIX_SCAN_GARBLED
+} gwcFixScanResult;
+
+/* Value of a field is mLength bytes at mOffset into the message */
+struct gwcFixField
+{
+    uint32_t mTag;
+    uint32_t mOffset;
+    uint32_t mLength;
+};
+
+/* View of a scanned message, valid while the bytes it was scanned from */
+class gwcFixMessage
+{
+    friend gwcFixScanResult gwcFix_scan (const char* data,
+                                         size_t size,
+                                         bool index,
+                                         gwcFixMessage& msg,
+                                         size_t& used);
+
+public:
+    gwcFixMessage ();
+
+    const char* getData () const
+    {
+        return mData;
+    }
+
+    size_t getSize () const
+    {
+        return mSize;
+    }
+
+    /* False if the message wasn't indexed */
+    bool isIndexed () const
+    {
+        return mIndexed;
+    }
+
+    size_t getFieldCount () const
+    {
+        return mCount;
+    }
+
+    const gwcFixField& getField (size_t i) const
+    {
+        return mFields[i];
+    }
+
+    /* First field with tag, NULL if there isn't one */
+    const gwcFixField* find (uint32_t tag) const;
+
+    bool getString (uint32_t tag, const char*& value, size_t& length) const;
+    bool getString (uint32_t tag, std::string& value) const;
+    bool getInteger (uint32_t tag, int64_t& value) const;
+    bool getDouble (uint32_t tag, double& value) const;
+
+    /* MsgType packed a character a byte with the first in the low byte, 0
+       if there isn't one */
+    uint32_t getMsgType () const;
+
+private:
+    gwcFixMessage (const gwcFixMessage& obj);
+    gwcFixMessage& operator= (const gwcFixMessage& obj);
+
+    const char* mData;
+    size_t      mSize;
+    bool        mIndexed;
+    size_t      mCount;
+    uint32_t    mSoh[2 * GWC_FIX_MAX_FIELDS];
+    gwcFixField mFields[GWC_FIX_MAX_FIELDS];
+};
+
+/* Frame the message at the start of data and check it. used is its length
+   when OK, the bytes to drop when GARBLED. Fields are indexed into msg
+   when index is set */
+gwcFixScanResult gwcFix_scan (const char* data,
+                              size_t size,
+                              bool index,
+                              gwcFixMessage& msg,
+                              size_t& used);
+
+/* MsgType straight from the wire, up to three characters packed a byte each
+   with the first in the low byte, 0 if there is no tag 35 */
+uint32_t gwcFix_msgType (const void* data, size_t size);
+
+/* Sum of bytes modulo 256 */
+uint32_t gwcFix_checkSum (const char* data, size_t size);
+
+/* Instruction set in use, avx2, sse2 or scalar */
+const char* gwcFix_simdName ();
+
+/* gwcFix_checkSum with the named instruction set rather than the one in
+   use, false if this cpu doesn't have it */
+bool gwcFix_checkSumWith (const char* simd,
+                          const char* data,
+                          size_t size,
+                          uint32_t& sum);
+
+/* Offsets of up to max SOH bytes in data with the named instruction set, n
+   is max + 1 if there are more. False if this cpu doesn't have it */
+bool gwcFix_findSohWith (const char* simd,
+                         const char* data,
+                         size_t size,
+                         uint32_t* offsets,
+                         size_t max,
+                         size_t& n);
@@ -1,30 +1,1193 @@
 #include "gwcConnector.h"
+#include "utils.h"
 
 #include <dl.h>
+#include <map>
 #include <sstream>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#ifndef WIN32
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 
 namespace neueda
 {
+bool
+gwcConnector::sendBatch (cdr* msgs, size_t n)
+{
+    if (n == 0)
+        return true;
+
+    std::vector<cdr*> batch (n);
+    for (size_t i = 0; i < n; i++)
+        batch[i] = &msgs[i];
+
+    return sendPaced (&batch[0], n);
+}
+
+bool
+gwcConnector::sendOrders (cdr* orders, size_t n)
+{
+    if (n == 0)
+        return true;
+
+    std::vector<cdr*> batch (n);
+    for (size_t i = 0; i < n; i++)
+    {
+        prepareOrder (orders[i]);
+        batch[i] = &orders[i];
+    }
+
+    return sendChecked (&batch[0], n);
+}
+
+bool
+gwcConnector::sendOrders (gwcOrder* orders, size_t n)
+{
+    if (n == 0)
+        return true;
+
+    // gwcOrder and cdr differ in size so can't pass through sendBatch
+    std::vector<cdr*> batch (n);
+    for (size_t i = 0; i < n; i++)
+    {
+        if (!mapOrderFields (orders[i]))
+            return false;
+        prepareOrder (orders[i]);
+        batch[i] = &orders[i];
+    }
+
+    return sendChecked (&batch[0], n);
+}
+
+bool
+gwcConnector::sendCancels (cdr* cancels, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        prepareCancel (cancels[i]);
+
+    return sendBatch (cancels, n);
+}
+
+bool
+gwcConnector::sendCancels (gwcOrder* cancels, size_t n)
+{
+    if (n == 0)
+        return true;
+
+    std::vector<cdr*> batch (n);
+    for (size_t i = 0; i < n; i++)
+    {
+        if (!mapOrderFields (cancels[i]))
+            return false;
+        prepareCancel (cancels[i]);
+        batch[i] = &cancels[i];
+    }
+
+    return sendPaced (&batch[0], n);
+}
+
+bool
+gwcConnector::sendPaced (cdr** msgs, size_t n)
+{
+    if (mThrottle == NULL)
+        return sendMsgs (msgs, n);
+
+    switch (mThrottle->send (msgs, n))
+    {
+    case GWC_THROTTLE_SENT:
+    case GWC_THROTTLE_QUEUED:
+        return true;
+    case GWC_THROTTLE_REJECTED:
+        if (mThrottle->getMode () == GWC_THROTTLE_REJECT)
+            mLog->warn ("throttle limit reached, message rejected");
+        else
+            mLog->warn ("throttle queue full, message rejected");
+        return false;
+    case GWC_THROTTLE_FAILED:
+        break;
+    }
+    return false;
+}
+
+bool
+gwcConnector::throttleTemplate ()
+{
+    if (mThrottle == NULL || mThrottle->take ())
+        return true;
+
+    mLog->warn ("throttle limit reached, template rejected");
+    return false;
+}
+
+void
+gwcConnector::riskFields (const cdr& msg, gwcRiskFields& fields) const
+{
+    getClOrdId (msg, false, fields.mClOrdId);
+    getClOrdId (msg, true, fields.mOrigClOrdId);
+    getRiskFields (msg, fields);
+}
+
+bool
+gwcConnector::sendChecked (cdr** orders, size_t n)
+{
+    if (mRisk == NULL)
+        return sendPaced (orders, n);
+
+    /* a batch is sent only if every order in it passes */
+    size_t checked = 0;
+    for (; checked < n; checked++)
+    {
+        gwcRiskFields fields;
+        riskFields (*orders[checked], fields);
+
+        gwcRiskResult r = mRisk->checkOrder (fields);
+        if (r != GWC_RISK_PASSED)
+        {
+            mLog->warn ("order %s failed risk checks, %s",
+                        fields.mClOrdId.c_str (),
+                        gwcRisk::resultToString (r));
+            break;
+        }
+    }
+    if (checked == n && sendPaced (orders, n))
+        return true;
+
+    for (size_t i = 0; i < checked; i++)
+    {
+        std::string clOrdId;
+        getClOrdId (*orders[i], false, clOrdId);
+        mRisk->release (clOrdId, "");
+    }
+    return false;
+}
+
+bool
+gwcConnector::sendModifyChecked (cdr& modify)
+{
+    if (mRisk == NULL)
+        return sendPaced (modify);
+
+    gwcRiskFields fields;
+    riskFields (modify, fields);
+
+    gwcRiskResult r = mRisk->checkModify (fields);
+    if (r != GWC_RISK_PASSED)
+    {
+        mLog->warn ("modify %s failed risk checks, %s",
+                    fields.mClOrdId.c_str (),
+                    gwcRisk::resultToString (r));
+        return false;
+    }
+
+    if (sendPaced (modify))
+        return true;
+
+    mRisk->release (fields.mClOrdId, fields.mOrigClOrdId);
+    return false;
+}
+
+bool
+gwcConnector::riskTemplate ()
+{
+    if (mRisk == NULL)
+        return true;
+
+    mLog->warn ("risk checks enabled, template rejected");
+    return false;
+}
+
+bool
+gwcConnector::getIdField (const cdr& msg, int field, std::string& id)
+{
+    if (msg.getString (field, id))
+        return true;
+
+    int64_t v;
+    if (!msg.getInteger (field, v))
+        return false;
+
+    std::stringstream ss;
+    ss << v;
+    id = ss.str ();
+    return true;
+}
+
+bool
+gwcConnector::initOutboundRing (const neueda::properties& props)
+{
+    std::string v;
+    bool enabled = false;
+
+    props.get ("outbound_ring", "false", v);
+    if (!utils_parseBool (v, enabled))
+    {
+        mLog->err ("failed to parse outbound_ring as bool");
+        return false;
+    }
+
+    if (!enabled)
+        return true;
+
+    int size = GWC_OUTBOUND_RING_SIZE;
+    bool valid;
+    if (props.get ("outbound_ring_size", size, valid))
+    {
+        if (!valid || size <= 0)
+        {
+            mLog->err ("failed to parse outbound_ring_size");
+            return false;
+        }
+    }
+
+    mOutboundRing = new gwcOutboundRing (size, &mOutboundDelegate);
+    mLog->info ("outbound ring enabled with %lu slots",
+                (unsigned long)mOutboundRing->getSize ());
+    return true;
+}
+
+bool
+gwcConnector::initThrottle (const neueda::properties& props,
+                            sbfMw mw,
+                            sbfQueue queue)
+{
+    int  rate = 0;
+    bool valid;
+    if (!props.get ("throttle_rate", rate, valid) || mThrottle != NULL)
+        return true;
+    if (!valid || rate <= 0)
+    {
+        mLog->err ("failed to parse throttle_rate");
+        return false;
+    }
+
+    int window = 1000;
+    if (props.get ("throttle_window_ms", window, valid))
+    {
+        if (!valid || window <= 0)
+        {
+            mLog->err ("failed to parse throttle_window_ms");
+            return false;
+        }
+    }
+
+    int burst = rate;
+    if (props.get ("throttle_burst", burst, valid))
+    {
+        if (!valid || burst <= 0)
+        {
+            mLog->err ("failed to parse throttle_burst");
+            return false;
+        }
+    }
+
+    int queueSize = GWC_THROTTLE_QUEUE_SIZE;
+    if (props.get ("throttle_queue_size", queueSize, valid))
+    {
+        if (!valid || queueSize <= 0)
+        {
+            mLog->err ("failed to parse throttle_queue_size");
+            return false;
+        }
+    }
+
+    std::string     v;
+    gwcThrottleMode mode;
+    props.get ("throttle_mode", "reject", v);
+    if (v == "reject")
+        mode = GWC_THROTTLE_REJECT;
+    else if (v == "queue")
+        mode = GWC_THROTTLE_QUEUE;
+    else
+    {
+        mLog->err ("invalid throttle_mode [%s] must be reject or queue",
+                   v.c_str ());
+        return false;
+    }
+
+    mThrottleMw = mw;
+    mThrottleQueue = queue;
+    mThrottle = new gwcThrottle (mode,
+                                 rate,
+                                 (uint64_t)window * 1000000,
+                                 burst,
+                                 queueSize,
+                                 &mThrottleDelegate);
+
+    mLog->info ("throttle %d messages every %d ms burst %d, %s when exceeded",
+                rate,
+                window,
+                burst,
+                v.c_str ());
+    return true;
+}
+
+void
+gwcConnector::stopThrottle ()
+{
+    if (mThrottleTimer)
+        sbfTimer_destroy (mThrottleTimer);
+    mThrottleTimer = NULL;
+}
+
+void
+gwcConnector::onThrottleTimer (sbfTimer timer, void* closure)
+{
+    gwcConnector* gwc = reinterpret_cast<gwcConnector*>(closure);
+
+    gwc->mThrottle->drain ();
+}
+
+bool
+gwcConnector::getNumberField (const cdr& msg, int field, double& value)
+{
+    if (msg.getDouble (field, value))
+        return true;
+
+    int64_t v;
+    if (!msg.getInteger (field, v))
+        return false;
+
+    value = (double)v;
+    return true;
+}
+
+bool
+gwcConnector::initOrderCache (const neueda::properties& props)
+{
+    std::string v;
+    bool enabled = false;
+
+    props.get ("order_cache", "false", v);
+    if (!utils_parseBool (v, enabled))
+    {
+        mLog->err ("failed to parse order_cache as bool");
+        return false;
+    }
+
+    if (!enabled)
+        return true;
+
+    int size = GWC_ORDER_CACHE_SIZE;
+    bool valid;
+    if (props.get ("order_cache_size", size, valid))
+    {
+        if (!valid || size <= 0)
+        {
+            mLog->err ("failed to parse order_cache_size");
+            return false;
+        }
+    }
+
+    if (mOrderCache == NULL)
+        mOrderCache = new gwcOrderCache (size);
+    mOrderCacheCallbacks.set (this, mOrderCache, mMessageCbs);
+    mMessageCbs = &mOrderCacheCallbacks;
+
+    mLog->info ("order cache enabled with %lu slots",
+                (unsigned long)mOrderCache->getSize ());
+    return true;
+}
+
+bool
+gwcConnector::typedCallbacksAllowed ()
+{
+    if (mOrderCache == NULL && mRisk == NULL)
+        return true;
+
+    mLog->err ("typed callbacks can't be used with order_cache or risk_checks");
+    return false;
+}
+
+static bool
+gwcConnector_getLimit (const neueda::properties& props,
+                       const char* key,
+                       double& value)
+{
+    std::string v;
+    if (!props.get (key, v))
+        return true;
+
+    char* end = NULL;
+    value = strtod (v.c_str (), &end);
+    return end != v.c_str () && *end == '\0' && value >= 0;
+}
+
+bool
+gwcConnector::initRisk (const neueda::properties& props)
+{
+    std::string v;
+    bool enabled = false;
+
+    props.get ("risk_checks", "false", v);
+    if (!utils_parseBool (v, enabled))
+    {
+        mLog->err ("failed to parse risk_checks as bool");
+        return false;
+    }
+
+    if (!enabled)
+        return true;
+
+    gwcRiskLimits limits;
+    double        collar = 0;
+    if (!gwcConnector_getLimit (props, "risk_max_order_qty", limits.mMaxOrderQty))
+    {
+        mLog->err ("failed to parse risk_max_order_qty");
+        return false;
+    }
+    if (!gwcConnector_getLimit (props, "risk_max_order_notional", limits.mMaxOrderNotional))
+    {
+        mLog->err ("failed to parse risk_max_order_notional");
+        return false;
+    }
+    if (!gwcConnector_getLimit (props, "risk_price_collar_pct", collar))
+    {
+        mLog->err ("failed to parse risk_price_collar_pct");
+        return false;
+    }
+    limits.mPriceCollar = collar / 100;
+    if (!gwcConnector_getLimit (props, "risk_max_instrument_exposure", limits.mMaxInstrumentExposure))
+    {
+        mLog->err ("failed to parse risk_max_instrument_exposure");
+        return false;
+    }
+    if (!gwcConnector_getLimit (props, "risk_max_account_exposure", limits.mMaxAccountExposure))
+    {
+        mLog->err ("failed to parse risk_max_account_exposure");
+        return false;
+    }
+
+    int  rate = 0;
+    bool valid;
+    if (props.get ("risk_max_order_rate", rate, valid))
+    {
+        if (!valid || rate < 0)
+        {
+            mLog->err ("failed to parse risk_max_order_rate");
+            return false;
+        }
+        limits.mMaxOrderRate = rate;
+    }
+
+    int orders = GWC_RISK_ORDERS;
+    if (props.get ("risk_orders", orders, valid))
+    {
+        if (!valid || orders <= 0)
+        {
+            mLog->err ("failed to parse risk_orders");
+            return false;
+        }
+    }
+
+    int instruments = GWC_RISK_INSTRUMENTS;
+    if (props.get ("risk_instruments", instruments, valid))
+    {
+        if (!valid || instruments <= 0)
+        {
+            mLog->err ("failed to parse risk_instruments");
+            return false;
+        }
+    }
+
+    int accounts = GWC_RISK_ACCOUNTS;
+    if (props.get ("risk_accounts", accounts, valid))
+    {
+        if (!valid || accounts <= 0)
+        {
+            mLog->err ("failed to parse risk_accounts");
+            return false;
+        }
+    }
+
+    if (mRisk == NULL)
+        mRisk = new gwcRisk (limits, orders, instruments, accounts);
+    mRiskCallbacks.set (this, mRisk, mMessageCbs);
+    mMessageCbs = &mRiskCallbacks;
+
+    mLog->info ("risk checks enabled");
+    return true;
+}
+
+bool
+gwcConnector::initLatency (const neueda::properties& props,
+                           gwcMessageCallbacks* messageCbs)
+{
+    std::string v;
+    bool enabled = false;
+
+    mMessageCbs = messageCbs;
+
+    props.get ("latency_stats", "false", v);
+    if (!utils_parseBool (v, enabled))
+    {
+        mLog->err ("failed to parse latency_stats as bool");
+        return false;
+    }
+
+    if (!enabled)
+        return true;
+
+    if (mLatency == NULL)
+        mLatency = new gwcLatency ();
+    mLatencyCallbacks.set (mLatency, messageCbs);
+    mMessageCbs = &mLatencyCallbacks;
+
+    mLog->info ("latency stats enabled");
+    return true;
+}
+
+bool
+gwcConnector::initLog (const neueda::properties& props, bool asyncLog)
+{
+    std::string v;
+    bool async = false;
+
+    mLogLevel = gwcLog_loggerLevel (mLog);
+    if (props.get ("log_level", v) && !gwcLog_parseLevel (v, mLogLevel))
+    {
+        mLog->err ("invalid log_level [%s] must be debug, info, warn, err or off",
+                   v.c_str ());
+        return false;
+    }
+
+    props.get ("async_log", "false", v);
+    if (!utils_parseBool (v, async))
+    {
+        mLog->err ("failed to parse async_log as bool");
+        return false;
+    }
+    if (async && !asyncLog)
+    {
+        mLog->err ("async_log is not supported by this connector");
+        return false;
+    }
+
+    if (!async || mLogSink != NULL)
+        return true;
+
+    int size = GWC_LOG_RING_SIZE;
+    bool valid;
+    if (props.get ("async_log_size", size, valid))
+    {
+        if (!valid || size <= 0)
+        {
+            mLog->err ("failed to parse async_log_size");
+            return false;
+        }
+    }
+
+    mLogSink = new gwcLogSink (mLog, &mLogFormatter, size);
+
+    std::string err;
+    if (!mLogSink->start (err))
+    {
+        mLog->err ("%s", err.c_str ());
+        delete mLogSink;
+        mLogSink = NULL;
+        return false;
+    }
+
+    mLog->info ("async log enabled with %d records", size);
+    return true;
+}
+
+void
+gwcConnector::stopLog ()
+{
+    if (mLogSink)
+        mLogSink->stop ();
+}
+
+bool
+gwcConnector::initJournal (const neueda::properties& props,
+                           const std::string& session,
+                           const std::string& journal)
+{
+    std::string path;
+    props.get ("journal", journal, path);
+    if (path.empty () || mJournal != NULL)
+        return true;
+
+    int  maxSize = 0;
+    int  fileCount = 0;
+    int  ringSize = GWC_JOURNAL_RING_SIZE;
+    bool valid;
+    if (props.get ("journal_max_size", maxSize, valid))
+    {
+        if (!valid || maxSize < 0)
+        {
+            mLog->err ("failed to parse journal_max_size");
+            return false;
+        }
+    }
+
+    if (props.get ("journal_file_count", fileCount, valid))
+    {
+        if (!valid || fileCount < 0)
+        {
+            mLog->err ("failed to parse journal_file_count");
+            return false;
+        }
+    }
+
+    if (props.get ("journal_ring_size", ringSize, valid))
+    {
+        if (!valid || ringSize <= 0)
+        {
+            mLog->err ("failed to parse journal_ring_size");
+            return false;
+        }
+    }
+
+    std::string name;
+    props.get ("journal_session", session, name);
+
+    std::string err;
+    mJournal = gwcJournal::attach (path, maxSize, fileCount, ringSize, err);
+    if (mJournal == NULL)
+    {
+        mLog->err ("failed to open journal: %s", err.c_str ());
+        return false;
+    }
+    mJournalSession = mJournal->addSession (name);
+
+    mLog->info ("journal %s session %s", path.c_str (), name.c_str ());
+    return true;
+}
+
+bool
+gwcConnector::initSeqnumStore (const neueda::properties& props)
+{
+    std::string   v;
+    std::string   segment;
+    gwcDurability durability;
+
+    /* a state segment survives a process crash unsynced so only syncs to
+       disk when asked */
+    props.get ("state_segment", "", segment);
+    if (!props.get ("seqno_durability", v))
+        v = segment.empty () ? "sync" : "async";
+
+    if (v == "sync")
+        durability = GWC_DURABILITY_SYNC;
+    else if (v == "group")
+        durability = GWC_DURABILITY_GROUP;
+    else if (v == "async")
+        durability = GWC_DURABILITY_ASYNC;
+    else
+    {
+        mLog->err ("invalid seqno_durability [%s] must be sync, group or async",
+                   v.c_str ());
+        return false;
+    }
+
+    int  interval = 1000;
+    int  count = 64;
+    bool valid;
+    if (props.get ("seqno_commit_interval_usecs", interval, valid))
+    {
+        if (!valid || interval <= 0)
+        {
+            mLog->err ("failed to parse seqno_commit_interval_usecs");
+            return false;
+        }
+    }
+
+    if (props.get ("seqno_commit_count", count, valid))
+    {
+        if (!valid || count <= 0)
+        {
+            mLog->err ("failed to parse seqno_commit_count");
+            return false;
+        }
+    }
+
+    mSeqnumStore.setDurability (durability, interval, count);
+
+    if (!segment.empty ())
+    {
+        int slots = GWC_STATE_SEGMENT_SLOTS;
+        if (props.get ("state_segment_slots", slots, valid))
+        {
+            if (!valid || slots <= 0)
+            {
+                mLog->err ("failed to parse state_segment_slots");
+                return false;
+            }
+        }
+
+        mSeqnumStore.setSegment (segment, slots);
+        mLog->info ("seqno cache kept in state segment %s", segment.c_str ());
+    }
+    if (durability != GWC_DURABILITY_SYNC)
+    {
+        mLog->info ("seqno cache committed %s every %d usecs%s",
+                    v.c_str (),
+                    interval,
+                    durability == GWC_DURABILITY_GROUP ? 
+                        " or seqno_commit_count updates" : "");
+    }
+    return true;
+}
+
+bool
+gwcConnector::initDispatch (const neueda::properties& props)
+{
+    std::string v;
+
+    props.get ("dispatch_mode", "block", v);
+    if (v == "block")
+        mDispatchMode = GWC_DISPATCH_BLOCK;
+    else if (v == "spin")
+        mDispatchMode = GWC_DISPATCH_SPIN;
+    else if (v == "hybrid")
+        mDispatchMode = GWC_DISPATCH_HYBRID;
+    else
+    {
+        mLog->err ("invalid dispatch_mode [%s] must be spin, hybrid or block",
+                   v.c_str ());
+        return false;
+    }
+
+    bool valid;
+    if (props.get ("dispatch_cpu", mDispatchCpu, valid))
+    {
+        if (!valid || mDispatchCpu < 0)
+        {
+            mLog->err ("failed to parse dispatch_cpu");
+            return false;
+        }
+    }
+
+    if (props.get ("dispatch_sched_fifo_prio", mDispatchPriority, valid))
+    {
+        if (!valid || mDispatchPriority < 0)
+        {
+            mLog->err ("failed to parse dispatch_sched_fifo_prio");
+            return false;
+        }
+    }
+
+    if (props.get ("dispatch_spin_usecs", mDispatchSpinUsecs, valid))
+    {
+        if (!valid || mDispatchSpinUsecs < 0)
+        {
+            mLog->err ("failed to parse dispatch_spin_usecs");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+sbfMw
+gwcConnector::createMw ()
+{
+    sbfKeyValue kv = sbfKeyValue_create ();
+
+    setQueueProperties (kv);
+
+    sbfMw mw = sbfMw_create (mSbfLog, kv);
+    sbfKeyValue_destroy (kv);
+    return mw;
+}
+
+void
+gwcConnector::setQueueProperties (sbfKeyValue kv)
+{
+    /* sbf queues spin on dequeue when asked to, for hybrid only for a 
+       bounded time before waiting */
+    if (mDispatchMode != GWC_DISPATCH_BLOCK)
+    {
+        std::stringstream usecs;
+        usecs << (mDispatchMode == GWC_DISPATCH_SPIN ? -1 : mDispatchSpinUsecs);
+
+        sbfKeyValue_put (kv, "queue.spin", "true");
+        sbfKeyValue_put (kv, "queue.spin_usecs", usecs.str ().c_str ());
+    }
+}
+
+void
+gwcConnector::dispatch (sbfQueue queue)
+{
+    prepareDispatchThread ();
+    sbfQueue_dispatch (queue);
+}
+
+void
+gwcConnector::prepareDispatchThread ()
+{
+#ifdef WIN32
+    if (mDispatchCpu >= 0)
+    {
+        if (SetThreadAffinityMask (GetCurrentThread (), 
+                                   (DWORD_PTR)1 << mDispatchCpu) == 0)
+            mLog->warn ("failed to pin dispatch thread to cpu %d", mDispatchCpu);
+    }
+    if (mDispatchPriority > 0)
+    {
+        if (!SetThreadPriority (GetCurrentThread (), THREAD_PRIORITY_TIME_CRITICAL))
+            mLog->warn ("failed to set dispatch thread priority");
+    }
+#else
+#ifdef __linux__
+    if (mDispatchCpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO (&set);
+        CPU_SET (mDispatchCpu, &set);
+
+        int rc = pthread_setaffinity_np (pthread_self (), sizeof set, &set);
+        if (rc != 0)
+        {
+            mLog->warn ("failed to pin dispatch thread to cpu %d [%s]", 
+                        mDispatchCpu,
+                        strerror (rc));
+        }
+        else
+            mLog->info ("dispatch thread pinned to cpu %d", mDispatchCpu);
+    }
+#else
+    if (mDispatchCpu >= 0)
+        mLog->warn ("dispatch_cpu not supported on this platform");
+#endif
+
+    if (mDispatchPriority > 0)
+    {
+        struct sched_param param;
+        memset (&param, 0, sizeof param);
+        param.sched_priority = mDispatchPriority;
+
+        int rc = pthread_setschedparam (pthread_self (), SCHED_FIFO, &param);
+        if (rc != 0)
+        {
+            mLog->warn ("failed to set SCHED_FIFO priority %d on dispatch thread [%s]",
+                        mDispatchPriority,
+                        strerror (rc));
+        }
+        else
+        {
+            mLog->info ("dispatch thread running SCHED_FIFO priority %d",
+                        mDispatchPriority);
+        }
+    }
+#endif
+}
+
+void
+gwcConnectorOutboundDelegate::onSend (const void* data, size_t size)
+{
+    mGwc->onOutboundSend (data, size);
+}
+
+void
+gwcConnectorOutboundDelegate::onSent (uint64_t seq, const void* data, size_t size)
+{
+    mGwc->onOutboundSent (seq, data, size);
+}
+
+void
+gwcConnectorOutboundDelegate::onDrained (uint64_t next)
+{
+    mGwc->onOutboundDrained (next);
+}
+
+bool
+gwcConnectorThrottleDelegate::onSend (cdr** msgs, size_t n)
+{
+    if (n == 1)
+        return mGwc->sendMsg (*msgs[0]);
+    return mGwc->sendMsgs (msgs, n);
+}
+
+void
+gwcConnectorThrottleDelegate::onQueued (uint64_t interval)
+{
+    /* no faster than every 100us, the drain catches up on every token
+       returned in between */
+    double secs = (double)interval / 1e9;
+    if (secs < 0.0001)
+        secs = 0.0001;
+
+    mGwc->mThrottleTimer = sbfTimer_create (sbfMw_getDefaultThread (mGwc->mThrottleMw),
+                                            mGwc->mThrottleQueue,
+                                            gwcConnector::onThrottleTimer,
+                                            mGwc,
+                                            secs);
+}
+
+void
+gwcConnectorThrottleDelegate::onDrained ()
+{
+    mGwc->stopThrottle ();
+}
+
+void
+gwcConnectorThrottleDelegate::onFailed (const cdr& msg)
+{
+    mGwc->mLog->warn ("queued message not sent");
+    mGwc->mMessageCbs->onSendFailed (msg);
+}
+
+void
+gwcOrderCacheCallbacks::onOrderAck (uint64_t seqno, const cdr& msg)
+{
+    std::string clOrdId;
+    if (mGwc->getClOrdId (msg, false, clOrdId))
+    {
+        gwcOrderFields fields;
+        mGwc->getOrderFields (msg, fields);
+        if (!mCache->acked (clOrdId, fields))
+            mGwc->mLog->warn ("order cache full, order %s not kept", clOrdId.c_str ());
+    }
+    mCbs->onOrderAck (seqno, msg);
+}
+
+void
+gwcOrderCacheCallbacks::onOrderRejected (uint64_t seqno, const cdr& msg)
+{
+    done (msg);
+    mCbs->onOrderRejected (seqno, msg);
+}
+
+void
+gwcOrderCacheCallbacks::onOrderDone (uint64_t seqno, const cdr& msg)
+{
+    done (msg);
+    mCbs->onOrderDone (seqno, msg);
+}
+
+void
+gwcOrderCacheCallbacks::onOrderFill (uint64_t seqno, const cdr& msg)
+{
+    std::string clOrdId;
+    if (mGwc->getClOrdId (msg, false, clOrdId))
+    {
+        gwcOrderFields fields;
+        mGwc->getOrderFields (msg, fields);
+        if (!mCache->filled (clOrdId, fields))
+            mGwc->mLog->warn ("order cache full, order %s not kept", clOrdId.c_str ());
+    }
+    mCbs->onOrderFill (seqno, msg);
+}
+
+void
+gwcOrderCacheCallbacks::onModifyAck (uint64_t seqno, const cdr& msg)
+{
+    std::string clOrdId;
+    std::string origClOrdId;
+    if (mGwc->getClOrdId (msg, false, clOrdId))
+    {
+        gwcOrderFields fields;
+        mGwc->getClOrdId (msg, true, origClOrdId);
+        mGwc->getOrderFields (msg, fields);
+        if (!mCache->modified (clOrdId, origClOrdId, fields))
+            mGwc->mLog->warn ("order cache full, order %s not kept", clOrdId.c_str ());
+    }
+    mCbs->onModifyAck (seqno, msg);
+}
+
+void
+gwcOrderCacheCallbacks::done (const cdr& msg)
+{
+    std::string clOrdId;
+    std::string origClOrdId;
+
+    /* a cancel ack carries the cancel's id and the order's */
+    mGwc->getClOrdId (msg, false, clOrdId);
+    mGwc->getClOrdId (msg, true, origClOrdId);
+    mCache->done (clOrdId, origClOrdId);
+}
+
+void
+gwcRiskCallbacks::onOrderRejected (uint64_t seqno, const cdr& msg)
+{
+    done (msg);
+    mCbs->onOrderRejected (seqno, msg);
+}
+
+void
+gwcRiskCallbacks::onOrderDone (uint64_t seqno, const cdr& msg)
+{
+    done (msg);
+    mCbs->onOrderDone (seqno, msg);
+}
+
+void
+gwcRiskCallbacks::onOrderFill (uint64_t seqno, const cdr& msg)
+{
+    std::string clOrdId;
+    if (mGwc->getClOrdId (msg, false, clOrdId))
+    {
+        gwcOrderFields fields;
+        mGwc->getOrderFields (msg, fields);
+        if (fields.mHasLastQty)
+        {
+            mRisk->filled (clOrdId,
+                           fields.mLastQty,
+                           fields.mHasLastPx,
+                           fields.mLastPx);
+        }
+    }
+    mCbs->onOrderFill (seqno, msg);
+}
+
+void
+gwcRiskCallbacks::onModifyAck (uint64_t seqno, const cdr& msg)
+{
+    std::string clOrdId;
+    std::string origClOrdId;
+
+    /* an ack without an original id is of a modify keeping the id */
+    if (mGwc->getClOrdId (msg, false, clOrdId))
+    {
+        mGwc->getClOrdId (msg, true, origClOrdId);
+        mRisk->modified (clOrdId, origClOrdId);
+    }
+    mCbs->onModifyAck (seqno, msg);
+}
+
+void
+gwcRiskCallbacks::onModifyRejected (uint64_t seqno, const cdr& msg)
+{
+    rejected (msg);
+    mCbs->onModifyRejected (seqno, msg);
+}
+
+void
+gwcRiskCallbacks::onCancelRejected (uint64_t seqno, const cdr& msg)
+{
+    /* millennium rejects an amend with a cancel reject, cancels hold
+       nothing so a real one releases nothing */
+    rejected (msg);
+    mCbs->onCancelRejected (seqno, msg);
+}
+
+void
+gwcRiskCallbacks::onSendFailed (const cdr& msg)
+{
+    std::string clOrdId;
+    std::string origClOrdId;
+
+    /* as for a send that fails straight away */
+    if (mGwc->getClOrdId (msg, false, clOrdId))
+    {
+        mGwc->getClOrdId (msg, true, origClOrdId);
+        mRisk->release (clOrdId, origClOrdId);
+    }
+    mCbs->onSendFailed (msg);
+}
+
+void
+gwcRiskCallbacks::rejected (const cdr& msg)
+{
+    std::string clOrdId;
+    std::string origClOrdId;
+
+    /* the order keeps what it held, the modify lets go of its own */
+    if (mGwc->getClOrdId (msg, false, clOrdId))
+    {
+        if (!mGwc->getClOrdId (msg, true, origClOrdId))
+            origClOrdId = clOrdId;
+        mRisk->release (clOrdId, origClOrdId);
+    }
+}
+
+void
+gwcRiskCallbacks::done (const cdr& msg)
+{
+    std::string clOrdId;
+    std::string origClOrdId;
+
+    mGwc->getClOrdId (msg, false, clOrdId);
+    mGwc->getClOrdId (msg, true, origClOrdId);
+    mRisk->done (clOrdId);
+    mRisk->done (origClOrdId);
+}
+
+bool
+gwcConnectorLogFormatter::formatMsg (const void* data,
+                                     size_t size,
+                                     std::string& out)
+{
+    return mGwc->formatLogMsg (data, size, out);
+}
+
+/* Connectors the factory can create without loading a library */
+struct gwcConnectorRegistry
+{
+    gwcConnectorRegistry ()
+    {
+        sbfMutex_init (&mLock, 0);
+    }
+
+    std::map<std::string, gwcConnector::getConnector> mConnectors;
+    sbfMutex                                          mLock;
+};
+
+static gwcConnectorRegistry&
+gwcConnectorFactory_registry ()
+{
+    static gwcConnectorRegistry registry;
+    return registry;
+}
+
+bool
+gwcConnectorFactory::add (const std::string& type, gwcConnector::getConnector get)
+{
+    gwcConnectorRegistry& registry = gwcConnectorFactory_registry ();
+
+    sbfMutex_lock (&registry.mLock);
+    bool added = registry.mConnectors.insert (std::make_pair (type, get)).second;
+    sbfMutex_unlock (&registry.mLock);
+
+    return added;
+}
+
 gwcConnector*
 gwcConnectorFactory::get (logger* log, const std::string& type, const neueda::properties& props)
 {
-    std::stringstream lib;
+    gwcConnectorRegistry&      registry = gwcConnectorFactory_registry ();
+    gwcConnector::getConnector g = NULL;
+
+    sbfMutex_lock (&registry.mLock);
+    std::map<std::string, gwcConnector::getConnector>::iterator it =
+        registry.mConnectors.find (type);
+    if (it != registry.mConnectors.end ())
+        g = it->second;
+    sbfMutex_unlock (&registry.mLock);
+
+    if (g == NULL)
+    {
+#ifdef GWC_STATIC_CONNECTORS
+        log->fatal ("connector [%s] not registered", type.c_str ());
+#else
+        std::stringstream lib;
 #ifndef WIN32
-    lib << "libgwc" << type << SBF_SHLIB_SUFFIX;
+        lib << "libgwc" << type << SBF_SHLIB_SUFFIX;
 #else
-    lib << "gwc" << type << ".dll";
+        lib << "gwc" << type << ".dll";
 #endif
-    dl_handle handle = dl_open (lib.str ().c_str ());
+        dl_handle handle = dl_open (lib.str ().c_str ());
 
-    if (handle == NULL) {
-        log->err ("%s", dl_error ());
-        log->fatal ("unable to load connector [%s]", type.c_str ());
-    }
+        if (handle == NULL) {
+            log->err ("%s", dl_error ());
+            log->fatal ("unable to load connector [%s]", type.c_str ());
+        }
 
-    gwcConnector::getConnector g = (gwcConnector::getConnector)dl_symbol (handle, "getConnector");
-    if (g == NULL)
-        log->fatal ("can't find getConnector function in %s", lib.str ().c_str ());
+        g = (gwcConnector::getConnector)dl_symbol (handle, "getConnector");
+        if (g == NULL)
+            log->fatal ("can't find getConnector function in %s", lib.str ().c_str ());
+
+        /* later connectors of this type skip loading */
+        add (type, g);
+#endif
+    }
 
     gwcConnector* connector = g (log, props);
     if (connector == NULL)
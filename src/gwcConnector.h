@@ -4,16 +4,29 @@
  */
 
 #include "gwcCommon.h"
+#include "gwcOrderTemplate.h"
+#include "gwcOutboundRing.h"
+#include "gwcSeqnumStore.h"
+#include "gwcLatency.h"
+#include "gwcLog.h"
+#include "gwcJournal.h"
+#include "gwcThrottle.h"
+#include "gwcOrderCache.h"
+#include "gwcRisk.h"
 #include "properties.h"
 #include "logger.h"
 #include "common.h"
 #include "cdr.h"
+#include "sbfMw.h"
 
 #include <string>
 
 
 namespace neueda {
 
+/* Encode space reserved per message when sending a batch */
+#define GWC_BATCH_MSG_SIZE 1024
+
 /* Session level callbacks */
 class gwcSessionCallbacks
 {
@@ -85,8 +98,118 @@ public:
 
     /* Raw message from not encoded into a cdr */
     virtual void onRawMsg (uint64_t seqno, const void* ptr, size_t len) {};
+
+    /* An order, cancel or modify the throttle queued was never sent, the
+       send failed or the session went down first */
+    virtual void onSendFailed (const cdr& msg) {};
 };
 
+/* Times the application's callbacks when latency_stats is set */
+class gwcLatencyMessageCallbacks : public gwcMessageCallbacks
+{
+public:
+    gwcLatencyMessageCallbacks () :
+        mLatency (NULL),
+        mCbs (NULL)
+    {
+    }
+
+    void set (gwcLatency* latency, gwcMessageCallbacks* cbs)
+    {
+        mLatency = latency;
+        mCbs = cbs;
+    }
+
+    virtual void onAdmin (uint64_t seqno, const cdr& msg)
+    {
+        mLatency->callbackEntry ();
+        mCbs->onAdmin (seqno, msg);
+        mLatency->callbackExit ();
+    }
+
+    virtual void onOrderAck (uint64_t seqno, const cdr& msg)
+    {
+        mLatency->callbackEntry ();
+        mCbs->onOrderAck (seqno, msg);
+        mLatency->callbackExit ();
+    }
+
+    virtual void onOrderRejected (uint64_t seqno, const cdr& msg)
+    {
+        mLatency->callbackEntry ();
+        mCbs->onOrderRejected (seqno, msg);
+        mLatency->callbackExit ();
+    }
+
+    virtual void onOrderDone (uint64_t seqno, const cdr& msg)
+    {
+        mLatency->callbackEntry ();
+        mCbs->onOrderDone (seqno, msg);
+        mLatency->callbackExit ();
+    }
+
+    virtual void onOrderFill (uint64_t seqno, const cdr& msg)
+    {
+        mLatency->callbackEntry ();
+        mCbs->onOrderFill (seqno, msg);
+        mLatency->callbackExit ();
+    }
+
+    virtual void onModifyAck (uint64_t seqno, const cdr& msg)
+    {
+        mLatency->callbackEntry ();
+        mCbs->onModifyAck (seqno, msg);
+        mLatency->callbackExit ();
+    }
+
+    virtual void onModifyRejected (uint64_t seqno, const cdr& msg)
+    {
+        mLatency->callbackEntry ();
+        mCbs->onModifyRejected (seqno, msg);
+        mLatency->callbackExit ();
+    }
+
+    virtual void onCancelRejected (uint64_t seqno, const cdr& msg)
+    {
+        mLatency->callbackEntry ();
+        mCbs->onCancelRejected (seqno, msg);
+        mLatency->callbackExit ();
+    }
+
+    virtual void onMsg (uint64_t seqno, const cdr& msg)
+    {
+        mLatency->callbackEntry ();
+        mCbs->onMsg (seqno, msg);
+        mLatency->callbackExit ();
+    }
+
+    virtual void onRawMsg (uint64_t seqno, const void* ptr, size_t len)
+    {
+        mLatency->callbackEntry ();
+        mCbs->onRawMsg (seqno, ptr, len);
+        mLatency->callbackExit ();
+    }
+
+    virtual void onSendFailed (const cdr& msg)
+    {
+        mLatency->callbackEntry ();
+        mCbs->onSendFailed (msg);
+        mLatency->callbackExit ();
+    }
+
+private:
+    gwcLatency*          mLatency;
+    gwcMessageCallbacks* mCbs;
+};
+
+/* How the dispatch thread waits for inbound events */
+typedef enum
+{
+    GWC_DISPATCH_BLOCK,   /* sleep until woken */
+    GWC_DISPATCH_SPIN,    /* busy poll, never sleep */
+    GWC_DISPATCH_HYBRID   /* busy poll for dispatch_spin_usecs then sleep */
+} gwcDispatchMode;
+
 /* Enum defining conector state */
 typedef enum
 {
@@ -99,9 +222,201 @@ typedef enum
     GWC_CONNECTOR_WAITING_TRADER_LOGOFF
 } gwcConnectorState;
 
+class gwcConnector;
+
+/* Forwards outbound ring events to the connector */
+class gwcConnectorOutboundDelegate : public gwcOutboundRingDelegate
+{
+public:
+    gwcConnectorOutboundDelegate (gwcConnector* gwc) :
+        mGwc (gwc)
+    {
+    }
+
+    virtual void onSend (const void* data, size_t size);
+
+    virtual void onSent (uint64_t seq, const void* data, size_t size);
+
+    virtual void onDrained (uint64_t next);
+
+private:
+    gwcConnector* mGwc;
+};
+
+/* Formats async log records through the connector */
+class gwcConnectorLogFormatter : public gwcLogFormatter
+{
+public:
+    gwcConnectorLogFormatter (gwcConnector* gwc) :
+        mGwc (gwc)
+    {
+    }
+
+    virtual bool formatMsg (const void* data, size_t size, std::string& out);
+
+private:
+    gwcConnector* mGwc;
+};
+
+/* Sends what the throttle lets through and drives its drain timer */
+class gwcConnectorThrottleDelegate : public gwcThrottleDelegate
+{
+public:
+    gwcConnectorThrottleDelegate (gwcConnector* gwc) :
+        mGwc (gwc)
+    {
+    }
+
+    virtual bool onSend (cdr** msgs, size_t n);
+
+    virtual void onQueued (uint64_t interval);
+
+    virtual void onDrained ();
+
+    virtual void onFailed (const cdr& msg);
+
+private:
+    gwcConnector* mGwc;
+};
+
+/* Updates the open order cache from an execution before passing it on to
+   the application's callbacks when order_cache is set */
+class gwcOrderCacheCallbacks : public gwcMessageCallbacks
+{
+public:
+    gwcOrderCacheCallbacks () :
+        mGwc (NULL),
+        mCache (NULL),
+        mCbs (NULL)
+    {
+    }
+
+    void set (gwcConnector* gwc, gwcOrderCache* cache, gwcMessageCallbacks* cbs)
+    {
+        mGwc = gwc;
+        mCache = cache;
+        mCbs = cbs;
+    }
+
+    virtual void onAdmin (uint64_t seqno, const cdr& msg)
+    {
+        mCbs->onAdmin (seqno, msg);
+    }
+
+    virtual void onOrderAck (uint64_t seqno, const cdr& msg);
+
+    virtual void onOrderRejected (uint64_t seqno, const cdr& msg);
+
+    virtual void onOrderDone (uint64_t seqno, const cdr& msg);
+
+    virtual void onOrderFill (uint64_t seqno, const cdr& msg);
+
+    virtual void onModifyAck (uint64_t seqno, const cdr& msg);
+
+    virtual void onModifyRejected (uint64_t seqno, const cdr& msg)
+    {
+        mCbs->onModifyRejected (seqno, msg);
+    }
+
+    virtual void onCancelRejected (uint64_t seqno, const cdr& msg)
+    {
+        mCbs->onCancelRejected (seqno, msg);
+    }
+
+    virtual void onMsg (uint64_t seqno, const cdr& msg)
+    {
+        mCbs->onMsg (seqno, msg);
+    }
+
+    virtual void onRawMsg (uint64_t seqno, const void* ptr, size_t len)
+    {
+        mCbs->onRawMsg (seqno, ptr, len);
+    }
+
+    virtual void onSendFailed (const cdr& msg)
+    {
+        mCbs->onSendFailed (msg);
+    }
+
+private:
+    void done (const cdr& msg);
+
+    gwcConnector*        mGwc;
+    gwcOrderCache*       mCache;
+    gwcMessageCallbacks* mCbs;
+};
+
+/* Wraps the message callbacks to release what orders hold against the risk
+   limits as they are filled, modified, done or rejected */
+class gwcRiskCallbacks : public gwcMessageCallbacks
+{
+public:
+    gwcRiskCallbacks () :
+        mGwc (NULL),
+        mRisk (NULL),
+        mCbs (NULL)
+    {
+    }
+
+    void set (gwcConnector* gwc, gwcRisk* risk, gwcMessageCallbacks* cbs)
+    {
+        mGwc = gwc;
+        mRisk = risk;
+        mCbs = cbs;
+    }
+
+    virtual void onAdmin (uint64_t seqno, const cdr& msg)
+    {
+        mCbs->onAdmin (seqno, msg);
+    }
+
+    virtual void onOrderAck (uint64_t seqno, const cdr& msg)
+    {
+        mCbs->onOrderAck (seqno, msg);
+    }
+
+    virtual void onOrderRejected (uint64_t seqno, const cdr& msg);
+
+    virtual void onOrderDone (uint64_t seqno, const cdr& msg);
+
+    virtual void onOrderFill (uint64_t seqno, const cdr& msg);
+
+    virtual void onModifyAck (uint64_t seqno, const cdr& msg);
+
+    virtual void onModifyRejected (uint64_t seqno, const cdr& msg);
+
+    virtual void onCancelRejected (uint64_t seqno, const cdr& msg);
+
+    virtual void onMsg (uint64_t seqno, const cdr& msg)
+    {
+        mCbs->onMsg (seqno, msg);
+    }
+
+    virtual void onRawMsg (uint64_t seqno, const void* ptr, size_t len)
+    {
+        mCbs->onRawMsg (seqno, ptr, len);
+    }
+
+    virtual void onSendFailed (const cdr& msg);
+
+private:
+    void done (const cdr& msg);
+    void rejected (const cdr& msg);
+
+    gwcConnector*        mGwc;
+    gwcRisk*             mRisk;
+    gwcMessageCallbacks* mCbs;
+};
+
 /* Generic connector, create using factory */
 class gwcConnector
 {
+    friend class gwcConnectorOutboundDelegate;
+    friend class gwcConnectorLogFormatter;
+    friend class gwcConnectorThrottleDelegate;
+    friend class gwcOrderCacheCallbacks;
+    friend class gwcRiskCallbacks;
+
 public:
     typedef gwcConnector* (*getConnector) (neueda::logger* log, const neueda::properties& props);
 
@@ -111,7 +426,27 @@ public:
         mMessageCbs (NULL),
         mState (GWC_CONNECTOR_INIT),
         mLoggedOn (0),
-        mRawEnabled (false)
+        mRawEnabled (false),
+        mOutboundRing (NULL),
+        mLatency (NULL),
+        mDispatchMode (GWC_DISPATCH_BLOCK),
+        mDispatchCpu (-1),
+        mDispatchPriority (0),
+        mDispatchSpinUsecs (50),
+        mLogLevel (GWC_LOG_LEVEL_INFO),
+        mLogSink (NULL),
+        mJournal (NULL),
+        mJournalSession (0),
+        mReplaying (false),
+        mThrottle (NULL),
+        mOrderCache (NULL),
+        mRisk (NULL),
+        mOutboundDelegate (this),
+        mLogFormatter (this),
+        mThrottleDelegate (this),
+        mThrottleMw (NULL),
+        mThrottleQueue (NULL),
+        mThrottleTimer (NULL)
     {
         mSbfLog = sbfLog_create (NULL, "sbf"); // can't fail
         sbfLog_setHook (mSbfLog, SBF_LOG_INFO, sbfLogCb, this);
@@ -123,6 +458,20 @@ public:
 
     virtual ~gwcConnector () 
     {
+        if (mOutboundRing)
+            delete mOutboundRing;
+        if (mLatency)
+            delete mLatency;
+        if (mLogSink)
+            delete mLogSink;
+        if (mJournal)
+            gwcJournal::detach (mJournal);
+        if (mThrottle)
+            delete mThrottle;
+        if (mOrderCache)
+            delete mOrderCache;
+        if (mRisk)
+            delete mRisk;
         if (mSbfLog)
             sbfLog_destroy (mSbfLog);
         sbfCondVar_destroy (&mEventCond);
@@ -162,6 +511,94 @@ public:
     /* Send a raw message */
     virtual bool sendRaw (void* data, size_t len) = 0;
 
+    /* Send a batch of messages in a single write, sequence numbers are 
+       contiguous, nothing is sent if any message fails to encode. msgs is
+       an array of cdr, not of gwcOrder */
+    bool sendBatch (cdr* msgs, size_t n);
+
+    /* Send a batch of orders, see sendBatch */
+    bool sendOrders (cdr* orders, size_t n);
+    bool sendOrders (gwcOrder* orders, size_t n);
+
+    /* Send a batch of cancels, see sendBatch */
+    bool sendCancels (cdr* cancels, size_t n);
+    bool sendCancels (gwcOrder* cancels, size_t n);
+
+    /* Pre-encode an order, cancel or modify into a template, returns false 
+       if the venue encoding doesn't support templates */
+    virtual bool createTemplate (gwcOrderTemplateType type,
+                                 gwcOrder& msg,
+                                 gwcOrderTemplate& tmpl)
+    {
+        mLog->warn ("order templates not supported by connector");
+        return false;
+    }
+
+    /* Send a template created by this connector, patch fields beforehand */
+    virtual bool sendTemplate (gwcOrderTemplate& tmpl)
+    {
+        mLog->warn ("order templates not supported by connector");
+        return false;
+    }
+
+    /* Client order id an order, cancel, modify or execution carries, or
+       with orig set the id of the order a cancel or modify refers to. 
+       False if the connector or message has none */
+    virtual bool getClOrdId (const cdr& msg, bool orig, std::string& id) const
+    {
+        return false;
+    }
+
+    /* Venue order id, quantities and last price an execution carries, for
+       the open order cache */
+    virtual void getOrderFields (const cdr& msg, gwcOrderFields& fields) const {};
+
+    /* Instrument, account, side, quantity and price of an order or modify,
+       for the risk checks */
+    virtual void getRiskFields (const cdr& msg, gwcRiskFields& fields) const {};
+
+    /* Pre-trade risk checks, NULL unless risk_checks is set. Set reference
+       prices for price collars through it */
+    gwcRisk* getRisk ()
+    {
+        return mRisk;
+    }
+
+    /* Open orders by client order id, NULL unless order_cache is set.
+       Lookups are lock free from any thread */
+    const gwcOrderCache* getOrderCache () const
+    {
+        return mOrderCache;
+    }
+
+    /* Snapshot of the per stage latency histograms, empty unless 
+       latency_stats is set */
+    gwcLatencyStats getLatencyStats () const
+    {
+        if (mLatency == NULL)
+            return gwcLatencyStats ();
+        return mLatency->snapshot ();
+    }
+
+    /* Snapshot of the throttle, all zero unless throttle_rate is set */
+    gwcThrottleStats getThrottleStats () const
+    {
+        if (mThrottle == NULL)
+            return gwcThrottleStats ();
+        return mThrottle->snapshot ();
+    }
+
+    /* Pass bytes received in an earlier session, e.g. from a journal,
+       through the connector's read path and on to the callbacks. Only for a
+       connector that is initialised but never started, once replayed it
+       no longer checks inbound sequence numbers or answers the venue.
+       Returns the bytes consumed */
+    size_t replay (const void* data, size_t size)
+    {
+        mReplaying = true;
+        return onReplay ((void*)data, size);
+    }
+
     /* wait for logon event */
     void waitForLogon ()
     {
@@ -207,11 +644,194 @@ public:
     } 
 
 protected:
+    /* Value of an id field as text, whether the venue sends it as a string
+       or an integer */
+    static bool getIdField (const cdr& msg, int field, std::string& id);
+
+    /* Value of a quantity or price field whether sent as a double or an
+       integer */
+    static bool getNumberField (const cdr& msg, int field, double& value);
+
+    /* Map gwcOrder fields onto venue fields */
+    virtual bool mapOrderFields (gwcOrder& order)
+    {
+        return true;
+    }
+
+    /* Set venue message type on an order, cancel or modify */
+    virtual void prepareOrder (cdr& order) {};
+    virtual void prepareCancel (cdr& cancel) {};
+    virtual void prepareModify (cdr& modify) {};
+
+    /* Encode and send messages in one write, connectors that can't batch
+       send one at a time */
+    virtual bool sendMsgs (cdr** msgs, size_t n)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            if (!sendMsg (*msgs[i]))
+                return false;
+        }
+        return true;
+    }
+
+    /* Parse throttle_rate, throttle_window_ms, throttle_burst, 
+       throttle_mode and throttle_queue_size, queued messages are sent from
+       a timer on queue. Connectors call stopThrottle from their destructor
+       before queue is destroyed */
+    bool initThrottle (const neueda::properties& props,
+                       sbfMw mw,
+                       sbfQueue queue);
+    void stopThrottle ();
+
+    /* Send orders, cancels and modifies through the throttle if there is
+       one, session messages go straight to sendMsg */
+    bool sendPaced (cdr& msg)
+    {
+        if (mThrottle == NULL)
+            return sendMsg (msg);
+
+        cdr* msgs = &msg;
+        return sendPaced (&msgs, 1);
+    }
+    bool sendPaced (cdr** msgs, size_t n);
+
+    /* Take a throttle token for a template, which can't be queued so is
+       rejected without one */
+    bool throttleTemplate ();
+
+    /* Send orders or a modify through the risk checks if risk_checks is
+       set then sendPaced, what a message holds is released if it isn't
+       sent */
+    bool sendChecked (cdr& order)
+    {
+        cdr* msgs = &order;
+        return sendChecked (&msgs, 1);
+    }
+    bool sendChecked (cdr** orders, size_t n);
+    bool sendModifyChecked (cdr& modify);
+
+    /* Templates are rejected when risk_checks is set, the checks can't
+       see what a template has been patched with */
+    bool riskTemplate ();
+
+    /* Create the outbound ring if outbound_ring is set, senders then encode
+       without taking the connector lock */
+    bool initOutboundRing (const neueda::properties& props);
+
+    /* Parse seqno_durability, seqno_commit_interval_usecs, 
+       seqno_commit_count, state_segment and state_segment_slots, connectors
+       then open and write their seqno cache through mSeqnumStore */
+    bool initSeqnumStore (const neueda::properties& props);
+
+    /* Set message callbacks, wrapped to time them if latency_stats is set */
+    bool initLatency (const neueda::properties& props,
+                      gwcMessageCallbacks* messageCbs);
+
+    /* Create the open order cache if order_cache is set, parses
+       order_cache_size. Wraps the message callbacks so call after
+       initLatency */
+    bool initOrderCache (const neueda::properties& props);
+
+    /* Create the risk checks if risk_checks is set, parses the risk_
+       limits and table sizes. Wraps the message callbacks so call after
+       initOrderCache */
+    bool initRisk (const neueda::properties& props);
+
+    /* Typed callbacks take executions past the order cache and the risk
+       checks, false if either is set */
+    bool typedCallbacksAllowed ();
+
+    /* Parse dispatch_mode, dispatch_cpu, dispatch_sched_fifo_prio and 
+       dispatch_spin_usecs */
+    bool initDispatch (const neueda::properties& props);
+
+    /* Parse log_level, which defaults to the level of the connector's
+       logger, async_log and async_log_size. Connectors that support
+       async_log pass asyncLog, override formatLogMsg and call stopLog from
+       their destructor before anything it uses is gone */
+    bool initLog (const neueda::properties& props, bool asyncLog);
+    void stopLog ();
+
+    /* Log heading then msg at level if enabled, queued as the encoded data
+       when async_log is set */
+    void logMsg (gwcLogLevel level,
+                 const char* heading,
+                 const cdr& msg,
+                 const void* data,
+                 size_t size)
+    {
+        if (mLogLevel > level)
+            return;
+
+        if (mLogSink != NULL)
+        {
+            mLogSink->logMsg (level, heading, data, size);
+            return;
+        }
+        gwcLog_write (mLog, level, heading);
+        gwcLog_write (mLog, level, msg.toString ().c_str ());
+    }
+
+    /* Attach the journal if journal, or failing that the journal argument,
+       is set. Parses journal_max_size, journal_file_count,
+       journal_ring_size and journal_session which defaults to session */
+    bool initJournal (const neueda::properties& props,
+                      const std::string& session,
+                      const std::string& journal = "");
+
+    /* Record a message received or sent in the journal, if there is one */
+    void journalIn (const void* data, size_t size)
+    {
+        if (mJournal)
+            mJournal->write (mJournalSession, GWC_JOURNAL_IN, data, size);
+    }
+
+    void journalOut (const void* data, size_t size)
+    {
+        if (mJournal)
+            mJournal->write (mJournalSession, GWC_JOURNAL_OUT, data, size);
+    }
+
+    /* Decode an encoded message to text on the async log thread */
+    virtual bool formatLogMsg (const void* data, size_t size, std::string& out)
+    {
+        return false;
+    }
+
+    /* Create mw, the queue spin properties follow the dispatch mode */
+    sbfMw createMw ();
+
+    /* Add the queue spin properties for the dispatch mode to kv */
+    void setQueueProperties (sbfKeyValue kv);
+
+    /* Body of the dispatch thread, pins and sets priority of the calling
+       thread then dispatches queue until it is destroyed */
+    void dispatch (sbfQueue queue);
+
+    /* Pin and set priority of the calling thread as configured */
+    void prepareDispatchThread ();
+
+    /* Feed replayed bytes to the read path of the inbound connection */
+    virtual size_t onReplay (void* data, size_t size)
+    {
+        return 0;
+    }
+
+    /* Outbound ring events, called by one sending thread at a time */
+    virtual void onOutboundSend (const void* data, size_t size) {};
+    virtual void onOutboundSent (uint64_t seq, const void* data, size_t size) {};
+    virtual void onOutboundDrained (uint64_t next) {};
+
     void reset ()
     {
         mState = GWC_CONNECTOR_INIT;
         mLoggedOn = 0;
         mTraderLoggedOn = 0;
+
+        /* nothing queued goes out on the next session */
+        if (mThrottle)
+            mThrottle->clear ();
     }
     
     void loggedOnEvent ()
@@ -265,11 +885,35 @@ protected:
     u_int                mLoggedOn;
     u_int                mTraderLoggedOn;
     bool                 mRawEnabled;
+    gwcOutboundRing*     mOutboundRing;
+    gwcLatency*          mLatency;
+    gwcDispatchMode      mDispatchMode;
+    int                  mDispatchCpu;
+    int                  mDispatchPriority;
+    int                  mDispatchSpinUsecs;
+    gwcSeqnumStore       mSeqnumStore;
+    gwcLogLevel          mLogLevel;
+    gwcLogSink*          mLogSink;
+    gwcJournal*          mJournal;
+    uint16_t             mJournalSession;
+    bool                 mReplaying;
+    gwcThrottle*         mThrottle;
+    gwcOrderCache*       mOrderCache;
+    gwcRisk*             mRisk;
 
 private:
     gwcConnector (const gwcConnector& obj);
     gwcConnector& operator= (const gwcConnector& obj);
 
+    /* Not defined, an array of gwcOrder would otherwise convert to cdr* and
+       be stepped through at the size of a cdr. Use sendOrders or
+       sendCancels */
+    bool sendBatch (gwcOrder* msgs, size_t n);
+
+    static void onThrottleTimer (sbfTimer timer, void* closure);
+
+    void riskFields (const cdr& msg, gwcRiskFields& fields) const;
+
     static int sbfLogCb (sbfLog log, sbfLogLevel level, const char* message, void* closure)
     {
         gwcConnector* gwc = reinterpret_cast<gwcConnector*>(closure);
@@ -293,16 +937,48 @@ private:
         return 1; // don't let sbf log it as well
     }
 
-    sbfCondVar mEventCond;
-    sbfMutex   mEventMutex;
+    sbfCondVar                   mEventCond;
+    sbfMutex                     mEventMutex;
+    gwcConnectorOutboundDelegate mOutboundDelegate;
+    gwcConnectorLogFormatter     mLogFormatter;
+    gwcConnectorThrottleDelegate mThrottleDelegate;
+    sbfMw                        mThrottleMw;
+    sbfQueue                     mThrottleQueue;
+    sbfTimer                     mThrottleTimer;
+    gwcLatencyMessageCallbacks   mLatencyCallbacks;
+    gwcOrderCacheCallbacks       mOrderCacheCallbacks;
+    gwcRiskCallbacks             mRiskCallbacks;
 };
 
 /* Factory to create correct connector */
 class gwcConnectorFactory
 {
 public:
-    /* Get a connector */
+    /* Get a connector, from those registered or else by loading
+       libgwc<type>, which is then registered. With GWC_STATIC_CONNECTORS
+       nothing is loaded and the type must have been registered */
     static gwcConnector* get (neueda::logger* log, const std::string& type, const neueda::properties& props);
+
+    /* Register how to create a connector type, false if it already is */
+    static bool add (const std::string& type, gwcConnector::getConnector get);
 };
 
+/* Entry point of a connector, getConnector for a library loaded at run
+   time or gwc<type>_getConnector when linked statically so several
+   connectors can be linked into one program */
+#ifdef GWC_STATIC_CONNECTORS
+#define GWC_CONNECTOR_ENTRY(type) gwc##type##_getConnector
+#else
+#define GWC_CONNECTOR_ENTRY(type) getConnector
+#endif
+
+/* Register a statically linked connector with the factory, at namespace
+   scope once in the program e.g. GWC_REGISTER_CONNECTOR (millennium).
+   Referencing the entry point pulls the connector out of its archive */
+#define GWC_REGISTER_CONNECTOR(type)                                        \
+    extern "C" neueda::gwcConnector* gwc##type##_getConnector (            \
+        neueda::logger* log, const neueda::properties& props);              \
+    static bool gwc##type##_registered =                                    \
+        neueda::gwcConnectorFactory::add (#type, gwc##type##_getConnector)
+
 }
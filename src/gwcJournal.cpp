@@ -0,0 +1,556 @@
+#include "gwcJournal.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <map>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+/* Ring entries are a commit word followed by the record. The commit word
+   is the entry size, written last, or the bytes skipped to the end of the
+   ring with the pad flag set */
+#define GWC_JOURNAL_PAD 0x8000000000000000ULL
+
+/* Smallest ring, a message may take at most a quarter of it */
+#define GWC_JOURNAL_MIN_RING_SIZE (1024 * 1024)
+
+namespace neueda
+{
+
+typedef std::map<std::string, gwcJournal*> gwcJournalMap;
+
+static gwcJournalMap gwcJournals;
+
+/* Guards the journal map */
+struct gwcJournalsLock
+{
+    gwcJournalsLock ()
+    {
+        sbfMutex_init (&mLock, 0);
+    }
+
+    sbfMutex mLock;
+};
+
+static sbfMutex*
+gwcJournal_mutex ()
+{
+    static gwcJournalsLock lock;
+    return &lock.mLock;
+}
+
+#define gwcJournal_lock() sbfMutex_lock (gwcJournal_mutex ())
+#define gwcJournal_unlock() sbfMutex_unlock (gwcJournal_mutex ())
+
+#ifndef WIN32
+#define gwcJournal_cas(p, o, n) __sync_bool_compare_and_swap ((p), (o), (n))
+#define gwcJournal_fetchAdd(p, v) __sync_fetch_and_add ((p), (v))
+#define gwcJournal_barrier() __sync_synchronize ()
+#define gwcJournal_yield() sched_yield ()
+#define gwcJournal_sleep() usleep (1000)
+#else
+#include <windows.h>
+#define gwcJournal_cas(p, o, n) \
+    (InterlockedCompareExchange64 ((volatile LONG64*)(p), (LONG64)(n), (LONG64)(o)) == (LONG64)(o))
+#define gwcJournal_fetchAdd(p, v) \
+    InterlockedExchangeAdd64 ((volatile LONG64*)(p), (LONG64)(v))
+#define gwcJournal_barrier() MemoryBarrier ()
+#define gwcJournal_yield() SwitchToThread ()
+#define gwcJournal_sleep() Sleep (1)
+#endif
+
+static uint64_t
+gwcJournal_now ()
+{
+#ifndef WIN32
+    struct timespec ts;
+    clock_gettime (CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+static std::string
+gwcJournal_rolledPath (const std::string& path, int n)
+{
+    char s[16];
+    snprintf (s, sizeof s, ".%d", n);
+    return path + s;
+}
+
+gwcJournal::gwcJournal () :
+    mMaxSize (0),
+    mFileCount (0),
+    mFd (-1),
+    mFileSize (0),
+    mFileMessages (0),
+    mBuffered (0),
+    mSessionCount (0),
+    mWrittenSessions (0),
+    mRing (NULL),
+    mMask (0),
+    mHead (0),
+    mTail (0),
+    mWaits (0),
+    mRunning (false),
+    mRolled (0),
+    mUsers (0)
+{
+    sbfMutex_init (&mSessionsLock, 0);
+}
+
+gwcJournal::~gwcJournal ()
+{
+    if (mRunning)
+    {
+        mRunning = false;
+        gwcJournal_barrier ();
+        sbfThread_join (mThread);
+    }
+    close ();
+
+    delete[] mRing;
+    sbfMutex_destroy (&mSessionsLock);
+}
+
+gwcJournal*
+gwcJournal::attach (const std::string& path,
+                    size_t maxSize,
+                    int fileCount,
+                    size_t ringSize,
+                    std::string& err)
+{
+#ifdef WIN32
+    err = "journal not supported on this platform";
+    return NULL;
+#else
+    gwcJournal_lock ();
+
+    gwcJournalMap::iterator itr = gwcJournals.find (path);
+    if (itr != gwcJournals.end ())
+    {
+        itr->second->mUsers++;
+        gwcJournal_unlock ();
+        return itr->second;
+    }
+
+    size_t size = GWC_JOURNAL_MIN_RING_SIZE;
+    while (size < ringSize)
+        size <<= 1;
+
+    gwcJournal* journal = new gwcJournal ();
+    journal->mPath = path;
+    journal->mMaxSize = maxSize;
+    journal->mFileCount = fileCount;
+    journal->mMask = size - 1;
+    journal->mRing = new char[size];
+    memset (journal->mRing, 0, size);
+    journal->mBuffer.resize (GWC_JOURNAL_WRITE_SIZE);
+
+    /* keep what an earlier run left by rolling it out of the way */
+    while (access (gwcJournal_rolledPath (path, journal->mRolled + 1).c_str (),
+                   F_OK) == 0)
+        journal->mRolled++;
+
+    struct stat sb;
+    if (stat (path.c_str (), &sb) == 0 && sb.st_size > 0)
+        journal->roll ();
+
+    if (!journal->open (err))
+    {
+        delete journal;
+        gwcJournal_unlock ();
+        return NULL;
+    }
+
+    journal->mRunning = true;
+    if (sbfThread_create (&journal->mThread, gwcJournal::writerCb, journal) != 0)
+    {
+        journal->mRunning = false;
+        err = "failed to start journal thread";
+        delete journal;
+        gwcJournal_unlock ();
+        return NULL;
+    }
+
+    journal->mUsers = 1;
+    gwcJournals[path] = journal;
+
+    gwcJournal_unlock ();
+    return journal;
+#endif
+}
+
+void
+gwcJournal::detach (gwcJournal* journal)
+{
+    gwcJournal_lock ();
+
+    if (--journal->mUsers == 0)
+    {
+        gwcJournals.erase (journal->mPath);
+        delete journal;
+    }
+
+    gwcJournal_unlock ();
+}
+
+uint16_t
+gwcJournal::addSession (const std::string& session)
+{
+    sbfMutex_lock (&mSessionsLock);
+
+    uint16_t id = (uint16_t)mSessions.size ();
+    mSessions.push_back (session.substr (0, GWC_JOURNAL_SESSION_SIZE));
+    gwcJournal_barrier ();
+    mSessionCount = mSessions.size ();
+
+    sbfMutex_unlock (&mSessionsLock);
+    return id;
+}
+
+void
+gwcJournal::write (uint16_t session,
+                   gwcJournalType type,
+                   const void* data,
+                   size_t size)
+{
+    uint64_t ringSize = mMask + 1;
+    uint64_t need = sizeof (uint64_t) + GWC_JOURNAL_RECORD_SIZE (size);
+    uint64_t head;
+    uint64_t pad;
+    bool     waited = false;
+
+    /* no venue message comes near this, they aren't journalled */
+    if (need > ringSize / 4)
+        return;
+
+    /* reserve need bytes, skipping to the start of the ring if they
+       don't fit before the end */
+    for (;;)
+    {
+        head = mHead;
+        uint64_t offset = head & mMask;
+        pad = offset + need > ringSize ? ringSize - offset : 0;
+
+        if (head + pad + need - mTail > ringSize)
+        {
+            if (!waited)
+            {
+                gwcJournal_fetchAdd (&mWaits, 1);
+                waited = true;
+            }
+            gwcJournal_yield ();
+            continue;
+        }
+        if (gwcJournal_cas (&mHead, head, head + pad + need))
+            break;
+    }
+
+    if (pad != 0)
+    {
+        volatile uint64_t* commit = (volatile uint64_t*)&mRing[head & mMask];
+        *commit = pad | GWC_JOURNAL_PAD;
+        head += pad;
+    }
+
+    char* entry = &mRing[head & mMask];
+    gwcJournalRecord* record = (gwcJournalRecord*)(entry + sizeof (uint64_t));
+    record->mLength = (uint32_t)size;
+    record->mSession = session;
+    record->mType = (uint8_t)type;
+    record->mReserved = 0;
+    record->mTimestamp = gwcJournal_now ();
+    memcpy (record + 1, data, size);
+
+    gwcJournal_barrier ();
+    *(volatile uint64_t*)entry = need;
+}
+
+bool
+gwcJournal::open (std::string& err)
+{
+#ifndef WIN32
+    mFd = ::open (mPath.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (mFd < 0)
+    {
+        err = std::string ("failed to open ") + mPath + ": " + strerror (errno);
+        return false;
+    }
+
+    /* allocate the whole file up front so writes never extend it */
+    if (mMaxSize > 0)
+        posix_fallocate (mFd, 0, mMaxSize);
+#endif
+    mFileSize = 0;
+    mFileMessages = 0;
+
+    gwcJournalFileHeader header;
+    memset (&header, 0, sizeof header);
+    memcpy (header.mMagic, GWC_JOURNAL_MAGIC, sizeof header.mMagic);
+    header.mVersion = GWC_JOURNAL_VERSION;
+    append (&header, sizeof header);
+
+    mWrittenSessions = 0;
+    writeSessions ();
+    return true;
+}
+
+void
+gwcJournal::close ()
+{
+    if (mFd < 0)
+        return;
+
+    flush ();
+#ifndef WIN32
+    /* drop the unused preallocated tail */
+    if (mMaxSize > 0)
+    {
+        if (ftruncate (mFd, mFileSize) != 0)
+            mFileSize = 0;
+    }
+    fdatasync (mFd);
+    ::close (mFd);
+#endif
+    mFd = -1;
+}
+
+void
+gwcJournal::roll ()
+{
+    close ();
+
+    mRolled++;
+    if (mFileCount > 0 && mRolled >= mFileCount)
+        mRolled = mFileCount - 1;
+
+    for (int i = mRolled - 1; i >= 0; i--)
+    {
+        std::string from = i == 0 ? mPath : gwcJournal_rolledPath (mPath, i);
+        std::string to = gwcJournal_rolledPath (mPath, i + 1);
+        rename (from.c_str (), to.c_str ());
+    }
+}
+
+void
+gwcJournal::flush ()
+{
+#ifndef WIN32
+    size_t done = 0;
+    while (done < mBuffered)
+    {
+        ssize_t n = ::write (mFd, &mBuffer[done], mBuffered - done);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        done += n;
+    }
+    mFileSize += done;
+#endif
+    mBuffered = 0;
+}
+
+void
+gwcJournal::writeSessions ()
+{
+    uint32_t count = mSessionCount;
+    gwcJournal_barrier ();
+
+    for (; mWrittenSessions < count; mWrittenSessions++)
+    {
+        char space[sizeof (gwcJournalRecord) + GWC_JOURNAL_SESSION_SIZE + 8];
+        memset (space, 0, sizeof space);
+
+        sbfMutex_lock (&mSessionsLock);
+        const std::string& name = mSessions[mWrittenSessions];
+        gwcJournalRecord* record = (gwcJournalRecord*)space;
+        record->mLength = (uint32_t)name.size ();
+        record->mSession = (uint16_t)mWrittenSessions;
+        record->mType = GWC_JOURNAL_SESSION;
+        record->mTimestamp = gwcJournal_now ();
+        memcpy (record + 1, name.c_str (), name.size ());
+        sbfMutex_unlock (&mSessionsLock);
+
+        append (space, GWC_JOURNAL_RECORD_SIZE (record->mLength));
+    }
+}
+
+void
+gwcJournal::append (const void* data, size_t size)
+{
+    if (mBuffered + size > mBuffer.size ())
+        flush ();
+    if (size > mBuffer.size ())
+        mBuffer.resize (size);
+
+    memcpy (&mBuffer[mBuffered], data, size);
+    mBuffered += size;
+}
+
+size_t
+gwcJournal::drain ()
+{
+    size_t written = 0;
+
+    for (;;)
+    {
+        char*    entry = &mRing[mTail & mMask];
+        uint64_t commit = *(volatile uint64_t*)entry;
+        if (commit == 0)
+            break;
+        gwcJournal_barrier ();
+
+        uint64_t size = commit & ~GWC_JOURNAL_PAD;
+        if ((commit & GWC_JOURNAL_PAD) == 0)
+        {
+            gwcJournalRecord* record = (gwcJournalRecord*)(entry + sizeof (uint64_t));
+            if (record->mSession >= mWrittenSessions)
+                writeSessions ();
+
+            /* buffered bytes count too, a file always takes one message */
+            if (mMaxSize > 0 &&
+                mFileMessages > 0 &&
+                mFileSize + mBuffered + size - sizeof (uint64_t) > mMaxSize)
+            {
+                /* messages are dropped if the new file can't be opened */
+                std::string err;
+                roll ();
+                open (err);
+            }
+            append (record, size - sizeof (uint64_t));
+            mFileMessages++;
+            written += size;
+        }
+
+        /* the next user of these bytes relies on a zero commit word */
+        memset (entry, 0, size);
+        gwcJournal_barrier ();
+        mTail = mTail + size;
+    }
+
+    if (mBuffered > 0)
+        flush ();
+    return written;
+}
+
+void*
+gwcJournal::writerCb (void* closure)
+{
+    gwcJournal* journal = reinterpret_cast<gwcJournal*>(closure);
+    journal->run ();
+    return NULL;
+}
+
+void
+gwcJournal::run ()
+{
+    while (mRunning)
+    {
+        writeSessions ();
+        if (drain () == 0)
+            gwcJournal_sleep ();
+    }
+
+    /* writers have detached by now, write what they left */
+    drain ();
+}
+
+gwcJournalReader::gwcJournalReader () :
+    mFile (NULL)
+{
+}
+
+gwcJournalReader::~gwcJournalReader ()
+{
+    close ();
+}
+
+bool
+gwcJournalReader::open (const std::string& path, std::string& err)
+{
+    close ();
+
+    mFile = fopen (path.c_str (), "rb");
+    if (mFile == NULL)
+    {
+        err = std::string ("failed to open ") + path + ": " + strerror (errno);
+        return false;
+    }
+
+    gwcJournalFileHeader header;
+    if (fread (&header, sizeof header, 1, mFile) != 1 ||
+        memcmp (header.mMagic, GWC_JOURNAL_MAGIC, sizeof header.mMagic) != 0)
+    {
+        err = path + " is not a journal";
+        close ();
+        return false;
+    }
+    if (header.mVersion != GWC_JOURNAL_VERSION)
+    {
+        err = path + " has an unsupported journal version";
+        close ();
+        return false;
+    }
+
+    mSessions.clear ();
+    return true;
+}
+
+void
+gwcJournalReader::close ()
+{
+    if (mFile != NULL)
+        fclose (mFile);
+    mFile = NULL;
+}
+
+bool
+gwcJournalReader::next (gwcJournalRecord& record, const char*& data)
+{
+    while (mFile != NULL)
+    {
+        if (fread (&record, sizeof record, 1, mFile) != 1)
+            return false;
+
+        /* the zeroed tail of a preallocated file that wasn't closed */
+        if (record.mType == 0)
+            return false;
+
+        size_t size = GWC_JOURNAL_RECORD_SIZE (record.mLength) - sizeof record;
+        if (mData.size () < size)
+            mData.resize (size);
+        if (size > 0 && fread (&mData[0], size, 1, mFile) != 1)
+            return false;
+        data = size > 0 ? &mData[0] : NULL;
+
+        if (record.mType != GWC_JOURNAL_SESSION)
+            return true;
+
+        if (mSessions.size () <= record.mSession)
+            mSessions.resize (record.mSession + 1);
+        mSessions[record.mSession].assign (data, record.mLength);
+    }
+    return false;
+}
+
+std::string
+gwcJournalReader::getSessionName (uint16_t session) const
+{
+    if (session >= mSessions.size ())
+        return "";
+    return mSessions[session];
+}
+
+}
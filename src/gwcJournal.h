@@ -0,0 +1,170 @@
+#pragma once
+/*
+ * Binary journal of the messages a connector sends and receives. Senders
+ * copy each message into a lock free ring and a background thread writes
+ * the records out in large sequential writes, rolling and preallocating
+ * files as it goes. Connectors naming the same path share one journal and
+ * are told apart by the session id in every record.
+ *
+ * A journal file is a gwcJournalFileHeader followed by records, each a
+ * gwcJournalRecord and mLength bytes of message padded to 8 bytes. Every
+ * file starts with a session record per session naming its id.
+ */
+
+#include "sbfCommon.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace neueda
+{
+
+#define GWC_JOURNAL_MAGIC "GWCJRNL"
+#define GWC_JOURNAL_VERSION 1
+
+/* Default ring size in bytes */
+#define GWC_JOURNAL_RING_SIZE (8 * 1024 * 1024)
+
+/* Largest single write to the file */
+#define GWC_JOURNAL_WRITE_SIZE (256 * 1024)
+
+/* Longest session name */
+#define GWC_JOURNAL_SESSION_SIZE 64
+
+typedef enum
+{
+    GWC_JOURNAL_IN = 1,
+    GWC_JOURNAL_OUT = 2,
+    /* message is the session name for mSession */
+    GWC_JOURNAL_SESSION = 3
+} gwcJournalType;
+
+struct gwcJournalFileHeader
+{
+    char     mMagic[8];
+    uint32_t mVersion;
+    uint32_t mReserved;
+};
+
+struct gwcJournalRecord
+{
+    uint32_t mLength;
+    uint16_t mSession;
+    uint8_t  mType;
+    uint8_t  mReserved;
+    /* nanoseconds since the epoch when the message was journalled */
+    uint64_t mTimestamp;
+};
+
+/* Space a record with length bytes of message takes in a file */
+#define GWC_JOURNAL_RECORD_SIZE(length) \
+    ((sizeof (gwcJournalRecord) + (length) + 7) & ~(size_t)7)
+
+class gwcJournal
+{
+public:
+    /* Open the journal at path, or share it if already open. maxSize of
+       zero never rolls, fileCount bounds the rolled files kept */
+    static gwcJournal* attach (const std::string& path,
+                               size_t maxSize,
+                               int fileCount,
+                               size_t ringSize,
+                               std::string& err);
+
+    /* Release a journal from attach, flushed and closed by the last user */
+    static void detach (gwcJournal* journal);
+
+    /* Id for session to pass to write, recorded in every file */
+    uint16_t addSession (const std::string& session);
+
+    /* Copy a message into the ring, waits for the writer only when the
+       ring is full. Safe from any thread */
+    void write (uint16_t session, gwcJournalType type, const void* data, size_t size);
+
+    /* Times write found the ring full and had to wait */
+    uint64_t getWaits () const
+    {
+        return mWaits;
+    }
+
+    const std::string& getPath () const
+    {
+        return mPath;
+    }
+
+private:
+    gwcJournal ();
+    ~gwcJournal ();
+    gwcJournal (const gwcJournal& obj);
+    gwcJournal& operator= (const gwcJournal& obj);
+
+    bool open (std::string& err);
+    void close ();
+    void roll ();
+    void flush ();
+    void writeSessions ();
+    void append (const void* data, size_t size);
+
+    /* Move committed records from the ring to the file, returns bytes */
+    size_t drain ();
+
+    static void* writerCb (void* closure);
+    void run ();
+
+    std::string              mPath;
+    size_t                   mMaxSize;
+    int                      mFileCount;
+    int                      mFd;
+    size_t                   mFileSize;
+    uint64_t                 mFileMessages;
+    std::vector<char>        mBuffer;
+    size_t                   mBuffered;
+    std::vector<std::string> mSessions;
+    sbfMutex                 mSessionsLock;
+    volatile uint32_t        mSessionCount;
+    uint32_t                 mWrittenSessions;
+
+    char*                    mRing;
+    uint64_t                 mMask;
+    char                     mPad0[64];
+    volatile uint64_t        mHead;
+    char                     mPad1[64];
+    volatile uint64_t        mTail;
+    char                     mPad2[64];
+    volatile uint64_t        mWaits;
+    volatile bool            mRunning;
+    sbfThread                mThread;
+    int                      mRolled;
+    int                      mUsers;
+};
+
+/* Reads the records of one journal file in order */
+class gwcJournalReader
+{
+public:
+    gwcJournalReader ();
+    ~gwcJournalReader ();
+
+    bool open (const std::string& path, std::string& err);
+    void close ();
+
+    /* Next message record and its data, valid until the next call. Session
+       records are kept to name sessions. False at the end of the file */
+    bool next (gwcJournalRecord& record, const char*& data);
+
+    /* Name of session, empty if its session record hasn't been read */
+    std::string getSessionName (uint16_t session) const;
+
+private:
+    gwcJournalReader (const gwcJournalReader& obj);
+    gwcJournalReader& operator= (const gwcJournalReader& obj);
+
+    FILE*                    mFile;
+    std::vector<char>        mData;
+    std::vector<std::string> mSessions;
+};
+
+}
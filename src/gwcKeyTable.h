@@ -0,0 +1,142 @@
+#pragma once
+/*
+ * Open addressing table of fixed size keyed by a short string, for tables
+ * that must not allocate once created. Probing is linear and erase shifts
+ * the entries after the erased one back rather than leaving a removed
+ * slot, so lookups never slow down however many keys come and go. Not
+ * locked, the owner serialises access.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <string>
+
+namespace neueda
+{
+
+/* EntryT is copied with memcpy and added zeroed, KeySize includes the
+   terminator */
+template <typename EntryT, size_t KeySize>
+class gwcKeyTable
+{
+public:
+    /* size is rounded up to a power of two */
+    gwcKeyTable (size_t size) :
+        mSlots (NULL),
+        mMask (0),
+        mCount (0)
+    {
+        size_t n = 2;
+        while (n < size)
+            n <<= 1;
+
+        mSlots = new gwcKeySlot[n];
+        memset (mSlots, 0, n * sizeof (gwcKeySlot));
+        mMask = n - 1;
+    }
+
+    ~gwcKeyTable ()
+    {
+        delete[] mSlots;
+    }
+
+    /* Entry for key, added if add is set. NULL if there isn't one, the
+       table is full or the key too long. An erase may move other entries
+       so pointers are only good until the next one */
+    EntryT* find (const std::string& key, bool add)
+    {
+        if (key.size () >= KeySize)
+            return NULL;
+
+        uint64_t h = hash (key.c_str (), key.size ());
+        for (uint64_t i = 0; i <= mMask; i++)
+        {
+            gwcKeySlot* slot = &mSlots[(h + i) & mMask];
+
+            if (!slot->mLive)
+            {
+                if (!add)
+                    return NULL;
+
+                slot->mLive = 1;
+                slot->mHash = h;
+                memcpy (slot->mKey, key.c_str (), key.size () + 1);
+                memset (&slot->mEntry, 0, sizeof slot->mEntry);
+                mCount++;
+                return &slot->mEntry;
+            }
+            if (slot->mHash == h && strcmp (slot->mKey, key.c_str ()) == 0)
+                return &slot->mEntry;
+        }
+        return NULL;
+    }
+
+    void erase (const std::string& key)
+    {
+        EntryT* entry = find (key, false);
+        if (entry == NULL)
+            return;
+
+        gwcKeySlot* slot = (gwcKeySlot*)
+            ((char*)entry - offsetof (gwcKeySlot, mEntry));
+        uint64_t    hole = slot - mSlots;
+        slot->mLive = 0;
+        mCount--;
+
+        /* an entry whose probe from its home slot passes the hole moves
+           back into it, leaving a hole where it was */
+        for (uint64_t i = (hole + 1) & mMask;
+             mSlots[i].mLive;
+             i = (i + 1) & mMask)
+        {
+            uint64_t home = mSlots[i].mHash & mMask;
+            if (((i - home) & mMask) < ((i - hole) & mMask))
+                continue;
+
+            memcpy (&mSlots[hole], &mSlots[i], sizeof (gwcKeySlot));
+            mSlots[i].mLive = 0;
+            hole = i;
+        }
+    }
+
+    size_t getCount () const
+    {
+        return mCount;
+    }
+
+    size_t getSize () const
+    {
+        return mMask + 1;
+    }
+
+private:
+    gwcKeyTable (const gwcKeyTable& obj);
+    gwcKeyTable& operator= (const gwcKeyTable& obj);
+
+    struct gwcKeySlot
+    {
+        uint32_t mLive;
+        uint64_t mHash;
+        char     mKey[KeySize];
+        EntryT   mEntry;
+    };
+
+    static uint64_t hash (const char* key, size_t len)
+    {
+        /* FNV-1a */
+        uint64_t h = 14695981039346656037ULL;
+        for (size_t i = 0; i < len; i++)
+        {
+            h ^= (unsigned char)key[i];
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+
+    gwcKeySlot* mSlots;
+    uint64_t    mMask;
+    size_t      mCount;
+};
+
+}
@@ -0,0 +1,376 @@
+#include "gwcLatency.h"
+
+#include <string.h>
+#include <sstream>
+
+#ifdef WIN32
+#include <windows.h>
+#include <intrin.h>
+#define GWC_THREAD_LOCAL __declspec(thread)
+#define gwcLatency_fetchAdd(p, v) \
+    InterlockedExchangeAdd64 ((volatile LONG64*)(p), (LONG64)(v))
+#define gwcLatency_cas32(p, o, n) \
+    (InterlockedCompareExchange ((volatile LONG*)(p), (LONG)(n), (LONG)(o)) == (LONG)(o))
+#define gwcLatency_cas64(p, o, n) \
+    (InterlockedCompareExchange64 ((volatile LONG64*)(p), (LONG64)(n), (LONG64)(o)) == (LONG64)(o))
+#define gwcLatency_barrier() MemoryBarrier ()
+#else
+#include <time.h>
+#define GWC_THREAD_LOCAL __thread
+#define gwcLatency_fetchAdd(p, v) __sync_fetch_and_add ((p), (v))
+#define gwcLatency_cas32(p, o, n) __sync_bool_compare_and_swap ((p), (o), (n))
+#define gwcLatency_cas64(p, o, n) __sync_bool_compare_and_swap ((p), (o), (n))
+#define gwcLatency_barrier() __sync_synchronize ()
+#endif
+
+/* States of a message type entry */
+#define GWC_LATENCY_TYPE_EMPTY 0
+#define GWC_LATENCY_TYPE_CLAIMED 1
+#define GWC_LATENCY_TYPE_READY 2
+
+
+namespace neueda
+{
+
+/* Outbound api call in progress on this thread */
+struct gwcLatencySample
+{
+    gwcLatency* mLatency;
+    uint64_t    mStart;
+    uint32_t    mKey;
+};
+
+static GWC_THREAD_LOCAL gwcLatencySample gwcLatencyCurrent;
+
+const char*
+gwcLatency_stageName (gwcLatencyStage stage)
+{
+    switch (stage)
+    {
+    case GWC_LATENCY_IN_DECODED:
+        return "in_decoded";
+    case GWC_LATENCY_IN_CALLBACK_ENTRY:
+        return "in_callback_entry";
+    case GWC_LATENCY_IN_CALLBACK_EXIT:
+        return "in_callback_exit";
+    case GWC_LATENCY_IN_CALLBACK:
+        return "in_callback";
+    case GWC_LATENCY_OUT_SEQUENCED:
+        return "out_sequenced";
+    case GWC_LATENCY_OUT_ENCODED:
+        return "out_encoded";
+    case GWC_LATENCY_OUT_WRITTEN:
+        return "out_written";
+    default:
+        return "unknown";
+    }
+}
+
+uint64_t
+gwcLatency_now ()
+{
+#ifdef WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER        now;
+
+    if (freq.QuadPart == 0)
+        QueryPerformanceFrequency (&freq);
+    QueryPerformanceCounter (&now);
+    return (uint64_t)((double)now.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static std::string
+gwcLatency_keyName (uint32_t key)
+{
+    if (key & 0x80000000)
+    {
+        std::string name;
+        for (size_t i = 0; i < 3; i++)
+        {
+            char c = (char)((key >> (8 * i)) & 0xff);
+            if (c != '\0')
+                name += c;
+        }
+        return name;
+    }
+
+    std::stringstream name;
+    name << key;
+    return name.str ();
+}
+
+gwcLatencyHistogram::gwcLatencyHistogram () :
+    mCount (0),
+    mSum (0),
+    mMin (~(uint64_t)0),
+    mMax (0)
+{
+    memset ((void*)mCounts, 0, sizeof mCounts);
+}
+
+size_t
+gwcLatencyHistogram::bucket (uint64_t value)
+{
+    if (value < (2ULL << GWC_LATENCY_SUB_BITS))
+        return (size_t)value;
+
+#ifdef WIN32
+    unsigned long msb;
+    _BitScanReverse64 (&msb, value);
+#else
+    size_t msb = 63 - __builtin_clzll (value);
+#endif
+    size_t e = msb - GWC_LATENCY_SUB_BITS;
+    size_t b = ((e + 1) << GWC_LATENCY_SUB_BITS) +
+               (size_t)(value >> e) - (1 << GWC_LATENCY_SUB_BITS);
+
+    return b < GWC_LATENCY_BUCKETS ? b : GWC_LATENCY_BUCKETS - 1;
+}
+
+uint64_t
+gwcLatencyHistogram::highest (size_t bucket)
+{
+    if (bucket < (2 << GWC_LATENCY_SUB_BITS))
+        return bucket;
+
+    size_t   e = (bucket >> GWC_LATENCY_SUB_BITS) - 1;
+    uint64_t sub = (bucket & ((1 << GWC_LATENCY_SUB_BITS) - 1)) +
+                   (1 << GWC_LATENCY_SUB_BITS);
+
+    return ((sub + 1) << e) - 1;
+}
+
+void
+gwcLatencyHistogram::record (uint64_t value)
+{
+    gwcLatency_fetchAdd (&mCounts[bucket (value)], 1);
+    gwcLatency_fetchAdd (&mCount, 1);
+    gwcLatency_fetchAdd (&mSum, value);
+
+    uint64_t min = mMin;
+    while (value < min && !gwcLatency_cas64 (&mMin, min, value))
+        min = mMin;
+
+    uint64_t max = mMax;
+    while (value > max && !gwcLatency_cas64 (&mMax, max, value))
+        max = mMax;
+}
+
+void
+gwcLatencyHistogram::snapshot (gwcLatencyStat& stat) const
+{
+    uint64_t counts[GWC_LATENCY_BUCKETS];
+    uint64_t total = 0;
+
+    /* buckets are summed rather than using mCount so the percentiles agree
+       with each other while recording carries on */
+    for (size_t i = 0; i < GWC_LATENCY_BUCKETS; i++)
+    {
+        counts[i] = mCounts[i];
+        total += counts[i];
+    }
+
+    stat.mCount = total;
+    stat.mMin = total > 0 ? mMin : 0;
+    stat.mMax = mMax;
+    stat.mMean = mCount > 0 ? mSum / mCount : 0;
+    stat.mP50 = 0;
+    stat.mP99 = 0;
+    stat.mP999 = 0;
+    if (total == 0)
+        return;
+
+    uint64_t p50 = (total * 500 + 999) / 1000;
+    uint64_t p99 = (total * 990 + 999) / 1000;
+    uint64_t p999 = (total * 999 + 999) / 1000;
+    uint64_t seen = 0;
+
+    for (size_t i = 0; i < GWC_LATENCY_BUCKETS; i++)
+    {
+        if (counts[i] == 0)
+            continue;
+
+        seen += counts[i];
+        if (stat.mP50 == 0 && seen >= p50)
+            stat.mP50 = highest (i);
+        if (stat.mP99 == 0 && seen >= p99)
+            stat.mP99 = highest (i);
+        if (seen >= p999)
+        {
+            stat.mP999 = highest (i);
+            break;
+        }
+    }
+
+    /* a bucket's top can be past anything actually recorded */
+    if (stat.mP50 > stat.mMax)
+        stat.mP50 = stat.mMax;
+    if (stat.mP99 > stat.mMax)
+        stat.mP99 = stat.mMax;
+    if (stat.mP999 > stat.mMax)
+        stat.mP999 = stat.mMax;
+}
+
+gwcLatency::gwcLatency () :
+    mInRead (0),
+    mInKey (0),
+    mInEntry (0)
+{
+    memset ((void*)mTypes, 0, sizeof mTypes);
+}
+
+gwcLatency::~gwcLatency ()
+{
+    for (size_t i = 0; i < GWC_LATENCY_TYPES; i++)
+        delete[] mTypes[i].mStages;
+}
+
+gwcLatencyHistogram*
+gwcLatency::find (uint32_t key)
+{
+    size_t start = (size_t)((key * 2654435761U) >> 16) % GWC_LATENCY_TYPES;
+
+    for (size_t i = 0; i < GWC_LATENCY_TYPES; i++)
+    {
+        type& t = mTypes[(start + i) % GWC_LATENCY_TYPES];
+
+        if (t.mState == GWC_LATENCY_TYPE_EMPTY &&
+            gwcLatency_cas32 (&t.mState,
+                              GWC_LATENCY_TYPE_EMPTY,
+                              GWC_LATENCY_TYPE_CLAIMED))
+        {
+            /* first message of this type */
+            t.mKey = key;
+            t.mStages = new gwcLatencyHistogram[GWC_LATENCY_STAGES];
+            gwcLatency_barrier ();
+            t.mState = GWC_LATENCY_TYPE_READY;
+            return t.mStages;
+        }
+
+        while (t.mState == GWC_LATENCY_TYPE_CLAIMED)
+            gwcLatency_barrier ();
+
+        if (t.mKey == key)
+            return t.mStages;
+    }
+
+    return NULL;
+}
+
+void
+gwcLatency::record (gwcLatencyStage stage, uint32_t key, uint64_t value)
+{
+    mAll[stage].record (value);
+
+    gwcLatencyHistogram* stages = find (key);
+    if (stages != NULL)
+        stages[stage].record (value);
+}
+
+void
+gwcLatency::inboundDecoded (uint32_t key, uint64_t read)
+{
+    mInRead = read;
+    mInKey = key;
+    mInEntry = 0;
+    record (GWC_LATENCY_IN_DECODED, key, gwcLatency_now () - read);
+}
+
+void
+gwcLatency::callbackEntry ()
+{
+    mInEntry = gwcLatency_now ();
+    if (mInRead != 0)
+        record (GWC_LATENCY_IN_CALLBACK_ENTRY, mInKey, mInEntry - mInRead);
+}
+
+void
+gwcLatency::callbackExit ()
+{
+    uint64_t now = gwcLatency_now ();
+
+    if (mInRead != 0)
+        record (GWC_LATENCY_IN_CALLBACK_EXIT, mInKey, now - mInRead);
+    if (mInEntry != 0)
+        record (GWC_LATENCY_IN_CALLBACK, mInKey, now - mInEntry);
+}
+
+void
+gwcLatency::outboundMark (gwcLatencyStage stage, uint32_t key)
+{
+    if (gwcLatencyCurrent.mLatency != this)
+        return;
+
+    gwcLatencyCurrent.mKey = key;
+    record (stage, key, gwcLatency_now () - gwcLatencyCurrent.mStart);
+}
+
+void
+gwcLatency::outboundMark (gwcLatencyStage stage)
+{
+    if (gwcLatencyCurrent.mLatency != this)
+        return;
+
+    record (stage,
+            gwcLatencyCurrent.mKey,
+            gwcLatency_now () - gwcLatencyCurrent.mStart);
+}
+
+gwcLatencyStats
+gwcLatency::snapshot () const
+{
+    gwcLatencyStats stats;
+    gwcLatencyStat  stat;
+
+    for (int s = 0; s < GWC_LATENCY_STAGES; s++)
+    {
+        stat.mStage = (gwcLatencyStage)s;
+        stat.mMsgType.clear ();
+        mAll[s].snapshot (stat);
+        if (stat.mCount > 0)
+            stats.push_back (stat);
+    }
+
+    for (size_t i = 0; i < GWC_LATENCY_TYPES; i++)
+    {
+        const type& t = mTypes[i];
+        if (t.mState != GWC_LATENCY_TYPE_READY)
+            continue;
+
+        for (int s = 0; s < GWC_LATENCY_STAGES; s++)
+        {
+            stat.mStage = (gwcLatencyStage)s;
+            stat.mMsgType = gwcLatency_keyName (t.mKey);
+            t.mStages[s].snapshot (stat);
+            if (stat.mCount > 0)
+                stats.push_back (stat);
+        }
+    }
+
+    return stats;
+}
+
+gwcLatencyScope::gwcLatencyScope (gwcLatency* latency) :
+    mOwner (false)
+{
+    if (latency == NULL || gwcLatencyCurrent.mLatency != NULL)
+        return;
+
+    gwcLatencyCurrent.mLatency = latency;
+    gwcLatencyCurrent.mStart = gwcLatency_now ();
+    gwcLatencyCurrent.mKey = 0;
+    mOwner = true;
+}
+
+gwcLatencyScope::~gwcLatencyScope ()
+{
+    if (mOwner)
+        gwcLatencyCurrent.mLatency = NULL;
+}
+
+}
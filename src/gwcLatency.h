@@ -0,0 +1,168 @@
+#pragma once
+/*
+ * Per stage latency histograms. Inbound stages are measured from the socket
+ * read that delivered a message, outbound stages from the API call that sent
+ * it, each into a log linear histogram per message type and one for all
+ * types. Recording is lock free, snapshots may be taken from any thread.
+ */
+
+#include "gwcCommon.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+namespace neueda
+{
+
+typedef enum
+{
+    GWC_LATENCY_IN_DECODED,        /* socket read to message decoded */
+    GWC_LATENCY_IN_CALLBACK_ENTRY, /* socket read to user callback entry */
+    GWC_LATENCY_IN_CALLBACK_EXIT,  /* socket read to user callback exit */
+    GWC_LATENCY_IN_CALLBACK,       /* time spent in the user callback */
+    GWC_LATENCY_OUT_SEQUENCED,     /* api entry to seqno assigned */
+    GWC_LATENCY_OUT_ENCODED,       /* api entry to message encoded with seqno */
+    GWC_LATENCY_OUT_WRITTEN,       /* api entry to socket write returned */
+    GWC_LATENCY_STAGES
+} gwcLatencyStage;
+
+/* Snapshot of one histogram, times in nanoseconds */
+struct gwcLatencyStat
+{
+    gwcLatencyStage mStage;
+    std::string     mMsgType; /* empty for all message types */
+    uint64_t        mCount;
+    uint64_t        mMin;
+    uint64_t        mMax;
+    uint64_t        mMean;
+    uint64_t        mP50;
+    uint64_t        mP99;
+    uint64_t        mP999;
+};
+
+typedef std::vector<gwcLatencyStat> gwcLatencyStats;
+
+/* Name of a stage, e.g. in_decoded */
+const char* gwcLatency_stageName (gwcLatencyStage stage);
+
+/* Monotonic time in nanoseconds */
+uint64_t gwcLatency_now ();
+
+/* Message type keys, numeric for binary protocols and up to three characters
+   for text ones */
+inline uint32_t gwcLatency_key (uint32_t type)
+{
+    return type & 0x7fffffff;
+}
+
+inline uint32_t gwcLatency_key (const std::string& type)
+{
+    uint32_t key = 0x80000000;
+    for (size_t i = 0; i < type.size () && i < 3; i++)
+        key |= (uint32_t)(unsigned char)type[i] << (8 * i);
+    return key;
+}
+
+/* Key for a text type already packed a character a byte, first character in
+   the low byte */
+inline uint32_t gwcLatency_textKey (uint32_t type)
+{
+    return 0x80000000 | (type & 0xffffff);
+}
+
+/* Values below 2 ^ (SUB_BITS + 1) are exact, above that each power of two
+   is split into 2 ^ SUB_BITS buckets, about 3% apart */
+#define GWC_LATENCY_SUB_BITS 5
+#define GWC_LATENCY_MAX_BITS 40
+#define GWC_LATENCY_BUCKETS \
+    ((GWC_LATENCY_MAX_BITS - GWC_LATENCY_SUB_BITS + 2) << GWC_LATENCY_SUB_BITS)
+
+/* Message types tracked individually, others only count towards all types */
+#define GWC_LATENCY_TYPES 64
+
+class gwcLatencyHistogram
+{
+public:
+    gwcLatencyHistogram ();
+
+    void record (uint64_t value);
+
+    void snapshot (gwcLatencyStat& stat) const;
+
+private:
+    static size_t bucket (uint64_t value);
+    static uint64_t highest (size_t bucket);
+
+    volatile uint64_t mCounts[GWC_LATENCY_BUCKETS];
+    volatile uint64_t mCount;
+    volatile uint64_t mSum;
+    volatile uint64_t mMin;
+    volatile uint64_t mMax;
+};
+
+class gwcLatency
+{
+public:
+    gwcLatency ();
+    ~gwcLatency ();
+
+    /* Add value to stage for key and for all types */
+    void record (gwcLatencyStage stage, uint32_t key, uint64_t value);
+
+    /* Inbound marks, from the dispatch thread only. Read is when the bytes
+       holding the message were read, from gwcLatency_now */
+    void inboundDecoded (uint32_t key, uint64_t read);
+    void callbackEntry ();
+    void callbackExit ();
+
+    /* Message handled, callbacks from now on aren't for a read */
+    void inboundDone ()
+    {
+        mInRead = 0;
+        mInKey = 0;
+        mInEntry = 0;
+    }
+
+    /* Outbound marks, for the api call in progress on this thread */
+    void outboundMark (gwcLatencyStage stage, uint32_t key);
+    void outboundMark (gwcLatencyStage stage);
+
+    gwcLatencyStats snapshot () const;
+
+private:
+    gwcLatency (const gwcLatency& obj);
+    gwcLatency& operator= (const gwcLatency& obj);
+
+    struct type
+    {
+        volatile uint32_t    mState;
+        uint32_t             mKey;
+        gwcLatencyHistogram* mStages;
+    };
+
+    gwcLatencyHistogram* find (uint32_t key);
+
+    gwcLatencyHistogram mAll[GWC_LATENCY_STAGES];
+    type                mTypes[GWC_LATENCY_TYPES];
+    uint64_t            mInRead;
+    uint32_t            mInKey;
+    uint64_t            mInEntry;
+};
+
+/* Outbound api call on this thread, nested calls are part of the outermost */
+class gwcLatencyScope
+{
+public:
+    gwcLatencyScope (gwcLatency* latency);
+    ~gwcLatencyScope ();
+
+private:
+    gwcLatencyScope (const gwcLatencyScope& obj);
+    gwcLatencyScope& operator= (const gwcLatencyScope& obj);
+
+    bool mOwner;
+};
+
+}
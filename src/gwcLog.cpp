@@ -0,0 +1,232 @@
+#include "gwcLog.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef WIN32
+#include <windows.h>
+#define gwcLog_fetchAdd(p, v) \
+    ((uint64_t)InterlockedExchangeAdd64 ((volatile LONG64*)(p), (LONG64)(v)))
+#define gwcLog_cas(p, o, n) \
+    (InterlockedCompareExchange64 ((volatile LONG64*)(p), (LONG64)(n), (LONG64)(o)) == (LONG64)(o))
+#define gwcLog_barrier() MemoryBarrier ()
+#define gwcLog_sleep() Sleep (1)
+#else
+#include <unistd.h>
+#define gwcLog_fetchAdd(p, v) __sync_fetch_and_add ((p), (v))
+#define gwcLog_cas(p, o, n) __sync_bool_compare_and_swap ((p), (o), (n))
+#define gwcLog_barrier() __sync_synchronize ()
+#define gwcLog_sleep() usleep (1000)
+#endif
+
+
+namespace neueda
+{
+
+bool
+gwcLog_parseLevel (const std::string& value, gwcLogLevel& level)
+{
+    if (value == "debug")
+        level = GWC_LOG_LEVEL_DEBUG;
+    else if (value == "info")
+        level = GWC_LOG_LEVEL_INFO;
+    else if (value == "warn")
+        level = GWC_LOG_LEVEL_WARN;
+    else if (value == "err")
+        level = GWC_LOG_LEVEL_ERR;
+    else if (value == "off")
+        level = GWC_LOG_LEVEL_OFF;
+    else
+        return false;
+    return true;
+}
+
+gwcLogLevel
+gwcLog_loggerLevel (logger* log)
+{
+    if (log->isLevelEnabled (logSeverity::DEBUG))
+        return GWC_LOG_LEVEL_DEBUG;
+    if (log->isLevelEnabled (logSeverity::INFO))
+        return GWC_LOG_LEVEL_INFO;
+    if (log->isLevelEnabled (logSeverity::WARNING))
+        return GWC_LOG_LEVEL_WARN;
+    if (log->isLevelEnabled (logSeverity::ERROR))
+        return GWC_LOG_LEVEL_ERR;
+    return GWC_LOG_LEVEL_OFF;
+}
+
+void
+gwcLog_write (logger* log, gwcLogLevel level, const char* text)
+{
+    switch (level)
+    {
+    case GWC_LOG_LEVEL_DEBUG:
+        log->debug ("%s", text);
+        break;
+    case GWC_LOG_LEVEL_INFO:
+        log->info ("%s", text);
+        break;
+    case GWC_LOG_LEVEL_WARN:
+        log->warn ("%s", text);
+        break;
+    case GWC_LOG_LEVEL_ERR:
+        log->err ("%s", text);
+        break;
+    default:
+        break;
+    }
+}
+
+gwcLogSink::gwcLogSink (logger* log, gwcLogFormatter* formatter, size_t records) :
+    mLog (log),
+    mFormatter (formatter),
+    mRecords (NULL),
+    mMask (0),
+    mHead (0),
+    mTail (0),
+    mDropped (0),
+    mReported (0),
+    mRunning (false)
+{
+    size_t size = 2;
+    while (size < records)
+        size <<= 1;
+
+    /* a record is free for seq when its state is seq and published when its
+       state is seq + 1, as for the outbound ring */
+    mMask = size - 1;
+    mRecords = new gwcLogRecord[size];
+    for (uint64_t seq = 0; seq < size; seq++)
+        mRecords[seq].mState = seq;
+}
+
+gwcLogSink::~gwcLogSink ()
+{
+    stop ();
+    delete[] mRecords;
+}
+
+bool
+gwcLogSink::start (std::string& err)
+{
+    if (mRunning)
+        return true;
+
+    mRunning = true;
+    if (sbfThread_create (&mThread, gwcLogSink::sinkCb, this) != 0)
+    {
+        mRunning = false;
+        err = "failed to start log sink thread";
+        return false;
+    }
+    return true;
+}
+
+void
+gwcLogSink::stop ()
+{
+    if (!mRunning)
+        return;
+
+    mRunning = false;
+    gwcLog_barrier ();
+    sbfThread_join (mThread);
+}
+
+void
+gwcLogSink::logMsg (gwcLogLevel level,
+                    const char* heading,
+                    const void* data,
+                    size_t size)
+{
+    /* claim only a free record so a full ring drops instead of waiting */
+    uint64_t seq = mHead;
+    for (;;)
+    {
+        if (mRecords[seq & mMask].mState != seq)
+        {
+            gwcLog_fetchAdd (&mDropped, 1);
+            return;
+        }
+        if (gwcLog_cas (&mHead, seq, seq + 1))
+            break;
+        seq = mHead;
+    }
+
+    gwcLogRecord& record = mRecords[seq & mMask];
+    record.mLevel = level;
+    record.mHeading = heading;
+    record.mSize = size;
+    if (size <= sizeof record.mData)
+        memcpy (record.mData, data, size);
+
+    gwcLog_barrier ();
+    record.mState = seq + 1;
+}
+
+size_t
+gwcLogSink::drain ()
+{
+    size_t      written = 0;
+    std::string text;
+
+    for (;;)
+    {
+        gwcLogRecord& record = mRecords[mTail & mMask];
+        if (record.mState != mTail + 1)
+            break;
+        gwcLog_barrier ();
+
+        gwcLog_write (mLog, record.mLevel, record.mHeading);
+        if (record.mSize > sizeof record.mData)
+        {
+            char s[64];
+            snprintf (s,
+                      sizeof s,
+                      "message of %lu bytes not logged",
+                      (unsigned long)record.mSize);
+            gwcLog_write (mLog, record.mLevel, s);
+        }
+        else if (mFormatter->formatMsg (record.mData, record.mSize, text))
+            gwcLog_write (mLog, record.mLevel, text.c_str ());
+        else
+            gwcLog_write (mLog, record.mLevel, "failed to format message");
+
+        gwcLog_barrier ();
+        record.mState = mTail + mMask + 1;
+        mTail++;
+        written++;
+    }
+
+    uint64_t dropped = mDropped;
+    if (dropped != mReported)
+    {
+        mLog->warn ("log sink dropped %llu records",
+                    (unsigned long long)(dropped - mReported));
+        mReported = dropped;
+    }
+    return written;
+}
+
+void*
+gwcLogSink::sinkCb (void* closure)
+{
+    gwcLogSink* sink = reinterpret_cast<gwcLogSink*>(closure);
+    sink->run ();
+    return NULL;
+}
+
+void
+gwcLogSink::run ()
+{
+    while (mRunning)
+    {
+        if (drain () == 0)
+            gwcLog_sleep ();
+    }
+
+    /* producers have stopped by now, write what they left */
+    drain ();
+}
+
+}
@@ -0,0 +1,121 @@
+#pragma once
+/*
+ * Connector logging for hot paths. The GWC_LOG_* macros check the connector
+ * log level before their arguments are evaluated, so a message dump that is
+ * not wanted costs a compare rather than a cdr toString.
+ *
+ * With an async sink, message dumps are queued as the encoded bytes off the
+ * wire and a background thread decodes, formats and writes them. Producers
+ * never block, a full ring drops the record and counts it.
+ */
+
+#include "logger.h"
+#include "sbfCommon.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+namespace neueda
+{
+
+typedef enum
+{
+    GWC_LOG_LEVEL_DEBUG,
+    GWC_LOG_LEVEL_INFO,
+    GWC_LOG_LEVEL_WARN,
+    GWC_LOG_LEVEL_ERR,
+    GWC_LOG_LEVEL_OFF
+} gwcLogLevel;
+
+/* Parse debug, info, warn, err or off */
+bool gwcLog_parseLevel (const std::string& value, gwcLogLevel& level);
+
+/* Most detailed level log has enabled */
+gwcLogLevel gwcLog_loggerLevel (logger* log);
+
+/* Write text to log at level */
+void gwcLog_write (logger* log, gwcLogLevel level, const char* text);
+
+/* Log through mLog when mLogLevel allows, for use inside connectors:
+   GWC_LOG_DEBUG ("%s", msg.toString ().c_str ()) */
+#define GWC_LOG_DEBUG if (mLogLevel > GWC_LOG_LEVEL_DEBUG) {} else mLog->debug
+#define GWC_LOG_INFO if (mLogLevel > GWC_LOG_LEVEL_INFO) {} else mLog->info
+
+/* Largest encoded message held by a record, longer ones are logged by size */
+#define GWC_LOG_RECORD_SIZE 1024
+
+/* Default number of records, must be a power of two */
+#define GWC_LOG_RING_SIZE 4096
+
+/* Turns encoded messages back into text, only ever called from the sink
+   thread so may keep its own codec */
+class gwcLogFormatter
+{
+public:
+    /* dtor */
+    virtual ~gwcLogFormatter () {};
+
+    /* Set out to the text of the message in data, false if it can't */
+    virtual bool formatMsg (const void* data, size_t size, std::string& out) = 0;
+};
+
+struct gwcLogRecord
+{
+    volatile uint64_t mState;
+    gwcLogLevel       mLevel;
+    const char*       mHeading;
+    size_t            mSize;
+    char              mData[GWC_LOG_RECORD_SIZE];
+};
+
+class gwcLogSink
+{
+public:
+    gwcLogSink (logger* log, gwcLogFormatter* formatter, size_t records);
+    ~gwcLogSink ();
+
+    /* Start the sink thread */
+    bool start (std::string& err);
+
+    /* Write everything queued and stop the sink thread */
+    void stop ();
+
+    /* Queue an encoded message to be written at level after heading, which
+       must outlive the sink such as a string literal. Safe from any thread */
+    void logMsg (gwcLogLevel level,
+                 const char* heading,
+                 const void* data,
+                 size_t size);
+
+    /* Records dropped because the ring was full */
+    uint64_t getDropped () const
+    {
+        return mDropped;
+    }
+
+private:
+    gwcLogSink (const gwcLogSink& obj);
+    gwcLogSink& operator= (const gwcLogSink& obj);
+
+    /* Write out published records, returns the number written */
+    size_t drain ();
+
+    static void* sinkCb (void* closure);
+    void run ();
+
+    logger*           mLog;
+    gwcLogFormatter*  mFormatter;
+    gwcLogRecord*     mRecords;
+    uint64_t          mMask;
+    char              mPad0[64];
+    volatile uint64_t mHead;
+    char              mPad1[64];
+    uint64_t          mTail;
+    volatile uint64_t mDropped;
+    uint64_t          mReported;
+    volatile bool     mRunning;
+    sbfThread         mThread;
+};
+
+}
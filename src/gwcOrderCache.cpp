@@ -0,0 +1,394 @@
+#include "gwcOrderCache.h"
+
+#include <string.h>
+
+#ifdef WIN32
+#include <windows.h>
+#define gwcOrderCache_barrier() MemoryBarrier ()
+#define gwcOrderCache_yield() SwitchToThread ()
+#else
+#include <sched.h>
+#define gwcOrderCache_barrier() __sync_synchronize ()
+#define gwcOrderCache_yield() sched_yield ()
+#endif
+
+#define GWC_ORDER_SLOT_EMPTY 0
+#define GWC_ORDER_SLOT_LIVE  1
+
+
+namespace neueda
+{
+
+gwcOrderCache::gwcOrderCache (size_t size) :
+    mSlots (NULL),
+    mMask (0),
+    mCount (0),
+    mMoves (0)
+{
+    size_t n = 2;
+    while (n < size)
+        n <<= 1;
+
+    mMask = n - 1;
+    mSlots = new gwcOrderCacheSlot[n];
+    memset (mSlots, 0, n * sizeof (gwcOrderCacheSlot));
+}
+
+gwcOrderCache::~gwcOrderCache ()
+{
+    delete[] mSlots;
+}
+
+uint64_t
+gwcOrderCache::hash (const char* id, size_t len)
+{
+    /* FNV-1a */
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < len; i++)
+    {
+        h ^= (unsigned char)id[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+bool
+gwcOrderCache::find (const std::string& clOrdId, gwcOpenOrder& order) const
+{
+    return find (clOrdId.c_str (), order);
+}
+
+bool
+gwcOrderCache::find (const char* clOrdId, gwcOpenOrder& order) const
+{
+    size_t len = strlen (clOrdId);
+    if (len >= GWC_ORDER_CACHE_ID_SIZE)
+        return false;
+
+    uint64_t h = hash (clOrdId, len);
+    for (;;)
+    {
+        uint32_t moves = mMoves;
+        if (moves & 1)
+        {
+            gwcOrderCache_yield ();
+            continue;
+        }
+        gwcOrderCache_barrier ();
+
+        if (probe (clOrdId, h, order))
+            return true;
+
+        /* the order may have moved behind the probe */
+        gwcOrderCache_barrier ();
+        if (mMoves == moves)
+            return false;
+    }
+}
+
+bool
+gwcOrderCache::probe (const char* id, uint64_t h, gwcOpenOrder& order) const
+{
+    for (uint64_t i = 0; i <= mMask; i++)
+    {
+        const gwcOrderCacheSlot* slot = &mSlots[(h + i) & mMask];
+        uint32_t                 status;
+        bool                     match;
+
+        for (;;)
+        {
+            uint32_t version = slot->mVersion;
+            if (version & 1)
+            {
+                gwcOrderCache_yield ();
+                continue;
+            }
+            gwcOrderCache_barrier ();
+
+            status = slot->mStatus;
+            match = status == GWC_ORDER_SLOT_LIVE && slot->mHash == h;
+            if (match)
+                memcpy (&order, (const void*)&slot->mOrder, sizeof order);
+
+            gwcOrderCache_barrier ();
+            if (slot->mVersion == version)
+                break;
+        }
+
+        if (status == GWC_ORDER_SLOT_EMPTY)
+            return false;
+        if (match && strcmp (order.mClOrdId, id) == 0)
+            return true;
+    }
+    return false;
+}
+
+gwcOrderCache::gwcOrderCacheSlot*
+gwcOrderCache::lookup (const char* id, size_t len, uint64_t h)
+{
+    for (uint64_t i = 0; i <= mMask; i++)
+    {
+        gwcOrderCacheSlot* slot = &mSlots[(h + i) & mMask];
+
+        if (slot->mStatus == GWC_ORDER_SLOT_EMPTY)
+            return NULL;
+        if (slot->mHash == h &&
+            strcmp (slot->mOrder.mClOrdId, id) == 0)
+            return slot;
+    }
+    return NULL;
+}
+
+gwcOrderCache::gwcOrderCacheSlot*
+gwcOrderCache::insert (const char* id, size_t len, uint64_t h)
+{
+    gwcOrderCacheSlot* slot = lookup (id, len, h);
+    if (slot != NULL)
+        return slot;
+
+    for (uint64_t i = 0; i <= mMask; i++)
+    {
+        slot = &mSlots[(h + i) & mMask];
+        if (slot->mStatus == GWC_ORDER_SLOT_LIVE)
+            continue;
+
+        beginWrite (slot);
+        slot->mStatus = GWC_ORDER_SLOT_LIVE;
+        slot->mHash = h;
+        slot->mLeavesKnown = 0;
+        memset (&slot->mOrder, 0, sizeof slot->mOrder);
+        memcpy (slot->mOrder.mClOrdId, id, len + 1);
+        slot->mOrder.mState = GWC_ORDER_STATE_NEW;
+        endWrite (slot);
+
+        mCount++;
+        return slot;
+    }
+    return NULL;
+}
+
+void
+gwcOrderCache::remove (gwcOrderCacheSlot* slot)
+{
+    mMoves++;
+    gwcOrderCache_barrier ();
+
+    uint64_t hole = slot - mSlots;
+    beginWrite (slot);
+    slot->mStatus = GWC_ORDER_SLOT_EMPTY;
+    endWrite (slot);
+
+    /* an order whose probe from its home slot passes the hole moves back
+       into it, leaving a hole where it was */
+    for (uint64_t i = (hole + 1) & mMask;
+         mSlots[i].mStatus != GWC_ORDER_SLOT_EMPTY;
+         i = (i + 1) & mMask)
+    {
+        uint64_t home = mSlots[i].mHash & mMask;
+        if (((i - home) & mMask) < ((i - hole) & mMask))
+            continue;
+
+        move (&mSlots[i], &mSlots[hole]);
+        hole = i;
+    }
+
+    gwcOrderCache_barrier ();
+    mMoves++;
+    mCount--;
+}
+
+void
+gwcOrderCache::move (gwcOrderCacheSlot* from, gwcOrderCacheSlot* to)
+{
+    beginWrite (to);
+    to->mStatus = GWC_ORDER_SLOT_LIVE;
+    to->mLeavesKnown = from->mLeavesKnown;
+    to->mHash = from->mHash;
+    to->mOrder = from->mOrder;
+    endWrite (to);
+
+    beginWrite (from);
+    from->mStatus = GWC_ORDER_SLOT_EMPTY;
+    endWrite (from);
+}
+
+void
+gwcOrderCache::apply (gwcOrderCacheSlot* slot, const gwcOrderFields& fields)
+{
+    gwcOpenOrder& order = slot->mOrder;
+
+    beginWrite (slot);
+    if (!fields.mOrderId.empty () &&
+        fields.mOrderId.size () < GWC_ORDER_CACHE_ID_SIZE)
+    {
+        memcpy (order.mOrderId,
+                fields.mOrderId.c_str (),
+                fields.mOrderId.size () + 1);
+    }
+
+    if (fields.mHasLastQty)
+        order.mLastQty = fields.mLastQty;
+    if (fields.mHasLastPx)
+        order.mLastPx = fields.mLastPx;
+
+    /* venues that don't send cum and leaves have them worked out from
+       the fill */
+    if (fields.mHasCumQty)
+        order.mCumQty = fields.mCumQty;
+    else if (fields.mHasLastQty)
+        order.mCumQty += fields.mLastQty;
+
+    if (fields.mHasLeavesQty)
+        order.mLeavesQty = fields.mLeavesQty;
+    else if (fields.mHasOrderQty)
+        order.mLeavesQty = fields.mOrderQty - order.mCumQty;
+    else if (fields.mHasLastQty && slot->mLeavesKnown)
+        order.mLeavesQty -= fields.mLastQty;
+    if (fields.mHasLeavesQty || fields.mHasOrderQty)
+        slot->mLeavesKnown = 1;
+
+    if (order.mLeavesQty < 0)
+        order.mLeavesQty = 0;
+    endWrite (slot);
+}
+
+void
+gwcOrderCache::beginWrite (gwcOrderCacheSlot* slot)
+{
+    slot->mVersion++;
+    gwcOrderCache_barrier ();
+}
+
+void
+gwcOrderCache::endWrite (gwcOrderCacheSlot* slot)
+{
+    gwcOrderCache_barrier ();
+    slot->mVersion++;
+}
+
+bool
+gwcOrderCache::acked (const std::string& clOrdId, const gwcOrderFields& fields)
+{
+    if (clOrdId.size () >= GWC_ORDER_CACHE_ID_SIZE)
+        return false;
+
+    gwcOrderCacheSlot* slot = insert (clOrdId.c_str (),
+                                      clOrdId.size (),
+                                      hash (clOrdId.c_str (), clOrdId.size ()));
+    if (slot == NULL)
+        return false;
+
+    /* an ack doesn't fill, cum and leaves are as the venue has them */
+    gwcOrderFields ack = fields;
+    ack.mHasLastQty = false;
+    ack.mHasLastPx = false;
+    apply (slot, ack);
+    return true;
+}
+
+bool
+gwcOrderCache::filled (const std::string& clOrdId, const gwcOrderFields& fields)
+{
+    if (clOrdId.size () >= GWC_ORDER_CACHE_ID_SIZE)
+        return false;
+
+    /* a fill for an order the cache hasn't seen acked is added */
+    gwcOrderCacheSlot* slot = insert (clOrdId.c_str (),
+                                      clOrdId.size (),
+                                      hash (clOrdId.c_str (), clOrdId.size ()));
+    if (slot == NULL)
+        return false;
+
+    apply (slot, fields);
+
+    /* kept until done if what is left isn't known */
+    if (slot->mLeavesKnown && slot->mOrder.mLeavesQty <= 0)
+    {
+        remove (slot);
+        return true;
+    }
+
+    beginWrite (slot);
+    slot->mOrder.mState = GWC_ORDER_STATE_PARTIALLY_FILLED;
+    endWrite (slot);
+    return true;
+}
+
+bool
+gwcOrderCache::modified (const std::string& clOrdId,
+                         const std::string& origClOrdId,
+                         const gwcOrderFields& fields)
+{
+    if (clOrdId.size () >= GWC_ORDER_CACHE_ID_SIZE)
+        return false;
+
+    uint64_t           h = hash (clOrdId.c_str (), clOrdId.size ());
+    gwcOrderCacheSlot* slot = lookup (clOrdId.c_str (), clOrdId.size (), h);
+
+    /* the order moves to its new id keeping what has been filled */
+    if (slot == NULL &&
+        !origClOrdId.empty () &&
+        origClOrdId.size () < GWC_ORDER_CACHE_ID_SIZE)
+    {
+        gwcOrderCacheSlot* orig = lookup (origClOrdId.c_str (),
+                                          origClOrdId.size (),
+                                          hash (origClOrdId.c_str (),
+                                                origClOrdId.size ()));
+
+        slot = insert (clOrdId.c_str (), clOrdId.size (), h);
+        if (slot == NULL)
+            return false;
+
+        if (orig != NULL)
+        {
+            beginWrite (slot);
+            memcpy (slot->mOrder.mOrderId,
+                    orig->mOrder.mOrderId,
+                    sizeof slot->mOrder.mOrderId);
+            slot->mOrder.mState = orig->mOrder.mState;
+            slot->mOrder.mLeavesQty = orig->mOrder.mLeavesQty;
+            slot->mOrder.mCumQty = orig->mOrder.mCumQty;
+            slot->mOrder.mLastQty = orig->mOrder.mLastQty;
+            slot->mOrder.mLastPx = orig->mOrder.mLastPx;
+            slot->mLeavesKnown = orig->mLeavesKnown;
+            endWrite (slot);
+
+            /* removing may move the new slot back */
+            remove (orig);
+            slot = lookup (clOrdId.c_str (), clOrdId.size (), h);
+        }
+    }
+    else if (slot == NULL)
+    {
+        slot = insert (clOrdId.c_str (), clOrdId.size (), h);
+        if (slot == NULL)
+            return false;
+    }
+
+    gwcOrderFields modify = fields;
+    modify.mHasLastQty = false;
+    modify.mHasLastPx = false;
+    apply (slot, modify);
+    return true;
+}
+
+void
+gwcOrderCache::done (const std::string& clOrdId, const std::string& origClOrdId)
+{
+    const std::string* ids[2] = { &clOrdId, &origClOrdId };
+
+    for (size_t i = 0; i < 2; i++)
+    {
+        const std::string& id = *ids[i];
+        if (id.empty () || id.size () >= GWC_ORDER_CACHE_ID_SIZE)
+            continue;
+
+        gwcOrderCacheSlot* slot = lookup (id.c_str (),
+                                          id.size (),
+                                          hash (id.c_str (), id.size ()));
+        if (slot != NULL)
+            remove (slot);
+    }
+}
+
+}
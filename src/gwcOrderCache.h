@@ -0,0 +1,137 @@
+#pragma once
+/*
+ * Open orders kept by the connector, keyed by client order id in an open
+ * addressing table of fixed size. Only the dispatch thread writes, updating
+ * an order from the execution before the callback for it is called. Reads
+ * are lock free from any thread, each slot carries a version that is odd
+ * while it is being written and readers retry until they see the same even
+ * version either side of their copy. Removing an order shifts the orders
+ * after it in the probe back so the table never fills with removed slots,
+ * a reader that misses while orders are moving looks again.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+namespace neueda
+{
+
+/* Default number of slots, rounded up to a power of two */
+#define GWC_ORDER_CACHE_SIZE 65536
+
+/* Longest client or venue order id kept, including the terminator */
+#define GWC_ORDER_CACHE_ID_SIZE 40
+
+typedef enum
+{
+    GWC_ORDER_STATE_NEW,              /* acked, nothing filled */
+    GWC_ORDER_STATE_PARTIALLY_FILLED
+} gwcOrderState;
+
+/* Order fields an execution carries, in the venue's units. Fields the
+   message doesn't carry are left unset */
+struct gwcOrderFields
+{
+    gwcOrderFields () :
+        mHasOrderQty (false),
+        mHasLeavesQty (false),
+        mHasCumQty (false),
+        mHasLastQty (false),
+        mHasLastPx (false),
+        mOrderQty (0),
+        mLeavesQty (0),
+        mCumQty (0),
+        mLastQty (0),
+        mLastPx (0)
+    {
+    }
+
+    std::string mOrderId;
+    bool        mHasOrderQty;
+    bool        mHasLeavesQty;
+    bool        mHasCumQty;
+    bool        mHasLastQty;
+    bool        mHasLastPx;
+    double      mOrderQty;
+    double      mLeavesQty;
+    double      mCumQty;
+    double      mLastQty;
+    double      mLastPx;
+};
+
+/* Copy of an open order */
+struct gwcOpenOrder
+{
+    char          mClOrdId[GWC_ORDER_CACHE_ID_SIZE];
+    char          mOrderId[GWC_ORDER_CACHE_ID_SIZE];
+    gwcOrderState mState;
+    double        mLeavesQty;
+    double        mCumQty;
+    double        mLastQty;
+    double        mLastPx;
+};
+
+class gwcOrderCache
+{
+public:
+    gwcOrderCache (size_t size);
+    ~gwcOrderCache ();
+
+    /* Copy of the open order with clOrdId, false if there isn't one. Lock
+       free, from any thread */
+    bool find (const std::string& clOrdId, gwcOpenOrder& order) const;
+    bool find (const char* clOrdId, gwcOpenOrder& order) const;
+
+    /* Orders open now */
+    size_t getCount () const
+    {
+        return mCount;
+    }
+
+    size_t getSize () const
+    {
+        return mMask + 1;
+    }
+
+    /* Updates from executions, dispatch thread only. False if the table
+       is full or the id too long to keep */
+    bool acked (const std::string& clOrdId, const gwcOrderFields& fields);
+    bool filled (const std::string& clOrdId, const gwcOrderFields& fields);
+    bool modified (const std::string& clOrdId,
+                   const std::string& origClOrdId,
+                   const gwcOrderFields& fields);
+    void done (const std::string& clOrdId, const std::string& origClOrdId);
+
+private:
+    gwcOrderCache (const gwcOrderCache& obj);
+    gwcOrderCache& operator= (const gwcOrderCache& obj);
+
+    struct gwcOrderCacheSlot
+    {
+        volatile uint32_t mVersion;
+        uint32_t          mStatus;
+        uint32_t          mLeavesKnown;
+        uint64_t          mHash;
+        gwcOpenOrder      mOrder;
+    };
+
+    static uint64_t hash (const char* id, size_t len);
+
+    bool probe (const char* id, uint64_t h, gwcOpenOrder& order) const;
+    gwcOrderCacheSlot* lookup (const char* id, size_t len, uint64_t h);
+    gwcOrderCacheSlot* insert (const char* id, size_t len, uint64_t h);
+    void remove (gwcOrderCacheSlot* slot);
+    void move (gwcOrderCacheSlot* from, gwcOrderCacheSlot* to);
+    void apply (gwcOrderCacheSlot* slot, const gwcOrderFields& fields);
+
+    void beginWrite (gwcOrderCacheSlot* slot);
+    void endWrite (gwcOrderCacheSlot* slot);
+
+    gwcOrderCacheSlot* mSlots;
+    uint64_t           mMask;
+    volatile size_t    mCount;
+    volatile uint32_t  mMoves; /* odd while remove is moving orders */
+};
+
+}
@@ -0,0 +1,303 @@
+#include "gwcOrderTemplate.h"
+
+#include <string.h>
+#include <sstream>
+
+
+namespace neueda
+{
+
+gwcOrderTemplate::gwcOrderTemplate () :
+    mOwner (NULL),
+    mType (GWC_TEMPLATE_ORDER),
+    mSideBuy (0),
+    mSideSell (0),
+    mSize (0)
+{
+    reset (NULL, GWC_TEMPLATE_ORDER);
+}
+
+void
+gwcOrderTemplate::reset (const void* owner, gwcOrderTemplateType type)
+{
+    mOwner = owner;
+    mType = type;
+    mSize = 0;
+    mLastError.clear ();
+
+    for (int i = 0; i < GWC_TEMPLATE_FIELD_MAX; i++)
+    {
+        mSlots[i].mEncoding = GWC_TEMPLATE_ENCODING_NONE;
+        mSlots[i].mOffset = 0;
+        mSlots[i].mWidth = 0;
+        mSlots[i].mScale = 1.0;
+        mSlots[i].mPad = '\0';
+    }
+}
+
+void
+gwcOrderTemplate::setSideValues (int64_t buy, int64_t sell)
+{
+    mSideBuy = buy;
+    mSideSell = sell;
+}
+
+bool
+gwcOrderTemplate::encode (codec& c, cdr& msg)
+{
+    if (c.encode (msg, mData, sizeof mData, mSize) != GW_CODEC_SUCCESS)
+    {
+        mLastError = c.getLastError ();
+        mSize = 0;
+        return false;
+    }
+    return true;
+}
+
+void
+gwcOrderTemplate::setProbe (cdr& msg,
+                            int key,
+                            gwcOrderTemplateEncoding encoding,
+                            size_t width,
+                            double cdrScale,
+                            int probe)
+{
+    if (encoding == GWC_TEMPLATE_ENCODING_ALPHA)
+    {
+        msg.setString (key, probe == 1 ? "1" : "2");
+        return;
+    }
+
+    /* every byte of the field set to the probe value, the most significant
+       byte always differs between the two probes */
+    uint64_t raw = 0;
+    for (size_t i = 0; i < width; i++)
+        raw = (raw << 8) | (uint64_t)probe;
+
+    if (cdrScale != 0)
+        msg.setDouble (key, (double)raw / cdrScale);
+    else
+        msg.setInteger (key, (int64_t)raw);
+}
+
+bool
+gwcOrderTemplate::locate (codec& c,
+                          const cdr& msg,
+                          gwcOrderTemplateField field,
+                          int key,
+                          gwcOrderTemplateEncoding encoding,
+                          size_t width,
+                          double cdrScale,
+                          double wireScale)
+{
+    char   first[GWC_ORDER_TEMPLATE_MAX_SIZE];
+    char   second[GWC_ORDER_TEMPLATE_MAX_SIZE];
+    size_t firstUsed;
+    size_t secondUsed;
+    cdr    probe (msg);
+
+    if (mSize == 0 || width == 0 ||
+        (width > sizeof (uint64_t) && encoding != GWC_TEMPLATE_ENCODING_ALPHA))
+    {
+        mLastError = "invalid template field definition";
+        return false;
+    }
+
+    /* encode the message twice with different values for the field, the
+       bytes that change give the offset of the field in the encoding */
+    setProbe (probe, key, encoding, width, cdrScale, 1);
+    if (c.encode (probe, first, sizeof first, firstUsed) != GW_CODEC_SUCCESS)
+    {
+        mLastError = c.getLastError ();
+        return false;
+    }
+
+    setProbe (probe, key, encoding, width, cdrScale, 2);
+    if (c.encode (probe, second, sizeof second, secondUsed) != GW_CODEC_SUCCESS)
+    {
+        mLastError = c.getLastError ();
+        return false;
+    }
+
+    if (firstUsed != mSize || secondUsed != mSize)
+    {
+        mLastError = "message encoding is not fixed width";
+        return false;
+    }
+
+    size_t lo = mSize;
+    size_t hi = 0;
+    for (size_t i = 0; i < mSize; i++)
+    {
+        if (first[i] == second[i])
+            continue;
+        if (lo == mSize)
+            lo = i;
+        hi = i;
+    }
+
+    /* field not encoded for this message type */
+    if (lo == mSize)
+        return true;
+
+    size_t offset = lo;
+    if (encoding == GWC_TEMPLATE_ENCODING_LE)
+    {
+        if (hi + 1 < width)
+        {
+            mLastError = "failed to locate field in encoding";
+            return false;
+        }
+        offset = hi + 1 - width;
+    }
+
+    if (offset > lo || hi >= offset + width || offset + width > mSize)
+    {
+        std::stringstream ss;
+        ss << "field " << key << " does not fit width " << width;
+        mLastError = ss.str ();
+        return false;
+    }
+
+    gwcOrderTemplateSlot& slot = mSlots[field];
+    slot.mEncoding = encoding;
+    slot.mOffset = offset;
+    slot.mWidth = width;
+    slot.mScale = wireScale;
+    slot.mPad = width > 1 ? first[offset + 1] : ' ';
+
+    return true;
+}
+
+bool
+gwcOrderTemplate::hasField (gwcOrderTemplateField field) const
+{
+    return mSlots[field].mEncoding != GWC_TEMPLATE_ENCODING_NONE;
+}
+
+bool
+gwcOrderTemplate::patchInteger (gwcOrderTemplateField field, int64_t value)
+{
+    const gwcOrderTemplateSlot& slot = mSlots[field];
+    uint64_t                    v = (uint64_t)value;
+
+    switch (slot.mEncoding)
+    {
+    case GWC_TEMPLATE_ENCODING_LE:
+        for (size_t i = 0; i < slot.mWidth; i++)
+        {
+            mData[slot.mOffset + i] = (char)(v & 0xff);
+            v >>= 8;
+        }
+        return true;
+
+    case GWC_TEMPLATE_ENCODING_BE:
+        for (size_t i = slot.mWidth; i > 0; i--)
+        {
+            mData[slot.mOffset + i - 1] = (char)(v & 0xff);
+            v >>= 8;
+        }
+        return true;
+
+    case GWC_TEMPLATE_ENCODING_ALPHA:
+    {
+        std::stringstream ss;
+        ss << value;
+        return patchString (field, ss.str ());
+    }
+
+    default:
+        return false;
+    }
+}
+
+bool
+gwcOrderTemplate::patchString (gwcOrderTemplateField field, const std::string& value)
+{
+    const gwcOrderTemplateSlot& slot = mSlots[field];
+
+    if (slot.mEncoding != GWC_TEMPLATE_ENCODING_ALPHA)
+        return false;
+
+    if (value.size () > slot.mWidth)
+    {
+        mLastError = "value [" + value + "] too long for field";
+        return false;
+    }
+
+    memcpy (mData + slot.mOffset, value.data (), value.size ());
+    memset (mData + slot.mOffset + value.size (),
+            slot.mPad,
+            slot.mWidth - value.size ());
+    return true;
+}
+
+bool
+gwcOrderTemplate::setPrice (double price)
+{
+    double scaled = price * mSlots[GWC_TEMPLATE_FIELD_PRICE].mScale;
+
+    return patchInteger (GWC_TEMPLATE_FIELD_PRICE,
+                         (int64_t)(scaled < 0 ? scaled - 0.5 : scaled + 0.5));
+}
+
+bool
+gwcOrderTemplate::setQty (uint64_t qty)
+{
+    double scaled = (double)qty * mSlots[GWC_TEMPLATE_FIELD_QTY].mScale;
+
+    return patchInteger (GWC_TEMPLATE_FIELD_QTY, (int64_t)(scaled + 0.5));
+}
+
+bool
+gwcOrderTemplate::setSide (gwcSide side)
+{
+    int64_t v;
+
+    switch (side)
+    {
+    case GWC_SIDE_BUY:
+        v = mSideBuy;
+        break;
+    case GWC_SIDE_SELL:
+        v = mSideSell;
+        break;
+    default:
+        mLastError = "only buy and sell can be patched";
+        return false;
+    }
+
+    const gwcOrderTemplateSlot& slot = mSlots[GWC_TEMPLATE_FIELD_SIDE];
+    if (slot.mEncoding == GWC_TEMPLATE_ENCODING_ALPHA)
+    {
+        mData[slot.mOffset] = (char)v;
+        return true;
+    }
+    return patchInteger (GWC_TEMPLATE_FIELD_SIDE, v);
+}
+
+bool
+gwcOrderTemplate::setClOrdId (const std::string& clOrdId)
+{
+    return patchString (GWC_TEMPLATE_FIELD_CLORDID, clOrdId);
+}
+
+bool
+gwcOrderTemplate::setClOrdId (int64_t clOrdId)
+{
+    return patchInteger (GWC_TEMPLATE_FIELD_CLORDID, clOrdId);
+}
+
+bool
+gwcOrderTemplate::setOrigClOrdId (const std::string& clOrdId)
+{
+    return patchString (GWC_TEMPLATE_FIELD_ORIG_CLORDID, clOrdId);
+}
+
+bool
+gwcOrderTemplate::setOrigClOrdId (int64_t clOrdId)
+{
+    return patchInteger (GWC_TEMPLATE_FIELD_ORIG_CLORDID, clOrdId);
+}
+
+}
@@ -0,0 +1,145 @@
+#pragma once
+/*
+ * Pre-encoded order template, the static fields of an order, cancel or modify
+ * are encoded once by the venue codec and price, qty, side and client order
+ * id are patched in place before each send
+ */
+
+#include "gwcCommon.h"
+#include "codec.h"
+
+#include <string>
+
+namespace neueda
+{
+
+#define GWC_ORDER_TEMPLATE_MAX_SIZE 1024
+
+/* Message held by a template */
+typedef enum
+{
+    GWC_TEMPLATE_ORDER,
+    GWC_TEMPLATE_CANCEL,
+    GWC_TEMPLATE_MODIFY
+} gwcOrderTemplateType;
+
+/* Fields that can be patched */
+typedef enum
+{
+    GWC_TEMPLATE_FIELD_PRICE,
+    GWC_TEMPLATE_FIELD_QTY,
+    GWC_TEMPLATE_FIELD_SIDE,
+    GWC_TEMPLATE_FIELD_CLORDID,
+    GWC_TEMPLATE_FIELD_ORIG_CLORDID,
+    GWC_TEMPLATE_FIELD_SEQNUM,
+    GWC_TEMPLATE_FIELD_MAX
+} gwcOrderTemplateField;
+
+/* Wire encoding of a patchable field */
+typedef enum
+{
+    GWC_TEMPLATE_ENCODING_NONE,   /* field not part of message */
+    GWC_TEMPLATE_ENCODING_LE,     /* little endian integer */
+    GWC_TEMPLATE_ENCODING_BE,     /* big endian integer */
+    GWC_TEMPLATE_ENCODING_ALPHA   /* fixed width padded string */
+} gwcOrderTemplateEncoding;
+
+struct gwcOrderTemplateSlot
+{
+    gwcOrderTemplateEncoding mEncoding;
+    size_t                   mOffset;
+    size_t                   mWidth;
+    double                   mScale;
+    char                     mPad;
+};
+
+/* Create with gwcConnector::createTemplate, send with gwcConnector::sendTemplate */
+class gwcOrderTemplate
+{
+public:
+    gwcOrderTemplate ();
+
+    /* Patch dynamic fields, false if the field is not part of the message */
+    bool setPrice (double price);
+    bool setQty (uint64_t qty);
+    bool setSide (gwcSide side);
+
+    /* Client order ids are strings or integers depending on venue */
+    bool setClOrdId (const std::string& clOrdId);
+    bool setClOrdId (int64_t clOrdId);
+    bool setOrigClOrdId (const std::string& clOrdId);
+    bool setOrigClOrdId (int64_t clOrdId);
+
+    /* True if field can be patched */
+    bool hasField (gwcOrderTemplateField field) const;
+
+    /* Offset of a patchable field in the encoding */
+    size_t getOffset (gwcOrderTemplateField field) const
+    {
+        return mSlots[field].mOffset;
+    }
+
+    gwcOrderTemplateType getType () const
+    {
+        return mType;
+    }
+
+    const void* getData () const
+    {
+        return mData;
+    }
+
+    size_t getSize () const
+    {
+        return mSize;
+    }
+
+    const std::string& getLastError () const
+    {
+        return mLastError;
+    }
+
+    /* Used by connectors when building and sending a template */
+    void reset (const void* owner, gwcOrderTemplateType type);
+    void setSideValues (int64_t buy, int64_t sell);
+    bool encode (codec& c, cdr& msg);
+    bool locate (codec& c,
+                 const cdr& msg,
+                 gwcOrderTemplateField field,
+                 int key,
+                 gwcOrderTemplateEncoding encoding,
+                 size_t width,
+                 double cdrScale,
+                 double wireScale);
+    bool patchInteger (gwcOrderTemplateField field, int64_t value);
+    bool patchString (gwcOrderTemplateField field, const std::string& value);
+
+    bool isOwner (const void* owner) const
+    {
+        return mOwner != NULL && mOwner == owner;
+    }
+
+    void* getBuffer ()
+    {
+        return mData;
+    }
+
+private:
+    void setProbe (cdr& msg,
+                   int key,
+                   gwcOrderTemplateEncoding encoding,
+                   size_t width,
+                   double cdrScale,
+                   int probe);
+
+    const void*          mOwner;
+    gwcOrderTemplateType mType;
+    gwcOrderTemplateSlot mSlots[GWC_TEMPLATE_FIELD_MAX];
+    int64_t              mSideBuy;
+    int64_t              mSideSell;
+    char                 mData[GWC_ORDER_TEMPLATE_MAX_SIZE];
+    size_t               mSize;
+    std::string          mLastError;
+};
+
+}
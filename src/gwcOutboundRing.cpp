@@ -0,0 +1,302 @@
+#include "gwcOutboundRing.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef WIN32
+#include <windows.h>
+#define gwcOutboundRing_fetchAdd(p, v) \
+    ((uint64_t)InterlockedExchangeAdd64 ((volatile LONG64*)(p), (LONG64)(v)))
+#define gwcOutboundRing_cas(p, o, n) \
+    (InterlockedCompareExchange ((volatile LONG*)(p), (LONG)(n), (LONG)(o)) == (LONG)(o))
+#define gwcOutboundRing_cas64(p, o, n) \
+    (InterlockedCompareExchange64 ((volatile LONG64*)(p), (LONG64)(n), (LONG64)(o)) == (LONG64)(o))
+#define gwcOutboundRing_barrier() MemoryBarrier ()
+#define gwcOutboundRing_yield() SwitchToThread ()
+#else
+#include <sched.h>
+#define gwcOutboundRing_fetchAdd(p, v) __sync_fetch_and_add ((p), (v))
+#define gwcOutboundRing_cas(p, o, n) __sync_bool_compare_and_swap ((p), (o), (n))
+#define gwcOutboundRing_cas64(p, o, n) __sync_bool_compare_and_swap ((p), (o), (n))
+#define gwcOutboundRing_barrier() __sync_synchronize ()
+#define gwcOutboundRing_yield() sched_yield ()
+#endif
+
+/* Slot state of a producer copying its message in */
+#define GWC_OUTBOUND_SLOT_BUSY 0x8000000000000000ULL
+
+/* Reset count bits of a ticket, below the busy bit */
+#define GWC_OUTBOUND_EPOCH_MASK 0x7fffULL
+
+/* Entry for a message type without a fixed width sequence number */
+#define GWC_SEQNUM_OFFSET_NONE 0xffff
+
+
+namespace neueda
+{
+
+gwcOutboundRing::gwcOutboundRing (size_t slots, gwcOutboundRingDelegate* delegate) :
+    mDelegate (delegate),
+    mSlots (NULL),
+    mMask (0),
+    mHead (0),
+    mTail (0),
+    mSending (0),
+    mDrain (NULL)
+{
+    /* round up to a power of two, each slot is then owned by every
+       size'th sequence number */
+    size_t size = 2;
+    while (size < slots)
+        size <<= 1;
+
+    mMask = size - 1;
+    mSlots = new gwcOutboundSlot[size];
+    mDrain = new char[GWC_OUTBOUND_DRAIN_MAX * GWC_OUTBOUND_SLOT_SIZE];
+
+    for (size_t i = 0; i < size; i++)
+    {
+        mSlots[i].mState = 0;
+        mSlots[i].mSize = 0;
+    }
+    reset (0);
+}
+
+gwcOutboundRing::~gwcOutboundRing ()
+{
+    delete[] mSlots;
+    delete[] mDrain;
+}
+
+void
+gwcOutboundRing::reset (uint64_t next)
+{
+    /* no one drains while slots are rewritten */
+    while (!tryAcquire ())
+        gwcOutboundRing_yield ();
+
+    /* claims from here on carry the new epoch, earlier ones no longer
+       match any slot and fail in publish */
+    uint64_t head;
+    uint64_t ticket;
+    do
+    {
+        head = mHead;
+        uint64_t epoch = ((head >> GWC_OUTBOUND_SEQ_BITS) + 1) & GWC_OUTBOUND_EPOCH_MASK;
+        ticket = (epoch << GWC_OUTBOUND_SEQ_BITS) | (next & GWC_OUTBOUND_SEQ_MASK);
+    }
+    while (!gwcOutboundRing_cas64 (&mHead, head, ticket));
+    mTail = ticket;
+
+    /* a slot is free for ticket when its state is ticket, published when
+       its state is ticket + 1 and free again for ticket + size once sent.
+       A producer still copying into a slot is let finish first */
+    for (uint64_t i = 0; i <= mMask; i++)
+    {
+        gwcOutboundSlot& slot = mSlots[(ticket + i) & mMask];
+        for (;;)
+        {
+            uint64_t state = slot.mState;
+            if ((state & GWC_OUTBOUND_SLOT_BUSY) == 0 &&
+                gwcOutboundRing_cas64 (&slot.mState, state, ticket + i))
+                break;
+            gwcOutboundRing_yield ();
+        }
+    }
+
+    release ();
+}
+
+uint64_t
+gwcOutboundRing::claim (size_t n)
+{
+    return gwcOutboundRing_fetchAdd (&mHead, (uint64_t)n);
+}
+
+bool
+gwcOutboundRing::publish (uint64_t ticket, const void* data, size_t size)
+{
+    gwcOutboundSlot& slot = mSlots[ticket & mMask];
+    bool             ok = fits (size);
+
+    /* ring is full, help the sender until our slot is free */
+    for (;;)
+    {
+        if (slot.mState == ticket &&
+            gwcOutboundRing_cas64 (&slot.mState, ticket, ticket | GWC_OUTBOUND_SLOT_BUSY))
+            break;
+        if (!current (ticket))
+            return false;
+
+        drain ();
+        gwcOutboundRing_yield ();
+    }
+
+    /* a message that doesn't fit still publishes its ticket empty so
+       those after it aren't held up */
+    if (!ok)
+        size = 0;
+    if (size > 0)
+        memcpy (slot.mData, data, size);
+    slot.mSize = size;
+
+    gwcOutboundRing_barrier ();
+    slot.mState = ticket + 1;
+
+    drain ();
+    return ok;
+}
+
+void
+gwcOutboundRing::sendDirect (const void* data, size_t size)
+{
+    while (!tryAcquire ())
+        gwcOutboundRing_yield ();
+
+    mDelegate->onSend (data, size);
+    drainLocked ();
+    release ();
+
+    drain ();
+}
+
+void
+gwcOutboundRing::drain ()
+{
+    /* a publish racing with release is picked up by the re-check, either
+       the publisher or we will see the other */
+    while (pending () && tryAcquire ())
+    {
+        drainLocked ();
+        release ();
+    }
+}
+
+bool
+gwcOutboundRing::tryAcquire ()
+{
+    return gwcOutboundRing_cas (&mSending, 0, 1);
+}
+
+void
+gwcOutboundRing::release ()
+{
+    gwcOutboundRing_barrier ();
+    mSending = 0;
+    gwcOutboundRing_barrier ();
+}
+
+bool
+gwcOutboundRing::pending ()
+{
+    uint64_t tail = mTail;
+    return mSlots[tail & mMask].mState == tail + 1;
+}
+
+void
+gwcOutboundRing::drainLocked ()
+{
+    uint64_t start = mTail;
+
+    for (;;)
+    {
+        uint64_t tail = mTail;
+        size_t   total = 0;
+        size_t   n = 0;
+
+        /* copy out contiguous published slots, freeing each so producers
+           waiting on a full ring can carry on while we write */
+        while (n < GWC_OUTBOUND_DRAIN_MAX)
+        {
+            gwcOutboundSlot& slot = mSlots[tail & mMask];
+            if (slot.mState != tail + 1)
+                break;
+
+            gwcOutboundRing_barrier ();
+            memcpy (mDrain + total, slot.mData, slot.mSize);
+            mDrainSizes[n++] = slot.mSize;
+            total += slot.mSize;
+
+            gwcOutboundRing_barrier ();
+            slot.mState = tail + mMask + 1;
+            tail++;
+        }
+
+        if (n == 0)
+            break;
+
+        if (total > 0)
+            mDelegate->onSend (mDrain, total);
+
+        size_t offset = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            if (mDrainSizes[i] > 0)
+                mDelegate->onSent (seqnum (mTail + i), mDrain + offset, mDrainSizes[i]);
+            offset += mDrainSizes[i];
+        }
+
+        mTail = tail;
+    }
+
+    if (mTail != start)
+        mDelegate->onDrained (seqnum (mTail));
+}
+
+gwcSeqnumOffsets::gwcSeqnumOffsets ()
+{
+    memset ((void*)mEntries, 0, sizeof mEntries);
+}
+
+bool
+gwcSeqnumOffsets::find (codec& c,
+                        const cdr& msg,
+                        uint16_t type,
+                        int key,
+                        size_t width,
+                        size_t& offset)
+{
+    volatile uint32_t& entry = mEntries[type % GWC_SEQNUM_OFFSETS];
+    uint32_t           value = entry;
+
+    if (value != 0 && (value >> 16) == type)
+    {
+        if ((value & 0xffff) == GWC_SEQNUM_OFFSET_NONE)
+            return false;
+
+        offset = (value & 0xffff) - 1;
+        return true;
+    }
+
+    /* first message of this type, racing threads find the same offset */
+    gwcOrderTemplate probe;
+    cdr              copy (msg);
+
+    probe.reset (this, GWC_TEMPLATE_ORDER);
+    if (!probe.encode (c, copy) ||
+        !probe.locate (c, copy, GWC_TEMPLATE_FIELD_SEQNUM, key,
+                       GWC_TEMPLATE_ENCODING_LE, width, 0, 1) ||
+        !probe.hasField (GWC_TEMPLATE_FIELD_SEQNUM))
+    {
+        entry = ((uint32_t)type << 16) | GWC_SEQNUM_OFFSET_NONE;
+        return false;
+    }
+
+    offset = probe.getOffset (GWC_TEMPLATE_FIELD_SEQNUM);
+    entry = ((uint32_t)type << 16) | (uint32_t)(offset + 1);
+    return true;
+}
+
+void
+gwcSeqnumOffsets::patch (void* data, size_t offset, size_t width, uint64_t seq)
+{
+    char* p = (char*)data + offset;
+
+    for (size_t i = 0; i < width; i++)
+    {
+        p[i] = (char)(seq & 0xff);
+        seq >>= 8;
+    }
+}
+
+}
@@ -0,0 +1,163 @@
+#pragma once
+/*
+ * Multi-producer outbound ring, producers encode outside any lock, claim a
+ * sequence number with an atomic and publish into the slot owned by that
+ * sequence number. A single sender drains published slots in sequence order
+ * and coalesces them into one write.
+ */
+
+#include "gwcOrderTemplate.h"
+#include "codec.h"
+#include "cdr.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace neueda
+{
+
+/* Space per slot, one encoded message */
+#define GWC_OUTBOUND_SLOT_SIZE 1024
+
+/* Default number of slots, must be a power of two */
+#define GWC_OUTBOUND_RING_SIZE 1024
+
+/* Most slots coalesced into one write by the sender */
+#define GWC_OUTBOUND_DRAIN_MAX 64
+
+/* Sequence numbers are the low bits of a ticket from claim, the bits above
+   count resets so a claim made before a reset can't be published after it */
+#define GWC_OUTBOUND_SEQ_BITS 48
+#define GWC_OUTBOUND_SEQ_MASK ((1ULL << GWC_OUTBOUND_SEQ_BITS) - 1)
+
+/* Sequence number offset cache size */
+#define GWC_SEQNUM_OFFSETS 256
+
+/* Called by whichever thread currently holds the sender role, never by two
+   threads at once */
+class gwcOutboundRingDelegate
+{
+public:
+    /* dtor */
+    virtual ~gwcOutboundRingDelegate () {};
+
+    /* Write data to the wire */
+    virtual void onSend (const void* data, size_t size) = 0;
+
+    /* Message with seq has been written, after onSend */
+    virtual void onSent (uint64_t seq, const void* data, size_t size) {};
+
+    /* All messages up to next have been written */
+    virtual void onDrained (uint64_t next) {};
+};
+
+struct gwcOutboundSlot
+{
+    volatile uint64_t mState;
+    size_t            mSize;
+    char              mData[GWC_OUTBOUND_SLOT_SIZE];
+};
+
+class gwcOutboundRing
+{
+public:
+    gwcOutboundRing (size_t slots, gwcOutboundRingDelegate* delegate);
+    ~gwcOutboundRing ();
+
+    /* Set next sequence number to claim. Claims made before the reset fail
+       to publish and anything not yet sent is dropped. Takes the sender
+       role so must not be called holding a lock the delegate takes */
+    void reset (uint64_t next);
+
+    /* Claim the next n contiguous sequence numbers, returns a ticket for
+       the first, the ticket for the i'th is the first plus i. Every ticket
+       claimed must be published */
+    uint64_t claim (size_t n = 1);
+
+    /* Sequence number of a ticket */
+    static uint64_t seqnum (uint64_t ticket)
+    {
+        return ticket & GWC_OUTBOUND_SEQ_MASK;
+    }
+
+    /* Next sequence number to be claimed */
+    uint64_t next () const
+    {
+        return seqnum (mHead);
+    }
+
+    /* Whether a message of size bytes fits a slot, check before claiming */
+    static bool fits (size_t size)
+    {
+        return size <= GWC_OUTBOUND_SLOT_SIZE;
+    }
+
+    /* Copy message for ticket into its slot and try to send, waits for the
+       slot if the ring is full. Size of 0 publishes nothing for the ticket.
+       False if the ring was reset since the claim or the message doesn't
+       fit, nothing is sent for the ticket */
+    bool publish (uint64_t ticket, const void* data, size_t size);
+
+    /* Send a message that carries no sequence number, such as a heartbeat,
+       waits for the sender role */
+    void sendDirect (const void* data, size_t size);
+
+    /* Send all published messages in order if no other thread is sending */
+    void drain ();
+
+    size_t getSize () const
+    {
+        return mMask + 1;
+    }
+
+private:
+    gwcOutboundRing (const gwcOutboundRing& obj);
+    gwcOutboundRing& operator= (const gwcOutboundRing& obj);
+
+    bool tryAcquire ();
+    void release ();
+    bool pending ();
+    void drainLocked ();
+
+    /* Whether ticket was claimed since the last reset */
+    bool current (uint64_t ticket) const
+    {
+        return ((ticket ^ mHead) >> GWC_OUTBOUND_SEQ_BITS) == 0;
+    }
+
+    gwcOutboundRingDelegate* mDelegate;
+    gwcOutboundSlot*         mSlots;
+    uint64_t                 mMask;
+    char                     mPad0[64];
+    volatile uint64_t        mHead;
+    char                     mPad1[64];
+    volatile uint64_t        mTail;
+    volatile uint32_t        mSending;
+    char                     mPad2[64];
+    char*                    mDrain;
+    size_t                   mDrainSizes[GWC_OUTBOUND_DRAIN_MAX];
+};
+
+/* Offset of a fixed width little endian sequence number in encoded messages,
+   found on first use of each message type by probing the codec */
+class gwcSeqnumOffsets
+{
+public:
+    gwcSeqnumOffsets ();
+
+    /* False if msg has no fixed width sequence number field key */
+    bool find (codec& c,
+               const cdr& msg,
+               uint16_t type,
+               int key,
+               size_t width,
+               size_t& offset);
+
+    /* Patch seq into an encoded message */
+    static void patch (void* data, size_t offset, size_t width, uint64_t seq);
+
+private:
+    volatile uint32_t mEntries[GWC_SEQNUM_OFFSETS];
+};
+
+}
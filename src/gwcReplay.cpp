@@ -0,0 +1,106 @@
+#include "gwcReplay.h"
+
+namespace neueda
+{
+
+gwcReplay::gwcReplay (gwcConnector* gwc) :
+    mGwc (gwc)
+{
+}
+
+bool
+gwcReplay::load (const std::vector<std::string>& paths,
+                 const std::string& session,
+                 std::string& err)
+{
+    std::string loaded;
+
+    mData.clear ();
+    mMessages.clear ();
+
+    for (size_t i = 0; i < paths.size (); i++)
+    {
+        gwcJournalReader reader;
+        if (!reader.open (paths[i], err))
+            return false;
+
+        gwcJournalRecord record;
+        const char*      data;
+        while (reader.next (record, data))
+        {
+            if (record.mType != GWC_JOURNAL_IN)
+                continue;
+
+            /* ids are per file, match on the name */
+            std::string name = reader.getSessionName (record.mSession);
+            if (!session.empty () && name != session)
+                continue;
+            if (session.empty () && !loaded.empty () && name != loaded)
+            {
+                err = "journal has sessions " + loaded + " and " + name +
+                      ", pick one";
+                return false;
+            }
+            loaded = name;
+
+            message m;
+            m.mOffset = mData.size ();
+            m.mSize = record.mLength;
+            m.mTimestamp = record.mTimestamp;
+            mMessages.push_back (m);
+            mData.insert (mData.end (), data, data + record.mLength);
+        }
+    }
+
+    if (mMessages.empty ())
+    {
+        err = "no inbound messages to replay";
+        return false;
+    }
+    return true;
+}
+
+void
+gwcReplay::run (double speed, gwcReplayStats& stats)
+{
+    gwcLatencyHistogram latency;
+
+    stats.mMessages = 0;
+    stats.mBytes = 0;
+    stats.mErrors = 0;
+
+    /* read paths may write to the data they are given, replay a copy */
+    std::vector<char> buffer (mData);
+
+    uint64_t first = mMessages.empty () ? 0 : mMessages[0].mTimestamp;
+    uint64_t start = gwcLatency_now ();
+    for (size_t i = 0; i < mMessages.size (); i++)
+    {
+        const message& m = mMessages[i];
+
+        if (speed > 0 && m.mTimestamp > first)
+        {
+            uint64_t due = start + (uint64_t)((m.mTimestamp - first) / speed);
+            while (gwcLatency_now () < due)
+                ;
+        }
+
+        uint64_t before = gwcLatency_now ();
+        size_t   used = mGwc->replay (&buffer[m.mOffset], m.mSize);
+        latency.record (gwcLatency_now () - before);
+
+        if (used != m.mSize)
+            stats.mErrors++;
+        stats.mMessages++;
+        stats.mBytes += m.mSize;
+    }
+
+    stats.mElapsedNs = gwcLatency_now () - start;
+    stats.mMsgsPerSec = stats.mElapsedNs ?
+        stats.mMessages * 1e9 / stats.mElapsedNs : 0.0;
+    stats.mBytesPerSec = stats.mElapsedNs ?
+        stats.mBytes * 1e9 / stats.mElapsedNs : 0.0;
+    latency.snapshot (stats.mLatency);
+}
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+/*
+ * Replays the inbound messages of a journal through a connector's read
+ * path, as fast as possible or at the recorded pacing, timing each message
+ * from read to the return of its callbacks.
+ */
+
+#include "gwcConnector.h"
+#include "gwcJournal.h"
+#include "gwcLatency.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace neueda
+{
+
+struct gwcReplayStats
+{
+    uint64_t       mMessages;
+    uint64_t       mBytes;
+    /* messages the connector didn't consume whole */
+    uint64_t       mErrors;
+    uint64_t       mElapsedNs;
+    double         mMsgsPerSec;
+    double         mBytesPerSec;
+    /* read path time per message, decode plus callbacks */
+    gwcLatencyStat mLatency;
+};
+
+class gwcReplay
+{
+public:
+    /* gwc must be initialised and not started, see gwcConnector::replay */
+    gwcReplay (gwcConnector* gwc);
+
+    /* Load the inbound messages of session, or of the only session when
+       empty, from journal files given oldest first */
+    bool load (const std::vector<std::string>& paths,
+               const std::string& session,
+               std::string& err);
+
+    /* Replay what was loaded. speed of 0 replays as fast as possible,
+       otherwise at the recorded pacing sped up by speed */
+    void run (double speed, gwcReplayStats& stats);
+
+    size_t getMessages () const
+    {
+        return mMessages.size ();
+    }
+
+private:
+    struct message
+    {
+        size_t   mOffset;
+        size_t   mSize;
+        uint64_t mTimestamp;
+    };
+
+    gwcConnector*        mGwc;
+    std::vector<char>    mData;
+    std::vector<message> mMessages;
+};
+
+}
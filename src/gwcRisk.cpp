@@ -0,0 +1,463 @@
+#include "gwcRisk.h"
+#include "gwcLatency.h"
+
+#include <float.h>
+
+#define GWC_RISK_RATE_WINDOW 1000000000ULL
+
+
+namespace neueda
+{
+
+static double
+gwcRisk_abs (double v)
+{
+    return v < 0 ? -v : v;
+}
+
+static double
+gwcRisk_limit (double limit)
+{
+    return limit > 0 ? limit : DBL_MAX;
+}
+
+gwcRisk::gwcRisk (const gwcRiskLimits& limits,
+                  size_t orders,
+                  size_t instruments,
+                  size_t accounts) :
+    mMaxOrderQty (gwcRisk_limit (limits.mMaxOrderQty)),
+    mMaxOrderNotional (gwcRisk_limit (limits.mMaxOrderNotional)),
+    mPriceCollar (gwcRisk_limit (limits.mPriceCollar)),
+    mMaxInstrumentExposure (gwcRisk_limit (limits.mMaxInstrumentExposure)),
+    mMaxAccountExposure (gwcRisk_limit (limits.mMaxAccountExposure)),
+    mMaxOrderRate (limits.mMaxOrderRate > 0 ? limits.mMaxOrderRate : (uint64_t)-1),
+    mOrders (orders),
+    mInstruments (instruments),
+    mAccounts (accounts),
+    mRateStart (0),
+    mRateCount (0)
+{
+    /* orders without a price are valued at the reference price when
+       there is a limit on notional */
+    mNeedsPrice = limits.mMaxOrderNotional > 0 ||
+                  limits.mMaxInstrumentExposure > 0 ||
+                  limits.mMaxAccountExposure > 0;
+
+    sbfMutex_init (&mLock, 0);
+}
+
+gwcRisk::~gwcRisk ()
+{
+    sbfMutex_destroy (&mLock);
+}
+
+double
+gwcRisk::held (const gwcRiskOrder* order)
+{
+    double leaves = order->mQty > order->mCum ? order->mQty - order->mCum : 0;
+    double notional = leaves * gwcRisk_abs (order->mPrice);
+
+    /* the order and a modify keeping its id are never both live at the
+       venue, the larger is held */
+    if (order->mPending)
+    {
+        double pending = order->mPendingQty > order->mCum ?
+            order->mPendingQty - order->mCum : 0;
+        pending *= gwcRisk_abs (order->mPendingPrice);
+        if (pending > notional)
+            notional = pending;
+    }
+    return notional;
+}
+
+bool
+gwcRisk::isOpen (const gwcRiskOrder* order)
+{
+    return order->mCum < order->mQty ||
+        (order->mPending && order->mCum < order->mPendingQty);
+}
+
+void
+gwcRisk::hold (gwcRiskOrder* order, double sign)
+{
+    double notional = sign * held (order);
+
+    order->mInstrument->mOpen += notional;
+    order->mAccount->mOpen += notional;
+}
+
+gwcRiskResult
+gwcRisk::check (gwcRiskBucket* instrument,
+                gwcRiskBucket* account,
+                double qty,
+                bool hasPrice,
+                double price,
+                double open)
+{
+    uint64_t now = gwcLatency_now ();
+    if (now - mRateStart >= GWC_RISK_RATE_WINDOW)
+    {
+        mRateStart = now;
+        mRateCount = 0;
+    }
+
+    double ref = instrument->mReference;
+    double notional = qty * gwcRisk_abs (price);
+    double away = gwcRisk_abs (price - ref);
+
+    /* every limit is tested and sets a bit, the first set is reported */
+    uint32_t failed =
+        (uint32_t)(qty > mMaxOrderQty) |
+        (uint32_t)(notional > mMaxOrderNotional) << 1 |
+        (uint32_t)((ref > 0) & hasPrice & (away > ref * mPriceCollar)) << 2 |
+        (uint32_t)(exposure (instrument) + open > mMaxInstrumentExposure) << 3 |
+        (uint32_t)(exposure (account) + open > mMaxAccountExposure) << 4 |
+        (uint32_t)(mRateCount >= mMaxOrderRate) << 5;
+
+    if (failed == 0)
+    {
+        mRateCount++;
+        return GWC_RISK_PASSED;
+    }
+
+    int r = GWC_RISK_MAX_ORDER_QTY;
+    while ((failed & 1) == 0)
+    {
+        failed >>= 1;
+        r++;
+    }
+    return (gwcRiskResult)r;
+}
+
+gwcRiskResult
+gwcRisk::result (gwcRiskResult r)
+{
+    if (r == GWC_RISK_PASSED)
+        mStats.mPassed++;
+    else
+        mStats.mRejected++;
+
+    sbfMutex_unlock (&mLock);
+    return r;
+}
+
+bool
+gwcRisk::setReferencePrice (const std::string& instrument, double price)
+{
+    sbfMutex_lock (&mLock);
+    gwcRiskBucket* bucket = mInstruments.find (instrument, true);
+    if (bucket != NULL)
+        bucket->mReference = price;
+    sbfMutex_unlock (&mLock);
+
+    return bucket != NULL;
+}
+
+gwcRiskResult
+gwcRisk::checkOrder (const gwcRiskFields& order)
+{
+    sbfMutex_lock (&mLock);
+
+    gwcRiskBucket* instrument = mInstruments.find (order.mInstrument, true);
+    gwcRiskBucket* account = mAccounts.find (order.mAccount, true);
+    if (instrument == NULL || account == NULL)
+        return result (GWC_RISK_FULL);
+
+    double price = order.mHasPrice ? order.mPrice : instrument->mReference;
+    if (!order.mHasPrice && instrument->mReference == 0 && mNeedsPrice)
+        return result (GWC_RISK_NO_PRICE);
+
+    double        notional = order.mQty * gwcRisk_abs (price);
+    gwcRiskResult r = check (instrument,
+                             account,
+                             order.mQty,
+                             order.mHasPrice,
+                             price,
+                             notional);
+    if (r != GWC_RISK_PASSED)
+        return result (r);
+
+    gwcRiskOrder* o = mOrders.find (order.mClOrdId, true);
+    if (o == NULL)
+        return result (GWC_RISK_FULL);
+
+    /* an id sent again replaces what the earlier order held */
+    if (o->mInstrument != NULL)
+        hold (o, -1);
+
+    o->mInstrument = instrument;
+    o->mAccount = account;
+    o->mSign = order.mHasSide && !order.mBuy ? -1 : 1;
+    o->mQty = order.mQty;
+    o->mCum = 0;
+    o->mPrice = price;
+    o->mPending = 0;
+    hold (o, 1);
+
+    return result (GWC_RISK_PASSED);
+}
+
+gwcRiskResult
+gwcRisk::checkModify (const gwcRiskFields& modify)
+{
+    const std::string& origId = modify.mOrigClOrdId.empty () ?
+        modify.mClOrdId : modify.mOrigClOrdId;
+
+    sbfMutex_lock (&mLock);
+
+    gwcRiskOrder* orig = mOrders.find (origId, false);
+    if (orig == NULL)
+        return result (GWC_RISK_UNKNOWN_ORDER);
+
+    bool   same = modify.mClOrdId.empty () || modify.mClOrdId == origId;
+    double qty = modify.mHasQty ? modify.mQty : orig->mQty;
+    double price = modify.mHasPrice ? modify.mPrice : orig->mPrice;
+    double sign = modify.mHasSide ? (modify.mBuy ? 1 : -1) : orig->mSign;
+    double leaves = qty > orig->mCum ? qty - orig->mCum : 0;
+    double open = leaves * gwcRisk_abs (price);
+
+    /* until the venue acks a modify with a new id both the order and the
+       modify are held, one keeping its id only adds what it holds over
+       the order */
+    if (same)
+    {
+        double current = orig->mQty > orig->mCum ? orig->mQty - orig->mCum : 0;
+        current *= gwcRisk_abs (orig->mPrice);
+        open = (open > current ? open : current) - held (orig);
+    }
+
+    gwcRiskResult r = check (orig->mInstrument,
+                             orig->mAccount,
+                             qty,
+                             modify.mHasPrice,
+                             price,
+                             open);
+    if (r != GWC_RISK_PASSED)
+        return result (r);
+
+    /* the order keeps its size until the modify is acked */
+    if (same)
+    {
+        hold (orig, -1);
+        orig->mPending = 1;
+        orig->mPendingSign = sign;
+        orig->mPendingQty = qty;
+        orig->mPendingPrice = price;
+        hold (orig, 1);
+        return result (GWC_RISK_PASSED);
+    }
+
+    gwcRiskOrder* o = mOrders.find (modify.mClOrdId, true);
+    if (o == NULL)
+        return result (GWC_RISK_FULL);
+    if (o->mInstrument != NULL)
+        hold (o, -1);
+
+    *o = *orig;
+    o->mSign = sign;
+    o->mQty = qty;
+    o->mPrice = price;
+    o->mReplacing = 1;
+    o->mPending = 0;
+    hold (o, 1);
+
+    return result (GWC_RISK_PASSED);
+}
+
+void
+gwcRisk::release (const std::string& clOrdId, const std::string& origClOrdId)
+{
+    /* a modify that keeps the order's id leaves it at its old size */
+    if (!origClOrdId.empty () &&
+        (clOrdId.empty () || clOrdId == origClOrdId))
+    {
+        settle (origClOrdId, false);
+        return;
+    }
+
+    done (clOrdId);
+}
+
+void
+gwcRisk::settle (const std::string& clOrdId, bool acked)
+{
+    sbfMutex_lock (&mLock);
+
+    gwcRiskOrder* o = mOrders.find (clOrdId, false);
+
+    /* a modify with a new id that is rejected never becomes the order */
+    if (o != NULL && o->mReplacing)
+    {
+        if (acked)
+            o->mReplacing = 0;
+        else
+        {
+            hold (o, -1);
+            mOrders.erase (clOrdId);
+        }
+    }
+    else if (o != NULL && o->mPending)
+    {
+        hold (o, -1);
+        if (acked)
+        {
+            o->mSign = o->mPendingSign;
+            o->mQty = o->mPendingQty;
+            o->mPrice = o->mPendingPrice;
+        }
+        o->mPending = 0;
+
+        if (isOpen (o))
+            hold (o, 1);
+        else
+            mOrders.erase (clOrdId);
+    }
+
+    sbfMutex_unlock (&mLock);
+}
+
+void
+gwcRisk::filled (const std::string& clOrdId, double qty, bool hasPx, double px)
+{
+    sbfMutex_lock (&mLock);
+
+    gwcRiskOrder* o = mOrders.find (clOrdId, false);
+    if (o != NULL)
+    {
+        double filled = o->mSign * qty * (hasPx ? px : o->mPrice);
+
+        hold (o, -1);
+        o->mCum += qty;
+        o->mInstrument->mPosition += filled;
+        o->mAccount->mPosition += filled;
+
+        if (isOpen (o))
+            hold (o, 1);
+        else
+            mOrders.erase (clOrdId);
+    }
+
+    sbfMutex_unlock (&mLock);
+}
+
+void
+gwcRisk::modified (const std::string& clOrdId, const std::string& origClOrdId)
+{
+    if (origClOrdId.empty () || origClOrdId == clOrdId)
+    {
+        settle (clOrdId, true);
+        return;
+    }
+
+    sbfMutex_lock (&mLock);
+
+    /* the modify is the order now */
+    gwcRiskOrder* o = mOrders.find (clOrdId, false);
+    if (o != NULL)
+        o->mReplacing = 0;
+
+    gwcRiskOrder* orig = mOrders.find (origClOrdId, false);
+    if (orig != NULL)
+    {
+        /* fills while the modify was in flight were booked to the order */
+        bool filled = false;
+        if (o != NULL && orig->mCum > o->mCum)
+        {
+            hold (o, -1);
+            o->mCum = orig->mCum;
+            filled = !isOpen (o);
+            if (!filled)
+                hold (o, 1);
+        }
+
+        /* an erase moves entries, neither pointer is used after */
+        hold (orig, -1);
+        mOrders.erase (origClOrdId);
+        if (filled)
+            mOrders.erase (clOrdId);
+    }
+
+    sbfMutex_unlock (&mLock);
+}
+
+void
+gwcRisk::done (const std::string& clOrdId)
+{
+    if (clOrdId.empty ())
+        return;
+
+    sbfMutex_lock (&mLock);
+
+    gwcRiskOrder* o = mOrders.find (clOrdId, false);
+    if (o != NULL)
+    {
+        hold (o, -1);
+        mOrders.erase (clOrdId);
+    }
+
+    sbfMutex_unlock (&mLock);
+}
+
+double
+gwcRisk::getInstrumentExposure (const std::string& instrument)
+{
+    sbfMutex_lock (&mLock);
+    gwcRiskBucket* bucket = mInstruments.find (instrument, false);
+    double         value = bucket != NULL ? exposure (bucket) : 0;
+    sbfMutex_unlock (&mLock);
+
+    return value;
+}
+
+double
+gwcRisk::getAccountExposure (const std::string& account)
+{
+    sbfMutex_lock (&mLock);
+    gwcRiskBucket* bucket = mAccounts.find (account, false);
+    double         value = bucket != NULL ? exposure (bucket) : 0;
+    sbfMutex_unlock (&mLock);
+
+    return value;
+}
+
+gwcRiskStats
+gwcRisk::snapshot ()
+{
+    sbfMutex_lock (&mLock);
+    gwcRiskStats stats = mStats;
+    stats.mOpenOrders = mOrders.getCount ();
+    sbfMutex_unlock (&mLock);
+
+    return stats;
+}
+
+const char*
+gwcRisk::resultToString (gwcRiskResult result)
+{
+    switch (result)
+    {
+    case GWC_RISK_PASSED:
+        return "passed";
+    case GWC_RISK_MAX_ORDER_QTY:
+        return "order quantity over limit";
+    case GWC_RISK_MAX_ORDER_NOTIONAL:
+        return "order notional over limit";
+    case GWC_RISK_PRICE_COLLAR:
+        return "price outside collar";
+    case GWC_RISK_INSTRUMENT_EXPOSURE:
+        return "instrument exposure over limit";
+    case GWC_RISK_ACCOUNT_EXPOSURE:
+        return "account exposure over limit";
+    case GWC_RISK_ORDER_RATE:
+        return "order rate over limit";
+    case GWC_RISK_NO_PRICE:
+        return "no price or reference price";
+    case GWC_RISK_UNKNOWN_ORDER:
+        return "unknown order";
+    case GWC_RISK_FULL:
+        return "no room for order";
+    }
+    return "unknown";
+}
+
+}
@@ -0,0 +1,215 @@
+#pragma once
+/*
+ * Pre-trade risk checks run by the connector before an order or modify is
+ * encoded. Limits are on an order's quantity and notional, its price
+ * against a reference price for the instrument, the exposure of the
+ * instrument and of the account and the rate orders are sent. An order that
+ * passes holds its notional against its instrument and account until it is
+ * filled, done or rejected. A modify keeping the order's id is held as
+ * pending until the venue acks it. Instruments, accounts and orders are
+ * kept in tables sized up front so a check doesn't allocate.
+ */
+
+#include "sbfCommon.h"
+#include "gwcKeyTable.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+namespace neueda
+{
+
+/* Default table sizes, rounded up to a power of two */
+#define GWC_RISK_ORDERS      65536
+#define GWC_RISK_INSTRUMENTS 4096
+#define GWC_RISK_ACCOUNTS    1024
+
+/* Longest client order id, instrument or account kept, including the
+   terminator */
+#define GWC_RISK_KEY_SIZE 40
+
+typedef enum
+{
+    GWC_RISK_PASSED,
+    GWC_RISK_MAX_ORDER_QTY,
+    GWC_RISK_MAX_ORDER_NOTIONAL,
+    GWC_RISK_PRICE_COLLAR,
+    GWC_RISK_INSTRUMENT_EXPOSURE,
+    GWC_RISK_ACCOUNT_EXPOSURE,
+    GWC_RISK_ORDER_RATE,
+    GWC_RISK_NO_PRICE,      /* no price and no reference price to value it */
+    GWC_RISK_UNKNOWN_ORDER, /* modify of an order the checks haven't seen */
+    GWC_RISK_FULL           /* no room to keep the order */
+} gwcRiskResult;
+
+/* Limits in the venue's units, zero is no limit */
+struct gwcRiskLimits
+{
+    gwcRiskLimits () :
+        mMaxOrderQty (0),
+        mMaxOrderNotional (0),
+        mPriceCollar (0),
+        mMaxInstrumentExposure (0),
+        mMaxAccountExposure (0),
+        mMaxOrderRate (0)
+    {
+    }
+
+    double   mMaxOrderQty;
+    double   mMaxOrderNotional;
+    double   mPriceCollar;           /* fraction of the reference price */
+    double   mMaxInstrumentExposure; /* open notional and net position */
+    double   mMaxAccountExposure;
+    uint32_t mMaxOrderRate;          /* orders and modifies a second */
+};
+
+/* What the checks need from an order or modify. A modify without side,
+   quantity or price keeps the order's */
+struct gwcRiskFields
+{
+    gwcRiskFields () :
+        mHasSide (false),
+        mBuy (false),
+        mHasQty (false),
+        mHasPrice (false),
+        mQty (0),
+        mPrice (0)
+    {
+    }
+
+    std::string mClOrdId;
+    std::string mOrigClOrdId;
+    std::string mInstrument;
+    std::string mAccount;
+    bool        mHasSide;
+    bool        mBuy;
+    bool        mHasQty;
+    bool        mHasPrice;
+    double      mQty;
+    double      mPrice;
+};
+
+struct gwcRiskStats
+{
+    gwcRiskStats () :
+        mPassed (0),
+        mRejected (0),
+        mOpenOrders (0)
+    {
+    }
+
+    uint64_t mPassed;
+    uint64_t mRejected;
+    uint64_t mOpenOrders;
+};
+
+class gwcRisk
+{
+public:
+    gwcRisk (const gwcRiskLimits& limits,
+             size_t orders,
+             size_t instruments,
+             size_t accounts);
+    ~gwcRisk ();
+
+    /* Price collars are checked against, false if there's no room for
+       the instrument */
+    bool setReferencePrice (const std::string& instrument, double price);
+
+    /* Check an order or modify, one that passes holds its notional until
+       release, done or it is filled */
+    gwcRiskResult checkOrder (const gwcRiskFields& order);
+    gwcRiskResult checkModify (const gwcRiskFields& modify);
+
+    /* An order or modify that passed but failed to send or was rejected,
+       a modify keeping the order's id leaves the order as it was. A reject
+       with only the modify's id is passed as both ids */
+    void release (const std::string& clOrdId, const std::string& origClOrdId);
+
+    /* Updates from executions, on the dispatch thread */
+    void filled (const std::string& clOrdId,
+                 double qty,
+                 bool hasPx,
+                 double px);
+    void modified (const std::string& clOrdId, const std::string& origClOrdId);
+    void done (const std::string& clOrdId);
+
+    /* Open notional plus absolute net position, zero if unknown */
+    double getInstrumentExposure (const std::string& instrument);
+    double getAccountExposure (const std::string& account);
+
+    gwcRiskStats snapshot ();
+
+    static const char* resultToString (gwcRiskResult result);
+
+private:
+    gwcRisk (const gwcRisk& obj);
+    gwcRisk& operator= (const gwcRisk& obj);
+
+    /* an instrument or account */
+    struct gwcRiskBucket
+    {
+        double mOpen;      /* notional of open orders */
+        double mPosition;  /* net notional filled, bought less sold */
+        double mReference; /* instruments only, zero if not set */
+    };
+
+    /* buckets are never erased so orders can point at them */
+    struct gwcRiskOrder
+    {
+        gwcRiskBucket* mInstrument;
+        gwcRiskBucket* mAccount;
+        double         mSign; /* 1 buy, -1 sell */
+        double         mQty;
+        double         mCum;
+        double         mPrice;
+        uint32_t       mReplacing; /* a modify with a new id not yet acked */
+        uint32_t       mPending;   /* a modify keeping the id is in flight */
+        double         mPendingSign;
+        double         mPendingQty;
+        double         mPendingPrice;
+    };
+
+    typedef gwcKeyTable<gwcRiskOrder, GWC_RISK_KEY_SIZE>  gwcRiskOrders;
+    typedef gwcKeyTable<gwcRiskBucket, GWC_RISK_KEY_SIZE> gwcRiskBuckets;
+
+    static double held (const gwcRiskOrder* order);
+    static bool isOpen (const gwcRiskOrder* order);
+
+    static double exposure (const gwcRiskBucket* bucket)
+    {
+        return bucket->mOpen +
+            (bucket->mPosition < 0 ? -bucket->mPosition : bucket->mPosition);
+    }
+
+    void hold (gwcRiskOrder* order, double sign);
+    gwcRiskResult check (gwcRiskBucket* instrument,
+                         gwcRiskBucket* account,
+                         double qty,
+                         bool hasPrice,
+                         double price,
+                         double open);
+    gwcRiskResult result (gwcRiskResult r);
+    void settle (const std::string& clOrdId, bool acked);
+
+    /* limits, no limit is the largest value */
+    double                      mMaxOrderQty;
+    double                      mMaxOrderNotional;
+    double                      mPriceCollar;
+    double                      mMaxInstrumentExposure;
+    double                      mMaxAccountExposure;
+    uint64_t                    mMaxOrderRate;
+    bool                        mNeedsPrice;
+
+    gwcRiskOrders               mOrders;
+    gwcRiskBuckets              mInstruments;
+    gwcRiskBuckets              mAccounts;
+
+    uint64_t                    mRateStart;
+    uint64_t                    mRateCount;
+    gwcRiskStats                mStats;
+    sbfMutex                    mLock;
+};
+
+}
@@ -0,0 +1,380 @@
+#include "gwcSeqnumStore.h"
+
+#include <string.h>
+
+#ifdef WIN32
+#include <windows.h>
+#define gwcSeqnumStore_sleep(usecs) Sleep ((DWORD)(((usecs) + 999) / 1000))
+#else
+#include <unistd.h>
+#define gwcSeqnumStore_sleep(usecs) usleep (usecs)
+#endif
+
+/* Longest sleep while a group fills, a full group is noticed this soon */
+#define GWC_SEQNUM_STORE_SLICE_USECS 100
+
+
+namespace neueda
+{
+
+gwcSeqnumStore::gwcSeqnumStore () :
+    mFile (NULL),
+    mSegment (NULL),
+    mSegmentSlots (GWC_STATE_SEGMENT_SLOTS),
+    mItemSize (0),
+    mDurability (GWC_DURABILITY_SYNC),
+    mIntervalUsecs (1000),
+    mCount (64),
+    mPending (0),
+    mRunning (false),
+    mWaiting (false),
+    mCommits (0)
+{
+    sbfMutex_init (&mEntriesLock, 0);
+    sbfMutex_init (&mFileLock, 0);
+    sbfCondVar_init (&mCond);
+}
+
+gwcSeqnumStore::~gwcSeqnumStore ()
+{
+    close ();
+
+    sbfCondVar_destroy (&mCond);
+    sbfMutex_destroy (&mFileLock);
+    sbfMutex_destroy (&mEntriesLock);
+}
+
+void
+gwcSeqnumStore::setDurability (gwcDurability durability,
+                               int intervalUsecs,
+                               int count)
+{
+    mDurability = durability;
+    mIntervalUsecs = intervalUsecs;
+    mCount = count;
+}
+
+void
+gwcSeqnumStore::setSegment (const std::string& path, size_t slots)
+{
+    mSegmentPath = path;
+    mSegmentSlots = slots;
+}
+
+bool
+gwcSeqnumStore::open (const std::string& name,
+                      size_t itemSize,
+                      int* created,
+                      sbfCacheFileItemCb cb,
+                      void* closure,
+                      std::string& err)
+{
+    mName = name;
+    mItemSize = itemSize;
+
+    if (mSegmentPath.empty ())
+    {
+        mFile = sbfCacheFile_open (name.c_str (),
+                                   itemSize,
+                                   0,
+                                   created,
+                                   cb,
+                                   closure);
+        if (mFile == NULL)
+        {
+            err = "failed to open cache file " + name;
+            return false;
+        }
+    }
+    else
+    {
+        if (itemSize > GWC_STATE_SLOT_DATA || name.size () >= GWC_STATE_OWNER_SIZE)
+        {
+            err = "cache " + name + " does not fit a state segment slot";
+            return false;
+        }
+
+        mSegment = gwcStateSegment::attach (mSegmentPath, mSegmentSlots, err);
+        if (mSegment == NULL)
+            return false;
+
+        /* hand back existing slots the way the cache file does */
+        uint32_t      index = 0;
+        gwcStateSlot* slot;
+        while ((slot = mSegment->find (name, index++)) != NULL)
+        {
+            uint64_t data[GWC_STATE_SLOT_DATA / sizeof (uint64_t)];
+            for (size_t i = 0; i < GWC_STATE_SLOT_DATA / sizeof (uint64_t); i++)
+                data[i] = slot->mData[i];
+
+            if (cb (NULL, (sbfCacheFileItem)slot, data, slot->mSize, closure) != 0)
+            {
+                err = "failed to load " + name + " from state segment";
+                close ();
+                return false;
+            }
+        }
+        *created = index == 1;
+    }
+
+    /* nothing for the writer to do for an async segment */
+    if (mDurability == GWC_DURABILITY_SYNC ||
+        (mSegment != NULL && mDurability == GWC_DURABILITY_ASYNC) ||
+        mRunning)
+        return true;
+
+    mRunning = true;
+    if (sbfThread_create (&mThread, gwcSeqnumStore::writerCb, this) != 0)
+    {
+        mRunning = false;
+        err = "failed to start seqno cache writer";
+        close ();
+        return false;
+    }
+    return true;
+}
+
+void
+gwcSeqnumStore::close ()
+{
+    stop ();
+
+    if (mFile != NULL)
+    {
+        sbfCacheFile_close (mFile);
+        mFile = NULL;
+    }
+    if (mSegment != NULL)
+    {
+        mSegment->sync ();
+        gwcStateSegment::detach (mSegment);
+        mSegment = NULL;
+    }
+}
+
+void
+gwcSeqnumStore::stop ()
+{
+    if (mRunning)
+    {
+        lockEntries ();
+        mRunning = false;
+        sbfCondVar_signal (&mCond);
+        unlockEntries ();
+
+        sbfThread_join (mThread);
+    }
+
+    if (mFile != NULL || mSegment != NULL)
+        commitEntries (true);
+}
+
+sbfCacheFileItem
+gwcSeqnumStore::add (void* data)
+{
+    if (mSegment != NULL)
+    {
+        gwcStateSlot* slot = mSegment->add (mName, data, mItemSize);
+        if (slot != NULL && mDurability == GWC_DURABILITY_SYNC)
+        {
+            mSegment->sync (slot);
+            mCommits++;
+        }
+        return (sbfCacheFileItem)slot;
+    }
+    if (mFile == NULL)
+        return NULL;
+
+    lockFile ();
+    sbfCacheFileItem item = sbfCacheFile_add (mFile, data);
+    sbfCacheFile_flush (mFile);
+    mCommits++;
+    unlockFile ();
+
+    return item;
+}
+
+void
+gwcSeqnumStore::write (sbfCacheFileItem item, const void* data, size_t size)
+{
+    if (item == NULL)
+        return;
+
+    if (mSegment != NULL)
+    {
+        /* in place, already safe from a process crash */
+        gwcStateSegment::store ((gwcStateSlot*)item, data, size);
+        if (mDurability == GWC_DURABILITY_SYNC)
+        {
+            mSegment->sync ((gwcStateSlot*)item);
+            mCommits++;
+            return;
+        }
+        if (mDurability == GWC_DURABILITY_ASYNC)
+            return;
+    }
+    else if (mFile == NULL)
+        return;
+    else if (mDurability == GWC_DURABILITY_SYNC ||
+             size > GWC_SEQNUM_STORE_ITEM_SIZE)
+    {
+        lockFile ();
+        sbfCacheFile_write (item, (void*)data);
+        sbfCacheFile_flush (mFile);
+        mCommits++;
+        unlockFile ();
+        return;
+    }
+
+    lockEntries ();
+
+    entry* e = NULL;
+    for (size_t i = 0; i < mEntries.size (); i++)
+    {
+        if (mEntries[i].mItem == item)
+        {
+            e = &mEntries[i];
+            break;
+        }
+    }
+    if (e == NULL)
+    {
+        mEntries.push_back (entry ());
+        e = &mEntries.back ();
+        e->mItem = item;
+    }
+
+    if (mSegment == NULL)
+        memcpy (e->mData, data, size);
+    e->mSize = size;
+    e->mDirty = true;
+    mPending++;
+
+    /* wake the writer for the first update of a group only, it notices a
+       full group itself */
+    if (mWaiting && mPending == 1)
+        sbfCondVar_signal (&mCond);
+
+    unlockEntries ();
+}
+
+void
+gwcSeqnumStore::commit ()
+{
+    if (mFile != NULL || mSegment != NULL)
+        commitEntries (true);
+}
+
+void
+gwcSeqnumStore::commitEntries (bool flush)
+{
+    /* file lock first, mCommitting belongs to whoever holds it */
+    lockFile ();
+
+    lockEntries ();
+    mCommitting.clear ();
+    for (size_t i = 0; i < mEntries.size (); i++)
+    {
+        if (mEntries[i].mDirty)
+        {
+            mCommitting.push_back (mEntries[i]);
+            mEntries[i].mDirty = false;
+        }
+    }
+    mPending = 0;
+    unlockEntries ();
+
+    if (mSegment != NULL)
+    {
+        /* stored in place already, only the sync is left */
+        for (size_t i = 0; i < mCommitting.size (); i++)
+            mSegment->sync ((gwcStateSlot*)mCommitting[i].mItem);
+    }
+    else
+    {
+        for (size_t i = 0; i < mCommitting.size (); i++)
+            sbfCacheFile_write (mCommitting[i].mItem, mCommitting[i].mData);
+        if (flush && !mCommitting.empty ())
+            sbfCacheFile_flush (mFile);
+    }
+    if (!mCommitting.empty ())
+        mCommits++;
+
+    unlockFile ();
+}
+
+void*
+gwcSeqnumStore::writerCb (void* closure)
+{
+    gwcSeqnumStore* store = reinterpret_cast<gwcSeqnumStore*>(closure);
+    store->run ();
+    return NULL;
+}
+
+void
+gwcSeqnumStore::run ()
+{
+    bool flush = mDurability == GWC_DURABILITY_GROUP;
+
+    lockEntries ();
+    while (mRunning)
+    {
+        if (mPending == 0)
+        {
+            mWaiting = true;
+            sbfCondVar_wait (&mCond, &mEntriesLock);
+            mWaiting = false;
+            continue;
+        }
+        unlockEntries ();
+
+        linger ();
+        commitEntries (flush);
+        lockEntries ();
+    }
+    unlockEntries ();
+}
+
+void
+gwcSeqnumStore::linger ()
+{
+    /* let the group fill up for at most one interval */
+    int waited = 0;
+    while (mRunning && waited < mIntervalUsecs)
+    {
+        if (mDurability == GWC_DURABILITY_GROUP && mPending >= mCount)
+            break;
+
+        int usecs = mIntervalUsecs - waited;
+        if (usecs > GWC_SEQNUM_STORE_SLICE_USECS)
+            usecs = GWC_SEQNUM_STORE_SLICE_USECS;
+        gwcSeqnumStore_sleep (usecs);
+        waited += usecs;
+    }
+}
+
+void
+gwcSeqnumStore::lockEntries ()
+{
+    sbfMutex_lock (&mEntriesLock);
+}
+
+void
+gwcSeqnumStore::unlockEntries ()
+{
+    sbfMutex_unlock (&mEntriesLock);
+}
+
+void
+gwcSeqnumStore::lockFile ()
+{
+    sbfMutex_lock (&mFileLock);
+}
+
+void
+gwcSeqnumStore::unlockFile ()
+{
+    sbfMutex_unlock (&mFileLock);
+}
+
+}
@@ -0,0 +1,134 @@
+#pragma once
+/*
+ * Sequence number persistence. In sync mode every update is written and
+ * flushed to the cache file before write returns, in group and async modes
+ * updates are copied aside and committed by a background writer thread so
+ * the dispatch thread never waits on the file.
+ *
+ * With a state segment items live in shared memory and are stored in place,
+ * durability then only decides when the segment is synced to disk.
+ */
+
+#include "gwcStateSegment.h"
+#include "sbfCommon.h"
+#include "sbfCacheFile.h"
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+namespace neueda
+{
+
+/* Largest cache file item the store will hold */
+#define GWC_SEQNUM_STORE_ITEM_SIZE 256
+
+typedef enum
+{
+    GWC_DURABILITY_SYNC,  /* write and flush every update */
+    GWC_DURABILITY_GROUP, /* commit every interval or count updates */
+    GWC_DURABILITY_ASYNC  /* write every interval, flush on close only */
+} gwcDurability;
+
+class gwcSeqnumStore
+{
+public:
+    gwcSeqnumStore ();
+    ~gwcSeqnumStore ();
+
+    void setDurability (gwcDurability durability,
+                        int intervalUsecs,
+                        int count);
+
+    gwcDurability getDurability () const
+    {
+        return mDurability;
+    }
+
+    /* Keep items in the state segment at path rather than a cache file */
+    void setSegment (const std::string& path, size_t slots);
+
+    bool hasSegment () const
+    {
+        return !mSegmentPath.empty ();
+    }
+
+    /* Open cache file name, or the slots owned by name in the state segment,
+       cb is called for every existing item as for sbfCacheFile_open. Starts
+       the writer thread if needed */
+    bool open (const std::string& name,
+               size_t itemSize,
+               int* created,
+               sbfCacheFileItemCb cb,
+               void* closure,
+               std::string& err);
+
+    /* Commit everything pending, stop the writer thread and close */
+    void close ();
+
+    /* Add a new item, always written and flushed before returning */
+    sbfCacheFileItem add (void* data);
+
+    /* Record new contents of item, size bytes from data */
+    void write (sbfCacheFileItem item, const void* data, size_t size);
+
+    /* Write and flush everything pending now */
+    void commit ();
+
+    /* Number of times updates have been written out, each sync write or
+       group of deferred updates counts once */
+    uint64_t getCommits () const
+    {
+        return mCommits;
+    }
+
+private:
+    gwcSeqnumStore (const gwcSeqnumStore& obj);
+    gwcSeqnumStore& operator= (const gwcSeqnumStore& obj);
+
+    struct entry
+    {
+        sbfCacheFileItem mItem;
+        size_t           mSize;
+        bool             mDirty;
+        char             mData[GWC_SEQNUM_STORE_ITEM_SIZE];
+    };
+
+    void lockEntries ();
+    void unlockEntries ();
+    void lockFile ();
+    void unlockFile ();
+    void stop ();
+
+    /* Sleep up to one interval without the entries lock, returns early once
+       a group is full or the writer is stopped */
+    void linger ();
+
+    /* Write out dirty entries, flush if asked */
+    void commitEntries (bool flush);
+
+    static void* writerCb (void* closure);
+    void run ();
+
+    sbfCacheFile       mFile;
+    gwcStateSegment*   mSegment;
+    std::string        mSegmentPath;
+    size_t             mSegmentSlots;
+    std::string        mName;
+    size_t             mItemSize;
+    gwcDurability      mDurability;
+    int                mIntervalUsecs;
+    int                mCount;
+    std::vector<entry> mEntries;
+    std::vector<entry> mCommitting;
+    volatile int       mPending;
+    volatile bool      mRunning;
+    bool               mWaiting;
+    volatile uint64_t  mCommits;
+    sbfMutex           mEntriesLock;
+    sbfMutex           mFileLock;
+    sbfCondVar         mCond;
+    sbfThread          mThread;
+};
+
+}
@@ -0,0 +1,569 @@
+#include "gwcSessionPool.h"
+
+namespace neueda
+{
+
+gwcSessionPoolMember::gwcSessionPoolMember (gwcSessionPool* pool,
+                                            gwcConnector* gwc) :
+    mPool (pool),
+    mGwc (gwc),
+    mReady (false),
+    mSecond (0),
+    mSent (0),
+    mOpen (0)
+{
+}
+
+gwcSessionPoolMember::~gwcSessionPoolMember ()
+{
+    delete mGwc;
+}
+
+void
+gwcSessionPoolMember::onConnected ()
+{
+    mPool->mSessionCbs->onConnected ();
+}
+
+void
+gwcSessionPoolMember::onLoggingOn (cdr& msg)
+{
+    mPool->mSessionCbs->onLoggingOn (msg);
+}
+
+bool
+gwcSessionPoolMember::onError (const std::string& error)
+{
+    /* new orders go elsewhere while the session reconnects */
+    mPool->setReady (this, false);
+    return mPool->mSessionCbs->onError (error);
+}
+
+void
+gwcSessionPoolMember::onLoggedOn (uint64_t seqno, const cdr& msg)
+{
+    mPool->setReady (this, true);
+    mPool->mSessionCbs->onLoggedOn (seqno, msg);
+}
+
+void
+gwcSessionPoolMember::onTraderLoggedOn (const cdr& msg)
+{
+    mPool->mSessionCbs->onTraderLoggedOn (msg);
+}
+
+void
+gwcSessionPoolMember::onTraderLoggedOff (const cdr& msg)
+{
+    mPool->mSessionCbs->onTraderLoggedOff (msg);
+}
+
+void
+gwcSessionPoolMember::onTraderLoggingOff (cdr& msg)
+{
+    mPool->mSessionCbs->onTraderLoggingOff (msg);
+}
+
+void
+gwcSessionPoolMember::onLoggedOff (uint64_t seqno, const cdr& msg)
+{
+    mPool->setReady (this, false);
+    mPool->mSessionCbs->onLoggedOff (seqno, msg);
+}
+
+void
+gwcSessionPoolMember::onGap (uint64_t expected, uint64_t recieved)
+{
+    mPool->mSessionCbs->onGap (expected, recieved);
+}
+
+void
+gwcSessionPoolMember::onAdmin (uint64_t seqno, const cdr& msg)
+{
+    mPool->mMessageCbs->onAdmin (seqno, msg);
+}
+
+void
+gwcSessionPoolMember::onOrderAck (uint64_t seqno, const cdr& msg)
+{
+    mPool->mMessageCbs->onOrderAck (seqno, msg);
+}
+
+void
+gwcSessionPoolMember::onOrderRejected (uint64_t seqno, const cdr& msg)
+{
+    mPool->release (this, msg);
+    mPool->mMessageCbs->onOrderRejected (seqno, msg);
+}
+
+void
+gwcSessionPoolMember::onOrderDone (uint64_t seqno, const cdr& msg)
+{
+    mPool->release (this, msg);
+    mPool->mMessageCbs->onOrderDone (seqno, msg);
+}
+
+void
+gwcSessionPoolMember::onOrderFill (uint64_t seqno, const cdr& msg)
+{
+    /* a fill that leaves nothing open is the last the order gets */
+    gwcOrderFields fields;
+    mGwc->getOrderFields (msg, fields);
+    if (fields.mHasLeavesQty && fields.mLeavesQty <= 0)
+        mPool->release (this, msg);
+    mPool->mMessageCbs->onOrderFill (seqno, msg);
+}
+
+void
+gwcSessionPoolMember::onModifyAck (uint64_t seqno, const cdr& msg)
+{
+    mPool->replaced (this, msg);
+    mPool->mMessageCbs->onModifyAck (seqno, msg);
+}
+
+void
+gwcSessionPoolMember::onModifyRejected (uint64_t seqno, const cdr& msg)
+{
+    mPool->rejected (this, msg);
+    mPool->mMessageCbs->onModifyRejected (seqno, msg);
+}
+
+void
+gwcSessionPoolMember::onCancelRejected (uint64_t seqno, const cdr& msg)
+{
+    /* some venues reject an amend with a cancel reject */
+    mPool->rejected (this, msg);
+    mPool->mMessageCbs->onCancelRejected (seqno, msg);
+}
+
+void
+gwcSessionPoolMember::onMsg (uint64_t seqno, const cdr& msg)
+{
+    mPool->mMessageCbs->onMsg (seqno, msg);
+}
+
+void
+gwcSessionPoolMember::onRawMsg (uint64_t seqno, const void* ptr, size_t len)
+{
+    mPool->mMessageCbs->onRawMsg (seqno, ptr, len);
+}
+
+void
+gwcSessionPoolMember::onSendFailed (const cdr& msg)
+{
+    mPool->failed (this, msg);
+    mPool->mMessageCbs->onSendFailed (msg);
+}
+
+gwcSessionPool::gwcSessionPool (neueda::logger* log,
+                                gwcSessionCallbacks* sessionCbs,
+                                gwcMessageCallbacks* messageCbs) :
+    mLog (log),
+    mSessionCbs (sessionCbs),
+    mMessageCbs (messageCbs)
+{
+    sbfMutex_init (&mLock, 1);
+}
+
+gwcSessionPool::~gwcSessionPool ()
+{
+    for (size_t i = 0; i < mMembers.size (); i++)
+        delete mMembers[i];
+    sbfMutex_destroy (&mLock);
+}
+
+bool
+gwcSessionPool::add (const std::string& type, const neueda::properties& props)
+{
+    return add (gwcConnectorFactory::get (mLog, type, props), props);
+}
+
+bool
+gwcSessionPool::add (gwcConnector* gwc, const neueda::properties& props)
+{
+    gwcSessionPoolMember* member = new gwcSessionPoolMember (this, gwc);
+    if (!gwc->init (member, member, props))
+    {
+        mLog->err ("failed to init session %lu of pool",
+                   (unsigned long)mMembers.size ());
+        delete member;
+        return false;
+    }
+
+    mMembers.push_back (member);
+    return true;
+}
+
+bool
+gwcSessionPool::start (bool reset)
+{
+    bool ok = true;
+    for (size_t i = 0; i < mMembers.size (); i++)
+    {
+        if (!mMembers[i]->mGwc->start (reset))
+        {
+            mLog->err ("failed to start session %lu of pool", (unsigned long)i);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+bool
+gwcSessionPool::stop ()
+{
+    bool ok = true;
+    for (size_t i = 0; i < mMembers.size (); i++)
+    {
+        if (!mMembers[i]->mGwc->stop ())
+            ok = false;
+    }
+    return ok;
+}
+
+bool
+gwcSessionPool::sendOrder (cdr& order)
+{
+    return routeOrder (order);
+}
+
+bool
+gwcSessionPool::sendOrder (gwcOrder& order)
+{
+    return routeOrder (order);
+}
+
+bool
+gwcSessionPool::sendCancel (cdr& cancel)
+{
+    return routeCancel (cancel);
+}
+
+bool
+gwcSessionPool::sendCancel (gwcOrder& cancel)
+{
+    return routeCancel (cancel);
+}
+
+bool
+gwcSessionPool::sendModify (cdr& modify)
+{
+    return routeModify (modify);
+}
+
+bool
+gwcSessionPool::sendModify (gwcOrder& modify)
+{
+    return routeModify (modify);
+}
+
+size_t
+gwcSessionPool::getReady ()
+{
+    size_t n = 0;
+
+    sbfMutex_lock (&mLock);
+    for (size_t i = 0; i < mMembers.size (); i++)
+    {
+        if (mMembers[i]->mReady)
+            n++;
+    }
+    sbfMutex_unlock (&mLock);
+
+    return n;
+}
+
+gwcConnector*
+gwcSessionPool::getOwner (const std::string& clOrdId)
+{
+    gwcConnector* gwc = NULL;
+
+    sbfMutex_lock (&mLock);
+    gwcSessionPoolOrders::iterator itr = mOrders.find (clOrdId);
+    if (itr != mOrders.end ())
+        gwc = itr->second->mGwc;
+    sbfMutex_unlock (&mLock);
+
+    return gwc;
+}
+
+template <typename MsgT>
+bool
+gwcSessionPool::routeOrder (MsgT& order)
+{
+    if (mMembers.empty ())
+        return false;
+
+    std::string clOrdId;
+    bool        tracked = mMembers[0]->mGwc->getClOrdId (order, false, clOrdId);
+    if (!tracked)
+        mLog->warn ("order has no client order id, it can't be cancelled through the pool");
+
+    /* a session that fails the send is skipped and the next least loaded
+       one tried */
+    std::vector<bool> tried (mMembers.size (), false);
+    for (;;)
+    {
+        sbfMutex_lock (&mLock);
+        gwcSessionPoolMember* member = pick (tried);
+        if (member != NULL)
+        {
+            sent (member);
+            if (tracked)
+            {
+                mOrders[clOrdId] = member;
+                member->mOpen++;
+            }
+        }
+        sbfMutex_unlock (&mLock);
+
+        if (member == NULL)
+        {
+            mLog->warn ("no session in pool ready to send order");
+            return false;
+        }
+
+        if (member->mGwc->sendOrder (order))
+            return true;
+
+        if (tracked)
+            release (member, order);
+        for (size_t i = 0; i < mMembers.size (); i++)
+        {
+            if (mMembers[i] == member)
+                tried[i] = true;
+        }
+    }
+}
+
+template <typename MsgT>
+bool
+gwcSessionPool::routeCancel (MsgT& cancel)
+{
+    gwcSessionPoolMember* member = owner (cancel);
+    if (member == NULL)
+        return false;
+
+    return member->mGwc->sendCancel (cancel);
+}
+
+template <typename MsgT>
+bool
+gwcSessionPool::routeModify (MsgT& modify)
+{
+    gwcSessionPoolMember* member = owner (modify);
+    if (member == NULL)
+        return false;
+
+    /* the replacement id belongs to the same session, one that keeps its
+       id is already there */
+    std::string clOrdId;
+    std::string origClOrdId;
+    bool        tracked = member->mGwc->getClOrdId (modify, false, clOrdId) &&
+                          member->mGwc->getClOrdId (modify, true, origClOrdId) &&
+                          clOrdId != origClOrdId;
+    if (tracked)
+    {
+        sbfMutex_lock (&mLock);
+        mOrders[clOrdId] = member;
+        mReplaces[clOrdId] = origClOrdId;
+        member->mOpen++;
+        sbfMutex_unlock (&mLock);
+    }
+
+    if (member->mGwc->sendModify (modify))
+        return true;
+
+    if (tracked)
+    {
+        sbfMutex_lock (&mLock);
+        forget (member, clOrdId);
+        sbfMutex_unlock (&mLock);
+    }
+    return false;
+}
+
+gwcSessionPoolMember*
+gwcSessionPool::pick (const std::vector<bool>& tried)
+{
+    uint64_t              second = gwcLatency_now () / 1000000000ULL;
+    gwcSessionPoolMember* best = NULL;
+    gwcThrottleStats      bestStats;
+
+    /* sessions with a throttle are compared on messages queued then
+       tokens left, which is all zero for those without */
+    for (size_t i = 0; i < mMembers.size (); i++)
+    {
+        gwcSessionPoolMember* member = mMembers[i];
+        if (!member->mReady || tried[i])
+            continue;
+
+        if (member->mSecond != second)
+        {
+            member->mSecond = second;
+            member->mSent = 0;
+        }
+
+        gwcThrottleStats stats = member->mGwc->getThrottleStats ();
+        if (best == NULL ||
+            stats.mQueued < bestStats.mQueued ||
+            (stats.mQueued == bestStats.mQueued &&
+             (stats.mTokens > bestStats.mTokens ||
+              (stats.mTokens == bestStats.mTokens &&
+               (member->mSent < best->mSent ||
+                (member->mSent == best->mSent && member->mOpen < best->mOpen))))))
+        {
+            best = member;
+            bestStats = stats;
+        }
+    }
+    return best;
+}
+
+gwcSessionPoolMember*
+gwcSessionPool::owner (const cdr& msg)
+{
+    std::string clOrdId;
+    if (mMembers.empty () || !mMembers[0]->mGwc->getClOrdId (msg, true, clOrdId))
+    {
+        mLog->warn ("message has no original client order id to route it by");
+        return NULL;
+    }
+
+    sbfMutex_lock (&mLock);
+    gwcSessionPoolMember*          member = NULL;
+    gwcSessionPoolOrders::iterator itr = mOrders.find (clOrdId);
+    if (itr != mOrders.end ())
+    {
+        member = itr->second;
+        sent (member);
+    }
+    bool ready = member != NULL && member->mReady;
+    sbfMutex_unlock (&mLock);
+
+    if (member == NULL)
+    {
+        mLog->warn ("no session in pool owns order %s", clOrdId.c_str ());
+        return NULL;
+    }
+
+    /* the venue only knows the order on the session that sent it */
+    if (!ready)
+    {
+        mLog->warn ("session owning order %s is not logged on", clOrdId.c_str ());
+        return NULL;
+    }
+    return member;
+}
+
+void
+gwcSessionPool::sent (gwcSessionPoolMember* member)
+{
+    uint64_t second = gwcLatency_now () / 1000000000ULL;
+
+    if (member->mSecond != second)
+    {
+        member->mSecond = second;
+        member->mSent = 0;
+    }
+    member->mSent++;
+}
+
+void
+gwcSessionPool::setReady (gwcSessionPoolMember* member, bool ready)
+{
+    sbfMutex_lock (&mLock);
+    member->mReady = ready;
+    sbfMutex_unlock (&mLock);
+}
+
+void
+gwcSessionPool::release (gwcSessionPoolMember* member, const cdr& msg)
+{
+    std::string clOrdId[2];
+    bool        found[2];
+    found[0] = member->mGwc->getClOrdId (msg, false, clOrdId[0]);
+    found[1] = member->mGwc->getClOrdId (msg, true, clOrdId[1]);
+
+    sbfMutex_lock (&mLock);
+    for (size_t i = 0; i < 2; i++)
+    {
+        if (found[i])
+            forget (member, clOrdId[i]);
+    }
+    sbfMutex_unlock (&mLock);
+}
+
+void
+gwcSessionPool::failed (gwcSessionPoolMember* member, const cdr& msg)
+{
+    std::string clOrdId;
+    std::string origClOrdId;
+    if (!member->mGwc->getClOrdId (msg, false, clOrdId))
+        return;
+    member->mGwc->getClOrdId (msg, true, origClOrdId);
+
+    /* a cancel or modify that was never sent leaves its order where it
+       is, only an id of its own is let go */
+    if (clOrdId == origClOrdId)
+        return;
+
+    sbfMutex_lock (&mLock);
+    forget (member, clOrdId);
+    sbfMutex_unlock (&mLock);
+}
+
+void
+gwcSessionPool::replaced (gwcSessionPoolMember* member, const cdr& msg)
+{
+    std::string clOrdId;
+    std::string origClOrdId;
+    if (!member->mGwc->getClOrdId (msg, false, clOrdId))
+        return;
+
+    /* the ack may not carry the id it replaced, the one the modify was
+       sent with is used when it doesn't */
+    sbfMutex_lock (&mLock);
+    gwcSessionPoolReplaces::iterator itr = mReplaces.find (clOrdId);
+    if (itr != mReplaces.end ())
+    {
+        origClOrdId = itr->second;
+        mReplaces.erase (itr);
+    }
+    else
+        member->mGwc->getClOrdId (msg, true, origClOrdId);
+
+    if (!origClOrdId.empty () && origClOrdId != clOrdId)
+        forget (member, origClOrdId);
+    sbfMutex_unlock (&mLock);
+}
+
+void
+gwcSessionPool::rejected (gwcSessionPoolMember* member, const cdr& msg)
+{
+    std::string clOrdId;
+    if (!member->mGwc->getClOrdId (msg, false, clOrdId))
+        return;
+
+    /* only a modify's own id is let go, the order it was for stays open
+       and a cancel's id was never tracked */
+    sbfMutex_lock (&mLock);
+    if (mReplaces.find (clOrdId) != mReplaces.end ())
+        forget (member, clOrdId);
+    sbfMutex_unlock (&mLock);
+}
+
+/* called with the lock held */
+void
+gwcSessionPool::forget (gwcSessionPoolMember* member, const std::string& clOrdId)
+{
+    gwcSessionPoolOrders::iterator itr = mOrders.find (clOrdId);
+    if (itr != mOrders.end () && itr->second == member)
+    {
+        mOrders.erase (itr);
+        member->mOpen--;
+    }
+    mReplaces.erase (clOrdId);
+}
+
+}
\ No newline at end of file
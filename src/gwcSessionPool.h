@@ -0,0 +1,147 @@
+#pragma once
+/*
+ * Pool of sessions to one venue. New orders go to the logged on session
+ * with the most throttle headroom, or without throttles the one that has
+ * sent the fewest messages in the current second, cancels and modifies go
+ * to the session that sent the order. Sessions that fail are
+ * skipped until they log on again.
+ */
+
+#include "gwcConnector.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace neueda
+{
+
+class gwcSessionPool;
+
+/* Callbacks of one session in a pool, tracks its state and the orders it
+   owns and passes everything on to the pool's callbacks */
+class gwcSessionPoolMember : public gwcSessionCallbacks,
+                             public gwcMessageCallbacks
+{
+    friend class gwcSessionPool;
+
+public:
+    gwcSessionPoolMember (gwcSessionPool* pool, gwcConnector* gwc);
+    virtual ~gwcSessionPoolMember ();
+
+    virtual void onConnected ();
+    virtual void onLoggingOn (cdr& msg);
+    virtual bool onError (const std::string& error);
+    virtual void onLoggedOn (uint64_t seqno, const cdr& msg);
+    virtual void onTraderLoggedOn (const cdr& msg);
+    virtual void onTraderLoggedOff (const cdr& msg);
+    virtual void onTraderLoggingOff (cdr& msg);
+    virtual void onLoggedOff (uint64_t seqno, const cdr& msg);
+    virtual void onGap (uint64_t expected, uint64_t recieved);
+
+    virtual void onAdmin (uint64_t seqno, const cdr& msg);
+    virtual void onOrderAck (uint64_t seqno, const cdr& msg);
+    virtual void onOrderRejected (uint64_t seqno, const cdr& msg);
+    virtual void onOrderDone (uint64_t seqno, const cdr& msg);
+    virtual void onOrderFill (uint64_t seqno, const cdr& msg);
+    virtual void onModifyAck (uint64_t seqno, const cdr& msg);
+    virtual void onModifyRejected (uint64_t seqno, const cdr& msg);
+    virtual void onCancelRejected (uint64_t seqno, const cdr& msg);
+    virtual void onMsg (uint64_t seqno, const cdr& msg);
+    virtual void onRawMsg (uint64_t seqno, const void* ptr, size_t len);
+    virtual void onSendFailed (const cdr& msg);
+
+private:
+    gwcSessionPoolMember (const gwcSessionPoolMember& obj);
+    gwcSessionPoolMember& operator= (const gwcSessionPoolMember& obj);
+
+    gwcSessionPool* mPool;
+    gwcConnector*   mGwc;
+
+    /* the rest are guarded by the pool lock */
+    bool            mReady;
+    uint64_t        mSecond;
+    uint64_t        mSent;
+    size_t          mOpen;
+};
+
+class gwcSessionPool
+{
+    friend class gwcSessionPoolMember;
+
+public:
+    /* Callbacks of every session are passed on to these */
+    gwcSessionPool (neueda::logger* log,
+                    gwcSessionCallbacks* sessionCbs,
+                    gwcMessageCallbacks* messageCbs);
+    ~gwcSessionPool ();
+
+    /* Create a session of type and init it with props, each session needs
+       its own logon and seqno_cache. Returns false on error */
+    bool add (const std::string& type, const neueda::properties& props);
+
+    /* Add a connector that hasn't been initialised, the pool owns it */
+    bool add (gwcConnector* gwc, const neueda::properties& props);
+
+    /* Start or stop every session */
+    bool start (bool reset);
+    bool stop ();
+
+    /* Send a new order on the least loaded session */
+    bool sendOrder (cdr& order);
+    bool sendOrder (gwcOrder& order);
+
+    /* Send a cancel or modify on the session that owns the order */
+    bool sendCancel (cdr& cancel);
+    bool sendCancel (gwcOrder& cancel);
+    bool sendModify (cdr& modify);
+    bool sendModify (gwcOrder& modify);
+
+    size_t getSize () const
+    {
+        return mMembers.size ();
+    }
+
+    gwcConnector* getSession (size_t i)
+    {
+        return mMembers[i]->mGwc;
+    }
+
+    /* Number of sessions logged on */
+    size_t getReady ();
+
+    /* Session the order with clOrdId was sent on, NULL if it isn't open */
+    gwcConnector* getOwner (const std::string& clOrdId);
+
+private:
+    gwcSessionPool (const gwcSessionPool& obj);
+    gwcSessionPool& operator= (const gwcSessionPool& obj);
+
+    typedef std::map<std::string, gwcSessionPoolMember*> gwcSessionPoolOrders;
+    typedef std::map<std::string, std::string> gwcSessionPoolReplaces;
+
+    template <typename MsgT> bool routeOrder (MsgT& order);
+    template <typename MsgT> bool routeCancel (MsgT& cancel);
+    template <typename MsgT> bool routeModify (MsgT& modify);
+
+    gwcSessionPoolMember* pick (const std::vector<bool>& tried);
+    gwcSessionPoolMember* owner (const cdr& msg);
+    void sent (gwcSessionPoolMember* member);
+    void setReady (gwcSessionPoolMember* member, bool ready);
+    void release (gwcSessionPoolMember* member, const cdr& msg);
+    void failed (gwcSessionPoolMember* member, const cdr& msg);
+    void replaced (gwcSessionPoolMember* member, const cdr& msg);
+    void rejected (gwcSessionPoolMember* member, const cdr& msg);
+    void forget (gwcSessionPoolMember* member, const std::string& clOrdId);
+
+    neueda::logger*                    mLog;
+    gwcSessionCallbacks*               mSessionCbs;
+    gwcMessageCallbacks*               mMessageCbs;
+    std::vector<gwcSessionPoolMember*> mMembers;
+    gwcSessionPoolOrders               mOrders;
+    /* id of a modify not yet acked or rejected to the id it replaces */
+    gwcSessionPoolReplaces             mReplaces;
+    sbfMutex                           mLock;
+};
+
+}
@@ -0,0 +1,297 @@
+#include "gwcStateSegment.h"
+#include "sbfCommon.h"
+
+#include <string.h>
+#include <map>
+
+#ifndef WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/* Marks a slot in use, written last when a slot is taken */
+#define GWC_STATE_SLOT_USED 0x67776373
+
+#define GWC_STATE_SEGMENT_MAGIC "GWCSTATE"
+#define GWC_STATE_SEGMENT_VERSION 1
+
+namespace neueda
+{
+
+/* First slot of the file */
+struct gwcStateSegmentHeader
+{
+    char     mMagic[8];
+    uint32_t mVersion;
+    uint32_t mSlotSize;
+    uint64_t mSlots;
+};
+
+typedef std::map<std::string, gwcStateSegment*> gwcStateSegmentMap;
+
+static gwcStateSegmentMap gwcStateSegments;
+
+/* Guards the segment map and slot allocation */
+struct gwcStateSegmentLock
+{
+    gwcStateSegmentLock ()
+    {
+        sbfMutex_init (&mLock, 0);
+    }
+
+    sbfMutex mLock;
+};
+
+static sbfMutex*
+gwcStateSegment_mutex ()
+{
+    static gwcStateSegmentLock lock;
+    return &lock.mLock;
+}
+
+#define gwcStateSegment_lock() sbfMutex_lock (gwcStateSegment_mutex ())
+#define gwcStateSegment_unlock() sbfMutex_unlock (gwcStateSegment_mutex ())
+
+#ifndef WIN32
+#define gwcStateSegment_barrier() __sync_synchronize ()
+#else
+#include <windows.h>
+#define gwcStateSegment_barrier() MemoryBarrier ()
+#endif
+
+gwcStateSegment::gwcStateSegment () :
+    mFd (-1),
+    mBase (NULL),
+    mLength (0),
+    mSlots (NULL),
+    mSlotCount (0),
+    mPageSize (4096),
+    mUsers (0)
+{
+}
+
+gwcStateSegment::~gwcStateSegment ()
+{
+#ifndef WIN32
+    if (mBase != NULL)
+    {
+        msync (mBase, mLength, MS_SYNC);
+        munmap (mBase, mLength);
+    }
+    if (mFd >= 0)
+        ::close (mFd);
+#endif
+}
+
+gwcStateSegment*
+gwcStateSegment::attach (const std::string& path,
+                         size_t slots,
+                         std::string& err)
+{
+    gwcStateSegment_lock ();
+
+    gwcStateSegmentMap::iterator itr = gwcStateSegments.find (path);
+    if (itr != gwcStateSegments.end ())
+    {
+        itr->second->mUsers++;
+        gwcStateSegment_unlock ();
+        return itr->second;
+    }
+
+    gwcStateSegment* segment = new gwcStateSegment ();
+    if (!segment->map (path, slots, err))
+    {
+        delete segment;
+        gwcStateSegment_unlock ();
+        return NULL;
+    }
+
+    segment->mUsers = 1;
+    gwcStateSegments[path] = segment;
+
+    gwcStateSegment_unlock ();
+    return segment;
+}
+
+void
+gwcStateSegment::detach (gwcStateSegment* segment)
+{
+    gwcStateSegment_lock ();
+
+    if (--segment->mUsers == 0)
+    {
+        gwcStateSegments.erase (segment->mPath);
+        delete segment;
+    }
+
+    gwcStateSegment_unlock ();
+}
+
+bool
+gwcStateSegment::map (const std::string& path, size_t slots, std::string& err)
+{
+#ifdef WIN32
+    err = "state segment not supported on this platform";
+    return false;
+#else
+    mPath = path;
+    mPageSize = (size_t)sysconf (_SC_PAGESIZE);
+
+    mFd = open (path.c_str (), O_RDWR | O_CREAT, 0644);
+    if (mFd < 0)
+    {
+        err = std::string ("failed to open ") + path + ": " + strerror (errno);
+        return false;
+    }
+
+    /* one process per segment, sessions would otherwise share slots */
+    if (flock (mFd, LOCK_EX | LOCK_NB) != 0)
+    {
+        err = path + " is in use by another process";
+        return false;
+    }
+
+    struct stat st;
+    if (fstat (mFd, &st) != 0)
+    {
+        err = std::string ("failed to stat ") + path + ": " + strerror (errno);
+        return false;
+    }
+
+    bool created = st.st_size == 0;
+    if (created)
+    {
+        /* slot 0 holds the header */
+        mLength = (slots + 1) * sizeof (gwcStateSlot);
+        if (ftruncate (mFd, (off_t)mLength) != 0)
+        {
+            err = std::string ("failed to size ") + path + ": " + strerror (errno);
+            return false;
+        }
+    }
+    else
+        mLength = (size_t)st.st_size;
+
+    mBase = mmap (NULL, mLength, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0);
+    if (mBase == MAP_FAILED)
+    {
+        mBase = NULL;
+        err = std::string ("failed to map ") + path + ": " + strerror (errno);
+        return false;
+    }
+
+    gwcStateSegmentHeader* header = (gwcStateSegmentHeader*)mBase;
+    if (created)
+    {
+        memcpy (header->mMagic, GWC_STATE_SEGMENT_MAGIC, sizeof header->mMagic);
+        header->mVersion = GWC_STATE_SEGMENT_VERSION;
+        header->mSlotSize = sizeof (gwcStateSlot);
+        header->mSlots = slots;
+        msync (mBase, mLength, MS_SYNC);
+    }
+    else if (mLength < sizeof (gwcStateSlot) ||
+             memcmp (header->mMagic, GWC_STATE_SEGMENT_MAGIC, sizeof header->mMagic) != 0 ||
+             header->mVersion != GWC_STATE_SEGMENT_VERSION ||
+             header->mSlotSize != sizeof (gwcStateSlot) ||
+             (header->mSlots + 1) * sizeof (gwcStateSlot) > mLength)
+    {
+        err = path + " is not a state segment";
+        return false;
+    }
+
+    mSlots = (gwcStateSlot*)mBase + 1;
+    mSlotCount = (size_t)header->mSlots;
+    return true;
+#endif
+}
+
+gwcStateSlot*
+gwcStateSegment::find (const std::string& owner, uint32_t index)
+{
+    for (size_t i = 0; i < mSlotCount; i++)
+    {
+        gwcStateSlot* slot = &mSlots[i];
+        if (slot->mUsed == GWC_STATE_SLOT_USED &&
+            slot->mIndex == index &&
+            strncmp (slot->mOwner, owner.c_str (), sizeof slot->mOwner) == 0)
+            return slot;
+    }
+    return NULL;
+}
+
+gwcStateSlot*
+gwcStateSegment::add (const std::string& owner, const void* data, size_t size)
+{
+    if (size > GWC_STATE_SLOT_DATA || owner.size () >= GWC_STATE_OWNER_SIZE)
+        return NULL;
+
+    gwcStateSegment_lock ();
+
+    uint32_t      index = 0;
+    gwcStateSlot* unused = NULL;
+    for (size_t i = 0; i < mSlotCount; i++)
+    {
+        gwcStateSlot* slot = &mSlots[i];
+        if (slot->mUsed != GWC_STATE_SLOT_USED)
+        {
+            if (unused == NULL)
+                unused = slot;
+        }
+        else if (strncmp (slot->mOwner, owner.c_str (), sizeof slot->mOwner) == 0)
+            index++;
+    }
+
+    if (unused != NULL)
+    {
+        memset (unused, 0, sizeof *unused);
+        unused->mSize = (uint32_t)size;
+        unused->mIndex = index;
+        strncpy (unused->mOwner, owner.c_str (), sizeof unused->mOwner - 1);
+        store (unused, data, size);
+        gwcStateSegment_barrier ();
+        unused->mUsed = GWC_STATE_SLOT_USED;
+    }
+
+    gwcStateSegment_unlock ();
+    return unused;
+}
+
+void
+gwcStateSegment::store (gwcStateSlot* slot, const void* data, size_t size)
+{
+    /* whole words so a crash never leaves a torn sequence number */
+    uint64_t words[GWC_STATE_SLOT_DATA / sizeof (uint64_t)];
+    size_t   n = (size + sizeof (uint64_t) - 1) / sizeof (uint64_t);
+
+    if (n == 0 || size > GWC_STATE_SLOT_DATA)
+        return;
+
+    words[n - 1] = slot->mData[n - 1];
+    memcpy (words, data, size);
+
+    for (size_t i = 0; i < n; i++)
+        slot->mData[i] = words[i];
+}
+
+void
+gwcStateSegment::sync (gwcStateSlot* slot)
+{
+#ifndef WIN32
+    uintptr_t page = (uintptr_t)slot & ~(uintptr_t)(mPageSize - 1);
+    msync ((void*)page, mPageSize, MS_SYNC);
+#endif
+}
+
+void
+gwcStateSegment::sync ()
+{
+#ifndef WIN32
+    msync (mBase, mLength, MS_SYNC);
+#endif
+}
+
+}
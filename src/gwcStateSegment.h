@@ -0,0 +1,84 @@
+#pragma once
+/*
+ * Memory mapped session state shared by every connector in the process.
+ * Each session or partition owns a cache line aligned slot and updates it
+ * with plain stores, the mapping survives a process crash without any flush,
+ * sync writes it to disk for machine crash durability.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+namespace neueda
+{
+
+/* Default number of slots in a new segment */
+#define GWC_STATE_SEGMENT_SLOTS 4096
+
+/* Largest item a slot can hold */
+#define GWC_STATE_SLOT_DATA 64
+
+/* Longest owner name, including the terminator */
+#define GWC_STATE_OWNER_SIZE 48
+
+struct gwcStateSlot
+{
+    uint32_t          mUsed;
+    uint32_t          mSize;
+    uint32_t          mIndex;
+    uint32_t          mReserved;
+    char              mOwner[GWC_STATE_OWNER_SIZE];
+    /* own cache line, the only one touched on update */
+    volatile uint64_t mData[GWC_STATE_SLOT_DATA / sizeof (uint64_t)];
+};
+
+class gwcStateSegment
+{
+public:
+    /* Map the segment at path, created with slots slots if it doesn't exist.
+       Connectors naming the same path share one mapping */
+    static gwcStateSegment* attach (const std::string& path,
+                                    size_t slots,
+                                    std::string& err);
+
+    /* Release a segment from attach, unmapped when the last user detaches */
+    static void detach (gwcStateSegment* segment);
+
+    /* index'th slot added by owner, NULL if there isn't one */
+    gwcStateSlot* find (const std::string& owner, uint32_t index);
+
+    /* Take a free slot for owner holding size bytes of data */
+    gwcStateSlot* add (const std::string& owner, const void* data, size_t size);
+
+    /* Store new contents of slot, word at a time */
+    static void store (gwcStateSlot* slot, const void* data, size_t size);
+
+    /* Write slot, or the whole segment, to disk */
+    void sync (gwcStateSlot* slot);
+    void sync ();
+
+    const std::string& getPath () const
+    {
+        return mPath;
+    }
+
+private:
+    gwcStateSegment ();
+    ~gwcStateSegment ();
+    gwcStateSegment (const gwcStateSegment& obj);
+    gwcStateSegment& operator= (const gwcStateSegment& obj);
+
+    bool map (const std::string& path, size_t slots, std::string& err);
+
+    std::string   mPath;
+    int           mFd;
+    void*         mBase;
+    size_t        mLength;
+    gwcStateSlot* mSlots;
+    size_t        mSlotCount;
+    size_t        mPageSize;
+    int           mUsers;
+};
+
+}
@@ -0,0 +1,195 @@
+#include "gwcThrottle.h"
+#include "gwcLatency.h"
+
+namespace neueda
+{
+
+gwcThrottle::gwcThrottle (gwcThrottleMode mode,
+                          uint32_t rate,
+                          uint64_t window,
+                          uint32_t burst,
+                          size_t queueSize,
+                          gwcThrottleDelegate* delegate) :
+    mMode (mode),
+    mDelegate (delegate),
+    mQueueSize (queueSize),
+    mArmed (false),
+    mDraining (false),
+    mTotalWait (0)
+{
+    mCost = window / rate;
+    if (mCost == 0)
+        mCost = 1;
+    mCapacity = mCost * burst;
+
+    /* start with a full bucket */
+    mCredit = mCapacity;
+    mLast = gwcLatency_now ();
+
+    sbfMutex_init (&mLock, 0);
+}
+
+gwcThrottle::~gwcThrottle ()
+{
+    sbfMutex_destroy (&mLock);
+}
+
+void
+gwcThrottle::refill (uint64_t now)
+{
+    if (now > mLast)
+    {
+        mCredit += now - mLast;
+        if (mCredit > mCapacity)
+            mCredit = mCapacity;
+    }
+    mLast = now;
+}
+
+gwcThrottleResult
+gwcThrottle::send (cdr** msgs, size_t n)
+{
+    uint64_t now = gwcLatency_now ();
+
+    sbfMutex_lock (&mLock);
+    refill (now);
+
+    /* anything queued or being drained goes first */
+    if (mQueue.empty () && !mDraining && mCredit >= n * mCost)
+    {
+        mCredit -= n * mCost;
+        mStats.mSent += n;
+        sbfMutex_unlock (&mLock);
+
+        if (!mDelegate->onSend (msgs, n))
+            return GWC_THROTTLE_FAILED;
+        return GWC_THROTTLE_SENT;
+    }
+
+    if (mMode == GWC_THROTTLE_REJECT || mQueue.size () + n > mQueueSize)
+    {
+        mStats.mRejected += n;
+        sbfMutex_unlock (&mLock);
+        return GWC_THROTTLE_REJECTED;
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        mQueue.push_back (gwcThrottleEntry ());
+        mQueue.back ().mMsg = *msgs[i];
+        mQueue.back ().mTime = now;
+    }
+    if (mQueue.size () > mStats.mMaxQueued)
+        mStats.mMaxQueued = mQueue.size ();
+
+    if (!mArmed)
+    {
+        mArmed = true;
+        mDelegate->onQueued (mCost);
+    }
+    sbfMutex_unlock (&mLock);
+    return GWC_THROTTLE_QUEUED;
+}
+
+bool
+gwcThrottle::take ()
+{
+    uint64_t now = gwcLatency_now ();
+
+    sbfMutex_lock (&mLock);
+    refill (now);
+
+    bool ok = mQueue.empty () && !mDraining && mCredit >= mCost;
+    if (ok)
+    {
+        mCredit -= mCost;
+        mStats.mSent++;
+    }
+    else
+        mStats.mRejected++;
+    sbfMutex_unlock (&mLock);
+
+    return ok;
+}
+
+void
+gwcThrottle::drain ()
+{
+    sbfMutex_lock (&mLock);
+    refill (gwcLatency_now ());
+
+    /* sends happen unlocked, mDraining keeps new sends queued behind the
+       one in flight so order is kept */
+    while (!mQueue.empty () && mCredit >= mCost)
+    {
+        cdr      msg = mQueue.front ().mMsg;
+        uint64_t wait = mLast - mQueue.front ().mTime;
+
+        mQueue.pop_front ();
+        mCredit -= mCost;
+        mStats.mSent++;
+        mStats.mDelayed++;
+        mTotalWait += wait;
+        if (wait > mStats.mMaxWait)
+            mStats.mMaxWait = wait;
+        mDraining = true;
+        sbfMutex_unlock (&mLock);
+
+        cdr* msgs = &msg;
+        bool sent = mDelegate->onSend (&msgs, 1);
+        if (!sent)
+            mDelegate->onFailed (msg);
+
+        sbfMutex_lock (&mLock);
+        if (!sent)
+            mStats.mFailed++;
+        refill (gwcLatency_now ());
+    }
+    mDraining = false;
+
+    if (mQueue.empty () && mArmed)
+    {
+        mArmed = false;
+        mDelegate->onDrained ();
+    }
+    sbfMutex_unlock (&mLock);
+}
+
+void
+gwcThrottle::clear ()
+{
+    std::deque<gwcThrottleEntry> dropped;
+
+    sbfMutex_lock (&mLock);
+    dropped.swap (mQueue);
+    mStats.mFailed += dropped.size ();
+    if (mArmed)
+    {
+        mArmed = false;
+        mDelegate->onDrained ();
+    }
+    sbfMutex_unlock (&mLock);
+
+    for (size_t i = 0; i < dropped.size (); i++)
+        mDelegate->onFailed (dropped[i].mMsg);
+}
+
+gwcThrottleStats
+gwcThrottle::snapshot ()
+{
+    uint64_t now = gwcLatency_now ();
+
+    sbfMutex_lock (&mLock);
+    refill (now);
+
+    gwcThrottleStats stats = mStats;
+    stats.mTokens = mCredit / mCost;
+    stats.mQueued = mQueue.size ();
+    if (mStats.mDelayed > 0)
+        stats.mMeanWait = mTotalWait / mStats.mDelayed;
+    sbfMutex_unlock (&mLock);
+
+    return stats;
+}
+
+}
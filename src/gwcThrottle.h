@@ -0,0 +1,148 @@
+#pragma once
+/*
+ * Client side token bucket for a venue's per session message rate limit.
+ * rate tokens come back every window up to burst and each message sent
+ * takes one. Without a token a message is either rejected or queued and
+ * sent from the dispatch thread as tokens come back, still in the order
+ * the messages were sent.
+ */
+
+#include "sbfCommon.h"
+#include "cdr.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <deque>
+
+namespace neueda
+{
+
+/* Default most messages queued */
+#define GWC_THROTTLE_QUEUE_SIZE 1024
+
+typedef enum
+{
+    GWC_THROTTLE_REJECT, /* fail sends that have no token */
+    GWC_THROTTLE_QUEUE   /* queue them until tokens come back */
+} gwcThrottleMode;
+
+typedef enum
+{
+    GWC_THROTTLE_SENT,     /* had tokens, passed to the delegate */
+    GWC_THROTTLE_QUEUED,   /* will be sent by drain */
+    GWC_THROTTLE_REJECTED, /* no tokens or no space in the queue */
+    GWC_THROTTLE_FAILED    /* had tokens but the delegate failed to send */
+} gwcThrottleResult;
+
+/* Snapshot of a throttle, times in nanoseconds */
+struct gwcThrottleStats
+{
+    gwcThrottleStats () :
+        mTokens (0),
+        mQueued (0),
+        mMaxQueued (0),
+        mSent (0),
+        mDelayed (0),
+        mRejected (0),
+        mFailed (0),
+        mMeanWait (0),
+        mMaxWait (0)
+    {
+    }
+
+    uint64_t mTokens;    /* tokens available now */
+    uint64_t mQueued;    /* messages waiting now */
+    uint64_t mMaxQueued; /* most messages waiting at once */
+    uint64_t mSent;      /* messages given a token */
+    uint64_t mDelayed;   /* of those, sent from the queue */
+    uint64_t mRejected;  /* messages refused */
+    uint64_t mFailed;    /* queued messages not sent, failed or cleared */
+    uint64_t mMeanWait;  /* time delayed messages spent queued */
+    uint64_t mMaxWait;
+};
+
+class gwcThrottleDelegate
+{
+public:
+    /* dtor */
+    virtual ~gwcThrottleDelegate () {};
+
+    /* Send messages that have been given tokens */
+    virtual bool onSend (cdr** msgs, size_t n) = 0;
+
+    /* Messages have been queued, call drain every interval nanoseconds
+       until onDrained. Called with the throttle locked */
+    virtual void onQueued (uint64_t interval) = 0;
+
+    /* The queue is empty again, called with the throttle locked */
+    virtual void onDrained () = 0;
+
+    /* A queued message the delegate failed to send or that was cleared,
+       called unlocked */
+    virtual void onFailed (const cdr& msg) = 0;
+};
+
+class gwcThrottle
+{
+public:
+    gwcThrottle (gwcThrottleMode mode,
+                 uint32_t rate,
+                 uint64_t window,
+                 uint32_t burst,
+                 size_t queueSize,
+                 gwcThrottleDelegate* delegate);
+    ~gwcThrottle ();
+
+    /* Send n messages if there are tokens for all of them and nothing is
+       queued ahead, else queue or reject all of them. Queued messages are
+       copied */
+    gwcThrottleResult send (cdr** msgs, size_t n);
+
+    /* Take a token for a message that can't be queued, false if there
+       isn't one or messages are queued ahead */
+    bool take ();
+
+    /* Send queued messages while there are tokens, from the thread that
+       was asked by onQueued */
+    void drain ();
+
+    /* Drop everything queued, each message is passed to onFailed. Called
+       when the session goes down as nothing queued can be sent on the
+       next one */
+    void clear ();
+
+    gwcThrottleMode getMode () const
+    {
+        return mMode;
+    }
+
+    gwcThrottleStats snapshot ();
+
+private:
+    gwcThrottle (const gwcThrottle& obj);
+    gwcThrottle& operator= (const gwcThrottle& obj);
+
+    struct gwcThrottleEntry
+    {
+        cdr      mMsg;
+        uint64_t mTime;
+    };
+
+    void refill (uint64_t now);
+
+    gwcThrottleMode              mMode;
+    gwcThrottleDelegate*         mDelegate;
+    uint64_t                     mCost;     /* nanoseconds of credit a token */
+    uint64_t                     mCapacity; /* credit of burst tokens */
+    uint64_t                     mCredit;
+    uint64_t                     mLast;
+    size_t                       mQueueSize;
+    std::deque<gwcThrottleEntry> mQueue;
+    bool                         mArmed;
+    bool                         mDraining;
+    gwcThrottleStats             mStats;
+    uint64_t                     mTotalWait;
+    sbfMutex                     mLock;
+};
+
+}
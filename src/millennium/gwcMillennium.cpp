@@ -1,14 +1,11 @@
 #include "gwcMillennium.h"
 
-#include "TurquoisePackets.h"
-#include "OsloPackets.h"
-#include "LsePackets.h"
-
 #include "sbfInterface.h"
 #include "utils.h"
 #include "fields.h"
 
 #include <sstream>
+#include <vector>
 
 static const string defaultCacheName = "millennium.seqno.cache";
 static const string defaultRawEnabled = "no";
@@ -44,35 +41,37 @@ gwcMillenniumRealTimeConnectionDelegate<CodecT>::onRead (void* data, size_t size
 
 template <typename CodecT>
 gwcMillenniumRecoveryConnectionDelegate<CodecT>::gwcMillenniumRecoveryConnectionDelegate(
-    gwcMillennium<CodecT>* gwc
+    gwcMillennium<CodecT>* gwc,
+    gwcMillenniumRecovery<CodecT>* recovery
     )
 : SbfTcpConnectionDelegate (),
-  mGwc (gwc)
+  mGwc (gwc),
+  mRecovery (recovery)
 { }
 
 template <typename CodecT>
 void
 gwcMillenniumRecoveryConnectionDelegate<CodecT>::onReady ()
 {
-    mGwc->onRecoveryConnectionReady ();
+    mGwc->onRecoveryConnectionReady (mRecovery);
 }
 
 template <typename CodecT>
 void
 gwcMillenniumRecoveryConnectionDelegate<CodecT>::onError ()
 {
-    mGwc->onRecoveryConnectionError ();
+    mGwc->onRecoveryConnectionError (mRecovery);
 }
 
 template <typename CodecT>
 size_t
 gwcMillenniumRecoveryConnectionDelegate<CodecT>::onRead (void* data, size_t size)
 {
-    return mGwc->onRecoveryConnectionRead (data, size);
+    return mGwc->onRecoveryConnectionRead (mRecovery, data, size);
 }
 
 extern "C" gwcConnector*
-getConnector (neueda::logger* log, const neueda::properties& props)
+GWC_CONNECTOR_ENTRY (millennium) (neueda::logger* log, const neueda::properties& props)
 {
     string venue;
     if (!props.get ("venue", venue)) 
@@ -101,16 +100,16 @@ gwcMillennium<CodecT>::gwcMillennium (neueda::logger* log) :
     gwcConnector (log),
     mRealTimeConnection (NULL),
     mRealTimeConnectionDelegate (this),
-    mRecoveryConnection (NULL),
-    mRecoveryConnectionDelegate (this),
-    mCacheFile (NULL),
     mMw (NULL),
     mQueue (NULL),
     mDispatching (false),
     mHb (NULL),
     mReconnectTimer (NULL),
     mSeenHb (false),
-    mWaitingDownloads (0)
+    mWaitingDownloads (0),
+    mRecoveryConnections (0),
+    mRecovery (NULL),
+    mTypedCbs (NULL)
 {
     
 }
@@ -118,16 +117,16 @@ gwcMillennium<CodecT>::gwcMillennium (neueda::logger* log) :
 template <typename CodecT>
 gwcMillennium<CodecT>::~gwcMillennium ()
 {
+    stopThrottle ();
     if (mReconnectTimer)
         sbfTimer_destroy (mReconnectTimer);
     if (mHb)
         sbfTimer_destroy (mHb);
     if (mRealTimeConnection)
         delete mRealTimeConnection;
-    if (mRecoveryConnection)
-        delete mRecoveryConnection;
-    if (mCacheFile)
-        sbfCacheFile_close (mCacheFile);
+    for (size_t i = 0; i < mRecoveries.size (); i++)
+        delete mRecoveries[i];
+    mSeqnumStore.close ();
     if (mQueue)
         sbfQueue_destroy (mQueue);
     if (mDispatching)
@@ -162,6 +161,7 @@ gwcMillennium<CodecT>::onRealTimeConnectionReady ()
     }
 
     mRealTimeConnection->send (space, used);
+    journalOut (space, used);
 }
 
 template <typename CodecT>
@@ -177,9 +177,10 @@ gwcMillennium<CodecT>::onRealTimeConnectionRead (void* data, size_t size)
 {
     size_t         left = size;
     size_t         used = 0;
-    cdr            msg;
+    cdr&           msg = mRealTimeMsg;
     LseHeader*     hdr = (LseHeader*)data;
     int32_t        seqno = 0;    
+    uint64_t       read = mLatency ? gwcLatency_now () : 0;
 
     if (mRawEnabled)
     {
@@ -192,9 +193,19 @@ gwcMillennium<CodecT>::onRealTimeConnectionRead (void* data, size_t size)
             if (left < hdr->mMessageLength + sizeof *hdr - 1)
                 return used;
 
+            if (holdRealTimeMsg (hdr, hdr->mMessageLength + sizeof *hdr - 1))
+            {
+                size_t messageLength = (hdr->mMessageLength + sizeof *hdr - 1);
+                left -= messageLength;
+                used += messageLength;
+                hdr = (LseHeader*)((char*)hdr + messageLength);
+                continue;
+            }
+
             if (isSessionMessage (hdr))
             {
                 size_t codecUsed = 0;
+                msg.clear ();
                 switch (mCodec.decode (msg, (void*)hdr, left, codecUsed))
                 {
                 case GW_CODEC_ERROR:
@@ -206,7 +217,12 @@ gwcMillennium<CodecT>::onRealTimeConnectionRead (void* data, size_t size)
                     return size;
 
                 case GW_CODEC_SUCCESS:
-                    handleRealTimeMsg (msg);
+                    journalIn (hdr, codecUsed);
+                    if (mLatency)
+                        mLatency->inboundDecoded (latencyKey (hdr), read);
+                    handleRealTimeMsg (hdr, msg);
+                    if (mLatency)
+                        mLatency->inboundDone ();
                     hdr = (LseHeader*)((char*)hdr + codecUsed);
                     left -= codecUsed;
                     used += codecUsed;
@@ -224,7 +240,12 @@ gwcMillennium<CodecT>::onRealTimeConnectionRead (void* data, size_t size)
                    updateSeqno (partId, seqno);
             }
 
+            journalIn (hdr, hdr->mMessageLength + sizeof *hdr - 1);
+            if (mLatency)
+                mLatency->inboundDecoded (latencyKey (hdr), read);
             mMessageCbs->onRawMsg (seqno, hdr, hdr->mMessageLength + sizeof *hdr - 1);
+            if (mLatency)
+                mLatency->inboundDone ();
             
             size_t messageLength = (hdr->mMessageLength + sizeof *hdr - 1);
             left -= messageLength;
@@ -238,6 +259,37 @@ gwcMillennium<CodecT>::onRealTimeConnectionRead (void* data, size_t size)
     for (;;)
     {
         size_t used;
+
+        if (left >= sizeof *hdr)
+        {
+            hdr = (LseHeader*)data;
+            size_t messageLength = hdr->mMessageLength + sizeof *hdr - 1;
+            if (left < messageLength)
+                return size - left;
+
+            if (holdRealTimeMsg (hdr, messageLength))
+            {
+                mSeenHb = true;
+                left -= messageLength;
+                data = (char*)data + messageLength;
+                continue;
+            }
+
+            /* typed callbacks bypass the codec for application messages */
+            if (mTypedCbs != NULL)
+            {
+                journalIn (hdr, messageLength);
+                if (handleTypedMsg (hdr))
+                {
+                    mSeenHb = true;
+                    left -= messageLength;
+                    data = (char*)data + messageLength;
+                    continue;
+                }
+            }
+        }
+
+        msg.clear ();
         switch (mCodec.decode (msg, data, left, used))
         {
         case GW_CODEC_ERROR:
@@ -252,7 +304,13 @@ gwcMillennium<CodecT>::onRealTimeConnectionRead (void* data, size_t size)
             return size;
 
         case GW_CODEC_SUCCESS:
-            handleRealTimeMsg (msg);
+            if (mTypedCbs == NULL)
+                journalIn (data, used);
+            if (mLatency)
+                mLatency->inboundDecoded (latencyKey ((LseHeader*)data), read);
+            handleRealTimeMsg ((LseHeader*)data, msg);
+            if (mLatency)
+                mLatency->inboundDone ();
             left -= used;
             break;
         }
@@ -264,7 +322,7 @@ gwcMillennium<CodecT>::onRealTimeConnectionRead (void* data, size_t size)
 
 template <typename CodecT>
 void 
-gwcMillennium<CodecT>::onRecoveryConnectionReady ()
+gwcMillennium<CodecT>::onRecoveryConnectionReady (gwcMillenniumRecovery<CodecT>* recovery)
 {
     cdr            logon;
     string         empty;
@@ -287,25 +345,31 @@ gwcMillennium<CodecT>::onRecoveryConnectionReady ()
         return;
     }
 
-    mRecoveryConnection->send (space, used);
+    recovery->mConnection->send (space, used);
+    journalOut (space, used);
 }
 
 template <typename CodecT>
 void 
-gwcMillennium<CodecT>::onRecoveryConnectionError ()
+gwcMillennium<CodecT>::onRecoveryConnectionError (gwcMillenniumRecovery<CodecT>* recovery)
 {
     error ("tcp drop recovery connection");
 }
 
 template <typename CodecT>
 size_t 
-gwcMillennium<CodecT>::onRecoveryConnectionRead (void* data, size_t size)
+gwcMillennium<CodecT>::onRecoveryConnectionRead (gwcMillenniumRecovery<CodecT>* recovery,
+                                                 void* data,
+                                                 size_t size)
 {
     size_t         left = size;
     size_t         used = 0;
-    cdr            msg;
+    cdr&           msg = mRecoveryMsg;
     LseHeader*     hdr = (LseHeader*)data;
     int32_t        seqno = 0;
+
+    /* session replies go back on the connection being read */
+    mRecovery = recovery;
     
     if (mRawEnabled)
     {
@@ -318,9 +382,19 @@ gwcMillennium<CodecT>::onRecoveryConnectionRead (void* data, size_t size)
             if (left < hdr->mMessageLength + sizeof *hdr - 1)
                 return used;
 
+            if (isRecovered (hdr))
+            {
+                size_t messageLength = (hdr->mMessageLength + sizeof *hdr - 1);
+                left -= messageLength;
+                used += messageLength;
+                hdr = (LseHeader*)((char*)hdr + messageLength);
+                continue;
+            }
+
             if (isSessionMessage (hdr))
             {
                 size_t codecUsed = 0;
+                msg.clear ();
                 switch (mCodec.decode (msg, (void*)hdr, left, codecUsed))
                 {
                 case GW_CODEC_ERROR:
@@ -332,7 +406,8 @@ gwcMillennium<CodecT>::onRecoveryConnectionRead (void* data, size_t size)
                     return left;
 
                 case GW_CODEC_SUCCESS:
-                    handleRecoveryMsg (msg);
+                    journalIn (hdr, codecUsed);
+                    handleRecoveryMsg (hdr, msg);
                     hdr = (LseHeader*)((char*)hdr + codecUsed);
                     left -= codecUsed;
                     used += codecUsed;
@@ -350,6 +425,7 @@ gwcMillennium<CodecT>::onRecoveryConnectionRead (void* data, size_t size)
                    updateSeqno (partId, seqno);
             }
 
+            journalIn (hdr, hdr->mMessageLength + sizeof *hdr - 1);
             mMessageCbs->onRawMsg (seqno, hdr, hdr->mMessageLength + sizeof *hdr - 1);
 
             size_t messageLength = (hdr->mMessageLength + sizeof *hdr - 1);
@@ -363,6 +439,36 @@ gwcMillennium<CodecT>::onRecoveryConnectionRead (void* data, size_t size)
     for (;;)
     {
         size_t used;
+
+        if (left >= sizeof *hdr)
+        {
+            hdr = (LseHeader*)data;
+            size_t messageLength = hdr->mMessageLength + sizeof *hdr - 1;
+            if (left < messageLength)
+                return size - left;
+
+            /* already delivered */
+            if (isRecovered (hdr))
+            {
+                left -= messageLength;
+                data = (char*)data + messageLength;
+                continue;
+            }
+
+            /* typed callbacks bypass the codec for application messages */
+            if (mTypedCbs != NULL)
+            {
+                journalIn (hdr, messageLength);
+                if (handleTypedMsg (hdr))
+                {
+                    left -= messageLength;
+                    data = (char*)data + messageLength;
+                    continue;
+                }
+            }
+        }
+
+        msg.clear ();
         switch (mCodec.decode (msg, data, left, used))
         {
         case GW_CODEC_ERROR:
@@ -377,7 +483,9 @@ gwcMillennium<CodecT>::onRecoveryConnectionRead (void* data, size_t size)
             return size;
 
         case GW_CODEC_SUCCESS:
-            handleRecoveryMsg (msg);
+            if (mTypedCbs == NULL)
+                journalIn (data, used);
+            handleRecoveryMsg ((LseHeader*)data, msg);
             left -= used;
             break;
         }
@@ -406,6 +514,13 @@ gwcMillennium<CodecT>::isSessionMessage (LseHeader* hdr)
     }
 }
 
+template <typename CodecT>
+uint32_t
+gwcMillennium<CodecT>::latencyKey (const LseHeader* hdr)
+{
+    return gwcLatency_textKey ((uint8_t)hdr->mMessageType);
+}
+
 template <typename CodecT>
 int32_t
 gwcMillennium<CodecT>::getSeqnum (LseHeader* hdr, uint8_t& appId)
@@ -433,6 +548,95 @@ gwcMillennium<CodecT>::getSeqnum (LseHeader* hdr, uint8_t& appId)
     } 
 }
 
+template <typename CodecT>
+bool
+gwcMillennium<CodecT>::handleTypedMsg (LseHeader* hdr)
+{
+    typedef gwcMillenniumPackets<CodecT> packets;
+
+    uint8_t partId;
+    int32_t seqno = getSeqnum (hdr, partId);
+    if (seqno == -1)
+        return false;
+
+    updateSeqno (partId, seqno);
+
+    switch (hdr->mMessageType)
+    {
+    case GW_MILLENNIUM_EXECUTION_REPORT_C:
+        mTypedCbs->onExecutionReport (
+            seqno, *(const typename packets::ExecutionReport*)hdr);
+        break;
+    case GW_MILLENNIUM_ORDER_CANCEL_REJECT_C:
+        mTypedCbs->onOrderCancelReject (
+            seqno, *(const typename packets::OrderCancelReject*)hdr);
+        break;
+    case GW_MILLENNIUM_BUSINESS_REJECT_C:
+        mTypedCbs->onBusinessReject (
+            seqno, *(const typename packets::BusinessReject*)hdr);
+        break;
+    }
+    return true;
+}
+
+template <typename CodecT>
+bool
+gwcMillennium<CodecT>::holdRealTimeMsg (LseHeader* hdr, size_t size)
+{
+    if (mHeld.empty ())
+        return false;
+
+    uint8_t partId;
+    if (getSeqnum (hdr, partId) == -1)
+        return false;
+
+    gwcMillenniumHeldMap::iterator itr = mHeld.find (partId);
+    if (itr == mHeld.end ())
+        return false;
+
+    itr->second.insert (itr->second.end (), (char*)hdr, (char*)hdr + size);
+    return true;
+}
+
+template <typename CodecT>
+void
+gwcMillennium<CodecT>::releaseHeld (uint64_t partId)
+{
+    gwcMillenniumHeldMap::iterator itr = mHeld.find (partId);
+    if (itr == mHeld.end ())
+        return;
+
+    vector<char> held;
+    held.swap (itr->second);
+    mHeld.erase (itr);
+
+    /* the download overlaps the held messages, skip what it delivered */
+    size_t offset = 0;
+    while (offset < held.size ())
+    {
+        LseHeader* hdr = (LseHeader*)&held[offset];
+        size_t     messageLength = hdr->mMessageLength + sizeof *hdr - 1;
+
+        if (!isRecovered (hdr))
+            onRealTimeConnectionRead (hdr, messageLength);
+        offset += messageLength;
+    }
+}
+
+template <typename CodecT>
+bool
+gwcMillennium<CodecT>::isRecovered (LseHeader* hdr)
+{
+    uint8_t partId;
+    int32_t seqno = getSeqnum (hdr, partId);
+    if (seqno == -1)
+        return false;
+
+    gwcMillenniumCacheMap::iterator itr = mCacheMap.find (partId);
+    return itr != mCacheMap.end () && 
+           (uint64_t)seqno <= itr->second->mData.mSeqno;
+}
+
 template <typename CodecT>
 void 
 gwcMillennium<CodecT>::onHbTimeout (sbfTimer timer, void* closure)
@@ -462,7 +666,7 @@ void*
 gwcMillennium<CodecT>::dispatchCb (void* closure)
 {
     gwcMillennium* gwc = reinterpret_cast<gwcMillennium*>(closure);
-    sbfQueue_dispatch (gwc->mQueue);
+    gwc->dispatch (gwc->mQueue);
     return NULL;
 }
 
@@ -503,8 +707,9 @@ gwcMillennium<CodecT>::updateSeqno (uint64_t partId, uint64_t seqno)
     if (itr != mCacheMap.end ())
     {
         itr->second->mData.mSeqno = seqno;
-        sbfCacheFile_write (itr->second->mItem, &itr->second->mData);
-        sbfCacheFile_flush (mCacheFile);
+        mSeqnumStore.write (itr->second->mItem,
+                            &itr->second->mData,
+                            sizeof itr->second->mData);
         return;
     }
 
@@ -512,10 +717,9 @@ gwcMillennium<CodecT>::updateSeqno (uint64_t partId, uint64_t seqno)
     gwcMillenniumCacheItem* ci = new gwcMillenniumCacheItem ();
     ci->mData.mSeqno = seqno;
     ci->mData.mParitionId = partId;
-    ci->mItem = sbfCacheFile_add (mCacheFile, &ci->mData);
+    ci->mItem = mSeqnumStore.add (&ci->mData);
 
     mCacheMap[partId] = ci;
-    sbfCacheFile_flush (mCacheFile);
 }
 
 template <typename CodecT>
@@ -526,9 +730,8 @@ gwcMillennium<CodecT>::reset ()
         delete mRealTimeConnection;
     mRealTimeConnection = NULL;
 
-    if (mRecoveryConnection)
-        delete mRecoveryConnection;
-    mRecoveryConnection = NULL;
+    closeRecoveries ();
+    mHeld.clear ();
 
     if (mHb)
         sbfTimer_destroy (mHb);
@@ -566,210 +769,309 @@ gwcMillennium<CodecT>::error (const string& err)
 }
 
 template <typename CodecT>
-void 
-gwcMillennium<CodecT>::handleRealTimeMsg (cdr& msg)
+bool
+gwcMillennium<CodecT>::connectRecoveries ()
 {
-    string mType;
-    msg.getString (MessageType, mType);
-    mSeenHb = true;
+    if (mRecoveries.empty ())
+        return false;
 
-    if (mType == GW_MILLENNIUM_LOGON_REPLY)
-    {
-        mMessageCbs->onAdmin (0, msg);
-        uint64_t rejectCode;
-        msg.getInteger (RejectCode, rejectCode);
-        if (rejectCode != 0)
-        {
-            stringstream ss;
-            ss << "real time logon failed code [" << rejectCode << "]";
-            error (ss.str());
-            return;
-        }
+    /* partitions are dealt out across the connections, real time messages
+       for them are held until each is downloaded */
+    mWaitingDownloads = 0;
+    for (size_t i = 0; i < mRecoveries.size (); i++)
+        mRecoveries[i]->mPartitions.clear ();
 
-        mLog->info ("logon complete for real time connection");
+    gwcMillenniumCacheMap::iterator itr = mCacheMap.begin ();
+    for (; itr != mCacheMap.end (); ++itr)
+    {
+        gwcMillenniumRecovery<CodecT>* recovery =
+            mRecoveries[mWaitingDownloads % mRecoveries.size ()];
+        recovery->mPartitions.push_back (itr->first);
+        mHeld[itr->first].clear ();
+        mWaitingDownloads++;
+    }
 
-        // initiate connection to recovery server
-        if (!mRecoveryConnection->connect ())
-        {
-            error ("failed to create tcp connection for recovery");
-            return ;
-        }
+    for (size_t i = 0; i < mRecoveries.size (); i++)
+    {
+        if (!mRecoveries[i]->mConnection->connect ())
+            return false;
+    }
 
-        // copy logon reply message for later 
-        mLogonMsg = msg;
+    mLog->info ("recovering %d partitions over %lu connections",
+                mWaitingDownloads,
+                (unsigned long)mRecoveries.size ());
+    return true;
+}
 
-        // start HB timer 
-        mHb = sbfTimer_create (sbfMw_getDefaultThread (mMw),
-                               mQueue,
-                               gwcMillennium<CodecT>::onHbTimeout,
-                               this,
-                               10.0);
+template <typename CodecT>
+void
+gwcMillennium<CodecT>::closeRecoveries ()
+{
+    for (size_t i = 0; i < mRecoveries.size (); i++)
+    {
+        if (mRecoveries[i]->mConnection)
+            delete mRecoveries[i]->mConnection;
+        mRecoveries[i]->mConnection = NULL;
+        mRecoveries[i]->mPartitions.clear ();
     }
+    mWaitingDownloads = 0;
+}
 
-    else if (mType == GW_MILLENNIUM_LOGOUT)
+template <typename CodecT>
+void
+gwcMillennium<CodecT>::requestRecovery ()
+{
+    if (mRecovery->mPartitions.empty ())
     {
-        mMessageCbs->onAdmin (0, msg);
-        // where we in a state to expect a logout
-        if (mState != GWC_CONNECTOR_WAITING_LOGOFF)
-        {
-            error ("unsolicited logoff from exchnage");
-            return;
-        }
-        reset ();
-        mSessionsCbs->onLoggedOff (0, msg);
-        loggedOffEvent ();
+        if (mWaitingDownloads == 0)
+            recovered ();
+        return;
     }
-    else if (mType == GW_MILLENNIUM_HEARTBEAT)
-    {
-        mMessageCbs->onAdmin (0, msg);
 
-        // send hb back 
-        cdr hb;
-        hb.setString (MessageType, GW_MILLENNIUM_HEARTBEAT);
-        
-        char space[1024];
-        size_t used;
-        mCodec.encode (hb, space, sizeof space, used);
-        mRealTimeConnection->send (space, used);
-    } 
-    else if (mType == GW_MILLENNIUM_REJECT)
-    {
-        handleRejectMsg (msg);
-    } 
-    else if (mType == GW_MILLENNIUM_EXECUTION_REPORT)
-    {
-        handleExecutionMsg (msg);
-    } 
-    else if (mType == GW_MILLENNIUM_ORDER_CANCEL_REJECT)
+    uint64_t partId = mRecovery->mPartitions.front ();
+
+    cdr missedmsgs;
+    missedmsgs.setString (MessageType, GW_MILLENNIUM_MISSED_MESSAGE_REQUEST);
+    missedmsgs.setInteger (AppID, partId);
+    missedmsgs.setInteger (LastMsgSeqNum, mCacheMap[partId]->mData.mSeqno);
+
+    char space[1024];
+    size_t used;
+    mCodec.encode (missedmsgs, space, sizeof space, used);
+    mRecovery->mConnection->send (space, used);
+    journalOut (space, used);
+}
+
+template <typename CodecT>
+void
+gwcMillennium<CodecT>::recoveryDone ()
+{
+    if (mRecovery->mPartitions.empty ())
+        return;
+
+    uint64_t partId = mRecovery->mPartitions.front ();
+    mRecovery->mPartitions.pop_front ();
+    mWaitingDownloads--;
+
+    mLog->info ("recovered partition %llu, %d left", 
+                (unsigned long long)partId, 
+                mWaitingDownloads);
+
+    releaseHeld (partId);
+    requestRecovery ();
+}
+
+template <typename CodecT>
+void
+gwcMillennium<CodecT>::recovered ()
+{
+    mState = GWC_CONNECTOR_READY;
+    closeRecoveries ();
+    mSessionsCbs->onLoggedOn (0, mLogonMsg);
+    loggedOnEvent ();
+}
+
+template <typename CodecT>
+gwcMillennium<CodecT>::msgHandlers::msgHandlers ()
+{
+    for (size_t i = 0; i < 256; i++)
     {
-        handleOrderCancelRejectMsg (msg);
-    } 
-    else if (mType == GW_MILLENNIUM_BUSINESS_REJECT)
+        mRealTime[i] = NULL;
+        mRecovery[i] = NULL;
+    }
+
+    mRealTime[GW_MILLENNIUM_LOGON_REPLY_C] =
+        &gwcMillennium::handleRealTimeLogonReplyMsg;
+    mRealTime[GW_MILLENNIUM_LOGOUT_C] = &gwcMillennium::handleLogoutMsg;
+    mRealTime[GW_MILLENNIUM_HEARTBEAT_C] =
+        &gwcMillennium::handleRealTimeHeartbeatMsg;
+
+    mRecovery[GW_MILLENNIUM_LOGON_REPLY_C] =
+        &gwcMillennium::handleRecoveryLogonReplyMsg;
+    mRecovery[GW_MILLENNIUM_HEARTBEAT_C] =
+        &gwcMillennium::handleRecoveryHeartbeatMsg;
+    mRecovery[GW_MILLENNIUM_MISSED_MESSAGE_REQUEST_ACK_C] =
+        &gwcMillennium::handleMissedMessageRequestAckMsg;
+    mRecovery[GW_MILLENNIUM_MISSED_MESSAGE_REPORT_C] =
+        &gwcMillennium::handleMissedMessageReportMsg;
+
+    /* application messages are handled the same on both connections */
+    msgHandler* tables[] = { mRealTime, mRecovery };
+    for (size_t i = 0; i < 2; i++)
     {
-        handleBusinessRejectMsg (msg);
+        tables[i][GW_MILLENNIUM_REJECT_C] = &gwcMillennium::handleRejectMsg;
+        tables[i][GW_MILLENNIUM_EXECUTION_REPORT_C] =
+            &gwcMillennium::handleExecutionMsg;
+        tables[i][GW_MILLENNIUM_ORDER_CANCEL_REJECT_C] =
+            &gwcMillennium::handleOrderCancelRejectMsg;
+        tables[i][GW_MILLENNIUM_BUSINESS_REJECT_C] =
+            &gwcMillennium::handleBusinessRejectMsg;
     }
 }
 
+template <typename CodecT>
+const typename gwcMillennium<CodecT>::msgHandlers gwcMillennium<CodecT>::sHandlers;
+
 template <typename CodecT>
 void 
-gwcMillennium<CodecT>::handleRecoveryMsg (cdr& msg)
+gwcMillennium<CodecT>::handleRealTimeMsg (const LseHeader* hdr, cdr& msg)
 {
-    string mType;
-    msg.getString (MessageType, mType);
+    mSeenHb = true;
 
-    if (mType == GW_MILLENNIUM_LOGON_REPLY)
-    {
-        mMessageCbs->onAdmin (0, msg);
+    msgHandler handler = sHandlers.mRealTime[(uint8_t)hdr->mMessageType];
+    if (handler != NULL)
+        (this->*handler) (msg);
+}
 
-        uint64_t rejectCode;
-        msg.getInteger (RejectCode, rejectCode);
-        if (rejectCode != 0)
-        {
-            stringstream ss;
-            ss << "recovery logon failed code [" << rejectCode << "]";
-            error (ss.str ());
-            return;
-        }
+template <typename CodecT>
+void 
+gwcMillennium<CodecT>::handleRecoveryMsg (const LseHeader* hdr, cdr& msg)
+{
+    msgHandler handler = sHandlers.mRecovery[(uint8_t)hdr->mMessageType];
+    if (handler != NULL)
+        (this->*handler) (msg);
+}
 
-        mLog->info ("logon complete for recovery connection");
-    
-        cdr missedmsgs;
-        missedmsgs.setString (MessageType, GW_MILLENNIUM_MISSED_MESSAGE_REQUEST);
-        gwcMillenniumCacheMap::iterator itr = mCacheMap.begin ();
-        for (; itr != mCacheMap.end(); ++itr)
-        {
-            missedmsgs.setInteger (AppID, itr->first);
-            missedmsgs.setInteger (LastMsgSeqNum, itr->second->mData.mSeqno);
-
-            char space[1024];
-            size_t used;
-            mCodec.encode (missedmsgs, space, sizeof space, used);
-            mRecoveryConnection->send (space, used);
-            mWaitingDownloads++;
-        }
-        
-        mLog->info ("send %d recovery requests", mWaitingDownloads);
-        if (mWaitingDownloads == 0)
-        {
-            mState = GWC_CONNECTOR_READY;
-            delete mRecoveryConnection;
-            mRecoveryConnection = NULL;
-            mSessionsCbs->onLoggedOn (0, mLogonMsg);
-            loggedOnEvent ();
-        }
-    }
-    else if (mType == GW_MILLENNIUM_HEARTBEAT)
+template <typename CodecT>
+void 
+gwcMillennium<CodecT>::handleRealTimeLogonReplyMsg (cdr& msg)
+{
+    mMessageCbs->onAdmin (0, msg);
+    uint64_t rejectCode;
+    msg.getInteger (RejectCode, rejectCode);
+    if (rejectCode != 0)
     {
-        mMessageCbs->onAdmin (0, msg);
-
-        cdr hb;
-        hb.setString (MessageType, GW_MILLENNIUM_HEARTBEAT);
-        
-        char space[1024];
-        size_t used;
-        mCodec.encode (hb, space, sizeof space, used);
-        mRecoveryConnection->send (space, used);
+        stringstream ss;
+        ss << "real time logon failed code [" << rejectCode << "]";
+        error (ss.str());
+        return;
     }
-    else if (mType == GW_MILLENNIUM_MISSED_MESSAGE_REQUEST_ACK)
-    {
-        mMessageCbs->onAdmin (0, msg);
 
-        uint64_t rType;
-        msg.getInteger (ResponseType, rType);
-        if (rType != 0)
-        {
-            mLog->warn ("missed message ack response type (%lld) some messages might be missing", 
-                        (signed long long)rType);
-            mWaitingDownloads--; 
-            if (mWaitingDownloads == 0)
-            {
-                mState = GWC_CONNECTOR_READY;
-                delete mRecoveryConnection;
-                mRecoveryConnection = NULL;
-                mSessionsCbs->onLoggedOn (0, mLogonMsg);
-                loggedOnEvent ();
-            }
-        }
-    }
-    else if (mType == GW_MILLENNIUM_MISSED_MESSAGE_REPORT)
+    mLog->info ("logon complete for real time connection");
+    if (mReplaying)
+        return;
+
+    // initiate connections to recovery server
+    if (!connectRecoveries ())
     {
-        mMessageCbs->onAdmin (0, msg);
+        error ("failed to create tcp connection for recovery");
+        return ;
+    }
 
-        uint64_t rType;
-        msg.getInteger (ResponseType, rType);
+    // copy logon reply message for later 
+    mLogonMsg = msg;
 
-        if (rType != 0)
-            mLog->warn ("missed message report response type (%lld) some messages might be missing", 
-                        (signed long long)rType);
+    // start HB timer 
+    mHb = sbfTimer_create (sbfMw_getDefaultThread (mMw),
+                           mQueue,
+                           gwcMillennium<CodecT>::onHbTimeout,
+                           this,
+                           10.0);
+}
 
-        mWaitingDownloads--; 
-        if (mWaitingDownloads == 0)
-        {
-            mState = GWC_CONNECTOR_READY;
-            delete mRecoveryConnection;
-            mRecoveryConnection = NULL;
-            mSessionsCbs->onLoggedOn (0, mLogonMsg);
-            loggedOnEvent ();
-        }
-    } 
-    else if (mType == GW_MILLENNIUM_REJECT)
-    {
-        handleRejectMsg (msg);
-    } 
-    else if (mType == GW_MILLENNIUM_EXECUTION_REPORT)
+template <typename CodecT>
+void 
+gwcMillennium<CodecT>::handleLogoutMsg (cdr& msg)
+{
+    mMessageCbs->onAdmin (0, msg);
+    // where we in a state to expect a logout
+    if (mState != GWC_CONNECTOR_WAITING_LOGOFF)
     {
-        handleExecutionMsg (msg);
-    } 
-    else if (mType == GW_MILLENNIUM_ORDER_CANCEL_REJECT)
+        error ("unsolicited logoff from exchnage");
+        return;
+    }
+    reset ();
+    mSessionsCbs->onLoggedOff (0, msg);
+    loggedOffEvent ();
+}
+
+template <typename CodecT>
+void 
+gwcMillennium<CodecT>::handleRealTimeHeartbeatMsg (cdr& msg)
+{
+    mMessageCbs->onAdmin (0, msg);
+    if (mReplaying)
+        return;
+
+    // send hb back 
+    cdr hb;
+    hb.setString (MessageType, GW_MILLENNIUM_HEARTBEAT);
+    
+    char space[1024];
+    size_t used;
+    mCodec.encode (hb, space, sizeof space, used);
+    mRealTimeConnection->send (space, used);
+    journalOut (space, used);
+}
+
+template <typename CodecT>
+void 
+gwcMillennium<CodecT>::handleRecoveryLogonReplyMsg (cdr& msg)
+{
+    mMessageCbs->onAdmin (0, msg);
+
+    uint64_t rejectCode;
+    msg.getInteger (RejectCode, rejectCode);
+    if (rejectCode != 0)
     {
-        handleOrderCancelRejectMsg (msg);
-    } 
-    else if (mType == GW_MILLENNIUM_BUSINESS_REJECT)
+        stringstream ss;
+        ss << "recovery logon failed code [" << rejectCode << "]";
+        error (ss.str ());
+        return;
+    }
+
+    mLog->info ("logon complete for recovery connection");
+    requestRecovery ();
+}
+
+template <typename CodecT>
+void 
+gwcMillennium<CodecT>::handleRecoveryHeartbeatMsg (cdr& msg)
+{
+    mMessageCbs->onAdmin (0, msg);
+
+    cdr hb;
+    hb.setString (MessageType, GW_MILLENNIUM_HEARTBEAT);
+    
+    char space[1024];
+    size_t used;
+    mCodec.encode (hb, space, sizeof space, used);
+    mRecovery->mConnection->send (space, used);
+    journalOut (space, used);
+}
+
+template <typename CodecT>
+void 
+gwcMillennium<CodecT>::handleMissedMessageRequestAckMsg (cdr& msg)
+{
+    mMessageCbs->onAdmin (0, msg);
+
+    uint64_t rType;
+    msg.getInteger (ResponseType, rType);
+    if (rType != 0)
     {
-        handleBusinessRejectMsg (msg);
+        mLog->warn ("missed message ack response type (%lld) some messages might be missing", 
+                    (signed long long)rType);
+        recoveryDone ();
     }
 }
 
+template <typename CodecT>
+void 
+gwcMillennium<CodecT>::handleMissedMessageReportMsg (cdr& msg)
+{
+    mMessageCbs->onAdmin (0, msg);
+
+    uint64_t rType;
+    msg.getInteger (ResponseType, rType);
+
+    if (rType != 0)
+        mLog->warn ("missed message report response type (%lld) some messages might be missing", 
+                    (signed long long)rType);
+
+    recoveryDone ();
+}
+
 template <typename CodecT>
 void 
 gwcMillennium<CodecT>::handleRejectMsg (cdr& msg)
@@ -852,7 +1154,15 @@ gwcMillennium<CodecT>::init (gwcSessionCallbacks* sessionCbs,
                              const neueda::properties& props)
 {
     mSessionsCbs = sessionCbs;
-    mMessageCbs = messageCbs;
+    if (!initLatency (props, messageCbs))
+        return false;
+
+    if (!initOrderCache (props))
+        return false;
+    if (!initRisk (props))
+        return false;
+    if (mTypedCbs != NULL && !typedCallbacksAllowed ())
+        return false;
 
     /* get props
        - seqno_cache default millennium.seqno.cache
@@ -890,16 +1200,27 @@ gwcMillennium<CodecT>::init (gwcSessionCallbacks* sessionCbs,
         return false;
     }
 
+    bool valid;
+    if (props.get ("recovery_connections", mRecoveryConnections, valid) &&
+        (!valid || mRecoveryConnections < 0))
+    {
+        mLog->err ("failed to parse recovery_connections");
+        return false;
+    }
+
+    if (!initSeqnumStore (props))
+        return false;
+
     int created;
-    mCacheFile = sbfCacheFile_open (cacheFileName.c_str (),
-                                    sizeof (gwcMillenniumSeqNum),
-                                    0, 
-                                    &created,
-                                    gwcMillennium<CodecT>::cacheFileItemCb,
-                                    this);
-    if (mCacheFile == NULL)
+    string err;
+    if (!mSeqnumStore.open (cacheFileName,
+                            sizeof (gwcMillenniumSeqNum),
+                            &created,
+                            gwcMillennium<CodecT>::cacheFileItemCb,
+                            this,
+                            err))
     {
-        mLog->err ("failed to create seqno cache file");
+        mLog->err ("failed to create seqno cache file: %s", err.c_str ());
         return false;
     }
     if (created)
@@ -919,16 +1240,22 @@ gwcMillennium<CodecT>::init (gwcSessionCallbacks* sessionCbs,
         mRawEnabled = true;
     }
 
-    sbfKeyValue kv = sbfKeyValue_create ();
-    mMw = sbfMw_create (mSbfLog, kv);
-    sbfKeyValue_destroy (kv);
+    if (!initDispatch (props))
+        return false;
+
+    if (!initLog (props, false))
+        return false;
+
+    if (!initJournal (props, cacheFileName))
+        return false;
+
+    mMw = createMw ();
     if (mMw == NULL)
     {
         mLog->err ("failed to create mw");
         return false;
     }
 
-    // could add a prop to make queue spin for max performance
     mQueue = sbfQueue_create (mMw, "default");
     if (mQueue == NULL)
     {
@@ -936,6 +1263,9 @@ gwcMillennium<CodecT>::init (gwcSessionCallbacks* sessionCbs,
         return false;
     }
 
+    if (!initThrottle (props, mMw, mQueue))
+        return false;
+
     // start to dispatch 
     if (sbfThread_create (&mThread, gwcMillennium<CodecT>::dispatchCb, this) != 0)
     {
@@ -965,13 +1295,32 @@ gwcMillennium<CodecT>::start (bool reset)
                                                 false,
                                                 true, // disable-nagles
                                                 &mRealTimeConnectionDelegate);
-    mRecoveryConnection = new SbfTcpConnection (mSbfLog,
-                                                sbfMw_getDefaultThread (mMw),
-                                                mQueue,
-                                                &mRecoveryHost,
-                                                false,
-                                                true, // disable-nagles
-                                                &mRecoveryConnectionDelegate);
+
+    /* a recovery connection per partition known so far, up to 
+       recovery_connections */
+    for (size_t i = 0; i < mRecoveries.size (); i++)
+        delete mRecoveries[i];
+    mRecoveries.clear ();
+    mRecovery = NULL;
+
+    size_t n = mCacheMap.size ();
+    if (mRecoveryConnections > 0 && n > (size_t)mRecoveryConnections)
+        n = mRecoveryConnections;
+    if (n == 0)
+        n = 1;
+    for (size_t i = 0; i < n; i++)
+    {
+        gwcMillenniumRecovery<CodecT>* recovery = 
+            new gwcMillenniumRecovery<CodecT> (this);
+        recovery->mConnection = new SbfTcpConnection (mSbfLog,
+                                                      sbfMw_getDefaultThread (mMw),
+                                                      mQueue,
+                                                      &mRecoveryHost,
+                                                      false,
+                                                      true, // disable-nagles
+                                                      &recovery->mDelegate);
+        mRecoveries.push_back (recovery);
+    }
     if (!mRealTimeConnection->connect ())
     {
         mLog->err ("failed to create connection to real time host");
@@ -1006,6 +1355,7 @@ gwcMillennium<CodecT>::stop ()
 
     codec.encode (logoff, space, sizeof space, used);
     mRealTimeConnection->send (space, used);
+    journalOut (space, used);
 
     return true;
 }
@@ -1105,6 +1455,8 @@ template <typename CodecT>
 bool
 gwcMillennium<CodecT>::sendOrder (gwcOrder& order)
 {
+    gwcLatencyScope latency (mLatency);
+
     if (!mapOrderFields (order))
         return false;
 
@@ -1194,6 +1546,8 @@ template <>
 bool
 gwcMillennium<osloCodec>::sendOrder (gwcOrder& order)
 {
+    gwcLatencyScope latency (mLatency);
+
     if (!mapOrderFields (order))
         return false;
 
@@ -1295,6 +1649,8 @@ template <>
 bool
 gwcMillennium<lseCodec>::sendOrder (gwcOrder& order)
 {
+    gwcLatencyScope latency (mLatency);
+
     if (!mapOrderFields (order))
         return false;
 
@@ -1304,15 +1660,26 @@ gwcMillennium<lseCodec>::sendOrder (gwcOrder& order)
 template <typename CodecT>
 bool 
 gwcMillennium<CodecT>::sendOrder (cdr& order)
+{
+    gwcLatencyScope latency (mLatency);
+
+    prepareOrder (order);
+    return sendChecked (order);
+}
+
+template <typename CodecT>
+void
+gwcMillennium<CodecT>::prepareOrder (cdr& order)
 {
     order.setString (MessageType, GW_MILLENNIUM_NEW_ORDER);
-    return sendMsg (order);
 }
 
 template <typename CodecT>
 bool 
 gwcMillennium<CodecT>::sendCancel (gwcOrder& cancel)
 {
+    gwcLatencyScope latency (mLatency);
+
     if (!mapOrderFields (cancel))
         return false;
 
@@ -1322,15 +1689,26 @@ gwcMillennium<CodecT>::sendCancel (gwcOrder& cancel)
 template <typename CodecT>
 bool 
 gwcMillennium<CodecT>::sendCancel (cdr& cancel)
+{
+    gwcLatencyScope latency (mLatency);
+
+    prepareCancel (cancel);
+    return sendPaced (cancel);
+}
+
+template <typename CodecT>
+void
+gwcMillennium<CodecT>::prepareCancel (cdr& cancel)
 {
     cancel.setString (MessageType, GW_MILLENNIUM_ORDER_CANCEL_REQUEST);
-    return sendMsg (cancel);
 }
 
 template <typename CodecT>
 bool 
 gwcMillennium<CodecT>::sendModify (gwcOrder& modify)
 {
+    gwcLatencyScope latency (mLatency);
+
     if (!mapOrderFields (modify))
         return false;
 
@@ -1340,15 +1718,26 @@ gwcMillennium<CodecT>::sendModify (gwcOrder& modify)
 template <typename CodecT>
 bool 
 gwcMillennium<CodecT>::sendModify (cdr& modify)
+{
+    gwcLatencyScope latency (mLatency);
+
+    prepareModify (modify);
+    return sendModifyChecked (modify);
+}
+
+template <typename CodecT>
+void
+gwcMillennium<CodecT>::prepareModify (cdr& modify)
 {
     modify.setString (MessageType, GW_MILLENNIUM_ORDER_CANCEL_REPLACE_REQUEST);
-    return sendMsg (modify);
 }
 
 template <typename CodecT>
 bool 
 gwcMillennium<CodecT>::sendMsg (cdr& msg)
 {
+    gwcLatencyScope latency (mLatency);
+
     char space[1024];
     size_t used;
     
@@ -1366,8 +1755,70 @@ gwcMillennium<CodecT>::sendMsg (cdr& msg)
         mLog->err ("failed to construct message [%s]", codec.getLastError ().c_str ());
         return false;
     }
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_ENCODED, latencyKey ((LseHeader*)space));
 
     mRealTimeConnection->send (space, used);
+    journalOut (space, used);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN);
+    return true;
+}
+
+template <typename CodecT>
+size_t
+gwcMillennium<CodecT>::onReplay (void* data, size_t size)
+{
+    return mRealTimeConnectionDelegate.onRead (data, size);
+}
+
+template <typename CodecT>
+bool 
+gwcMillennium<CodecT>::sendMsgs (cdr** msgs, size_t n)
+{
+    gwcLatencyScope latency (mLatency);
+
+    vector<char> space (n * GWC_BATCH_MSG_SIZE);
+    vector<size_t> sizes (n);
+    size_t total = 0;
+    size_t used;
+    
+    // use a codec from the stack gets around threading issues
+    CodecT codec;
+
+    if (mState != GWC_CONNECTOR_READY)
+    {
+        mLog->warn ("gwc not ready to send messages");
+        return false;
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (codec.encode (*msgs[i], 
+                          &space[total], 
+                          space.size () - total, 
+                          used) != GW_CODEC_SUCCESS)
+        {
+            mLog->err ("failed to construct batch message [%s]",
+                       codec.getLastError ().c_str ());
+            return false;
+        }
+        sizes[i] = used;
+        total += used;
+    }
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_ENCODED, 
+                                latencyKey ((LseHeader*)&space[0]));
+
+    mRealTimeConnection->send (&space[0], total);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN);
+    size_t offset = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        journalOut (&space[offset], sizes[i]);
+        offset += sizes[i];
+    }
     return true;
 }
 
@@ -1375,6 +1826,8 @@ template <typename CodecT>
 bool
 gwcMillennium<CodecT>::sendRaw (void* data, size_t len)
 {
+    gwcLatencyScope latency (mLatency);
+
     if (!mRawEnabled)
     {
         mLog->warn ("raw send interface not enabled");
@@ -1388,6 +1841,120 @@ gwcMillennium<CodecT>::sendRaw (void* data, size_t len)
     }
  
     mRealTimeConnection->send (data, len);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN, latencyKey ((LseHeader*)data));
+    journalOut (data, len);
+    return true;
+}
+
+template <typename CodecT>
+bool
+gwcMillennium<CodecT>::getClOrdId (const cdr& msg, bool orig, std::string& id) const
+{
+    return getIdField (msg, orig ? OriginalClientOrderID : ClientOrderID, id);
+}
+
+template <typename CodecT>
+void
+gwcMillennium<CodecT>::getOrderFields (const cdr& msg, gwcOrderFields& fields) const
+{
+    getIdField (msg, OrderID, fields.mOrderId);
+    fields.mHasOrderQty = getNumberField (msg, OrderQty, fields.mOrderQty);
+    fields.mHasLeavesQty = getNumberField (msg, LeavesQty, fields.mLeavesQty);
+    fields.mHasLastQty = getNumberField (msg, ExecutedQty, fields.mLastQty);
+    fields.mHasLastPx = getNumberField (msg, ExecutedPrice, fields.mLastPx);
+}
+
+template <typename CodecT>
+void
+gwcMillennium<CodecT>::getRiskFields (const cdr& msg, gwcRiskFields& fields) const
+{
+    int64_t side;
+
+    getIdField (msg, InstrumentID, fields.mInstrument);
+    getIdField (msg, Account, fields.mAccount);
+    fields.mHasSide = msg.getInteger (Side, side);
+    fields.mBuy = fields.mHasSide && side == 1;
+    fields.mHasQty = getNumberField (msg, OrderQty, fields.mQty);
+    fields.mHasPrice = getNumberField (msg, LimitPrice, fields.mPrice);
+}
+
+template <typename CodecT>
+bool
+gwcMillennium<CodecT>::createTemplate (gwcOrderTemplateType type,
+                                       gwcOrder& msg,
+                                       gwcOrderTemplate& tmpl)
+{
+    if (!mapOrderFields (msg))
+        return false;
+
+    switch (type)
+    {
+    case GWC_TEMPLATE_ORDER:
+        msg.setString (MessageType, GW_MILLENNIUM_NEW_ORDER);
+        break;
+    case GWC_TEMPLATE_CANCEL:
+        msg.setString (MessageType, GW_MILLENNIUM_ORDER_CANCEL_REQUEST);
+        break;
+    case GWC_TEMPLATE_MODIFY:
+        msg.setString (MessageType, GW_MILLENNIUM_ORDER_CANCEL_REPLACE_REQUEST);
+        break;
+    }
+
+    /* prices are 8 implied decimals, client order ids are alpha(20) */
+    CodecT codec;
+    tmpl.reset (this, type);
+    tmpl.setSideValues (1, 2);
+    if (!tmpl.encode (codec, msg) ||
+        !tmpl.locate (codec, msg, GWC_TEMPLATE_FIELD_PRICE, LimitPrice,
+                      GWC_TEMPLATE_ENCODING_LE, 8, 100000000.0, 100000000.0) ||
+        !tmpl.locate (codec, msg, GWC_TEMPLATE_FIELD_QTY, OrderQty,
+                      GWC_TEMPLATE_ENCODING_LE, 4, 0, 1) ||
+        !tmpl.locate (codec, msg, GWC_TEMPLATE_FIELD_SIDE, Side,
+                      GWC_TEMPLATE_ENCODING_LE, 1, 0, 1) ||
+        !tmpl.locate (codec, msg, GWC_TEMPLATE_FIELD_CLORDID, ClientOrderID,
+                      GWC_TEMPLATE_ENCODING_ALPHA, 20, 0, 1) ||
+        !tmpl.locate (codec, msg, GWC_TEMPLATE_FIELD_ORIG_CLORDID,
+                      OriginalClientOrderID, GWC_TEMPLATE_ENCODING_ALPHA, 20, 0, 1))
+    {
+        mLog->err ("failed to construct template [%s]",
+                   tmpl.getLastError ().c_str ());
+        tmpl.reset (NULL, type);
+        return false;
+    }
+
+    return true;
+}
+
+template <typename CodecT>
+bool
+gwcMillennium<CodecT>::sendTemplate (gwcOrderTemplate& tmpl)
+{
+    gwcLatencyScope latency (mLatency);
+
+    if (!tmpl.isOwner (this))
+    {
+        mLog->warn ("template not created by this connector");
+        return false;
+    }
+
+    if (!riskTemplate ())
+        return false;
+
+    if (!throttleTemplate ())
+        return false;
+
+    if (mState != GWC_CONNECTOR_READY)
+    {
+        mLog->warn ("gwc not ready to send messages");
+        return false;
+    }
+
+    mRealTimeConnection->send (tmpl.getData (), tmpl.getSize ());
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN, 
+                                latencyKey ((LseHeader*)tmpl.getData ()));
+    journalOut (tmpl.getData (), tmpl.getSize ());
     return true;
 }
 
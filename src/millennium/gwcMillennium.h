@@ -14,7 +14,13 @@
 #include "jseCodec.h"
 #include "borsaitalianaCodec.h"
 
+#include "TurquoisePackets.h"
+#include "OsloPackets.h"
+#include "LsePackets.h"
+
+#include <deque>
 #include <map>
+#include <vector>
 
 using namespace std;
 using namespace neueda;
@@ -61,7 +67,57 @@ struct gwcMillenniumCacheItem
     gwcMillenniumSeqNum mData;
 };
 
+/* Wire packets for each venue, venues without their own packets share lse */
+template <typename CodecT>
+struct gwcMillenniumPackets
+{
+    typedef LseExecutionReport   ExecutionReport;
+    typedef LseOrderCancelReject OrderCancelReject;
+    typedef LseBusinessReject    BusinessReject;
+};
+
+template <>
+struct gwcMillenniumPackets<osloCodec>
+{
+    typedef OsloExecutionReport   ExecutionReport;
+    typedef OsloOrderCancelReject OrderCancelReject;
+    typedef OsloBusinessReject    BusinessReject;
+};
+
+template <>
+struct gwcMillenniumPackets<turquoiseCodec>
+{
+    typedef TurquoiseExecutionReport   ExecutionReport;
+    typedef TurquoiseOrderCancelReject OrderCancelReject;
+    typedef TurquoiseBusinessReject    BusinessReject;
+};
+
+/* Typed message callbacks, when set these are called in place of the cdr 
+   callbacks for execution reports and rejects. The message is a view over 
+   the receive buffer and is only valid for the duration of the callback */
+template <typename CodecT>
+class gwcMillenniumTypedCallbacks
+{
+public:
+    typedef typename gwcMillenniumPackets<CodecT>::ExecutionReport ExecutionReport;
+    typedef typename gwcMillenniumPackets<CodecT>::OrderCancelReject OrderCancelReject;
+    typedef typename gwcMillenniumPackets<CodecT>::BusinessReject BusinessReject;
+
+    /* dtor */
+    virtual ~gwcMillenniumTypedCallbacks () {};
+
+    /* On execution report, acks/fills/done/rejects */
+    virtual void onExecutionReport (uint64_t seqno, const ExecutionReport& msg) {};
+
+    /* On cancel rejected */
+    virtual void onOrderCancelReject (uint64_t seqno, const OrderCancelReject& msg) {};
+
+    /* On business reject */
+    virtual void onBusinessReject (uint64_t seqno, const BusinessReject& msg) {};
+};
+
 template <typename CodecT> class gwcMillennium;
+template <typename CodecT> struct gwcMillenniumRecovery;
 template <typename CodecT>
 class gwcMillenniumRealTimeConnectionDelegate: public SbfTcpConnectionDelegate
 {
@@ -86,7 +142,8 @@ class gwcMillenniumRecoveryConnectionDelegate: public SbfTcpConnectionDelegate
     friend class gwcMillennium<CodecT>;
     
 public:
-    gwcMillenniumRecoveryConnectionDelegate (gwcMillennium<CodecT>* gwc);
+    gwcMillenniumRecoveryConnectionDelegate (gwcMillennium<CodecT>* gwc,
+                                             gwcMillenniumRecovery<CodecT>* recovery);
 
     virtual void onReady ();
 
@@ -95,7 +152,29 @@ public:
     virtual size_t onRead (void* data, size_t size);
 
 private:
-    gwcMillennium<CodecT>* mGwc;
+    gwcMillennium<CodecT>*         mGwc;
+    gwcMillenniumRecovery<CodecT>* mRecovery;
+};
+
+/* A connection to the recovery host. Partitions are requested on it one at 
+   a time so the report that ends a download is for the one at the front */
+template <typename CodecT>
+struct gwcMillenniumRecovery
+{
+    gwcMillenniumRecovery (gwcMillennium<CodecT>* gwc) :
+        mConnection (NULL),
+        mDelegate (gwc, this)
+    { }
+
+    ~gwcMillenniumRecovery ()
+    {
+        if (mConnection)
+            delete mConnection;
+    }
+
+    SbfTcpConnection*                               mConnection;
+    gwcMillenniumRecoveryConnectionDelegate<CodecT> mDelegate;
+    deque<uint64_t>                                 mPartitions;
 };
 
 template <typename CodecT>
@@ -106,6 +185,7 @@ class gwcMillennium : public gwcConnector
     
 public:
     typedef map<uint64_t, gwcMillenniumCacheItem*> gwcMillenniumCacheMap;
+    typedef map<uint64_t, vector<char> > gwcMillenniumHeldMap;
 
     gwcMillennium (neueda::logger* log);
     virtual ~gwcMillennium ();
@@ -133,14 +213,42 @@ public:
 
     virtual bool sendRaw (void* data, size_t len);
 
+    virtual bool getClOrdId (const cdr& msg, bool orig, std::string& id) const;
+
+    virtual void getOrderFields (const cdr& msg, gwcOrderFields& fields) const;
+
+    virtual void getRiskFields (const cdr& msg, gwcRiskFields& fields) const;
+
+    virtual bool createTemplate (gwcOrderTemplateType type,
+                                 gwcOrder& msg,
+                                 gwcOrderTemplate& tmpl);
+    virtual bool sendTemplate (gwcOrderTemplate& tmpl);
+
+    /* Set typed callbacks for execution reports and rejects, NULL to go 
+       back to cdr callbacks. False if the connector has an order cache or
+       risk checks */
+    bool setTypedCallbacks (gwcMillenniumTypedCallbacks<CodecT>* typedCbs)
+    {
+        if (typedCbs != NULL && !typedCallbacksAllowed ())
+            return false;
+
+        mTypedCbs = typedCbs;
+        return true;
+    }
+
 protected:
+    virtual void prepareOrder (cdr& order);
+    virtual void prepareCancel (cdr& cancel);
+    virtual void prepareModify (cdr& modify);
+    virtual bool sendMsgs (cdr** msgs, size_t n);
+    virtual size_t onReplay (void* data, size_t size);
+
     SbfTcpConnection*         mRealTimeConnection;
     gwcMillenniumRealTimeConnectionDelegate<CodecT>  mRealTimeConnectionDelegate;
     
-    SbfTcpConnection*         mRecoveryConnection;
-    gwcMillenniumRecoveryConnectionDelegate<CodecT>  mRecoveryConnectionDelegate;
+    /* Partitions are recovered over these concurrently */
+    vector<gwcMillenniumRecovery<CodecT>*> mRecoveries;
     
-    sbfCacheFile          mCacheFile;
     sbfMw                 mMw;
     sbfQueue              mQueue;
     sbfThread             mThread;
@@ -152,6 +260,16 @@ private:
     void error (const string& err);
     bool isSessionMessage (LseHeader* hdr);
     int getSeqnum (LseHeader* hdr, uint8_t& appId);
+    uint32_t latencyKey (const LseHeader* hdr);
+    bool handleTypedMsg (LseHeader* hdr);
+    bool holdRealTimeMsg (LseHeader* hdr, size_t size);
+    void releaseHeld (uint64_t partId);
+    bool isRecovered (LseHeader* hdr);
+    bool connectRecoveries ();
+    void closeRecoveries ();
+    void requestRecovery ();
+    void recoveryDone ();
+    void recovered ();
     bool mapOrderFields (gwcOrder& order);
 
     // handle state
@@ -159,18 +277,40 @@ private:
     void onRealTimeConnectionError ();
     size_t onRealTimeConnectionRead (void* data, size_t size);
     
-    void onRecoveryConnectionReady ();
-    void onRecoveryConnectionError ();
-    size_t onRecoveryConnectionRead (void* data, size_t size);
+    void onRecoveryConnectionReady (gwcMillenniumRecovery<CodecT>* recovery);
+    void onRecoveryConnectionError (gwcMillenniumRecovery<CodecT>* recovery);
+    size_t onRecoveryConnectionRead (gwcMillenniumRecovery<CodecT>* recovery,
+                                     void* data,
+                                     size_t size);
     
-    // handle messages 
-    void handleRealTimeMsg (cdr& msg);
-    void handleRecoveryMsg (cdr& msg);
+    // handle messages, dispatched on the wire message type
+    void handleRealTimeMsg (const LseHeader* hdr, cdr& msg);
+    void handleRecoveryMsg (const LseHeader* hdr, cdr& msg);
+    void handleRealTimeLogonReplyMsg (cdr& msg);
+    void handleRealTimeHeartbeatMsg (cdr& msg);
+    void handleLogoutMsg (cdr& msg);
+    void handleRecoveryLogonReplyMsg (cdr& msg);
+    void handleRecoveryHeartbeatMsg (cdr& msg);
+    void handleMissedMessageRequestAckMsg (cdr& msg);
+    void handleMissedMessageReportMsg (cdr& msg);
     void handleRejectMsg (cdr& msg);
     void handleExecutionMsg (cdr& msg); 
     void handleOrderCancelRejectMsg (cdr& msg);
     void handleBusinessRejectMsg (cdr& msg);
 
+    typedef void (gwcMillennium::*msgHandler) (cdr& msg);
+
+    /* Handlers indexed by message type for each connection, NULL for types
+       that are ignored. Built once per venue when the library loads */
+    struct msgHandlers
+    {
+        msgHandlers ();
+
+        msgHandler mRealTime[256];
+        msgHandler mRecovery[256];
+    };
+    static const msgHandlers sHandlers;
+
     static void* dispatchCb (void* closure);
     static sbfError cacheFileItemCb (sbfCacheFile file, 
                                      sbfCacheFileItem item, 
@@ -190,9 +330,27 @@ private:
 
     CodecT                mCodec;
 
+    /* Inbound messages are decoded into these, one per connection, cleared
+       before each decode rather than constructed per read. clear () still
+       frees the field nodes, the codec allocates them again */
+    cdr                   mRealTimeMsg;
+    cdr                   mRecoveryMsg;
+
     bool                  mSeenHb;
     int                   mWaitingDownloads;
 
+    /* Most recovery connections, 0 for one per partition */
+    int                   mRecoveryConnections;
+
+    /* Recovery connection being read from */
+    gwcMillenniumRecovery<CodecT>* mRecovery;
+
+    /* Real time application messages for partitions still being recovered,
+       delivered in order once the partition's download is done */
+    gwcMillenniumHeldMap  mHeld;
+
     cdr                   mLogonMsg;
+
+    gwcMillenniumTypedCallbacks<CodecT>* mTypedCbs;
 };
 
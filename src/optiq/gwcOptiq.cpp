@@ -6,6 +6,7 @@
 #include "fields.h"
 
 #include <sstream>
+#include <vector>
 
 gwcOptiqTcpConnectionDelegate::gwcOptiqTcpConnectionDelegate (gwcOptiq* gwc)
     : SbfTcpConnectionDelegate (),
@@ -32,7 +33,7 @@ gwcOptiqTcpConnectionDelegate::onRead (void* data, size_t size)
 }
 
 extern "C" gwcConnector*
-getConnector (neueda::logger* log, const neueda::properties& props)
+GWC_CONNECTOR_ENTRY (optiq) (neueda::logger* log, const neueda::properties& props)
 {
     return new gwcOptiq (log);
 }
@@ -41,7 +42,6 @@ gwcOptiq::gwcOptiq (neueda::logger* log) :
     gwcConnector (log),
     mTcpConnection (NULL),
     mTcpConnectionDelegate (this),
-    mCacheFile (NULL),
     mCacheItem (NULL),        
     mMw (NULL),
     mQueue (NULL),
@@ -59,14 +59,15 @@ gwcOptiq::gwcOptiq (neueda::logger* log) :
 
 gwcOptiq::~gwcOptiq ()
 {
+    stopLog ();
+    stopThrottle ();
     if (mReconnectTimer)
         sbfTimer_destroy (mReconnectTimer);
     if (mHb)
         sbfTimer_destroy (mHb);
     if (mTcpConnection)
         delete mTcpConnection;
-    if (mCacheFile)
-        sbfCacheFile_close (mCacheFile);
+    mSeqnumStore.close ();
     if (mQueue)
         sbfQueue_destroy (mQueue);
     if (mDispatching)
@@ -136,6 +137,7 @@ gwcOptiq::onTcpConnectionReady ()
     }
 
     mTcpConnection->send (space, used);
+    journalOut (space, used);
 }
 
 void 
@@ -147,8 +149,9 @@ gwcOptiq::onTcpConnectionError ()
 size_t 
 gwcOptiq::onTcpConnectionRead (void* data, size_t size)
 {
-    size_t left = size;
-    cdr msg;
+    size_t   left = size;
+    cdr&     msg = mInboundMsg;
+    uint64_t read = mLatency ? gwcLatency_now () : 0;
 
     if (mRawEnabled)
     {
@@ -172,6 +175,7 @@ gwcOptiq::onTcpConnectionRead (void* data, size_t size)
             if (isSessionMessage(header->getTemplateId()))
             {
                 size_t used = 0;
+                msg.clear ();
                 switch(mCodec.decode (msg, data, left, used))
                 { 
                     case GW_CODEC_ERROR:
@@ -186,7 +190,14 @@ gwcOptiq::onTcpConnectionRead (void* data, size_t size)
                         return size;
 
                     case GW_CODEC_SUCCESS:
+                        journalIn (data, used);
+                        logMsg (GWC_LOG_LEVEL_DEBUG, "msg in..", msg, data, used);
+                        if (mLatency)
+                            mLatency->inboundDecoded (
+                                gwcLatency_key (header->getTemplateId ()), read);
                         handleTcpMsg (msg);
+                        if (mLatency)
+                            mLatency->inboundDone ();
                         left -= used;
                         break;
                 }
@@ -200,8 +211,14 @@ gwcOptiq::onTcpConnectionRead (void* data, size_t size)
 
             mSeqnums.mInbound = seqNum;
             mSeenHb = true;
-            
+            journalIn (data, frameLength);
+
+            if (mLatency)
+                mLatency->inboundDecoded (
+                    gwcLatency_key (header->getTemplateId ()), read);
             mMessageCbs->onRawMsg(seqNum, data, frameLength);
+            if (mLatency)
+                mLatency->inboundDone ();
 
             data = reinterpret_cast<char*>(data) + frameLength;
             left -= frameLength;
@@ -213,6 +230,7 @@ gwcOptiq::onTcpConnectionRead (void* data, size_t size)
     while (left > 0)
     {
         size_t used = 0;
+        msg.clear ();
         switch (mCodec.decode (msg, data, left, used))
         {
         case GW_CODEC_ERROR:
@@ -227,7 +245,18 @@ gwcOptiq::onTcpConnectionRead (void* data, size_t size)
             return size;
 
         case GW_CODEC_SUCCESS:
+            journalIn (data, used);
+            logMsg (GWC_LOG_LEVEL_DEBUG, "msg in..", msg, data, used);
+            if (mLatency)
+            {
+                int64_t templateId = 0;
+                msg.getInteger (TemplateId, templateId);
+                mLatency->inboundDecoded (gwcLatency_key ((uint32_t)templateId),
+                                          read);
+            }
             handleTcpMsg (msg);
+            if (mLatency)
+                mLatency->inboundDone ();
             left -= used;
             break;
         }
@@ -269,7 +298,7 @@ void*
 gwcOptiq::dispatchCb (void* closure)
 {
     gwcOptiq* gwc = reinterpret_cast<gwcOptiq*>(closure);
-    sbfQueue_dispatch (gwc->mQueue);
+    gwc->dispatch (gwc->mQueue);
     return NULL;
 }
 
@@ -326,9 +355,6 @@ gwcOptiq::handleTcpMsg (cdr& msg)
 
     msg.getInteger (TemplateId, templateId);
 
-    mLog->info ("msg in..");
-    mLog->info ("%s", msg.toString ().c_str ());
-
     /* any message counts as a hb */
     mSeenHb = true;
 
@@ -349,7 +375,6 @@ gwcOptiq::handleTcpMsg (cdr& msg)
         mMessageCbs->onAdmin (0, msg);
         if (templateId == OptiqLogonAckTemplateId)
         {
-            mState = GWC_CONNECTOR_READY;
             mHb = sbfTimer_create (sbfMw_getDefaultThread (mMw),
                                    mQueue,
                                    gwcOptiq::onHbTimeout,
@@ -364,13 +389,18 @@ gwcOptiq::handleTcpMsg (cdr& msg)
             LastClMsgSeqNum - 0
             */
 
+            /* outbound seqnum must be known before anyone can send, the
+               ring is reset outside the lock its sender takes */
+            msg.getInteger (LastClMsgSeqNum, outbound);
+            if (mOutboundRing)
+                mOutboundRing->reset (outbound + 1);
+
             /* patch up outbound seqnum */
             lock ();
-            msg.getInteger (LastClMsgSeqNum, outbound);
             mSeqnums.mOutbound = outbound;
 
-            sbfCacheFile_write (mCacheItem, &mSeqnums);
-            sbfCacheFile_flush (mCacheFile);
+            mSeqnumStore.write (mCacheItem, &mSeqnums, sizeof mSeqnums);
+            mState = GWC_CONNECTOR_READY;
             unlock ();
 
             mSessionsCbs->onLoggedOn (0, msg);
@@ -387,8 +417,7 @@ gwcOptiq::handleTcpMsg (cdr& msg)
             mSeqnums.mOutbound = outbound;
             mSeqnums.mInbound = inbound;
 
-            sbfCacheFile_write (mCacheItem, &mSeqnums);
-            sbfCacheFile_flush (mCacheFile);
+            mSeqnumStore.write (mCacheItem, &mSeqnums, sizeof mSeqnums);
             unlock ();
 
             error ("logon rejected");
@@ -410,8 +439,7 @@ gwcOptiq::handleTcpMsg (cdr& msg)
         lock ();
         /* update cache */
         mSeqnums.mInbound = seqno;
-        sbfCacheFile_write (mCacheItem, &mSeqnums);
-        sbfCacheFile_flush (mCacheFile);
+        mSeqnumStore.write (mCacheItem, &mSeqnums, sizeof mSeqnums);
         unlock ();
     }
 
@@ -545,7 +573,13 @@ gwcOptiq::init (gwcSessionCallbacks* sessionCbs,
                 const neueda::properties& props)
 {
     mSessionsCbs = sessionCbs;
-    mMessageCbs = messageCbs;
+    if (!initLatency (props, messageCbs))
+        return false;
+
+    if (!initOrderCache (props))
+        return false;
+    if (!initRisk (props))
+        return false;
 
     string v;
     if (!props.get ("host", v))
@@ -584,23 +618,25 @@ gwcOptiq::init (gwcSessionCallbacks* sessionCbs,
     string cacheFileName;
     props.get ("seqno_cache", "optiq.seqno.cache", cacheFileName);
     
+    if (!initSeqnumStore (props))
+        return false;
+
     int created;
-    mCacheFile = sbfCacheFile_open (cacheFileName.c_str (),
-                                    sizeof (gwcOptiqSeqnums),
-                                    0,
-                                    &created,
-                                    cacheFileItemCb,
-                                    this);
-    if (mCacheFile == NULL)
+    string err;
+    if (!mSeqnumStore.open (cacheFileName,
+                            sizeof (gwcOptiqSeqnums),
+                            &created,
+                            cacheFileItemCb,
+                            this,
+                            err))
     {
-        mLog->err ("failed to create optiq seqno cache file");
+        mLog->err ("failed to create optiq seqno cache file: %s", err.c_str ());
         return false;
     }
     if (created)
     {
         mLog->info ("created seqno cachefile %s", cacheFileName.c_str ());
-        mCacheItem = sbfCacheFile_add (mCacheFile, &mSeqnums);
-        sbfCacheFile_flush (mCacheFile);
+        mCacheItem = mSeqnumStore.add (&mSeqnums);
     }
 
     string enableRaw;
@@ -616,16 +652,25 @@ gwcOptiq::init (gwcSessionCallbacks* sessionCbs,
         mRawEnabled = true;
     } 
 
-    sbfKeyValue kv = sbfKeyValue_create ();
-    mMw = sbfMw_create (mSbfLog, kv);
-    sbfKeyValue_destroy (kv);
+    if (!initOutboundRing (props))
+        return false;
+
+    if (!initDispatch (props))
+        return false;
+
+    if (!initLog (props, true))
+        return false;
+
+    if (!initJournal (props, cacheFileName))
+        return false;
+
+    mMw = createMw ();
     if (mMw == NULL)
     {
         mLog->err ("failed to create mw");
         return false;
     }
 
-    // could add a prop to make queue spin for max performance
     mQueue = sbfQueue_create (mMw, "default");
     if (mQueue == NULL)
     {
@@ -633,6 +678,9 @@ gwcOptiq::init (gwcSessionCallbacks* sessionCbs,
         return false;
     }
 
+    if (!initThrottle (props, mMw, mQueue))
+        return false;
+
     // start to dispatch 
     if (sbfThread_create (&mThread, gwcOptiq::dispatchCb, this) != 0)
     {
@@ -776,6 +824,8 @@ gwcOptiq::mapOrderFields (gwcOrder& order)
 bool
 gwcOptiq::sendOrder (gwcOrder& order)
 {
+    gwcLatencyScope latency (mLatency);
+
     if (!mapOrderFields (order))
         return false;
 
@@ -784,14 +834,24 @@ gwcOptiq::sendOrder (gwcOrder& order)
 
 bool 
 gwcOptiq::sendOrder (cdr& order)
+{
+    gwcLatencyScope latency (mLatency);
+
+    prepareOrder (order);
+    return sendChecked (order);
+}
+
+void
+gwcOptiq::prepareOrder (cdr& order)
 {
     order.setInteger (TemplateId, OptiqNewOrderTemplateId);
-    return sendMsg (order);
 }
 
 bool
 gwcOptiq::sendCancel (gwcOrder& cancel)
 {
+    gwcLatencyScope latency (mLatency);
+
     if (!mapOrderFields (cancel))
         return false;
 
@@ -800,14 +860,24 @@ gwcOptiq::sendCancel (gwcOrder& cancel)
 
 bool 
 gwcOptiq::sendCancel (cdr& cancel)
+{
+    gwcLatencyScope latency (mLatency);
+
+    prepareCancel (cancel);
+    return sendPaced (cancel);
+}
+
+void
+gwcOptiq::prepareCancel (cdr& cancel)
 {
     cancel.setInteger (TemplateId, OptiqCancelRequestTemplateId);
-    return sendMsg (cancel);
 }
 
 bool
 gwcOptiq::sendModify (gwcOrder& modify)
 {
+    gwcLatencyScope latency (mLatency);
+
     if (!mapOrderFields (modify))
         return false;
 
@@ -816,18 +886,50 @@ gwcOptiq::sendModify (gwcOrder& modify)
 
 bool 
 gwcOptiq::sendModify (cdr& modify)
+{
+    gwcLatencyScope latency (mLatency);
+
+    prepareModify (modify);
+    return sendModifyChecked (modify);
+}
+
+void
+gwcOptiq::prepareModify (cdr& modify)
 {
     modify.setInteger (TemplateId, OptiqCancelReplaceTemplateId);
-    return sendMsg (modify);
+}
+
+bool
+gwcOptiq::isAdminMsg (cdr& msg)
+{
+    int64_t templateId = 0;
+
+    msg.getInteger (TemplateId, templateId);
+    switch (templateId)
+    {
+    case OptiqLogonTemplateId:
+    case OptiqLogonAckTemplateId:
+    case OptiqLogonRejectTemplateId:
+    case OptiqLogoutTemplateId:
+    case OptiqHeartbeatTemplateId:
+    case OptiqTestRequestTemplateId:
+    case OptiqTechnicalRejectTemplateId:
+        return true;
+    default:
+        return false;
+    }
 }
 
 bool 
 gwcOptiq::sendMsg (cdr& msg)
 {
+    gwcLatencyScope latency (mLatency);
+
+    if (mOutboundRing)
+        return sendMsgRing (msg);
+
     char space[1024];
     size_t used;
-    bool admin = false;
-    int64_t templateId;
 
     // use a codec from the stack gets around threading issues
     optiqCodec codec;
@@ -840,31 +942,15 @@ gwcOptiq::sendMsg (cdr& msg)
         return false;
     }
 
-    msg.getInteger (TemplateId, templateId);
-    switch (templateId)
-    {
-    case OptiqLogonTemplateId:
-    case OptiqLogonAckTemplateId:
-    case OptiqLogonRejectTemplateId:
-    case OptiqLogoutTemplateId:
-    case OptiqHeartbeatTemplateId:
-    case OptiqTestRequestTemplateId:
-    case OptiqTechnicalRejectTemplateId:
-        admin = true;
-        break;
-    default:
-        admin = false;
-        break;
-    }
-
-    if (!admin)
+    if (!isAdminMsg (msg))
     {
         /* update seqnum cache */
         mSeqnums.mOutbound++;
         msg.setInteger (ClMsgSeqNum, mSeqnums.mOutbound);
-        sbfCacheFile_write (mCacheItem, &mSeqnums);
-        sbfCacheFile_flush (mCacheFile);
+        mSeqnumStore.write (mCacheItem, &mSeqnums, sizeof mSeqnums);
     }
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_SEQUENCED, latencyKey (msg));
 
     if (codec.encode (msg, space, sizeof space, used) != GW_CODEC_SUCCESS)
     {
@@ -873,22 +959,353 @@ gwcOptiq::sendMsg (cdr& msg)
         unlock ();
         return false;
     }   
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_ENCODED);
 
     mTcpConnection->send (space, used);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN);
+    journalOut (space, used);
+
+    unlock ();
+    return true;
+}
+
+bool 
+gwcOptiq::sendMsgs (cdr** msgs, size_t n)
+{
+    gwcLatencyScope latency (mLatency);
+
+    if (mOutboundRing)
+        return sendMsgsRing (msgs, n);
+
+    vector<char> space (n * GWC_BATCH_MSG_SIZE);
+    vector<size_t> sizes (n);
+    size_t total = 0;
+    size_t used;
+
+    // use a codec from the stack gets around threading issues
+    optiqCodec codec;
+
+    lock ();
+    if (mState != GWC_CONNECTOR_READY)
+    {
+        mLog->warn ("gwc not ready to send messages");
+        unlock ();
+        return false;
+    }
+
+    /* seqnums are contiguous across the batch and the cache is written once, 
+       all are rolled back if a message fails to encode */
+    int64_t outbound = mSeqnums.mOutbound;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (!isAdminMsg (*msgs[i]))
+        {
+            mSeqnums.mOutbound++;
+            msgs[i]->setInteger (ClMsgSeqNum, mSeqnums.mOutbound);
+        }
+    }
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_SEQUENCED, latencyKey (*msgs[0]));
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (codec.encode (*msgs[i], 
+                          &space[total], 
+                          space.size () - total, 
+                          used) != GW_CODEC_SUCCESS)
+        {
+            mLog->err ("failed to construct batch message [%s]", 
+                       codec.getLastError ().c_str ());
+            mSeqnums.mOutbound = outbound;
+            unlock ();
+            return false;
+        }
+        sizes[i] = used;
+        total += used;
+    }
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_ENCODED);
+
+    if (mSeqnums.mOutbound != outbound)
+    {
+        mSeqnumStore.write (mCacheItem, &mSeqnums, sizeof mSeqnums);
+    }
+
+    mTcpConnection->send (&space[0], total);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN);
+    size_t offset = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        journalOut (&space[offset], sizes[i]);
+        offset += sizes[i];
+    }
+
+    unlock ();
+    return true;
+}
+
+uint32_t
+gwcOptiq::latencyKey (const cdr& msg)
+{
+    int64_t templateId = 0;
+    msg.getInteger (TemplateId, templateId);
+    return gwcLatency_key ((uint32_t)templateId);
+}
+
+bool
+gwcOptiq::encodeOutbound (optiqCodec& codec,
+                          cdr& msg,
+                          char* space,
+                          size_t size,
+                          size_t& used,
+                          size_t& offset)
+{
+    int64_t templateId = 0;
+    msg.getInteger (TemplateId, templateId);
+
+    /* encode with a placeholder seqnum so nothing is claimed for a message
+       that fails to encode, the real one is patched in afterwards */
+    msg.setInteger (ClMsgSeqNum, 0);
+    if (codec.encode (msg, space, size, used) != GW_CODEC_SUCCESS)
+    {
+        mLog->err ("failed to construct message [%s]", 
+                   codec.getLastError ().c_str ());
+        return false;
+    }
+
+    if (!mSeqnumOffsets.find (codec, 
+                              msg, 
+                              (uint16_t)templateId, 
+                              ClMsgSeqNum, 
+                              4, 
+                              offset))
+    {
+        mLog->err ("failed to construct message [no ClMsgSeqNum]");
+        return false;
+    }
+
+    return true;
+}
+
+bool
+gwcOptiq::sendMsgRing (cdr& msg)
+{
+    char space[GWC_OUTBOUND_SLOT_SIZE];
+    size_t used;
+    size_t offset;
+
+    // use a codec from the stack gets around threading issues
+    optiqCodec codec;
+
+    if (mState != GWC_CONNECTOR_READY)
+    {
+        mLog->warn ("gwc not ready to send messages");
+        return false;
+    }
+
+    /* admin messages carry no seqnum */
+    if (isAdminMsg (msg))
+    {
+        if (codec.encode (msg, space, sizeof space, used) != GW_CODEC_SUCCESS)
+        {
+            mLog->err ("failed to construct message [%s]", 
+                       codec.getLastError ().c_str ());
+            return false;
+        }
+        mOutboundRing->sendDirect (space, used);
+        return true;
+    }
+
+    if (!encodeOutbound (codec, msg, space, sizeof space, used, offset))
+        return false;
+
+    /* encoded once the claimed seqnum is patched in */
+    uint64_t ticket = mOutboundRing->claim ();
+    uint64_t seqNo = gwcOutboundRing::seqnum (ticket);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_SEQUENCED, latencyKey (msg));
+    gwcSeqnumOffsets::patch (space, offset, 4, seqNo);
+    msg.setInteger (ClMsgSeqNum, seqNo);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_ENCODED);
+
+    if (!mOutboundRing->publish (ticket, space, used))
+    {
+        mLog->warn ("session reset before message could be sent");
+        return false;
+    }
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN);
+    return true;
+}
+
+bool
+gwcOptiq::sendMsgsRing (cdr** msgs, size_t n)
+{
+    vector<char> space (n * GWC_OUTBOUND_SLOT_SIZE);
+    vector<size_t> sizes (n);
+    vector<size_t> offsets (n);
+
+    // use a codec from the stack gets around threading issues
+    optiqCodec codec;
+
+    if (mState != GWC_CONNECTOR_READY)
+    {
+        mLog->warn ("gwc not ready to send messages");
+        return false;
+    }
+
+    /* admin messages carry no seqnum so can't be part of a contiguous 
+       claim */
+    for (size_t i = 0; i < n; i++)
+    {
+        if (isAdminMsg (*msgs[i]))
+            return gwcConnector::sendMsgs (msgs, n);
+    }
+
+    /* encode all first so nothing is claimed or sent if one fails */
+    for (size_t i = 0; i < n; i++)
+    {
+        if (!encodeOutbound (codec, 
+                             *msgs[i], 
+                             &space[i * GWC_OUTBOUND_SLOT_SIZE],
+                             GWC_OUTBOUND_SLOT_SIZE,
+                             sizes[i],
+                             offsets[i]))
+        {
+            return false;
+        }
+    }
+
+    uint64_t ticket = mOutboundRing->claim (n);
+    uint64_t seqNo = gwcOutboundRing::seqnum (ticket);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_SEQUENCED, latencyKey (*msgs[0]));
+
+    for (size_t i = 0; i < n; i++)
+    {
+        gwcSeqnumOffsets::patch (&space[i * GWC_OUTBOUND_SLOT_SIZE], 
+                                 offsets[i], 
+                                 4, 
+                                 seqNo + i);
+        msgs[i]->setInteger (ClMsgSeqNum, seqNo + i);
+    }
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_ENCODED);
+
+    /* every ticket is published, the rest fail too once one has */
+    bool ok = true;
+    for (size_t i = 0; i < n; i++)
+    {
+        ok = mOutboundRing->publish (ticket + i, 
+                                     &space[i * GWC_OUTBOUND_SLOT_SIZE], 
+                                     sizes[i]) && ok;
+    }
+    if (!ok)
+    {
+        mLog->warn ("session reset before messages could be sent");
+        return false;
+    }
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN);
+    return true;
+}
+
+size_t
+gwcOptiq::onReplay (void* data, size_t size)
+{
+    return mTcpConnectionDelegate.onRead (data, size);
+}
+
+void
+gwcOptiq::onOutboundSend (const void* data, size_t size)
+{
+    lock ();
+    if (mTcpConnection)
+        mTcpConnection->send ((void*)data, size);
+    unlock ();
+}
 
+void
+gwcOptiq::onOutboundDrained (uint64_t next)
+{
+    /* seqnum cache is written once per drained group rather than per
+       message */
+    lock ();
+    mSeqnums.mOutbound = next - 1;
+    mSeqnumStore.write (mCacheItem, &mSeqnums, sizeof mSeqnums);
     unlock ();
+}
+
+void
+gwcOptiq::onOutboundSent (uint64_t seq, const void* data, size_t size)
+{
+    journalOut (data, size);
+}
+
+bool
+gwcOptiq::formatLogMsg (const void* data, size_t size, std::string& out)
+{
+    cdr    msg;
+    size_t used = 0;
+
+    if (mLogCodec.decode (msg, data, size, used) != GW_CODEC_SUCCESS)
+        return false;
+    out = msg.toString ();
     return true;
 }
 
 bool
 gwcOptiq::sendRaw (void* data, size_t len)
 {
+    gwcLatencyScope latency (mLatency);
+
     if (!mRawEnabled)
     {
         mLog->warn ("raw send interface not enabled");
         return false;
     }    
 
+    if (mOutboundRing)
+    {
+        if (mState != GWC_CONNECTOR_READY)
+        {
+            mLog->warn ("gwc not ready to send messages");
+            return false;
+        }
+
+        /* raw messages take a seqnum as on the locked path, rejected
+           before claiming if the ring can't hold them */
+        if (!gwcOutboundRing::fits (len))
+        {
+            mLog->err ("raw message of %lu bytes too large to send",
+                       (unsigned long)len);
+            return false;
+        }
+
+        // set sequence number, to ensure admin msgs remain in sync
+        uint64_t ticket = mOutboundRing->claim ();
+        if (mLatency)
+            mLatency->outboundMark (GWC_LATENCY_OUT_SEQUENCED, 0);
+        uint16_t* seqNum = reinterpret_cast<uint16_t*>(
+            static_cast<char*>(data) + sizeof(optiqMessageHeaderPacket) + 2);
+        *seqNum = gwcOutboundRing::seqnum (ticket);
+        if (mLatency)
+            mLatency->outboundMark (GWC_LATENCY_OUT_ENCODED);
+
+        if (!mOutboundRing->publish (ticket, data, len))
+        {
+            mLog->warn ("session reset before message could be sent");
+            return false;
+        }
+        if (mLatency)
+            mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN);
+        return true;
+    }
+
     lock ();
 
     if (mState != GWC_CONNECTOR_READY)
@@ -904,10 +1321,170 @@ gwcOptiq::sendRaw (void* data, size_t len)
         static_cast<char*>(data) + sizeof(optiqMessageHeaderPacket) + 2);
 
     *seqNum = ++mSeqnums.mOutbound;
+    if (mLatency)
+    {
+        mLatency->outboundMark (GWC_LATENCY_OUT_SEQUENCED, 0);
+        mLatency->outboundMark (GWC_LATENCY_OUT_ENCODED);
+    }
 
     mTcpConnection->send (data, len);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN);
+    journalOut (data, len);
 
     unlock ();
     return true;
 }
 
+bool
+gwcOptiq::getClOrdId (const cdr& msg, bool orig, std::string& id) const
+{
+    return getIdField (msg, orig ? OrigClientOrderID : ClientOrderID, id);
+}
+
+void
+gwcOptiq::getOrderFields (const cdr& msg, gwcOrderFields& fields) const
+{
+    getIdField (msg, OrderID, fields.mOrderId);
+    fields.mHasOrderQty = getNumberField (msg, OrderQty, fields.mOrderQty);
+    fields.mHasLeavesQty = getNumberField (msg, LeavesQuantity, fields.mLeavesQty);
+    fields.mHasLastQty = getNumberField (msg, LastTradedQuantity, fields.mLastQty);
+    fields.mHasLastPx = getNumberField (msg, LastTradedPx, fields.mLastPx);
+}
+
+void
+gwcOptiq::getRiskFields (const cdr& msg, gwcRiskFields& fields) const
+{
+    int64_t side;
+
+    /* optiq has no account on an order, the firm stands in for it */
+    getIdField (msg, SymbolIndex, fields.mInstrument);
+    getIdField (msg, FirmID, fields.mAccount);
+    fields.mHasSide = msg.getInteger (OrderSide, side);
+    fields.mBuy = fields.mHasSide && side == OPTIQ_SIDE_BUY;
+    fields.mHasQty = getNumberField (msg, OrderQty, fields.mQty);
+    fields.mHasPrice = getNumberField (msg, OrderPx, fields.mPrice);
+}
+
+bool
+gwcOptiq::createTemplate (gwcOrderTemplateType type,
+                          gwcOrder& msg,
+                          gwcOrderTemplate& tmpl)
+{
+    if (!mapOrderFields (msg))
+        return false;
+
+    switch (type)
+    {
+    case GWC_TEMPLATE_ORDER:
+        msg.setInteger (TemplateId, OptiqNewOrderTemplateId);
+        break;
+    case GWC_TEMPLATE_CANCEL:
+        msg.setInteger (TemplateId, OptiqCancelRequestTemplateId);
+        break;
+    case GWC_TEMPLATE_MODIFY:
+        msg.setInteger (TemplateId, OptiqCancelReplaceTemplateId);
+        break;
+    }
+    msg.setInteger (ClMsgSeqNum, 0);
+
+    /* prices are passed through unscaled as in mapOrderFields */
+    optiqCodec codec;
+    tmpl.reset (this, type);
+    tmpl.setSideValues (OPTIQ_SIDE_BUY, OPTIQ_SIDE_SELL);
+    if (!tmpl.encode (codec, msg) ||
+        !tmpl.locate (codec, msg, GWC_TEMPLATE_FIELD_PRICE, OrderPx,
+                      GWC_TEMPLATE_ENCODING_LE, 8, 0, 1) ||
+        !tmpl.locate (codec, msg, GWC_TEMPLATE_FIELD_QTY, OrderQty,
+                      GWC_TEMPLATE_ENCODING_LE, 8, 0, 1) ||
+        !tmpl.locate (codec, msg, GWC_TEMPLATE_FIELD_SIDE, OrderSide,
+                      GWC_TEMPLATE_ENCODING_LE, 1, 0, 1) ||
+        !tmpl.locate (codec, msg, GWC_TEMPLATE_FIELD_CLORDID, ClientOrderID,
+                      GWC_TEMPLATE_ENCODING_LE, 8, 0, 1) ||
+        !tmpl.locate (codec, msg, GWC_TEMPLATE_FIELD_ORIG_CLORDID,
+                      OrigClientOrderID, GWC_TEMPLATE_ENCODING_LE, 8, 0, 1) ||
+        !tmpl.locate (codec, msg, GWC_TEMPLATE_FIELD_SEQNUM, ClMsgSeqNum,
+                      GWC_TEMPLATE_ENCODING_LE, 4, 0, 1))
+    {
+        mLog->err ("failed to construct template [%s]",
+                   tmpl.getLastError ().c_str ());
+        tmpl.reset (NULL, type);
+        return false;
+    }
+
+    if (!tmpl.hasField (GWC_TEMPLATE_FIELD_SEQNUM))
+    {
+        mLog->err ("failed to construct template [no ClMsgSeqNum]");
+        tmpl.reset (NULL, type);
+        return false;
+    }
+
+    return true;
+}
+
+bool
+gwcOptiq::sendTemplate (gwcOrderTemplate& tmpl)
+{
+    gwcLatencyScope latency (mLatency);
+
+    if (!tmpl.isOwner (this))
+    {
+        mLog->warn ("template not created by this connector");
+        return false;
+    }
+
+    if (!riskTemplate ())
+        return false;
+
+    if (!throttleTemplate ())
+        return false;
+
+    if (mOutboundRing)
+    {
+        if (mState != GWC_CONNECTOR_READY)
+        {
+            mLog->warn ("gwc not ready to send messages");
+            return false;
+        }
+
+        uint64_t ticket = mOutboundRing->claim ();
+        if (mLatency)
+            mLatency->outboundMark (GWC_LATENCY_OUT_SEQUENCED, 0);
+        tmpl.patchInteger (GWC_TEMPLATE_FIELD_SEQNUM, gwcOutboundRing::seqnum (ticket));
+        if (mLatency)
+            mLatency->outboundMark (GWC_LATENCY_OUT_ENCODED);
+        if (!mOutboundRing->publish (ticket, tmpl.getData (), tmpl.getSize ()))
+        {
+            mLog->warn ("session reset before message could be sent");
+            return false;
+        }
+        if (mLatency)
+            mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN);
+        return true;
+    }
+
+    lock ();
+    if (mState != GWC_CONNECTOR_READY)
+    {
+        mLog->warn ("gwc not ready to send messages");
+        unlock ();
+        return false;
+    }
+
+    /* update seqnum cache */
+    mSeqnums.mOutbound++;
+    mSeqnumStore.write (mCacheItem, &mSeqnums, sizeof mSeqnums);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_SEQUENCED, 0);
+    tmpl.patchInteger (GWC_TEMPLATE_FIELD_SEQNUM, mSeqnums.mOutbound);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_ENCODED);
+
+    mTcpConnection->send (tmpl.getData (), tmpl.getSize ());
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN);
+    journalOut (tmpl.getData (), tmpl.getSize ());
+
+    unlock ();
+    return true;
+}
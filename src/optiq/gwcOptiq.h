@@ -75,11 +75,31 @@ public:
     virtual bool sendMsg (cdr& msg);
     virtual bool sendRaw (void* data, size_t len);
 
+    virtual bool getClOrdId (const cdr& msg, bool orig, std::string& id) const;
+
+    virtual void getOrderFields (const cdr& msg, gwcOrderFields& fields) const;
+
+    virtual void getRiskFields (const cdr& msg, gwcRiskFields& fields) const;
+
+    virtual bool createTemplate (gwcOrderTemplateType type,
+                                 gwcOrder& msg,
+                                 gwcOrderTemplate& tmpl);
+    virtual bool sendTemplate (gwcOrderTemplate& tmpl);
+
 protected:
+    virtual void prepareOrder (cdr& order);
+    virtual void prepareCancel (cdr& cancel);
+    virtual void prepareModify (cdr& modify);
+    virtual bool sendMsgs (cdr** msgs, size_t n);
+    virtual size_t onReplay (void* data, size_t size);
+    virtual void onOutboundSend (const void* data, size_t size);
+    virtual void onOutboundSent (uint64_t seq, const void* data, size_t size);
+    virtual bool formatLogMsg (const void* data, size_t size, std::string& out);
+    virtual void onOutboundDrained (uint64_t next);
+
     SbfTcpConnection*             mTcpConnection;
     gwcOptiqTcpConnectionDelegate mTcpConnectionDelegate;
 
-    sbfCacheFile                  mCacheFile;
     sbfCacheFileItem              mCacheItem;
     sbfMw                         mMw;
     sbfQueue                      mQueue;
@@ -89,7 +109,17 @@ private:
     // utility methods
     void reset ();
     void error (const string& err);
+    bool isAdminMsg (cdr& msg);
     bool mapOrderFields (gwcOrder& order);
+    uint32_t latencyKey (const cdr& msg);
+    bool encodeOutbound (optiqCodec& codec,
+                         cdr& msg,
+                         char* space,
+                         size_t size,
+                         size_t& used,
+                         size_t& offset);
+    bool sendMsgRing (cdr& msg);
+    bool sendMsgsRing (cdr** msgs, size_t n);
 
     // handle state
     void onTcpConnectionReady ();
@@ -125,8 +155,11 @@ private:
     sbfTimer                mHb;
     sbfTimer                mReconnectTimer;
     optiqCodec              mCodec;
+    optiqCodec              mLogCodec;
+    cdr                     mInboundMsg;
     bool                    mSeenHb;
     int                     mMissedHb;
     gwcOptiqSeqnums         mSeqnums;
+    gwcSeqnumOffsets        mSeqnumOffsets;
 };
 
@@ -58,7 +58,6 @@ gwcSoupBin::gwcSoupBin (neueda::logger* log) :
     gwcConnector (log),
     mConnection (NULL),
     mConnectionDelegate (this),
-    mCacheFile (NULL),
     mMw (NULL),
     mQueue (NULL),
     mSequenceNumber (0),
@@ -73,6 +72,7 @@ gwcSoupBin::gwcSoupBin (neueda::logger* log) :
 
 gwcSoupBin::~gwcSoupBin ()
 {
+    stopThrottle ();
     if (mReconnectTimer)
         sbfTimer_destroy (mReconnectTimer);
     if (mHb)
@@ -81,8 +81,7 @@ gwcSoupBin::~gwcSoupBin ()
         delete mConnection;
     if (mCacheItem)
         delete mCacheItem;
-    if (mCacheFile)
-        sbfCacheFile_close (mCacheFile);
+    mSeqnumStore.close ();
     if (mQueue)
         sbfQueue_destroy (mQueue);
     if (mDispatching)
@@ -133,6 +132,7 @@ gwcSoupBin::onConnectionReady ()
         return;
     }
     mConnection->send (space, used);
+    journalOut (space, used);
 }
 
 void 
@@ -145,8 +145,9 @@ size_t
 gwcSoupBin::onConnectionRead (void* data, size_t size)
 {
     size_t left = size;
-    cdr    msg;
+    cdr&   msg = mInboundMsg;
     gwcSoupBinHeader* hdr = (gwcSoupBinHeader*)data;
+    uint64_t read = mLatency ? gwcLatency_now () : 0;
 
     if (mRawEnabled)
     {
@@ -168,6 +169,7 @@ gwcSoupBin::onConnectionRead (void* data, size_t size)
             if (isSessionMessage (hdr->mType))
             {
                 size_t codecUsed = 0;
+                msg.clear ();
                 switch (getCodec ().decode (msg, (void*)hdr, left, codecUsed))
                 {
                 case GW_CODEC_ERROR:
@@ -180,7 +182,12 @@ gwcSoupBin::onConnectionRead (void* data, size_t size)
 
                 case GW_CODEC_SUCCESS:
                 {
-                    handleRealTimeMsg (msg);
+                    journalIn (hdr, codecUsed);
+                    if (mLatency)
+                        mLatency->inboundDecoded (latencyKey (hdr->mType), read);
+                    handleRealTimeMsg (hdr, msg);
+                    if (mLatency)
+                        mLatency->inboundDone ();
                     left -= codecUsed;
                     used += codecUsed;
                     hdr = (gwcSoupBinHeader*)((char*)data + codecUsed);
@@ -190,7 +197,12 @@ gwcSoupBin::onConnectionRead (void* data, size_t size)
                 }
             }
             
+            journalIn (hdr, messageLength);
+            if (mLatency)
+                mLatency->inboundDecoded (latencyKey (hdr->mType), read);
             mMessageCbs->onRawMsg (0, hdr, messageLength);
+            if (mLatency)
+                mLatency->inboundDone ();
                 
             hdr = (gwcSoupBinHeader*)((char*)data + messageLength);
             left -= messageLength;
@@ -201,6 +213,7 @@ gwcSoupBin::onConnectionRead (void* data, size_t size)
     for (;;)
     {
         size_t used;
+        msg.clear ();
         switch (getCodec ().decode (msg, data, left, used))
         {
         case GW_CODEC_ERROR:
@@ -215,7 +228,13 @@ gwcSoupBin::onConnectionRead (void* data, size_t size)
             return size;
 
         case GW_CODEC_SUCCESS:
-            handleRealTimeMsg (msg);
+            journalIn (data, used);
+            if (mLatency)
+                mLatency->inboundDecoded (
+                    latencyKey (((gwcSoupBinHeader*)data)->mType), read);
+            handleRealTimeMsg (data, msg);
+            if (mLatency)
+                mLatency->inboundDone ();
             left -= used;
             break;
         }
@@ -223,6 +242,12 @@ gwcSoupBin::onConnectionRead (void* data, size_t size)
     }
 }
 
+uint32_t
+gwcSoupBin::latencyKey (char type) const
+{
+    return gwcLatency_textKey ((uint8_t)type);
+}
+
 bool
 gwcSoupBin::isSessionMessage (char type) const
 {
@@ -240,31 +265,31 @@ gwcSoupBin::isSessionMessage (char type) const
 }
 
 void
-gwcSoupBin::handleRealTimeMsg (cdr& msg)
+gwcSoupBin::handleRealTimeMsg (const void* data, cdr& msg)
 {
     // seen messages from the server
     mSeenMessageWithinHbInterval = true;
     
-    string messageType;
-    msg.getString (MessageType, messageType);
+    const gwcSoupBinHeader* hdr = (const gwcSoupBinHeader*)data;
+    const char* payload = (const char*)data + sizeof *hdr;
 
-    char mType = messageType[0];
+    char mType = hdr->mType;
     if (isSessionMessage (mType))
     {
-        handleSessionMessge (msg);
+        handleSessionMessge (mType, msg);
     }
     else
     {
         switch (mType)
         {
         case GWC_SOUP_BIN_UNSEQUENCED_MESSAGE_TYPE:
-            handleUnsequencedMessage (msg);
+            handleUnsequencedMessage (payload, msg);
             break;
 
         case GWC_SOUP_BIN_SEQUENCED_MESSAGE_TYPE:
             mSequenceNumber++;
             updateSeqno (mSession, mSequenceNumber);
-            handleSequencedMessage (msg);
+            handleSequencedMessage (payload, msg);
             break;
 
         default:
@@ -276,15 +301,15 @@ gwcSoupBin::handleRealTimeMsg (cdr& msg)
 }
 
 void
-gwcSoupBin::handleSessionMessge (cdr& msg)
+gwcSoupBin::handleSessionMessge (char type, cdr& msg)
 {
-    string mType;
-    msg.getString (MessageType, mType);
-
-    if (mType[0] == GWC_SOUP_BIN_LOGIN_ACCEPTED_MESSAGE_TYPE)
+    switch (type)
     {
+    case GWC_SOUP_BIN_LOGIN_ACCEPTED_MESSAGE_TYPE:
         mMessageCbs->onAdmin (mSequenceNumber, msg);
         mSessionsCbs->onLoggedOn (0, msg);
+        if (mReplaying)
+            break;
         mState = GWC_CONNECTOR_READY;
         loggedOnEvent ();
         
@@ -292,9 +317,9 @@ gwcSoupBin::handleSessionMessge (cdr& msg)
 
         // start heartbeats
         resetHbTimer ();
-    }
-    else if (mType[0] == GWC_SOUP_BIN_LOGIN_REJECTED_MESSAGE_TYPE)
-    {
+        break;
+
+    case GWC_SOUP_BIN_LOGIN_REJECTED_MESSAGE_TYPE:
         mMessageCbs->onAdmin (mSequenceNumber, msg);
 
         // where we in a state to expect a logout
@@ -306,15 +331,16 @@ gwcSoupBin::handleSessionMessge (cdr& msg)
         reset ();
         mSessionsCbs->onLoggedOff (mSequenceNumber, msg);
         loggedOffEvent ();
-    }
-    else if (mType[0] == GWC_SOUP_BIN_SERVER_HEART_BEAT_MESSAGE_TYPE)
-    {
+        break;
+
+    case GWC_SOUP_BIN_SERVER_HEART_BEAT_MESSAGE_TYPE:
         mMessageCbs->onAdmin (mSequenceNumber, msg);
-    }
-    else
-    {
-        mLog->err ("unhandled message type [%s]", mType.c_str ());
+        break;
+
+    default:
+        mLog->err ("unhandled message type [%c]", type);
         mLog->err ("%s", msg.toString ().c_str ());
+        break;
     }
 }
 
@@ -354,7 +380,7 @@ void*
 gwcSoupBin::dispatchCb (void* closure)
 {
     gwcSoupBin* gwc = reinterpret_cast<gwcSoupBin*>(closure);
-    sbfQueue_dispatch (gwc->mQueue);
+    gwc->dispatch (gwc->mQueue);
     return NULL;
 }
 
@@ -381,10 +407,16 @@ gwcSoupBin::cacheFileItemCb (sbfCacheFile file,
     return 0;
 }
 
+size_t
+gwcSoupBin::onReplay (void* data, size_t size)
+{
+    return mConnectionDelegate.onRead (data, size);
+}
+
 void
 gwcSoupBin::updateSeqno (string& session, uint32_t seqno)
 {
-    mLog->info ("update seqno for session [%s] to [%u]", session.c_str (), seqno);
+    GWC_LOG_DEBUG ("update seqno for session [%s] to [%u]", session.c_str (), seqno);
 
     if (mCacheItem)
     {
@@ -393,8 +425,9 @@ gwcSoupBin::updateSeqno (string& session, uint32_t seqno)
                  session.c_str (),
                  sizeof(mCacheItem->mData.mSession));
         
-        sbfCacheFile_write (mCacheItem->mItem, &mCacheItem->mData);
-        sbfCacheFile_flush (mCacheFile);
+        mSeqnumStore.write (mCacheItem->mItem,
+                            &mCacheItem->mData,
+                            sizeof mCacheItem->mData);
 
         return;
     }
@@ -405,8 +438,7 @@ gwcSoupBin::updateSeqno (string& session, uint32_t seqno)
              session.c_str (),
              sizeof(mCacheItem->mData.mSession));
     
-    mCacheItem->mItem = sbfCacheFile_add (mCacheFile, &mCacheItem->mData);
-    sbfCacheFile_flush (mCacheFile);
+    mCacheItem->mItem = mSeqnumStore.add (&mCacheItem->mData);
 }
 
 void
@@ -466,7 +498,13 @@ gwcSoupBin::init (gwcSessionCallbacks* sessionCbs,
                   const neueda::properties& props)
 {
     mSessionsCbs = sessionCbs;
-    mMessageCbs = messageCbs;
+    if (!initLatency (props, messageCbs))
+        return false;
+
+    if (!initOrderCache (props))
+        return false;
+    if (!initRisk (props))
+        return false;
 
     string cacheFileName;
     props.get ("seqno_cache", kDefaultCacheName, cacheFileName);
@@ -485,16 +523,19 @@ gwcSoupBin::init (gwcSessionCallbacks* sessionCbs,
         return false;
     }
 
+    if (!initSeqnumStore (props))
+        return false;
+
     int created;
-    mCacheFile = sbfCacheFile_open (cacheFileName.c_str (),
-                                    sizeof (gwcSoupBinSeqNum),
-                                    0, 
-                                    &created,
-                                    gwcSoupBin::cacheFileItemCb,
-                                    this);
-    if (mCacheFile == NULL)
+    string err;
+    if (!mSeqnumStore.open (cacheFileName,
+                            sizeof (gwcSoupBinSeqNum),
+                            &created,
+                            gwcSoupBin::cacheFileItemCb,
+                            this,
+                            err))
     {
-        mLog->err ("failed to create seqno cache file");
+        mLog->err ("failed to create seqno cache file: %s", err.c_str ());
         return false;
     }
     if (created)
@@ -513,16 +554,22 @@ gwcSoupBin::init (gwcSessionCallbacks* sessionCbs,
         mRawEnabled = true;
     }
 
-    sbfKeyValue kv = sbfKeyValue_create ();
-    mMw = sbfMw_create (mSbfLog, kv);
-    sbfKeyValue_destroy (kv);
+    if (!initDispatch (props))
+        return false;
+
+    if (!initLog (props, false))
+        return false;
+
+    if (!initJournal (props, cacheFileName))
+        return false;
+
+    mMw = createMw ();
     if (mMw == NULL)
     {
         mLog->err ("failed to create mw");
         return false;
     }
 
-    // could add a prop to make queue spin for max performance
     mQueue = sbfQueue_create (mMw, "default");
     if (mQueue == NULL)
     {
@@ -530,6 +577,9 @@ gwcSoupBin::init (gwcSessionCallbacks* sessionCbs,
         return false;
     }
 
+    if (!initThrottle (props, mMw, mQueue))
+        return false;
+
     // start to dispatch 
     if (sbfThread_create (&mThread, gwcSoupBin::dispatchCb, this) != 0)
     {
@@ -587,6 +637,7 @@ gwcSoupBin::stop ()
         return false;
     }
     mConnection->send (space, used);
+    journalOut (space, used);
 
     return true;
 }
@@ -594,6 +645,8 @@ gwcSoupBin::stop ()
 bool
 gwcSoupBin::sendRaw (void* data, size_t len)
 {
+    gwcLatencyScope latency (mLatency);
+
     if (!mRawEnabled)
     {
         mLog->warn ("raw send interface not enabled");
@@ -607,6 +660,10 @@ gwcSoupBin::sendRaw (void* data, size_t len)
     }
  
     mConnection->send (data, len);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN, 
+                                latencyKey (((gwcSoupBinHeader*)data)->mType));
+    journalOut (data, len);
     return true;
 }
 
@@ -70,7 +70,6 @@ protected:
     SbfTcpConnection*            mConnection;
     gwcSoupBinConnectionDelegate mConnectionDelegate;
 
-    sbfCacheFile          mCacheFile;
     sbfMw                 mMw;
     sbfQueue              mQueue;
     sbfThread             mThread;
@@ -81,19 +80,21 @@ protected:
     struct gwcSoupBinCacheItem* mCacheItem;
 
     bool isSessionMessage (char type) const;
+    uint32_t latencyKey (char type) const;
 
-    // allows to override handling behaviour
-    virtual void handleRealTimeMsg (cdr& msg);
+    // allows to override handling behaviour, data is the decoded packet
+    virtual void handleRealTimeMsg (const void* data, cdr& msg);
     virtual void sendHeartBeat ();
-    virtual void handleSessionMessge (cdr& msg);
+    virtual void handleSessionMessge (char type, cdr& msg);
     virtual void updateSeqno (string& session, uint32_t seqno);
+    virtual size_t onReplay (void* data, size_t size);
 
     // veneue specific
     virtual neueda::codec& getCodec () = 0;
 
-    // handle messages
-    virtual void handleSequencedMessage (cdr& msg) = 0;
-    virtual void handleUnsequencedMessage (cdr& msg) = 0;
+    // handle messages, payload is the message inside the packet
+    virtual void handleSequencedMessage (const char* payload, cdr& msg) = 0;
+    virtual void handleUnsequencedMessage (const char* payload, cdr& msg) = 0;
 
 private:
     void reset ();
@@ -120,5 +121,6 @@ private:
     sbfTimer    mHb;
     sbfTimer    mReconnectTimer;
     bool        mSeenMessageWithinHbInterval;
+    cdr         mInboundMsg;
 };
 
@@ -1,13 +1,44 @@
 #include "swxCodecConstants.h"
 #include "gwcSwx.h"
 
+#include <vector>
+
 
 extern "C" gwcConnector*
-getConnector (neueda::logger* log, const neueda::properties& props)
+GWC_CONNECTOR_ENTRY (swx) (neueda::logger* log, const neueda::properties& props)
 {
     return new gwcSwx (log);
 }
 
+typedef void (gwcMessageCallbacks::*gwcSwxCallback) (uint64_t seqno,
+                                                     const cdr& msg);
+
+/* Callback for each sequenced message type, NULL for unknown types */
+struct gwcSwxCallbacks
+{
+    gwcSwxCallbacks ()
+    {
+        for (size_t i = 0; i < 256; i++)
+            mCallbacks[i] = NULL;
+
+        mCallbacks[SWX_SYSTEM_EVENT_MESSAGE_TYPE] = &gwcMessageCallbacks::onAdmin;
+        mCallbacks[SWX_ACCEPTED_MESSAGE_TYPE] = &gwcMessageCallbacks::onOrderAck;
+        mCallbacks[SWX_REPLACED_MESSAGE_TYPE] = &gwcMessageCallbacks::onModifyAck;
+        mCallbacks[SWX_CANCELLED_MESSAGE_TYPE] = &gwcMessageCallbacks::onOrderDone;
+        mCallbacks[SWX_EXECUTED_ORDER_MESSAGE_TYPE] =
+            &gwcMessageCallbacks::onOrderFill;
+        mCallbacks[SWX_REJECTED_ORDER_MESSAGE_TYPE] =
+            &gwcMessageCallbacks::onOrderRejected;
+        mCallbacks[SWX_ORDER_PRIORITY_UPDATE_CHANGE_MESSAGE_TYPE] =
+            &gwcMessageCallbacks::onMsg;
+        mCallbacks[SWX_BROKEN_TRADE_MESSAGE_TYPE] = &gwcMessageCallbacks::onMsg;
+    }
+
+    gwcSwxCallback mCallbacks[256];
+};
+
+static const gwcSwxCallbacks gwcSwxSequencedCallbacks;
+
 gwcSwx::gwcSwx (neueda::logger* log)
     : gwcSoupBin (log)
 {
@@ -91,6 +122,8 @@ gwcSwx::mapOrderFields (gwcOrder& order)
 bool
 gwcSwx::sendOrder (gwcOrder& order)
 {
+    gwcLatencyScope latency (mLatency);
+
     if (!mapOrderFields (order))
         return false;
     
@@ -99,15 +132,25 @@ gwcSwx::sendOrder (gwcOrder& order)
 
 bool
 gwcSwx::sendOrder (cdr& order)
+{
+    gwcLatencyScope latency (mLatency);
+
+    prepareOrder (order);
+    return sendChecked (order);
+}
+
+void
+gwcSwx::prepareOrder (cdr& order)
 {
     order.setString (MessageType, "%c", SWX_UNSEQUENCED_MESSAGE_TYPE);
     order.setString (Type, "%c", SWX_ENTER_ORDER_MESSAGE_TYPE);
-    return sendMsg (order);
 }
 
 bool
 gwcSwx::sendCancel (gwcOrder& cancel)
 {
+    gwcLatencyScope latency (mLatency);
+
     if (!mapOrderFields (cancel))
         return false;
     
@@ -116,15 +159,25 @@ gwcSwx::sendCancel (gwcOrder& cancel)
 
 bool
 gwcSwx::sendCancel (cdr& cancel)
+{
+    gwcLatencyScope latency (mLatency);
+
+    prepareCancel (cancel);
+    return sendPaced (cancel);
+}
+
+void
+gwcSwx::prepareCancel (cdr& cancel)
 {
     cancel.setString (MessageType, "%c", SWX_UNSEQUENCED_MESSAGE_TYPE);
     cancel.setString (Type, "%c", SWX_CANCEL_ORDER_MESSAGE_TYPE);
-    return sendMsg (cancel);
 }
 
 bool
 gwcSwx::sendModify (gwcOrder& modify)
 {
+    gwcLatencyScope latency (mLatency);
+
     if (!mapOrderFields (modify))
         return false;
     
@@ -133,72 +186,56 @@ gwcSwx::sendModify (gwcOrder& modify)
 
 bool
 gwcSwx::sendModify (cdr& modify)
+{
+    gwcLatencyScope latency (mLatency);
+
+    prepareModify (modify);
+    return sendModifyChecked (modify);
+}
+
+void
+gwcSwx::prepareModify (cdr& modify)
 {
     modify.setString (MessageType, "%c", SWX_UNSEQUENCED_MESSAGE_TYPE);
     modify.setString (Type, "%c", SWX_REPLACE_ORDER_MESSAGE_TYPE);
-    return sendMsg (modify);
 }
 
 void
-gwcSwx::handleSequencedMessage (cdr& msg)
+gwcSwx::handleSequencedMessage (const char* payload, cdr& msg)
 {
-    string mTypeStr;
-    bool ok = msg.getString (Type, mTypeStr);
-    if (!ok)
-    {
-        mLog->err ("no type on sequenced message [%s]", msg.toString ().c_str ());
-        return;
-    }
-
-    char mType = *(mTypeStr.c_str ());
-    switch (mType)
+    char mType = *payload;
+    gwcSwxCallback callback = gwcSwxSequencedCallbacks.mCallbacks[(uint8_t)mType];
+    if (callback == NULL)
     {
-    case SWX_SYSTEM_EVENT_MESSAGE_TYPE:
-        mMessageCbs->onAdmin (mSequenceNumber, msg);
-        break;
-
-    case SWX_ACCEPTED_MESSAGE_TYPE:
-        mMessageCbs->onOrderAck (mSequenceNumber, msg);
-        break;
-
-    case SWX_REPLACED_MESSAGE_TYPE:
-        mMessageCbs->onModifyAck (mSequenceNumber, msg);
-        break;
-        
-    case SWX_CANCELLED_MESSAGE_TYPE:
-        mMessageCbs->onOrderDone (mSequenceNumber, msg);
-        break;
-
-    case SWX_EXECUTED_ORDER_MESSAGE_TYPE:
-        mMessageCbs->onOrderFill (mSequenceNumber, msg);
-        break;
-
-    case SWX_REJECTED_ORDER_MESSAGE_TYPE:
-        mMessageCbs->onOrderRejected (mSequenceNumber, msg);
-        break;
-
-    case SWX_ORDER_PRIORITY_UPDATE_CHANGE_MESSAGE_TYPE:
-    case SWX_BROKEN_TRADE_MESSAGE_TYPE:
-        mMessageCbs->onMsg (mSequenceNumber, msg);
-        break;
-            
-    default:
         mLog->err ("unable to handle sequenced message-type [%c]", mType);
         mLog->err ("%s", msg.toString ().c_str ());
-        break;
+        return;
     }
+
+    (mMessageCbs->*callback) (mSequenceNumber, msg);
 }
 
 void
-gwcSwx::handleUnsequencedMessage (cdr& msg)
+gwcSwx::handleUnsequencedMessage (const char* payload, cdr& msg)
 {
     // pass to on message for now in-case this happens
     mMessageCbs->onMsg (mSequenceNumber, msg);
 }
 
+uint32_t
+gwcSwx::latencyKey (const cdr& msg)
+{
+    /* keyed on the message inside the unsequenced packet */
+    string type;
+    msg.getString (Type, type);
+    return gwcLatency_key (type);
+}
+
 bool
 gwcSwx::sendMsg (cdr& msg)
 {
+    gwcLatencyScope latency (mLatency);
+
     char space[1024];
     size_t used;
     
@@ -216,7 +253,183 @@ gwcSwx::sendMsg (cdr& msg)
         mLog->err ("failed to construct message [%s]", codec.getLastError ().c_str ());
         return false;
     }
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_ENCODED, latencyKey (msg));
 
     mConnection->send (space, used);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN);
+    journalOut (space, used);
     return true;
 }
+
+bool
+gwcSwx::sendMsgs (cdr** msgs, size_t n)
+{
+    gwcLatencyScope latency (mLatency);
+
+    vector<char> space (n * GWC_BATCH_MSG_SIZE);
+    vector<size_t> sizes (n);
+    size_t total = 0;
+    size_t used;
+    
+    // use a codec from the stack gets around threading issues
+    neueda::swxCodec codec;
+
+    if (mState != GWC_CONNECTOR_READY)
+    {
+        mLog->warn ("gwc not ready to send messages");
+        return false;
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (codec.encode (*msgs[i], 
+                          &space[total], 
+                          space.size () - total, 
+                          used) != GW_CODEC_SUCCESS)
+        {
+            mLog->err ("failed to construct batch message [%s]",
+                       codec.getLastError ().c_str ());
+            return false;
+        }
+        sizes[i] = used;
+        total += used;
+    }
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_ENCODED, latencyKey (*msgs[0]));
+
+    mConnection->send (&space[0], total);
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN);
+    size_t offset = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        journalOut (&space[offset], sizes[i]);
+        offset += sizes[i];
+    }
+    return true;
+}
+
+bool
+gwcSwx::createTemplate (gwcOrderTemplateType type,
+                        gwcOrder& msg,
+                        gwcOrderTemplate& tmpl)
+{
+    if (!mapOrderFields (msg))
+        return false;
+
+    msg.setString (MessageType, "%c", SWX_UNSEQUENCED_MESSAGE_TYPE);
+
+    /* tokens identify orders, a replace carries the existing and the new
+       token */
+    int clOrdIdKey = OrderToken;
+    int origClOrdIdKey = OriginalOrderToken;
+    switch (type)
+    {
+    case GWC_TEMPLATE_ORDER:
+        msg.setString (Type, "%c", SWX_ENTER_ORDER_MESSAGE_TYPE);
+        break;
+    case GWC_TEMPLATE_CANCEL:
+        msg.setString (Type, "%c", SWX_CANCEL_ORDER_MESSAGE_TYPE);
+        break;
+    case GWC_TEMPLATE_MODIFY:
+        msg.setString (Type, "%c", SWX_REPLACE_ORDER_MESSAGE_TYPE);
+        clOrdIdKey = ReplacementOrderToken;
+        origClOrdIdKey = ExistingOrderToken;
+        break;
+    }
+
+    // use a codec from the stack gets around threading issues
+    neueda::swxCodec codec;
+    tmpl.reset (this, type);
+    tmpl.setSideValues (SWX_ORDERVERB_BUY, SWX_ORDERVERB_SELL);
+    if (!tmpl.encode (codec, msg) ||
+        !tmpl.locate (codec, msg, GWC_TEMPLATE_FIELD_PRICE, OrderPrice,
+                      GWC_TEMPLATE_ENCODING_BE, 4, 0, 1) ||
+        !tmpl.locate (codec, msg, GWC_TEMPLATE_FIELD_QTY, OrderQuantity,
+                      GWC_TEMPLATE_ENCODING_BE, 4, 0, 1) ||
+        !tmpl.locate (codec, msg, GWC_TEMPLATE_FIELD_SIDE, OrderVerb,
+                      GWC_TEMPLATE_ENCODING_ALPHA, 1, 0, 1) ||
+        !tmpl.locate (codec, msg, GWC_TEMPLATE_FIELD_CLORDID, clOrdIdKey,
+                      GWC_TEMPLATE_ENCODING_BE, 4, 0, 1) ||
+        !tmpl.locate (codec, msg, GWC_TEMPLATE_FIELD_ORIG_CLORDID,
+                      origClOrdIdKey, GWC_TEMPLATE_ENCODING_BE, 4, 0, 1))
+    {
+        mLog->err ("failed to construct template [%s]",
+                   tmpl.getLastError ().c_str ());
+        tmpl.reset (NULL, type);
+        return false;
+    }
+
+    return true;
+}
+
+bool
+gwcSwx::sendTemplate (gwcOrderTemplate& tmpl)
+{
+    gwcLatencyScope latency (mLatency);
+
+    if (!tmpl.isOwner (this))
+    {
+        mLog->warn ("template not created by this connector");
+        return false;
+    }
+
+    if (!riskTemplate ())
+        return false;
+
+    if (!throttleTemplate ())
+        return false;
+
+    if (mState != GWC_CONNECTOR_READY)
+    {
+        mLog->warn ("gwc not ready to send messages");
+        return false;
+    }
+
+    mConnection->send (tmpl.getData (), tmpl.getSize ());
+    if (mLatency)
+        mLatency->outboundMark (GWC_LATENCY_OUT_WRITTEN, 0);
+    journalOut (tmpl.getData (), tmpl.getSize ());
+    return true;
+}
+
+bool
+gwcSwx::getClOrdId (const cdr& msg, bool orig, std::string& id) const
+{
+    /* a replace carries the existing and the new token */
+    if (orig)
+    {
+        return getIdField (msg, ExistingOrderToken, id) ||
+               getIdField (msg, OriginalOrderToken, id);
+    }
+    return getIdField (msg, ReplacementOrderToken, id) ||
+           getIdField (msg, OrderToken, id);
+}
+
+void
+gwcSwx::getOrderFields (const cdr& msg, gwcOrderFields& fields) const
+{
+    getIdField (msg, OrderReferenceNumber, fields.mOrderId);
+    fields.mHasOrderQty = getNumberField (msg, OrderQuantity, fields.mOrderQty);
+    fields.mHasLastQty = getNumberField (msg, ExecutedQuantity, fields.mLastQty);
+    fields.mHasLastPx = getNumberField (msg, ExecutionPrice, fields.mLastPx);
+}
+
+void
+gwcSwx::getRiskFields (const cdr& msg, gwcRiskFields& fields) const
+{
+    std::string verb;
+
+    /* swx has no account on an order, the principal stands in for it */
+    getIdField (msg, OrderBook, fields.mInstrument);
+    getIdField (msg, PrincipalId, fields.mAccount);
+    fields.mHasSide = msg.getString (OrderVerb, verb) && !verb.empty ();
+    fields.mBuy = fields.mHasSide && verb[0] == SWX_ORDERVERB_BUY;
+    fields.mHasQty = getNumberField (msg, OrderQuantity, fields.mQty);
+
+    /* market orders carry the largest price */
+    fields.mHasPrice = getNumberField (msg, OrderPrice, fields.mPrice) &&
+                       fields.mPrice != 0x7FFFFFFF;
+}
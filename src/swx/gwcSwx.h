@@ -22,12 +22,28 @@ public:
     bool sendModify (cdr& modify);
 
     bool sendMsg (cdr& msg);
+
+    bool createTemplate (gwcOrderTemplateType type,
+                         gwcOrder& msg,
+                         gwcOrderTemplate& tmpl);
+    bool sendTemplate (gwcOrderTemplate& tmpl);
+
+    bool getClOrdId (const cdr& msg, bool orig, std::string& id) const;
+
+    void getOrderFields (const cdr& msg, gwcOrderFields& fields) const;
+
+    void getRiskFields (const cdr& msg, gwcRiskFields& fields) const;
     
 protected:
     bool mapOrderFields (gwcOrder& order);
+    uint32_t latencyKey (const cdr& msg);
+    void prepareOrder (cdr& order);
+    void prepareCancel (cdr& cancel);
+    void prepareModify (cdr& modify);
+    bool sendMsgs (cdr** msgs, size_t n);
     neueda::codec& getCodec ();
-    void handleSequencedMessage (cdr& msg);
-    void handleUnsequencedMessage (cdr& msg);
+    void handleSequencedMessage (const char* payload, cdr& msg);
+    void handleUnsequencedMessage (const char* payload, cdr& msg);
 
 private:
     neueda::swxCodec mCodec;
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "gwcFixClock.h"
+
+#include <time.h>
+#include <string>
+
+using namespace ::testing;
+
+/* 2025-12-31 23:59:59 UTC */
+#define LAST_SECOND_OF_2025 1767225599
+
+class FixClockTestHarness : public ::testing::Test
+{
+protected:
+    static std::string render (gwcFixClock& clock, time_t sec, long nsec)
+    {
+        struct timespec ts;
+        ts.tv_sec = sec;
+        ts.tv_nsec = nsec;
+
+        char   s[GWC_FIX_TIME_SIZE];
+        size_t n = clock.render (ts, s);
+        return std::string (s, n);
+    }
+};
+
+// TESTS
+
+TEST_F(FixClockTestHarness, TEST_THAT_CLOCK_RENDERS_THE_NEW_SECOND_WHEN_IT_ROLLS)
+{
+    // setup
+    gwcFixClock clock;
+    std::string first = render (clock, LAST_SECOND_OF_2025, 999999999);
+
+    // do test, same second from the cache then the next day and year
+    std::string cached = render (clock, LAST_SECOND_OF_2025, 5000000);
+    std::string rolled = render (clock, LAST_SECOND_OF_2025 + 1, 1);
+    std::string earlier = render (clock, LAST_SECOND_OF_2025, 0);
+
+    // check, truncated and never rounded into the next second
+    ASSERT_EQ ("20251231-23:59:59.999", first);
+    ASSERT_EQ ("20251231-23:59:59.005", cached);
+    ASSERT_EQ ("20260101-00:00:00.000", rolled);
+    ASSERT_EQ ("20251231-23:59:59.000", earlier);
+}
+
+TEST_F(FixClockTestHarness, TEST_THAT_CLOCK_RENDERS_THE_PRECISION_SET)
+{
+    // setup
+    gwcFixClock         clock;
+    gwcFixTimePrecision micro;
+    gwcFixTimePrecision nano;
+    ASSERT_TRUE (gwcFixClock_parsePrecision ("micro", micro));
+    ASSERT_TRUE (gwcFixClock_parsePrecision ("nano", nano));
+
+    // do test
+    std::string milliTime = render (clock, LAST_SECOND_OF_2025 + 1, 12345678);
+    clock.setPrecision (micro);
+    std::string microTime = render (clock, LAST_SECOND_OF_2025 + 1, 12345678);
+    clock.setPrecision (nano);
+    std::string nanoTime = render (clock, LAST_SECOND_OF_2025 + 1, 12345678);
+
+    // check
+    ASSERT_EQ ("20260101-00:00:00.012", milliTime);
+    ASSERT_EQ ("20260101-00:00:00.012345", microTime);
+    ASSERT_EQ ("20260101-00:00:00.012345678", nanoTime);
+
+    gwcFixTimePrecision other;
+    ASSERT_FALSE (gwcFixClock_parsePrecision ("second", other));
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "gwcFixHeader.h"
+#include "gwcFixScanner.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+using namespace ::testing;
+
+#define NOW "20260101-10:00:00.123"
+
+class FixHeaderTestHarness : public ::testing::Test
+{
+protected:
+    virtual void SetUp ()
+    {
+        ASSERT_TRUE (mHeader.init ("FIX.4.4", "SENDER", "TARGET"));
+    }
+
+    /* Frame encoding as the connector does, with the header room in front */
+    std::string frame (const std::string& encoding, int64_t seqnum)
+    {
+        memcpy (mSpace + GWC_FIX_HEADER_ROOM, encoding.data (), encoding.size ());
+
+        size_t size = encoding.size ();
+        char*  data = mHeader.frame (mSpace + GWC_FIX_HEADER_ROOM,
+                                     size,
+                                     seqnum,
+                                     NOW,
+                                     sizeof NOW - 1);
+        if (data == NULL)
+            return "";
+        return std::string (data, size);
+    }
+
+    /* Message with body and BodyLength and CheckSum worked out here */
+    static std::string expected (const std::string& body)
+    {
+        char prefix[32];
+        snprintf (prefix, sizeof prefix, "8=FIX.4.4\0019=%lu\001", (unsigned long)body.size ());
+
+        std::string msg = prefix + body;
+        char        trailer[16];
+        snprintf (trailer, sizeof trailer, "10=%03u\001",
+                  gwcFix_checkSum (msg.data (), msg.size ()));
+        return msg + trailer;
+    }
+
+    gwcFixHeader mHeader;
+    char         mSpace[GWC_FIX_HEADER_ROOM + 1024];
+};
+
+// TESTS
+
+TEST_F(FixHeaderTestHarness, TEST_THAT_ENCODING_IS_FRAMED_WITH_SESSION_HEADER_AND_TRAILER)
+{
+    // setup
+    std::string encoding = "35=D\00111=order-1\00138=100\001";
+
+    // do test
+    std::string msg = frame (encoding, 7);
+
+    // check, BodyLength counts from MsgType up to the CheckSum
+    std::string body = "35=D\00149=SENDER\00156=TARGET\00134=7\00152=" NOW "\001"
+                       "11=order-1\00138=100\001";
+    ASSERT_EQ (expected (body), msg);
+
+    gwcFixMessage scanned;
+    size_t        used;
+    ASSERT_EQ (GWC_FIX_SCAN_OK,
+               gwcFix_scan (msg.data (), msg.size (), true, scanned, used));
+    ASSERT_EQ (msg.size (), used);
+}
+
+TEST_F(FixHeaderTestHarness, TEST_THAT_HEADER_AND_TRAILER_IN_THE_ENCODING_ARE_REPLACED)
+{
+    // setup, stale BodyLength and CheckSum from the codec
+    std::string encoding = "8=FIX.4.2\0019=99\00135=F\00111=order-2\00110=000\001";
+
+    // do test
+    std::string msg = frame (encoding, 123456789);
+
+    // check
+    std::string body = "35=F\00149=SENDER\00156=TARGET\00134=123456789\00152=" NOW "\001"
+                       "11=order-2\001";
+    ASSERT_EQ (expected (body), msg);
+}
+
+TEST_F(FixHeaderTestHarness, TEST_THAT_ENCODING_WITHOUT_MSG_TYPE_IS_NOT_FRAMED)
+{
+    // setup
+    std::string encoding = "11=order-3\00138=100\001";
+
+    // do test
+    memcpy (mSpace + GWC_FIX_HEADER_ROOM, encoding.data (), encoding.size ());
+    size_t size = encoding.size ();
+    char*  data = mHeader.frame (mSpace + GWC_FIX_HEADER_ROOM, size, 1, NOW, sizeof NOW - 1);
+
+    // check
+    ASSERT_TRUE (data == NULL);
+}
+
+TEST_F(FixHeaderTestHarness, TEST_THAT_FRAMED_MESSAGE_IS_WITHIN_MAX_SIZE)
+{
+    // setup, longest seqnum and a nanosecond SendingTime
+    std::string encoding (900, 'x');
+    encoding = "35=D\00158=" + encoding + "\001";
+    const char* time = "20260101-10:00:00.123456789";
+
+    // do test
+    memcpy (mSpace + GWC_FIX_HEADER_ROOM, encoding.data (), encoding.size ());
+    size_t size = encoding.size ();
+    char*  data = mHeader.frame (mSpace + GWC_FIX_HEADER_ROOM,
+                                 size,
+                                 INT64_MAX,
+                                 time,
+                                 strlen (time));
+
+    // check
+    ASSERT_TRUE (data != NULL);
+    ASSERT_GE (data, mSpace);
+    ASSERT_LE (size, mHeader.maxSize () + encoding.size () + GWC_FIX_TRAILER_SIZE);
+}
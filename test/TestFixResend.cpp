@@ -0,0 +1,241 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "gwcFixResend.h"
+#include "gwcFixScanner.h"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ::testing;
+
+#define NOW "20260101-10:00:00.123"
+#define SENT "20260101-09:00:00.456"
+
+class FixResendTestHarness : public ::testing::Test
+{
+protected:
+    virtual void SetUp ()
+    {
+        static int        tests = 0;
+        std::stringstream path;
+        path << "/tmp/gwc-fix-store-" << getpid () << "-" << tests++;
+        mPath = path.str ();
+        unlink (mPath.c_str ());
+
+        std::string err;
+        ASSERT_TRUE (mStore.open (mPath, 1024, err)) << err;
+        ASSERT_TRUE (mResend.init ("FIX.4.4", "SENDER", "TARGET"));
+    }
+
+    virtual void TearDown ()
+    {
+        mStore.close ();
+        unlink (mPath.c_str ());
+    }
+
+    /* Frame body with BeginString, BodyLength and CheckSum */
+    static std::string frame (const std::string& body)
+    {
+        std::stringstream msg;
+        msg << "8=FIX.4.4\0019=" << body.size () << "\001" << body;
+
+        std::string s = msg.str ();
+        char        trailer[16];
+        snprintf (trailer, sizeof trailer, "10=%03u\001",
+                  gwcFix_checkSum (s.data (), s.size ()));
+        return s + trailer;
+    }
+
+    /* Message of type seqnum as the connector sends it */
+    static std::string sent (const char* type, int64_t seqnum)
+    {
+        std::stringstream body;
+        body << "35=" << type << "\00149=SENDER\00156=TARGET\00134=" << seqnum
+             << "\00152=" << SENT << "\00111=order-" << seqnum << "\00138=100\001";
+        return frame (body.str ());
+    }
+
+    void store (const char* type, int64_t seqnum)
+    {
+        std::string msg = sent (type, seqnum);
+        mStore.add (seqnum, msg.data (), msg.size ());
+    }
+
+    /* Build the whole of begin to end, split into messages */
+    std::vector<std::string> resend (int64_t begin, int64_t end, size_t& failed)
+    {
+        std::vector<char>   out;
+        std::vector<size_t> sizes;
+        failed = 0;
+
+        while (begin <= end)
+            begin = mResend.build (mStore, begin, end, NOW, sizeof NOW - 1,
+                                   out, sizes, failed);
+
+        std::vector<std::string> msgs;
+        size_t                   offset = 0;
+        for (size_t i = 0; i < sizes.size (); i++)
+        {
+            msgs.push_back (std::string (&out[offset], sizes[i]));
+            offset += sizes[i];
+        }
+        EXPECT_EQ (out.size (), offset);
+        return msgs;
+    }
+
+    /* A resent message must frame and check as any inbound one */
+    static void checkFramed (const std::string& msg)
+    {
+        gwcFixMessage scanned;
+        size_t        used;
+        ASSERT_EQ (GWC_FIX_SCAN_OK,
+                   gwcFix_scan (msg.data (), msg.size (), true, scanned, used));
+        ASSERT_EQ (msg.size (), used);
+    }
+
+    std::string        mPath;
+    gwcFixMessageStore mStore;
+    gwcFixResend       mResend;
+};
+
+// TESTS
+
+TEST_F(FixResendTestHarness, TEST_THAT_KEPT_MESSAGE_IS_RESENT_WITH_POSS_DUP_AND_ORIG_SENDING_TIME)
+{
+    // setup
+    store ("D", 1);
+
+    // do test
+    size_t                   failed;
+    std::vector<std::string> msgs = resend (1, 1, failed);
+
+    // check, SendingTime is now and the original follows PossDupFlag
+    std::string body = "35=D\00149=SENDER\00156=TARGET\00134=1\001"
+                       "52=" NOW "\00143=Y\001122=" SENT "\001"
+                       "11=order-1\00138=100\001";
+    ASSERT_EQ (1u, msgs.size ());
+    ASSERT_EQ (frame (body), msgs[0]);
+    checkFramed (msgs[0]);
+    ASSERT_EQ (0u, failed);
+}
+
+TEST_F(FixResendTestHarness, TEST_THAT_SESSION_MESSAGES_AND_MISSING_ONES_ARE_GAP_FILLED)
+{
+    // setup, 1 logon, 2 order, 3 heartbeat, 4 never kept, 5 order
+    store ("A", 1);
+    store ("D", 2);
+    store ("0", 3);
+    store ("D", 5);
+
+    // do test
+    size_t                   failed;
+    std::vector<std::string> msgs = resend (1, 5, failed);
+
+    // check, each run of gaps is one SequenceReset moving on past it
+    std::string gapFill1 = "35=4\00149=SENDER\00156=TARGET\00134=1\00143=Y\001"
+                           "52=" NOW "\001122=" NOW "\001123=Y\00136=2\001";
+    std::string gapFill3 = "35=4\00149=SENDER\00156=TARGET\00134=3\00143=Y\001"
+                           "52=" NOW "\001122=" NOW "\001123=Y\00136=5\001";
+    ASSERT_EQ (4u, msgs.size ());
+    ASSERT_EQ (frame (gapFill1), msgs[0]);
+    ASSERT_NE (std::string::npos, msgs[1].find ("\00134=2\001"));
+    ASSERT_NE (std::string::npos, msgs[1].find ("\00143=Y\001122=" SENT "\001"));
+    ASSERT_EQ (frame (gapFill3), msgs[2]);
+    ASSERT_NE (std::string::npos, msgs[3].find ("\00134=5\001"));
+    for (size_t i = 0; i < msgs.size (); i++)
+        checkFramed (msgs[i]);
+    ASSERT_EQ (0u, failed);
+}
+
+TEST_F(FixResendTestHarness, TEST_THAT_TRAILING_GAP_FILLS_TO_ONE_PAST_END)
+{
+    // setup
+    store ("D", 1);
+    store ("0", 2);
+
+    // do test
+    size_t                   failed;
+    std::vector<std::string> msgs = resend (1, 3, failed);
+
+    // check
+    ASSERT_EQ (2u, msgs.size ());
+    ASSERT_NE (std::string::npos, msgs[1].find ("\00134=2\001"));
+    ASSERT_NE (std::string::npos, msgs[1].find ("\00136=4\001"));
+}
+
+TEST_F(FixResendTestHarness, TEST_THAT_UNPARSEABLE_MESSAGE_IS_GAP_FILLED_AND_COUNTED)
+{
+    // setup, no SendingTime to move
+    std::string msg = frame ("35=D\00149=SENDER\00156=TARGET\00134=1\00111=x\001");
+    mStore.add (1, msg.data (), msg.size ());
+    store ("D", 2);
+
+    // do test
+    size_t                   failed;
+    std::vector<std::string> msgs = resend (1, 2, failed);
+
+    // check
+    ASSERT_EQ (2u, msgs.size ());
+    ASSERT_NE (std::string::npos, msgs[0].find ("35=4\001"));
+    ASSERT_NE (std::string::npos, msgs[0].find ("\00136=2\001"));
+    ASSERT_EQ (1u, failed);
+}
+
+TEST_F(FixResendTestHarness, TEST_THAT_RESEND_REQUEST_RANGE_IS_LIMITED_TO_MESSAGES_SENT)
+{
+    // setup
+    int64_t begin = 0;
+    int64_t end = 0;
+    int64_t pastBegin = 12;
+    int64_t pastEnd = 20;
+    int64_t overBegin = 5;
+    int64_t overEnd = 50;
+
+    // do test
+    bool all = gwcFixResend::range (begin, end, 10);
+    bool past = gwcFixResend::range (pastBegin, pastEnd, 10);
+    bool over = gwcFixResend::range (overBegin, overEnd, 10);
+
+    // check, EndSeqNo 0 is everything sent
+    ASSERT_TRUE (all);
+    ASSERT_EQ (1, begin);
+    ASSERT_EQ (10, end);
+    ASSERT_FALSE (past);
+    ASSERT_TRUE (over);
+    ASSERT_EQ (5, overBegin);
+    ASSERT_EQ (10, overEnd);
+}
+
+TEST_F(FixResendTestHarness, TEST_THAT_LARGE_RESEND_IS_BUILT_IN_PIECES)
+{
+    // setup
+    for (int64_t i = 1; i <= 1000; i++)
+        store ("D", i);
+
+    // do test
+    std::vector<char>   out;
+    std::vector<size_t> sizes;
+    size_t              failed = 0;
+    int64_t             next = 1;
+    size_t              pieces = 0;
+    size_t              msgs = 0;
+    while (next <= 1000)
+    {
+        next = mResend.build (mStore, next, 1000, NOW, sizeof NOW - 1,
+                              out, sizes, failed);
+        ASSERT_LT (out.size (), (size_t)GWC_FIX_RESEND_SIZE + GWC_FIX_STORE_MSG_SIZE);
+        pieces++;
+        msgs += sizes.size ();
+        out.clear ();
+        sizes.clear ();
+    }
+
+    // check, every message once across more than one piece
+    ASSERT_EQ (1001, next);
+    ASSERT_GT (pieces, 1u);
+    ASSERT_EQ (1000u, msgs);
+}
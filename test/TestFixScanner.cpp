@@ -0,0 +1,290 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "gwcFixScanner.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ::testing;
+
+/* A framing case, the bytes scanned and what the scan should say */
+struct scanCase
+{
+    const char*      mName;
+    std::string      mData;
+    gwcFixScanResult mResult;
+    size_t           mUsed;
+};
+
+static const char* simds[] = { "scalar", "sse2", "avx2" };
+
+class FixScannerTestHarness : public ::testing::Test
+{
+protected:
+    /* Frame body with BeginString, BodyLength and CheckSum */
+    static std::string frame (const std::string& body)
+    {
+        std::stringstream msg;
+        msg << "8=FIX.4.4\0019=" << body.size () << "\001" << body;
+
+        std::string s = msg.str ();
+        char        trailer[16];
+        snprintf (trailer, sizeof trailer, "10=%03u\001",
+                  gwcFix_checkSum (s.data (), s.size ()));
+        return s + trailer;
+    }
+
+    static std::string order ()
+    {
+        return frame ("35=8\00134=12\00111=order-1\00131=12.5\00138=-100\001");
+    }
+
+    static gwcFixScanResult scan (const std::string& data, gwcFixMessage& msg, size_t& used)
+    {
+        return gwcFix_scan (data.data (), data.size (), true, msg, used);
+    }
+
+    /* Bytes to scan, not all SOH free so both finds have work */
+    static std::vector<char> randomBytes (size_t size)
+    {
+        std::vector<char> data (size);
+        for (size_t i = 0; i < size; i++)
+            data[i] = (rand () % 8) == 0 ? '\001' : (char)(rand () & 0xff);
+        return data;
+    }
+};
+
+// TESTS
+
+TEST_F(FixScannerTestHarness, TEST_THAT_FRAMING_BOUNDARIES_SCAN_AS_EXPECTED)
+{
+    // setup
+    std::string msg = order ();
+    std::string badSum = msg;
+    badSum[badSum.size () - 2] = badSum[badSum.size () - 2] == '0' ? '1' : '0';
+    std::string badLength = "8=FIX.4.4\0019=5\00135=0\00111=x\00110=000\001";
+
+    scanCase cases[] = {
+        { "empty", "", GWC_FIX_SCAN_SHORT, 0 },
+        { "first byte", "8", GWC_FIX_SCAN_SHORT, 0 },
+        { "stray byte", "x", GWC_FIX_SCAN_GARBLED, 1 },
+        { "begin string", "8=FIX.4.4", GWC_FIX_SCAN_SHORT, 0 },
+        { "no body length tag", "8=FIX.4.4\0019", GWC_FIX_SCAN_SHORT, 0 },
+        { "body length digits", "8=FIX.4.4\0019=12", GWC_FIX_SCAN_SHORT, 0 },
+        { "body length not digits", "8=FIX.4.4\0019=x\001", GWC_FIX_SCAN_GARBLED, 14 },
+        { "body length too large", "8=FIX.4.4\0019=99999999\001", GWC_FIX_SCAN_GARBLED, 21 },
+        { "begin string too long", std::string ("8=") + std::string (40, 'X'),
+          GWC_FIX_SCAN_GARBLED, 42 },
+        { "all but the last byte", msg.substr (0, msg.size () - 1), GWC_FIX_SCAN_SHORT, 0 },
+        { "whole message", msg, GWC_FIX_SCAN_OK, msg.size () },
+        { "message and more", msg + "8=FIX", GWC_FIX_SCAN_OK, msg.size () },
+        { "bad check sum", badSum, GWC_FIX_SCAN_GARBLED, badSum.size () },
+        { "body length short of the trailer", badLength, GWC_FIX_SCAN_GARBLED, badLength.size () },
+        { "garbage before a message", "xx\001" + msg, GWC_FIX_SCAN_GARBLED, 3 }
+    };
+
+    for (size_t i = 0; i < sizeof cases / sizeof cases[0]; i++)
+    {
+        // do test
+        gwcFixMessage    scanned;
+        size_t           used;
+        gwcFixScanResult result = scan (cases[i].mData, scanned, used);
+
+        // check
+        ASSERT_EQ (cases[i].mResult, result) << cases[i].mName;
+        ASSERT_EQ (cases[i].mUsed, used) << cases[i].mName;
+    }
+}
+
+TEST_F(FixScannerTestHarness, TEST_THAT_GARBLED_STREAM_RESYNCS_ON_THE_NEXT_MESSAGE)
+{
+    // setup, garbage, a message with a bad CheckSum, a stray field and a
+    // good message
+    std::string msg = order ();
+    std::string badSum = msg;
+    badSum[badSum.size () - 2] = badSum[badSum.size () - 2] == '0' ? '1' : '0';
+    std::string stream = "garbage\001" + badSum + "x\001" + msg;
+
+    // do test, as the connector reads
+    size_t offset = 0;
+    size_t garbled = 0;
+    size_t ok = 0;
+    while (offset < stream.size ())
+    {
+        gwcFixMessage scanned;
+        size_t        used = 0;
+        switch (scan (stream.substr (offset), scanned, used))
+        {
+        case GWC_FIX_SCAN_OK:
+            ok++;
+            break;
+        case GWC_FIX_SCAN_GARBLED:
+            garbled++;
+            break;
+        case GWC_FIX_SCAN_SHORT:
+            FAIL () << "short at " << offset;
+        }
+        ASSERT_GT (used, 0u);
+        offset += used;
+    }
+
+    // check
+    ASSERT_EQ (stream.size (), offset);
+    ASSERT_EQ (1u, ok);
+    ASSERT_EQ (3u, garbled);
+}
+
+TEST_F(FixScannerTestHarness, TEST_THAT_FIELDS_ARE_INDEXED_AND_READ_TYPED)
+{
+    // setup
+    std::string msg = frame ("35=AE\00134=12\00111=order-1\00131=12.5\00138=-100\001");
+
+    // do test
+    gwcFixMessage scanned;
+    size_t        used;
+    ASSERT_EQ (GWC_FIX_SCAN_OK, scan (msg, scanned, used));
+
+    // check
+    ASSERT_TRUE (scanned.isIndexed ());
+    ASSERT_EQ (8u, scanned.getFieldCount ());
+    ASSERT_EQ (8u, scanned.getField (0).mTag);
+    ASSERT_EQ (10u, scanned.getField (7).mTag);
+    ASSERT_EQ ((uint32_t)'A' | ((uint32_t)'E' << 8), scanned.getMsgType ());
+    ASSERT_EQ (gwcFix_msgType (msg.data (), msg.size ()), scanned.getMsgType ());
+
+    int64_t     seqnum;
+    int64_t     qty;
+    double      price;
+    std::string id;
+    ASSERT_TRUE (scanned.getInteger (34, seqnum));
+    ASSERT_EQ (12, seqnum);
+    ASSERT_TRUE (scanned.getInteger (38, qty));
+    ASSERT_EQ (-100, qty);
+    ASSERT_TRUE (scanned.getDouble (31, price));
+    ASSERT_EQ (12.5, price);
+    ASSERT_TRUE (scanned.getString (11, id));
+    ASSERT_EQ ("order-1", id);
+    ASSERT_FALSE (scanned.getInteger (11, qty));
+    ASSERT_FALSE (scanned.getString (44, id));
+}
+
+TEST_F(FixScannerTestHarness, TEST_THAT_DATA_FIELD_MAY_HOLD_SOH)
+{
+    // setup, RawData of 5 bytes with a SOH in it
+    std::string msg = frame ("35=8\00195=5\00196=ab\001cd\00158=after\001");
+
+    // do test
+    gwcFixMessage scanned;
+    size_t        used;
+    ASSERT_EQ (GWC_FIX_SCAN_OK, scan (msg, scanned, used));
+
+    // check
+    std::string raw;
+    std::string text;
+    ASSERT_TRUE (scanned.isIndexed ());
+    ASSERT_TRUE (scanned.getString (96, raw));
+    ASSERT_EQ (std::string ("ab\001cd", 5), raw);
+    ASSERT_TRUE (scanned.getString (58, text));
+    ASSERT_EQ ("after", text);
+}
+
+TEST_F(FixScannerTestHarness, TEST_THAT_DATA_FIELD_OF_THE_WRONG_LENGTH_IS_FRAMED_NOT_INDEXED)
+{
+    // setup
+    std::string msg = frame ("35=8\00195=3\00196=ab\001cd\00158=after\001");
+
+    // do test
+    gwcFixMessage scanned;
+    size_t        used;
+    gwcFixScanResult result = scan (msg, scanned, used);
+
+    // check
+    ASSERT_EQ (GWC_FIX_SCAN_OK, result);
+    ASSERT_EQ (msg.size (), used);
+    ASSERT_FALSE (scanned.isIndexed ());
+}
+
+TEST_F(FixScannerTestHarness, TEST_THAT_MESSAGE_WITH_TOO_MANY_FIELDS_IS_FRAMED_NOT_INDEXED)
+{
+    // setup
+    std::string body = "35=8\001";
+    for (int i = 0; i < GWC_FIX_MAX_FIELDS; i++)
+        body += "58=x\001";
+    std::string msg = frame (body);
+
+    // do test
+    gwcFixMessage scanned;
+    size_t        used;
+    gwcFixScanResult result = scan (msg, scanned, used);
+
+    // check
+    ASSERT_EQ (GWC_FIX_SCAN_OK, result);
+    ASSERT_EQ (msg.size (), used);
+    ASSERT_FALSE (scanned.isIndexed ());
+}
+
+TEST_F(FixScannerTestHarness, TEST_THAT_EACH_INSTRUCTION_SET_AGREES_WITH_A_PLAIN_LOOP)
+{
+    // setup, every alignment and tail length and all bytes 0xff so lane
+    // sums would overflow if not emptied
+    srand (1);
+    std::vector<char> ones (5000, (char)0xff);
+    std::vector<char> data = randomBytes (5000);
+
+    for (size_t s = 0; s < sizeof simds / sizeof simds[0]; s++)
+    {
+        uint32_t sum;
+        if (!gwcFix_checkSumWith (simds[s], &data[0], 0, sum))
+            continue;
+
+        for (size_t start = 0; start < 32; start++)
+        {
+            for (size_t size = 0; start + size < data.size (); size += size < 300 ? 1 : 97)
+            {
+                // do test
+                uint32_t onesSum;
+                ASSERT_TRUE (gwcFix_checkSumWith (simds[s], &data[start], size, sum));
+                ASSERT_TRUE (gwcFix_checkSumWith (simds[s], &ones[start], size, onesSum));
+
+                uint32_t offsets[GWC_FIX_MAX_FIELDS];
+                size_t   n;
+                ASSERT_TRUE (gwcFix_findSohWith (simds[s],
+                                                 &data[start],
+                                                 size,
+                                                 offsets,
+                                                 GWC_FIX_MAX_FIELDS,
+                                                 n));
+
+                // check
+                uint32_t              plain = 0;
+                std::vector<uint32_t> sohs;
+                for (size_t i = 0; i < size; i++)
+                {
+                    plain += (unsigned char)data[start + i];
+                    if (data[start + i] == '\001')
+                        sohs.push_back ((uint32_t)i);
+                }
+                ASSERT_EQ (plain & 0xff, sum) << simds[s] << " " << start << " " << size;
+                ASSERT_EQ ((uint32_t)((size * 0xff) & 0xff), onesSum) << simds[s] << " " << size;
+
+                if (sohs.size () > GWC_FIX_MAX_FIELDS)
+                {
+                    ASSERT_EQ ((size_t)GWC_FIX_MAX_FIELDS + 1, n) << simds[s] << " " << size;
+                    sohs.resize (GWC_FIX_MAX_FIELDS);
+                }
+                else
+                    ASSERT_EQ (sohs.size (), n) << simds[s] << " " << size;
+                for (size_t i = 0; i < sohs.size (); i++)
+                    ASSERT_EQ (sohs[i], offsets[i]) << simds[s] << " " << size;
+            }
+        }
+    }
+
+    // the set in use is one of those checked
+    std::string inUse = gwcFix_simdName ();
+    ASSERT_TRUE (inUse == "scalar" || inUse == "sse2" || inUse == "avx2");
+}
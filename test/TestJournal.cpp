@@ -0,0 +1,281 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "gwcJournal.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sstream>
+#include <vector>
+
+using namespace neueda;
+using namespace ::testing;
+
+/* Message written by writerCb, its index in the first 8 bytes */
+struct journalMsg
+{
+    uint64_t mIndex;
+    char     mText[56];
+};
+
+struct journalWriter
+{
+    gwcJournal* mJournal;
+    uint16_t    mSession;
+    uint64_t    mCount;
+};
+
+class JournalTestHarness : public ::testing::Test
+{
+protected:
+    virtual void SetUp ()
+    {
+        static int        tests = 0;
+        std::stringstream path;
+        path << "/tmp/gwc-journal-" << getpid () << "-" << tests++;
+        mPath = path.str ();
+        removeFiles ();
+    }
+
+    virtual void TearDown ()
+    {
+        removeFiles ();
+    }
+
+    void removeFiles ()
+    {
+        unlink (mPath.c_str ());
+        for (int i = 1; i <= 8; i++)
+            unlink (rolledPath (i).c_str ());
+    }
+
+    std::string rolledPath (int n)
+    {
+        std::stringstream path;
+        path << mPath << "." << n;
+        return path.str ();
+    }
+
+    static void* writerCb (void* closure)
+    {
+        journalWriter* writer = reinterpret_cast<journalWriter*>(closure);
+
+        for (uint64_t i = 0; i < writer->mCount; i++)
+        {
+            journalMsg msg;
+            memset (&msg, 0, sizeof msg);
+            msg.mIndex = i;
+            snprintf (msg.mText, sizeof msg.mText, "message %llu", (unsigned long long)i);
+            writer->mJournal->write (writer->mSession, GWC_JOURNAL_OUT, &msg, sizeof msg);
+        }
+        return NULL;
+    }
+
+    /* Read every message record in path, by session */
+    static bool readAll (const std::string& path,
+                         std::vector<std::vector<uint64_t> >& bySession,
+                         std::vector<std::string>& names)
+    {
+        gwcJournalReader reader;
+        std::string      err;
+        if (!reader.open (path, err))
+            return false;
+
+        gwcJournalRecord record;
+        const char*      data;
+        while (reader.next (record, data))
+        {
+            if (record.mLength != sizeof (journalMsg))
+                return false;
+
+            journalMsg msg;
+            memcpy (&msg, data, sizeof msg);
+            if (bySession.size () <= record.mSession)
+            {
+                bySession.resize (record.mSession + 1);
+                names.resize (record.mSession + 1);
+            }
+            bySession[record.mSession].push_back (msg.mIndex);
+            names[record.mSession] = reader.getSessionName (record.mSession);
+        }
+        return true;
+    }
+
+    std::string mPath;
+};
+
+// TESTS
+
+TEST_F(JournalTestHarness, TEST_THAT_ATTACH_SHARES_A_JOURNAL_PER_PATH)
+{
+    // setup
+    std::string err;
+    gwcJournal* first = gwcJournal::attach (mPath, 0, 0, 0, err);
+    ASSERT_TRUE (first != NULL) << err;
+
+    // do test
+    gwcJournal* second = gwcJournal::attach (mPath, 0, 0, 0, err);
+
+    // check
+    ASSERT_EQ (first, second);
+    ASSERT_EQ (0, first->addSession ("first"));
+    ASSERT_EQ (1, second->addSession ("second"));
+    gwcJournal::detach (second);
+    gwcJournal::detach (first);
+}
+
+TEST_F(JournalTestHarness, TEST_THAT_RECORDS_FROM_CONCURRENT_SESSIONS_ARE_READ_BACK_IN_ORDER)
+{
+    // setup, enough to wrap the smallest ring several times
+    std::string err;
+    gwcJournal* journal = gwcJournal::attach (mPath, 0, 0, 0, err);
+    ASSERT_TRUE (journal != NULL) << err;
+
+    journalWriter writers[4];
+    sbfThread     threads[4];
+    for (int i = 0; i < 4; i++)
+    {
+        std::stringstream name;
+        name << "session-" << i;
+        writers[i].mJournal = journal;
+        writers[i].mSession = journal->addSession (name.str ());
+        writers[i].mCount = 20000;
+    }
+
+    // do test
+    for (int i = 0; i < 4; i++)
+        ASSERT_EQ (0, sbfThread_create (&threads[i], writerCb, &writers[i]));
+    for (int i = 0; i < 4; i++)
+        sbfThread_join (threads[i]);
+    gwcJournal::detach (journal);
+
+    // check, nothing lost and each session in the order it wrote
+    std::vector<std::vector<uint64_t> > bySession;
+    std::vector<std::string>            names;
+    ASSERT_TRUE (readAll (mPath, bySession, names));
+    ASSERT_EQ (4u, bySession.size ());
+    for (int i = 0; i < 4; i++)
+    {
+        std::stringstream name;
+        name << "session-" << i;
+        ASSERT_EQ (name.str (), names[i]);
+        ASSERT_EQ (20000u, bySession[i].size ());
+        for (uint64_t j = 0; j < bySession[i].size (); j++)
+            ASSERT_EQ (j, bySession[i][j]);
+    }
+}
+
+TEST_F(JournalTestHarness, TEST_THAT_JOURNAL_ROLLS_AT_MAX_SIZE)
+{
+    // setup
+    std::string err;
+    gwcJournal* journal = gwcJournal::attach (mPath, 64 * 1024, 0, 0, err);
+    ASSERT_TRUE (journal != NULL) << err;
+
+    journalWriter writer;
+    writer.mJournal = journal;
+    writer.mSession = journal->addSession ("rolling");
+    writer.mCount = 5000;
+
+    // do test, about 400KB of records
+    writerCb (&writer);
+    gwcJournal::detach (journal);
+
+    // check, every file names the session and the files hold every record
+    std::vector<uint64_t> all;
+    int                   files = 0;
+    for (int i = 8; i >= 0; i--)
+    {
+        std::string path = i == 0 ? mPath : rolledPath (i);
+        if (access (path.c_str (), F_OK) != 0)
+            continue;
+
+        std::vector<std::vector<uint64_t> > bySession;
+        std::vector<std::string>            names;
+        ASSERT_TRUE (readAll (path, bySession, names)) << path;
+        ASSERT_EQ (1u, bySession.size ()) << path;
+        ASSERT_EQ ("rolling", names[0]) << path;
+        all.insert (all.end (), bySession[0].begin (), bySession[0].end ());
+        files++;
+    }
+    ASSERT_GT (files, 1);
+    ASSERT_EQ (5000u, all.size ());
+    for (uint64_t j = 0; j < all.size (); j++)
+        ASSERT_EQ (j, all[j]);
+}
+
+TEST_F(JournalTestHarness, TEST_THAT_FILE_COUNT_BOUNDS_ROLLED_FILES)
+{
+    // setup
+    std::string err;
+    gwcJournal* journal = gwcJournal::attach (mPath, 16 * 1024, 3, 0, err);
+    ASSERT_TRUE (journal != NULL) << err;
+
+    journalWriter writer;
+    writer.mJournal = journal;
+    writer.mSession = journal->addSession ("bounded");
+    writer.mCount = 5000;
+
+    // do test
+    writerCb (&writer);
+    gwcJournal::detach (journal);
+
+    // check, the newest two rolled files are kept and no more
+    ASSERT_EQ (0, access (mPath.c_str (), F_OK));
+    ASSERT_EQ (0, access (rolledPath (1).c_str (), F_OK));
+    ASSERT_EQ (0, access (rolledPath (2).c_str (), F_OK));
+    ASSERT_NE (0, access (rolledPath (3).c_str (), F_OK));
+}
+
+TEST_F(JournalTestHarness, TEST_THAT_EARLIER_JOURNAL_IS_ROLLED_AT_START_UP)
+{
+    // setup, a journal left by an earlier run
+    std::string err;
+    gwcJournal* journal = gwcJournal::attach (mPath, 0, 0, 0, err);
+    ASSERT_TRUE (journal != NULL) << err;
+    journalWriter writer;
+    writer.mJournal = journal;
+    writer.mSession = journal->addSession ("earlier");
+    writer.mCount = 10;
+    writerCb (&writer);
+    gwcJournal::detach (journal);
+
+    // do test
+    journal = gwcJournal::attach (mPath, 0, 0, 0, err);
+    ASSERT_TRUE (journal != NULL) << err;
+    writer.mJournal = journal;
+    writer.mSession = journal->addSession ("later");
+    writer.mCount = 5;
+    writerCb (&writer);
+    gwcJournal::detach (journal);
+
+    // check
+    std::vector<std::vector<uint64_t> > earlier;
+    std::vector<std::vector<uint64_t> > later;
+    std::vector<std::string>            names;
+    ASSERT_TRUE (readAll (rolledPath (1), earlier, names));
+    ASSERT_EQ ("earlier", names[0]);
+    ASSERT_EQ (10u, earlier[0].size ());
+    ASSERT_TRUE (readAll (mPath, later, names));
+    ASSERT_EQ ("later", names[0]);
+    ASSERT_EQ (5u, later[0].size ());
+}
+
+TEST_F(JournalTestHarness, TEST_THAT_READER_REFUSES_A_FILE_THAT_IS_NOT_A_JOURNAL)
+{
+    // setup
+    FILE* f = fopen (mPath.c_str (), "wb");
+    ASSERT_TRUE (f != NULL);
+    fputs ("8=FIX.4.2\0019=5\00135=0\00110=000\001", f);
+    fclose (f);
+
+    // do test
+    gwcJournalReader reader;
+    std::string      err;
+    bool             ok = reader.open (mPath, err);
+
+    // check
+    ASSERT_FALSE (ok);
+    ASSERT_FALSE (err.empty ());
+}
@@ -26,11 +26,19 @@ public:
         mRealTimeConnection = *connection;
     }
 
+    gwcMillenniumRecovery<lseCodec>* getRecovery ()
+    {
+        if (mRecoveries.empty ())
+            mRecoveries.push_back (new gwcMillenniumRecovery<lseCodec> (this));
+        return mRecoveries[0];
+    }
+
     void setRecoveryConnection (SbfTcpConnection** connection)
     {
-        if (mRecoveryConnection)
-            delete mRecoveryConnection;
-        mRecoveryConnection = *connection;
+        gwcMillenniumRecovery<lseCodec>* recovery = getRecovery ();
+        if (recovery->mConnection)
+            delete recovery->mConnection;
+        recovery->mConnection = *connection;
     }
 
     void mockRealTimeConnectionReady ()
@@ -50,20 +58,33 @@ public:
 
     void mockRecoveryConnectionReady ()
     {
-        mRecoveryConnectionDelegate.onReady ();
+        getRecovery ()->mDelegate.onReady ();
     }
 
     void mockRecoveryConnectionError ()
     {
-        mRecoveryConnectionDelegate.onError ();
+        getRecovery ()->mDelegate.onError ();
     }
 
     size_t mockRecoveryConnectionRead (void* data, size_t len)
     {
-        return mRecoveryConnectionDelegate.onRead (data, len);
+        return getRecovery ()->mDelegate.onRead (data, len);
     }
 };
 
+class MockLseTypedCallbacks : public gwcMillenniumTypedCallbacks<lseCodec>
+{
+public:
+    MOCK_METHOD2 (onExecutionReport, void(uint64_t seqno,
+                                          const LseExecutionReport& msg));
+
+    MOCK_METHOD2 (onOrderCancelReject, void(uint64_t seqno,
+                                            const LseOrderCancelReject& msg));
+
+    MOCK_METHOD2 (onBusinessReject, void(uint64_t seqno,
+                                         const LseBusinessReject& msg));
+};
+
 class LseMillenniumTestHarness : public Test
 {
 protected:
@@ -130,11 +151,19 @@ protected:
         return d;
     }
 
-    cdr setExecutionReport (cdr d, string execType)
+    cdr setMissedMessageReport (cdr d, int responseType)
+    {
+        d.setString (MessageType, GW_MILLENNIUM_MISSED_MESSAGE_REPORT);
+        d.setInteger (ResponseType, responseType);
+
+        return d;
+    }
+
+    cdr setExecutionReport (cdr d, string execType, int seqno = 1234)
     {
         d.setString (MessageType, GW_MILLENNIUM_EXECUTION_REPORT);
         d.setInteger (AppID, 123);
-        d.setInteger (SequenceNo, 1234);
+        d.setInteger (SequenceNo, seqno);
         d.setString (ExecutionID, "mockExecID");
         d.setString (ClientOrderID, "123");
         d.setString (OrderID, "orderID");
@@ -205,7 +234,8 @@ protected:
     void setupMockRecoveryConnection ()
     {       
         mRecoveryDelegate =
-            new gwcMillenniumRecoveryConnectionDelegate<lseCodec>(mConnector);
+            new gwcMillenniumRecoveryConnectionDelegate<lseCodec>(
+                mConnector, mConnector->getRecovery ());
         mMockRecoveryConnection = new MockSbfTcpConnection (
             NULL,
             NULL,
@@ -303,6 +333,30 @@ protected:
         mockRealTimeMessage (d);
     }
 
+    void mockExecutionMessageRecovery (string execType, int seqno)
+    {
+        cdr d;
+        d = setExecutionReport (d, execType, seqno);
+
+        mockRecoveryMessage (d);
+    }
+
+    void mockExecutionMessageRealTime (string execType, int seqno)
+    {
+        cdr d;
+        d = setExecutionReport (d, execType, seqno);
+
+        mockRealTimeMessage (d);
+    }
+
+    void mockMissedMessageReport ()
+    {
+        cdr d;
+        d = setMissedMessageReport (d, 0);
+
+        mockRecoveryMessage (d);
+    }
+
     void mockFullInitilizedConnector ()
     {
         mockInitilizeConnector ();
@@ -369,6 +423,12 @@ protected:
     bool mMockConnectionActive;
 };
 
+static gwcConnector*
+getMockLseConnector (logger* log, const properties& props)
+{
+    return new MockLseConnector (log);
+}
+
 // TESTS
 
 TEST_F(LseMillenniumTestHarness, TEST_THAT_INIT_FAILS_ON_MISSING_REALTIME_HOST_PARAM)
@@ -547,3 +607,280 @@ TEST_F(LseMillenniumTestHarness, TEST_THAT_ON_EXECUTION_EXEC_TYPE_DEFAULT_ON_MSG
     
     mockExecutionMessageRealTime ("E");
 }
+
+TEST_F(LseMillenniumTestHarness, TEST_THAT_PATCHED_TEMPLATE_MATCHES_ENCODED_ORDER)
+{
+    // setup
+    mockInitilizeConnector ();
+
+    gwcOrder order = getMockNewOrder ();
+    gwcOrderTemplate tmpl;
+    ASSERT_TRUE (mConnector->createTemplate (GWC_TEMPLATE_ORDER, order, tmpl));
+
+    gwcOrder expected = getMockNewOrder ();
+    expected.setPrice (1250.5);
+    expected.setQty (2000);
+    expected.setSide (GWC_SIDE_SELL);
+    expected.setString (ClientOrderID, "myorder2");
+    gwcOrderTemplate expectedTmpl;
+    ASSERT_TRUE (mConnector->createTemplate (GWC_TEMPLATE_ORDER, 
+                                             expected, 
+                                             expectedTmpl));
+
+    // do test
+    ASSERT_TRUE (tmpl.setPrice (1250.5));
+    ASSERT_TRUE (tmpl.setQty (2000));
+    ASSERT_TRUE (tmpl.setSide (GWC_SIDE_SELL));
+    ASSERT_TRUE (tmpl.setClOrdId (std::string ("myorder2")));
+
+    // check
+    ASSERT_EQ (tmpl.getSize (), expectedTmpl.getSize ());
+    ASSERT_EQ (0, memcmp (tmpl.getData (), 
+                          expectedTmpl.getData (), 
+                          tmpl.getSize ()));
+}
+
+TEST_F(LseMillenniumTestHarness, TEST_THAT_CANNOT_SEND_TEMPLATE_IF_NOT_LOGGED_ON)
+{
+    // setup
+    mockInitilizeConnector ();
+    EXPECT_CALL(*mSessionCallbacks, onLoggingOn(_)).Times(1);
+    mConnector->mockRealTimeConnectionReady ();
+
+    gwcOrder order = getMockNewOrder ();
+    gwcOrderTemplate tmpl;
+    ASSERT_TRUE (mConnector->createTemplate (GWC_TEMPLATE_ORDER, order, tmpl));
+
+    // do test
+    bool ok = mConnector->sendTemplate (tmpl);
+
+    // check
+    ASSERT_FALSE (ok);
+}
+
+TEST_F(LseMillenniumTestHarness, TEST_THAT_CAN_SEND_TEMPLATE_IF_LOGGED_ON)
+{
+    // setup
+    mockFullInitilizedConnector ();
+
+    gwcOrder order = getMockNewOrder ();
+    gwcOrderTemplate tmpl;
+    ASSERT_TRUE (mConnector->createTemplate (GWC_TEMPLATE_ORDER, order, tmpl));
+    ASSERT_TRUE (tmpl.setClOrdId (std::string ("myorder2")));
+
+    // do test
+    bool ok = mConnector->sendTemplate (tmpl);
+
+    // check
+    ASSERT_TRUE (ok);
+}
+
+TEST_F(LseMillenniumTestHarness, TEST_THAT_CANNOT_SEND_BATCH_IF_NOT_LOGGED_ON)
+{
+    // setup
+    mockInitilizeConnector ();
+    EXPECT_CALL(*mSessionCallbacks, onLoggingOn(_)).Times(1);
+    mConnector->mockRealTimeConnectionReady ();
+
+    gwcOrder orders[3];
+    for (int i = 0; i < 3; i++)
+        orders[i] = getMockNewOrder ();
+
+    // do test
+    bool ok = mConnector->sendOrders (orders, 3);
+
+    // check
+    ASSERT_FALSE (ok);
+}
+
+TEST_F(LseMillenniumTestHarness, TEST_THAT_BATCH_OF_ORDERS_IS_SENT_IN_ONE_WRITE)
+{
+    // setup
+    mockFullInitilizedConnector ();
+
+    size_t single = 0;
+    size_t batch = 0;
+    EXPECT_CALL(*mMockRealTimeConnection, send(_, _))
+        .WillOnce(SaveArg<1>(&single))
+        .WillOnce(SaveArg<1>(&batch))
+        .WillRepeatedly(Return ());
+
+    gwcOrder order = getMockNewOrder ();
+    ASSERT_TRUE (mConnector->sendOrder (order));
+
+    gwcOrder orders[3];
+    for (int i = 0; i < 3; i++)
+        orders[i] = getMockNewOrder ();
+
+    // do test
+    bool ok = mConnector->sendOrders (orders, 3);
+
+    // check
+    ASSERT_TRUE (ok);
+    ASSERT_EQ (3 * single, batch);
+}
+
+TEST_F(LseMillenniumTestHarness, TEST_THAT_AMEND_REJECTED_WITH_CANCEL_REJECT_RELEASES_ITS_RISK)
+{
+    // setup
+    mProps->setProperty ("risk_checks", "true");
+    mockFullInitilizedConnector ();
+
+    gwcOrder order = getMockNewOrder ();
+    ASSERT_TRUE (mConnector->sendOrder (order));
+    double held = mConnector->getRisk ()->getInstrumentExposure ("133215");
+
+    gwcOrder modify = getMockNewOrder ();
+    modify.setString (ClientOrderID, "myorder1");
+    modify.setString (OriginalClientOrderID, "myorder");
+    modify.setQty (2000);
+    ASSERT_TRUE (mConnector->sendModify (modify));
+    double amended = mConnector->getRisk ()->getInstrumentExposure ("133215");
+
+    // do test, the venue only sends the amend's id back
+    EXPECT_CALL(*mMessageCallbacks, onCancelRejected(_, _)).Times(1);
+    cdr reject;
+    reject.setString (MessageType, GW_MILLENNIUM_ORDER_CANCEL_REJECT);
+    reject.setInteger (AppID, 123);
+    reject.setInteger (SequenceNo, 1234);
+    reject.setString (ClientOrderID, "myorder1");
+    reject.setString (OrderID, "orderID");
+    reject.setInteger (CancelRejectReason, 2000);
+    mockRealTimeMessage (reject);
+
+    // check, only the order is held again
+    ASSERT_GT (amended, held);
+    ASSERT_EQ (held, mConnector->getRisk ()->getInstrumentExposure ("133215"));
+    ASSERT_EQ (1u, mConnector->getRisk ()->snapshot ().mOpenOrders);
+}
+
+TEST_F(LseMillenniumTestHarness, TEST_THAT_TYPED_CALLBACKS_ARE_REFUSED_WITH_ORDER_CACHE)
+{
+    // setup
+    mProps->setProperty ("order_cache", "true");
+    mockFullInitilizedConnector ();
+    MockLseTypedCallbacks typedCbs;
+
+    // do test
+    bool set = mConnector->setTypedCallbacks (&typedCbs);
+
+    // check, the cache keeps seeing executions
+    ASSERT_FALSE (set);
+    EXPECT_CALL(typedCbs, onExecutionReport(_, _)).Times(0);
+    EXPECT_CALL(*mMessageCallbacks, onOrderAck(_, _)).Times(1);
+    mockExecutionMessageRealTime ("0");
+    ASSERT_EQ (1u, mConnector->getOrderCache ()->getCount ());
+}
+
+TEST_F(LseMillenniumTestHarness, TEST_THAT_INIT_FAILS_WITH_TYPED_CALLBACKS_AND_ORDER_CACHE)
+{
+    // setup
+    MockLseTypedCallbacks typedCbs;
+    ASSERT_TRUE (mConnector->setTypedCallbacks (&typedCbs));
+    mProps->setProperty ("real_time_host", "127.0.0.1:9899");
+    mProps->setProperty ("recovery_host", "127.0.0.1:10000");
+    mProps->setProperty ("order_cache", "true");
+
+    // do test
+    bool ok = mConnector->init (mSessionCallbacks, mMessageCallbacks, *mProps);
+
+    // check
+    ASSERT_FALSE (ok);
+    mConnector->setTypedCallbacks (NULL);
+}
+
+TEST_F(LseMillenniumTestHarness, TEST_THAT_TYPED_CALLBACKS_ARE_REFUSED_WITH_RISK_CHECKS)
+{
+    // setup
+    mProps->setProperty ("risk_checks", "true");
+    mockFullInitilizedConnector ();
+    gwcOrder order = getMockNewOrder ();
+    order.setString (ClientOrderID, "123");
+    ASSERT_TRUE (mConnector->sendOrder (order));
+    MockLseTypedCallbacks typedCbs;
+
+    // do test
+    bool set = mConnector->setTypedCallbacks (&typedCbs);
+
+    // check, the done order still lets go of what it held
+    ASSERT_FALSE (set);
+    EXPECT_CALL(typedCbs, onExecutionReport(_, _)).Times(0);
+    EXPECT_CALL(*mMessageCallbacks, onOrderDone(_, _)).Times(1);
+    mockExecutionMessageRealTime ("4");
+    ASSERT_EQ (0u, mConnector->getRisk ()->snapshot ().mOpenOrders);
+    ASSERT_EQ (0, mConnector->getRisk ()->getInstrumentExposure ("133215"));
+}
+
+TEST_F(LseMillenniumTestHarness, TEST_THAT_TYPED_CALLBACK_REPLACES_CDR_CALLBACK_FOR_EXECUTION)
+{
+    // setup
+    mockFullInitilizedConnector ();
+    MockLseTypedCallbacks typedCbs;
+    mConnector->setTypedCallbacks (&typedCbs);
+
+    EXPECT_CALL(typedCbs, onExecutionReport(1234, _)).Times(1);
+    EXPECT_CALL(*mMessageCallbacks, onOrderAck(_, _)).Times(0);
+
+    mockExecutionMessageRealTime ("0");
+    mConnector->setTypedCallbacks (NULL);
+}
+
+TEST_F(LseMillenniumTestHarness, TEST_THAT_TYPED_CALLBACK_DOES_NOT_TAKE_SESSION_MESSAGES)
+{
+    // setup
+    mockFullInitilizedConnector ();
+    MockLseTypedCallbacks typedCbs;
+    mConnector->setTypedCallbacks (&typedCbs);
+
+    EXPECT_CALL(typedCbs, onExecutionReport(_, _)).Times(0);
+    EXPECT_CALL(*mMessageCallbacks, onMsg(_, _)).Times(1);
+
+    mockRejectMessageRealTime ();
+    mConnector->setTypedCallbacks (NULL);
+}
+
+TEST_F(LseMillenniumTestHarness, TEST_THAT_REAL_TIME_MESSAGES_ARE_HELD_UNTIL_PARTITION_IS_RECOVERED)
+{
+    // setup, partition 123 last seen at 1234
+    mockFullInitilizedConnector ();
+    EXPECT_CALL(*mMessageCallbacks, onOrderAck(1234, _)).Times(1);
+    mockExecutionMessageRealTime ("0");
+
+    // log on again, recovery of partition 123 starts
+    setupMockRecoveryConnection ();
+    EXPECT_CALL(*mMessageCallbacks, onAdmin(_, _))
+        .Times (AnyNumber ());
+    mockLogonReplyRealTime ();
+
+    // do test
+    {
+        InSequence seq;
+        EXPECT_CALL(*mMessageCallbacks, onOrderAck(1235, _)).Times(1);
+        EXPECT_CALL(*mMessageCallbacks, onOrderAck(1236, _)).Times(1);
+        EXPECT_CALL(*mMessageCallbacks, onOrderAck(1237, _)).Times(1);
+        EXPECT_CALL(*mSessionCallbacks, onLoggedOn(_, _)).Times(1);
+    }
+
+    mockExecutionMessageRealTime ("0", 1236);
+    mockExecutionMessageRealTime ("0", 1237);
+    mockLogonReplyRecovery ();
+    mockExecutionMessageRecovery ("0", 1235);
+    mockExecutionMessageRecovery ("0", 1236);
+
+    // check, held 1236 was downloaded so only 1237 is released
+    mockMissedMessageReport ();
+}
+
+TEST_F(LseMillenniumTestHarness, TEST_THAT_FACTORY_GETS_REGISTERED_CONNECTOR_WITHOUT_LOADING_IT)
+{
+    ASSERT_TRUE (gwcConnectorFactory::add ("mocklse", getMockLseConnector));
+
+    // there is no libgwcmocklse to load, the registry has to be used
+    gwcConnector* connector = gwcConnectorFactory::get (mLogger,
+                                                        "mocklse",
+                                                        *mProps);
+    ASSERT_TRUE (connector != NULL);
+    ASSERT_TRUE (dynamic_cast<MockLseConnector*> (connector) != NULL);
+
+    delete connector;
+}
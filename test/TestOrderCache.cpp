@@ -0,0 +1,185 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "gwcOrderCache.h"
+
+#include <pthread.h>
+#include <sstream>
+#include <string>
+
+using namespace neueda;
+using namespace ::testing;
+
+/* Orders kept open at once by the writer in the reader test */
+#define OPEN_ORDERS 5
+
+static std::string
+orderId (int n)
+{
+    std::stringstream s;
+    s << "order-" << n;
+    return s.str ();
+}
+
+/* Reader looking for the newest order, which stays open until the writer
+   is OPEN_ORDERS further on */
+struct cacheReader
+{
+    gwcOrderCache* mCache;
+    volatile int   mNewest;
+    volatile bool  mStop;
+    size_t         mMissed;
+    size_t         mFinds;
+};
+
+static void*
+readCache (void* closure)
+{
+    cacheReader* reader = (cacheReader*)closure;
+    gwcOpenOrder order;
+
+    while (!reader->mStop)
+    {
+        int n = reader->mNewest;
+        __sync_synchronize ();
+        bool found = reader->mCache->find (orderId (n), order);
+        __sync_synchronize ();
+
+        /* a miss only counts if the order was open the whole time */
+        if (!found && reader->mNewest < n + OPEN_ORDERS)
+            reader->mMissed++;
+        reader->mFinds++;
+    }
+    return NULL;
+}
+
+class OrderCacheTestHarness : public ::testing::Test
+{
+protected:
+    static std::string id (int n)
+    {
+        return orderId (n);
+    }
+
+    static gwcOrderFields ack (double qty)
+    {
+        gwcOrderFields fields;
+        fields.mHasOrderQty = true;
+        fields.mOrderQty = qty;
+        return fields;
+    }
+
+    bool found (const std::string& clOrdId)
+    {
+        gwcOpenOrder order;
+        return mCache->find (clOrdId, order);
+    }
+
+    virtual void TearDown ()
+    {
+        delete mCache;
+    }
+
+    gwcOrderCache* mCache;
+};
+
+// TESTS
+
+TEST_F(OrderCacheTestHarness, TEST_THAT_ORDERS_AFTER_A_REMOVED_ONE_ARE_STILL_FOUND)
+{
+    // setup, more orders than half the slots so probes run into each other
+    mCache = new gwcOrderCache (16);
+    for (int i = 0; i < 12; i++)
+        ASSERT_TRUE (mCache->acked (id (i), ack (100)));
+
+    // do test, remove every other one
+    for (int i = 0; i < 12; i += 2)
+        mCache->done (id (i), "");
+
+    // check
+    ASSERT_EQ (6u, mCache->getCount ());
+    for (int i = 0; i < 12; i++)
+        ASSERT_EQ (i % 2 == 1, found (id (i))) << id (i);
+}
+
+TEST_F(OrderCacheTestHarness, TEST_THAT_CHURN_DOES_NOT_FILL_THE_TABLE)
+{
+    // setup
+    mCache = new gwcOrderCache (8);
+
+    // do test, many more orders through the table than it has slots with
+    // a few open at once
+    for (int i = 0; i < 10000; i++)
+    {
+        ASSERT_TRUE (mCache->acked (id (i), ack (100)));
+        if (i >= 5)
+            mCache->done (id (i - 5), "");
+    }
+
+    // check, the open ones are found and a miss still ends
+    ASSERT_EQ (5u, mCache->getCount ());
+    for (int i = 9995; i < 10000; i++)
+        ASSERT_TRUE (found (id (i))) << id (i);
+    ASSERT_FALSE (found (id (0)));
+    ASSERT_FALSE (found ("never-sent"));
+}
+
+TEST_F(OrderCacheTestHarness, TEST_THAT_MODIFY_MOVES_THE_ORDER_TO_ITS_NEW_ID)
+{
+    // setup
+    mCache = new gwcOrderCache (8);
+    for (int i = 0; i < 6; i++)
+        ASSERT_TRUE (mCache->acked (id (i), ack (100)));
+    gwcOrderFields fill;
+    fill.mHasLastQty = true;
+    fill.mLastQty = 40;
+    ASSERT_TRUE (mCache->filled (id (0), fill));
+
+    // do test
+    ASSERT_TRUE (mCache->modified ("modify-0", id (0), ack (200)));
+
+    // check, what was filled moves with it
+    gwcOpenOrder order;
+    ASSERT_FALSE (found (id (0)));
+    ASSERT_TRUE (mCache->find ("modify-0", order));
+    ASSERT_EQ (40, order.mCumQty);
+    ASSERT_EQ (160, order.mLeavesQty);
+    ASSERT_EQ (GWC_ORDER_STATE_PARTIALLY_FILLED, order.mState);
+    ASSERT_EQ (6u, mCache->getCount ());
+    for (int i = 1; i < 6; i++)
+        ASSERT_TRUE (found (id (i))) << id (i);
+}
+
+TEST_F(OrderCacheTestHarness, TEST_THAT_READER_FINDS_OPEN_ORDERS_WHILE_OTHERS_MOVE)
+{
+    // setup, few enough slots that most orders are away from home
+    mCache = new gwcOrderCache (8);
+    ASSERT_TRUE (mCache->acked (id (0), ack (100)));
+
+    cacheReader reader;
+    reader.mCache = mCache;
+    reader.mNewest = 0;
+    reader.mStop = false;
+    reader.mMissed = 0;
+    reader.mFinds = 0;
+
+    pthread_t thread;
+    ASSERT_EQ (0, pthread_create (&thread, NULL, readCache, &reader));
+
+    // do test, each remove shifts the orders after it back
+    for (int i = 1; i < 200000; i++)
+    {
+        ASSERT_TRUE (mCache->acked (id (i), ack (100)));
+        __sync_synchronize ();
+        reader.mNewest = i;
+        __sync_synchronize ();
+        if (i >= OPEN_ORDERS)
+            mCache->done (id (i - OPEN_ORDERS), "");
+    }
+    reader.mStop = true;
+    pthread_join (thread, NULL);
+
+    // check
+    ASSERT_GT (reader.mFinds, 0u);
+    ASSERT_EQ (0u, reader.mMissed);
+}
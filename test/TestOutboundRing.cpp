@@ -0,0 +1,221 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "gwcOutboundRing.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <vector>
+
+using namespace neueda;
+using namespace ::testing;
+
+#define PRODUCERS 8
+#define MESSAGES 20000
+
+/* Producer id and per producer count, the sequence number is in front */
+struct ringMsg
+{
+    uint64_t mSeqnum;
+    uint32_t mProducer;
+    uint32_t mCount;
+};
+
+class RecordingDelegate : public gwcOutboundRingDelegate
+{
+public:
+    RecordingDelegate () :
+        mSends (0),
+        mDrained (0)
+    { }
+
+    virtual void onSend (const void* data, size_t size)
+    {
+        const char* p = (const char*)data;
+        mBytes.insert (mBytes.end (), p, p + size);
+        mSends++;
+    }
+
+    virtual void onSent (uint64_t seq, const void* data, size_t size)
+    {
+        mSent.push_back (seq);
+    }
+
+    virtual void onDrained (uint64_t next)
+    {
+        mDrained = next;
+    }
+
+    std::vector<ringMsg> messages () const
+    {
+        std::vector<ringMsg> msgs (mBytes.size () / sizeof (ringMsg));
+        if (!msgs.empty ())
+            memcpy (&msgs[0], &mBytes[0], msgs.size () * sizeof (ringMsg));
+        return msgs;
+    }
+
+    std::vector<char>     mBytes;
+    std::vector<uint64_t> mSent;
+    size_t                mSends;
+    uint64_t              mDrained;
+};
+
+class OutboundRingTestHarness : public ::testing::Test
+{
+protected:
+    struct producer
+    {
+        gwcOutboundRing* mRing;
+        uint32_t         mId;
+        bool             mOk;
+    };
+
+    static void* produce (void* closure)
+    {
+        producer* p = reinterpret_cast<producer*>(closure);
+
+        p->mOk = true;
+        for (uint32_t i = 0; i < MESSAGES; i++)
+        {
+            ringMsg  msg;
+            uint64_t ticket = p->mRing->claim ();
+
+            msg.mSeqnum = gwcOutboundRing::seqnum (ticket);
+            msg.mProducer = p->mId;
+            msg.mCount = i;
+            if (!p->mRing->publish (ticket, &msg, sizeof msg))
+                p->mOk = false;
+        }
+        return NULL;
+    }
+
+    RecordingDelegate mDelegate;
+};
+
+// TESTS
+
+TEST_F(OutboundRingTestHarness, TEST_THAT_CONCURRENT_PRODUCERS_ARE_SENT_IN_SEQUENCE_ORDER)
+{
+    // setup, a small ring so producers wait on each other
+    gwcOutboundRing ring (16, &mDelegate);
+    ring.reset (1);
+
+    pthread_t threads[PRODUCERS];
+    producer  producers[PRODUCERS];
+
+    // do test
+    for (uint32_t i = 0; i < PRODUCERS; i++)
+    {
+        producers[i].mRing = &ring;
+        producers[i].mId = i;
+        ASSERT_EQ (0, pthread_create (&threads[i], NULL, produce, &producers[i]));
+    }
+    for (uint32_t i = 0; i < PRODUCERS; i++)
+        pthread_join (threads[i], NULL);
+
+    // check, every message once, in seqnum order and each producer's in
+    // the order it sent them
+    std::vector<ringMsg> msgs = mDelegate.messages ();
+    ASSERT_EQ ((size_t)PRODUCERS * MESSAGES, msgs.size ());
+    ASSERT_EQ ((size_t)PRODUCERS * MESSAGES, mDelegate.mSent.size ());
+
+    std::vector<uint32_t> counts (PRODUCERS, 0);
+    for (size_t i = 0; i < msgs.size (); i++)
+    {
+        ASSERT_EQ (i + 1, msgs[i].mSeqnum);
+        ASSERT_EQ (i + 1, mDelegate.mSent[i]);
+        ASSERT_LT (msgs[i].mProducer, (uint32_t)PRODUCERS);
+        ASSERT_EQ (counts[msgs[i].mProducer]++, msgs[i].mCount);
+    }
+    for (uint32_t i = 0; i < PRODUCERS; i++)
+        ASSERT_TRUE (producers[i].mOk);
+
+    ASSERT_EQ ((uint64_t)PRODUCERS * MESSAGES + 1, ring.next ());
+    ASSERT_EQ ((uint64_t)PRODUCERS * MESSAGES + 1, mDelegate.mDrained);
+}
+
+TEST_F(OutboundRingTestHarness, TEST_THAT_OVERSIZE_MESSAGE_IS_REFUSED_WITHOUT_HOLDING_UP_THE_RING)
+{
+    // setup
+    gwcOutboundRing ring (4, &mDelegate);
+    ring.reset (1);
+
+    char big[GWC_OUTBOUND_SLOT_SIZE + 1];
+    memset (big, 'x', sizeof big);
+    ringMsg msg;
+    memset (&msg, 0, sizeof msg);
+
+    // do test
+    ASSERT_FALSE (gwcOutboundRing::fits (sizeof big));
+    uint64_t first = ring.claim ();
+    uint64_t second = ring.claim ();
+    bool bigOk = ring.publish (first, big, sizeof big);
+    msg.mSeqnum = gwcOutboundRing::seqnum (second);
+    bool ok = ring.publish (second, &msg, sizeof msg);
+
+    // check, nothing of the big message is written and the next one is
+    ASSERT_FALSE (bigOk);
+    ASSERT_TRUE (ok);
+    ASSERT_EQ (sizeof msg, mDelegate.mBytes.size ());
+    ASSERT_EQ (1u, mDelegate.mSent.size ());
+    ASSERT_EQ (2u, mDelegate.mSent[0]);
+    ASSERT_EQ (3u, mDelegate.mDrained);
+}
+
+TEST_F(OutboundRingTestHarness, TEST_THAT_CLAIM_MADE_BEFORE_RESET_FAILS_TO_PUBLISH)
+{
+    // setup
+    gwcOutboundRing ring (4, &mDelegate);
+    ring.reset (1);
+
+    ringMsg msg;
+    memset (&msg, 0, sizeof msg);
+    uint64_t stale = ring.claim ();
+
+    // do test, session logs on again at seqnum 1
+    ring.reset (1);
+    uint64_t fresh = ring.claim ();
+    bool staleOk = ring.publish (stale, &msg, sizeof msg);
+    msg.mSeqnum = gwcOutboundRing::seqnum (fresh);
+    bool freshOk = ring.publish (fresh, &msg, sizeof msg);
+
+    // check, same seqnum but only the claim after the reset is sent
+    ASSERT_EQ (gwcOutboundRing::seqnum (stale), gwcOutboundRing::seqnum (fresh));
+    ASSERT_FALSE (staleOk);
+    ASSERT_TRUE (freshOk);
+    ASSERT_EQ (1u, mDelegate.mSent.size ());
+    ASSERT_EQ (1u, mDelegate.mSent[0]);
+    ASSERT_EQ (sizeof msg, mDelegate.mBytes.size ());
+}
+
+TEST_F(OutboundRingTestHarness, TEST_THAT_FULL_RING_CAN_BE_RESET_WHILE_PRODUCERS_WAIT)
+{
+    // setup, a ring of two slots so producers are mostly waiting on it
+    gwcOutboundRing ring (2, &mDelegate);
+    ring.reset (1);
+
+    pthread_t threads[PRODUCERS];
+    producer  producers[PRODUCERS];
+    for (uint32_t i = 0; i < PRODUCERS; i++)
+    {
+        producers[i].mRing = &ring;
+        producers[i].mId = i;
+        ASSERT_EQ (0, pthread_create (&threads[i], NULL, produce, &producers[i]));
+    }
+
+    // do test, reset while they run
+    for (int i = 0; i < 50; i++)
+        ring.reset (1);
+    for (uint32_t i = 0; i < PRODUCERS; i++)
+        pthread_join (threads[i], NULL);
+
+    // check, nobody hung and between resets seqnums are contiguous
+    std::vector<ringMsg> msgs = mDelegate.messages ();
+    ASSERT_FALSE (msgs.empty ());
+    ASSERT_EQ (1u, msgs[0].mSeqnum);
+    for (size_t i = 1; i < msgs.size (); i++)
+    {
+        if (msgs[i].mSeqnum != 1)
+            ASSERT_EQ (msgs[i - 1].mSeqnum + 1, msgs[i].mSeqnum);
+    }
+}
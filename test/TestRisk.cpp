@@ -0,0 +1,321 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "gwcRisk.h"
+
+#include <sstream>
+#include <string>
+
+using namespace neueda;
+using namespace ::testing;
+
+class RiskTestHarness : public ::testing::Test
+{
+protected:
+    virtual void SetUp ()
+    {
+        gwcRiskLimits limits;
+        limits.mMaxInstrumentExposure = 100000;
+        mRisk = new gwcRisk (limits, 8, 8, 8);
+    }
+
+    virtual void TearDown ()
+    {
+        delete mRisk;
+    }
+
+    /* start again with only these limits */
+    void setLimits (const gwcRiskLimits& limits)
+    {
+        delete mRisk;
+        mRisk = new gwcRisk (limits, 8, 8, 8);
+    }
+
+    static std::string id (int n)
+    {
+        std::stringstream s;
+        s << "order-" << n;
+        return s.str ();
+    }
+
+    static gwcRiskFields order (const std::string& clOrdId, double qty, double price)
+    {
+        gwcRiskFields fields;
+        fields.mClOrdId = clOrdId;
+        fields.mInstrument = "VOD";
+        fields.mAccount = "ACC";
+        fields.mHasSide = true;
+        fields.mBuy = true;
+        fields.mHasQty = true;
+        fields.mQty = qty;
+        fields.mHasPrice = true;
+        fields.mPrice = price;
+        return fields;
+    }
+
+    static gwcRiskFields modify (const std::string& clOrdId,
+                                 const std::string& origClOrdId,
+                                 double qty)
+    {
+        gwcRiskFields fields;
+        fields.mClOrdId = clOrdId;
+        fields.mOrigClOrdId = origClOrdId;
+        fields.mHasQty = true;
+        fields.mQty = qty;
+        return fields;
+    }
+
+    double exposure ()
+    {
+        return mRisk->getInstrumentExposure ("VOD");
+    }
+
+    gwcRisk* mRisk;
+};
+
+// TESTS
+
+TEST_F(RiskTestHarness, TEST_THAT_ORDERS_COMING_AND_GOING_DO_NOT_FILL_THE_TABLE)
+{
+    // do test, many more orders than slots with a few open at once
+    for (int i = 0; i < 10000; i++)
+    {
+        ASSERT_EQ (GWC_RISK_PASSED, mRisk->checkOrder (order (id (i), 1, 10))) << i;
+        if (i >= 5)
+            mRisk->done (id (i - 5));
+    }
+
+    // check, the open ones are still found and let go
+    ASSERT_EQ (5u, mRisk->snapshot ().mOpenOrders);
+    ASSERT_EQ (50, exposure ());
+    for (int i = 9995; i < 10000; i++)
+        mRisk->done (id (i));
+    ASSERT_EQ (0u, mRisk->snapshot ().mOpenOrders);
+    ASSERT_EQ (0, exposure ());
+}
+
+TEST_F(RiskTestHarness, TEST_THAT_ORDERS_AFTER_A_DONE_ONE_KEEP_WHAT_THEY_HOLD)
+{
+    // setup, most of the slots taken so probes run into each other
+    for (int i = 0; i < 7; i++)
+        ASSERT_EQ (GWC_RISK_PASSED, mRisk->checkOrder (order (id (i), 10, i + 1)));
+
+    // do test
+    mRisk->done (id (0));
+    mRisk->done (id (3));
+    mRisk->filled (id (5), 10, false, 0);
+
+    // check, 10 each open at 2, 3, 5 and 7 and 10 filled at 6
+    ASSERT_EQ (170 + 60, exposure ());
+    ASSERT_EQ (GWC_RISK_PASSED, mRisk->checkModify (modify ("modify-1", id (1), 20)));
+    mRisk->modified ("modify-1", id (1));
+    ASSERT_EQ (4u, mRisk->snapshot ().mOpenOrders);
+    ASSERT_EQ (190 + 60, exposure ());
+}
+
+TEST_F(RiskTestHarness, TEST_THAT_MODIFY_KEEPING_THE_ID_CHANGES_THE_ORDER_ONLY_ONCE_ACKED)
+{
+    // setup
+    ASSERT_EQ (GWC_RISK_PASSED, mRisk->checkOrder (order ("order-1", 100, 10)));
+
+    // do test, a larger modify rejected then a smaller one acked
+    ASSERT_EQ (GWC_RISK_PASSED, mRisk->checkModify (modify ("order-1", "", 300)));
+    double pending = exposure ();
+    mRisk->release ("order-1", "order-1");
+    double rejected = exposure ();
+
+    ASSERT_EQ (GWC_RISK_PASSED, mRisk->checkModify (modify ("order-1", "", 50)));
+    double smaller = exposure ();
+    mRisk->filled ("order-1", 20, false, 0);
+    mRisk->modified ("order-1", "");
+    double acked = exposure ();
+
+    // check, the larger of order and modify is held until the ack
+    ASSERT_EQ (3000, pending);
+    ASSERT_EQ (1000, rejected);
+    ASSERT_EQ (1000, smaller);
+    ASSERT_EQ (300 + 200, acked);
+
+    mRisk->filled ("order-1", 30, false, 0);
+    ASSERT_EQ (0u, mRisk->snapshot ().mOpenOrders);
+}
+
+TEST_F(RiskTestHarness, TEST_THAT_MODIFY_WITH_A_NEW_ID_REJECTED_BY_ITS_ID_ALONE_IS_RELEASED)
+{
+    // setup
+    ASSERT_EQ (GWC_RISK_PASSED, mRisk->checkOrder (order ("order-1", 100, 10)));
+    ASSERT_EQ (GWC_RISK_PASSED, mRisk->checkModify (modify ("order-2", "order-1", 200)));
+    double amended = exposure ();
+
+    // do test, as a reject without the original id is passed
+    mRisk->release ("order-2", "order-2");
+
+    // check
+    ASSERT_EQ (3000, amended);
+    ASSERT_EQ (1000, exposure ());
+    ASSERT_EQ (1u, mRisk->snapshot ().mOpenOrders);
+
+    // and a modify that is acked stays as the order
+    ASSERT_EQ (GWC_RISK_PASSED, mRisk->checkModify (modify ("order-3", "order-1", 50)));
+    mRisk->modified ("order-3", "order-1");
+    mRisk->release ("order-3", "order-3");
+    ASSERT_EQ (500, exposure ());
+}
+
+TEST_F(RiskTestHarness, TEST_THAT_ORDER_OVER_MAX_QTY_IS_REJECTED)
+{
+    // setup
+    gwcRiskLimits limits;
+    limits.mMaxOrderQty = 100;
+    setLimits (limits);
+
+    // do test
+    gwcRiskResult at = mRisk->checkOrder (order ("order-1", 100, 10));
+    gwcRiskResult over = mRisk->checkOrder (order ("order-2", 101, 10));
+
+    // check
+    ASSERT_EQ (GWC_RISK_PASSED, at);
+    ASSERT_EQ (GWC_RISK_MAX_ORDER_QTY, over);
+    ASSERT_EQ (1u, mRisk->snapshot ().mPassed);
+    ASSERT_EQ (1u, mRisk->snapshot ().mRejected);
+    ASSERT_EQ (GWC_RISK_MAX_ORDER_QTY,
+               mRisk->checkModify (modify ("order-3", "order-1", 101)));
+}
+
+TEST_F(RiskTestHarness, TEST_THAT_ORDER_OVER_MAX_NOTIONAL_IS_REJECTED)
+{
+    // setup
+    gwcRiskLimits limits;
+    limits.mMaxOrderNotional = 1000;
+    setLimits (limits);
+
+    // do test
+    gwcRiskResult at = mRisk->checkOrder (order ("order-1", 100, 10));
+    gwcRiskResult over = mRisk->checkOrder (order ("order-2", 100, 10.5));
+
+    // check, a modify is valued at the order's price when it has none
+    ASSERT_EQ (GWC_RISK_PASSED, at);
+    ASSERT_EQ (GWC_RISK_MAX_ORDER_NOTIONAL, over);
+    ASSERT_EQ (GWC_RISK_MAX_ORDER_NOTIONAL,
+               mRisk->checkModify (modify ("order-3", "order-1", 101)));
+    ASSERT_EQ (1000, exposure ());
+}
+
+TEST_F(RiskTestHarness, TEST_THAT_ORDER_OVER_INSTRUMENT_EXPOSURE_IS_REJECTED)
+{
+    // setup
+    gwcRiskLimits limits;
+    limits.mMaxInstrumentExposure = 1000;
+    setLimits (limits);
+    ASSERT_EQ (GWC_RISK_PASSED, mRisk->checkOrder (order ("order-1", 60, 10)));
+
+    // do test
+    gwcRiskResult at = mRisk->checkOrder (order ("order-2", 40, 10));
+    gwcRiskResult over = mRisk->checkOrder (order ("order-3", 1, 10));
+    gwcRiskFields other = order ("order-4", 1, 10);
+    other.mInstrument = "BT";
+    gwcRiskResult otherInstrument = mRisk->checkOrder (other);
+
+    // check
+    ASSERT_EQ (GWC_RISK_PASSED, at);
+    ASSERT_EQ (GWC_RISK_INSTRUMENT_EXPOSURE, over);
+    ASSERT_EQ (GWC_RISK_PASSED, otherInstrument);
+    ASSERT_EQ (1000, exposure ());
+
+    // and room is made once an order is done
+    mRisk->done ("order-2");
+    ASSERT_EQ (GWC_RISK_PASSED, mRisk->checkOrder (order ("order-3", 1, 10)));
+}
+
+TEST_F(RiskTestHarness, TEST_THAT_ORDER_OVER_ACCOUNT_EXPOSURE_IS_REJECTED)
+{
+    // setup
+    gwcRiskLimits limits;
+    limits.mMaxAccountExposure = 1000;
+    setLimits (limits);
+    ASSERT_EQ (GWC_RISK_PASSED, mRisk->checkOrder (order ("order-1", 100, 10)));
+
+    // do test, the account is held across instruments
+    gwcRiskFields sameAccount = order ("order-2", 1, 10);
+    sameAccount.mInstrument = "BT";
+    gwcRiskFields otherAccount = order ("order-3", 1, 10);
+    otherAccount.mAccount = "ACC2";
+    gwcRiskResult over = mRisk->checkOrder (sameAccount);
+    gwcRiskResult other = mRisk->checkOrder (otherAccount);
+
+    // check
+    ASSERT_EQ (GWC_RISK_ACCOUNT_EXPOSURE, over);
+    ASSERT_EQ (GWC_RISK_PASSED, other);
+    ASSERT_EQ (1000, mRisk->getAccountExposure ("ACC"));
+    ASSERT_EQ (10, mRisk->getAccountExposure ("ACC2"));
+}
+
+TEST_F(RiskTestHarness, TEST_THAT_ORDERS_OVER_THE_RATE_ARE_REJECTED)
+{
+    // setup
+    gwcRiskLimits limits;
+    limits.mMaxOrderRate = 3;
+    setLimits (limits);
+
+    // do test, well within a second
+    for (int i = 0; i < 3; i++)
+        ASSERT_EQ (GWC_RISK_PASSED, mRisk->checkOrder (order (id (i), 1, 10))) << i;
+    gwcRiskResult order4 = mRisk->checkOrder (order (id (3), 1, 10));
+    gwcRiskResult modify1 = mRisk->checkModify (modify ("modify-1", id (0), 2));
+
+    // check, modifies count against the rate too
+    ASSERT_EQ (GWC_RISK_ORDER_RATE, order4);
+    ASSERT_EQ (GWC_RISK_ORDER_RATE, modify1);
+    ASSERT_EQ (3u, mRisk->snapshot ().mOpenOrders);
+}
+
+TEST_F(RiskTestHarness, TEST_THAT_ORDER_WITHOUT_A_PRICE_NEEDS_A_REFERENCE_PRICE)
+{
+    // setup
+    gwcRiskFields market = order ("order-1", 100, 0);
+    market.mHasPrice = false;
+
+    // do test
+    gwcRiskResult noReference = mRisk->checkOrder (market);
+    ASSERT_TRUE (mRisk->setReferencePrice ("VOD", 10));
+    gwcRiskResult withReference = mRisk->checkOrder (market);
+
+    // check, it is held at the reference price
+    ASSERT_EQ (GWC_RISK_NO_PRICE, noReference);
+    ASSERT_EQ (GWC_RISK_PASSED, withReference);
+    ASSERT_EQ (1000, exposure ());
+
+    // and without a notional limit there is nothing to value it for
+    gwcRiskLimits limits;
+    limits.mMaxOrderQty = 1000;
+    setLimits (limits);
+    ASSERT_EQ (GWC_RISK_PASSED, mRisk->checkOrder (market));
+}
+
+TEST_F(RiskTestHarness, TEST_THAT_FILLS_MOVE_EXPOSURE_FROM_OPEN_NOTIONAL_TO_POSITION)
+{
+    // setup
+    ASSERT_EQ (GWC_RISK_PASSED, mRisk->checkOrder (order ("order-1", 100, 10)));
+    double open = exposure ();
+
+    // do test
+    mRisk->filled ("order-1", 40, true, 10);
+    double partlyFilled = exposure ();
+    mRisk->filled ("order-1", 60, true, 11);
+    double filled = exposure ();
+
+    // check, 600 open and 400 bought then 1060 bought
+    ASSERT_EQ (1000, open);
+    ASSERT_EQ (600 + 400, partlyFilled);
+    ASSERT_EQ (1060, filled);
+    ASSERT_EQ (1060, mRisk->getAccountExposure ("ACC"));
+    ASSERT_EQ (0u, mRisk->snapshot ().mOpenOrders);
+
+    // and a sell holds its notional until it fills against the position
+    gwcRiskFields sell = order ("order-2", 50, 10);
+    sell.mBuy = false;
+    ASSERT_EQ (GWC_RISK_PASSED, mRisk->checkOrder (sell));
+    ASSERT_EQ (500 + 1060, exposure ());
+    mRisk->filled ("order-2", 50, true, 10);
+    ASSERT_EQ (560, exposure ());
+}
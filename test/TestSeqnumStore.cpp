@@ -0,0 +1,256 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "gwcSeqnumStore.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sstream>
+#include <vector>
+
+using namespace neueda;
+using namespace ::testing;
+
+/* Layout of a session's seqnos in the cache */
+struct seqnums
+{
+    uint64_t mInbound;
+    uint64_t mOutbound;
+};
+
+class SeqnumStoreTestHarness : public ::testing::Test
+{
+protected:
+    virtual void SetUp ()
+    {
+        /* short enough to name state segment slots */
+        static int        tests = 0;
+        std::stringstream path;
+        path << "/tmp/gwc-seqnums-" << getpid () << "-" << tests++;
+        mPath = path.str ();
+        mSegmentPath = mPath + ".state";
+        unlink (mPath.c_str ());
+        unlink (mSegmentPath.c_str ());
+    }
+
+    virtual void TearDown ()
+    {
+        unlink (mPath.c_str ());
+        unlink (mSegmentPath.c_str ());
+    }
+
+    static sbfError loadCb (sbfCacheFile file,
+                            sbfCacheFileItem item,
+                            void* itemData,
+                            size_t itemSize,
+                            void* closure)
+    {
+        std::vector<seqnums>* loaded = reinterpret_cast<std::vector<seqnums>*>(closure);
+
+        seqnums s;
+        memcpy (&s, itemData, sizeof s);
+        loaded->push_back (s);
+        return 0;
+    }
+
+    bool open (gwcSeqnumStore& store, std::vector<seqnums>& loaded)
+    {
+        std::string err;
+        int         created;
+
+        return store.open (mPath, sizeof (seqnums), &created, loadCb, &loaded, err);
+    }
+
+    static void update (gwcSeqnumStore& store, sbfCacheFileItem item, uint64_t outbound)
+    {
+        seqnums s;
+        s.mInbound = 1;
+        s.mOutbound = outbound;
+        store.write (item, &s, sizeof s);
+    }
+
+    /* Wait up to a second for the writer to reach commits */
+    static void waitForCommits (gwcSeqnumStore& store, uint64_t commits)
+    {
+        for (int i = 0; i < 1000 && store.getCommits () < commits; i++)
+            usleep (1000);
+    }
+
+    std::string mPath;
+    std::string mSegmentPath;
+};
+
+// TESTS
+
+TEST_F(SeqnumStoreTestHarness, TEST_THAT_SYNC_DURABILITY_COMMITS_EVERY_UPDATE)
+{
+    // setup
+    gwcSeqnumStore       store;
+    std::vector<seqnums> loaded;
+    seqnums              s = {1, 1};
+
+    store.setDurability (GWC_DURABILITY_SYNC, 1000, 64);
+    ASSERT_TRUE (open (store, loaded));
+    sbfCacheFileItem item = store.add (&s);
+    uint64_t added = store.getCommits ();
+
+    // do test
+    for (uint64_t i = 2; i <= 11; i++)
+        update (store, item, i);
+
+    // check
+    ASSERT_EQ (added + 10, store.getCommits ());
+}
+
+TEST_F(SeqnumStoreTestHarness, TEST_THAT_GROUP_DURABILITY_COMMITS_FULL_GROUP_AT_ONCE)
+{
+    // setup, an interval long enough that only the count can end the group
+    gwcSeqnumStore       store;
+    std::vector<seqnums> loaded;
+    seqnums              s = {1, 1};
+
+    store.setDurability (GWC_DURABILITY_GROUP, 5000000, 8);
+    ASSERT_TRUE (open (store, loaded));
+    sbfCacheFileItem item = store.add (&s);
+    uint64_t added = store.getCommits ();
+
+    // do test
+    for (uint64_t i = 2; i <= 9; i++)
+        update (store, item, i);
+    waitForCommits (store, added + 1);
+
+    // check, one commit for the eight updates, well before the interval
+    ASSERT_EQ (added + 1, store.getCommits ());
+    store.close ();
+}
+
+TEST_F(SeqnumStoreTestHarness, TEST_THAT_GROUP_DURABILITY_COMMITS_PARTIAL_GROUP_AFTER_INTERVAL)
+{
+    // setup
+    gwcSeqnumStore       store;
+    std::vector<seqnums> loaded;
+    seqnums              s = {1, 1};
+
+    store.setDurability (GWC_DURABILITY_GROUP, 20000, 1000);
+    ASSERT_TRUE (open (store, loaded));
+    sbfCacheFileItem item = store.add (&s);
+    uint64_t added = store.getCommits ();
+
+    // do test
+    for (uint64_t i = 2; i <= 6; i++)
+        update (store, item, i);
+    waitForCommits (store, added + 1);
+
+    // check
+    ASSERT_EQ (added + 1, store.getCommits ());
+    store.close ();
+}
+
+TEST_F(SeqnumStoreTestHarness, TEST_THAT_ASYNC_DURABILITY_BATCHES_UPDATES)
+{
+    // setup
+    gwcSeqnumStore       store;
+    std::vector<seqnums> loaded;
+    seqnums              s = {1, 1};
+
+    store.setDurability (GWC_DURABILITY_ASYNC, 50000, 1);
+    ASSERT_TRUE (open (store, loaded));
+    sbfCacheFileItem item = store.add (&s);
+    uint64_t added = store.getCommits ();
+
+    // do test
+    for (uint64_t i = 2; i <= 1001; i++)
+        update (store, item, i);
+    waitForCommits (store, added + 1);
+
+    // check, the count plays no part in async mode
+    ASSERT_LT (store.getCommits (), added + 10);
+    store.close ();
+}
+
+TEST_F(SeqnumStoreTestHarness, TEST_THAT_CLOSE_COMMITS_PENDING_UPDATES)
+{
+    // setup
+    std::vector<seqnums> loaded;
+    seqnums              s = {1, 1};
+    {
+        gwcSeqnumStore store;
+        store.setDurability (GWC_DURABILITY_GROUP, 5000000, 1000);
+        ASSERT_TRUE (open (store, loaded));
+        sbfCacheFileItem item = store.add (&s);
+
+        // do test
+        update (store, item, 42);
+        store.close ();
+    }
+
+    gwcSeqnumStore store;
+    ASSERT_TRUE (open (store, loaded));
+
+    // check
+    ASSERT_EQ (1u, loaded.size ());
+    ASSERT_EQ (42u, loaded[0].mOutbound);
+}
+
+TEST_F(SeqnumStoreTestHarness, TEST_THAT_SEQNUMS_SURVIVE_STATE_SEGMENT_REMAP)
+{
+    // setup
+    std::vector<seqnums> loaded;
+    seqnums              first = {1, 1};
+    seqnums              second = {7, 7};
+    {
+        gwcSeqnumStore store;
+        store.setDurability (GWC_DURABILITY_ASYNC, 1000, 64);
+        store.setSegment (mSegmentPath, 64);
+        ASSERT_TRUE (open (store, loaded));
+        ASSERT_TRUE (loaded.empty ());
+
+        sbfCacheFileItem a = store.add (&first);
+        sbfCacheFileItem b = store.add (&second);
+
+        // do test, stored in place then unmapped
+        update (store, a, 100);
+        update (store, b, 200);
+        store.close ();
+    }
+
+    gwcSeqnumStore store;
+    store.setSegment (mSegmentPath, 64);
+    ASSERT_TRUE (open (store, loaded));
+
+    // check, same items in the order they were added
+    ASSERT_EQ (2u, loaded.size ());
+    ASSERT_EQ (100u, loaded[0].mOutbound);
+    ASSERT_EQ (200u, loaded[1].mOutbound);
+    store.close ();
+}
+
+TEST_F(SeqnumStoreTestHarness, TEST_THAT_STATE_SEGMENT_KEEPS_OWNERS_APART)
+{
+    // setup
+    std::vector<seqnums> loaded;
+    std::vector<seqnums> other;
+    seqnums              s = {1, 1};
+
+    gwcSeqnumStore store;
+    store.setSegment (mSegmentPath, 64);
+    ASSERT_TRUE (open (store, loaded));
+    sbfCacheFileItem item = store.add (&s);
+    update (store, item, 5);
+
+    // do test, a second session in the same segment
+    std::string    err;
+    int            created;
+    gwcSeqnumStore second;
+    second.setSegment (mSegmentPath, 64);
+    bool ok = second.open (mPath + ".other", sizeof (seqnums), &created,
+                           loadCb, &other, err);
+
+    // check
+    ASSERT_TRUE (ok);
+    ASSERT_TRUE (other.empty ());
+    ASSERT_EQ (1, created);
+    second.close ();
+    store.close ();
+}
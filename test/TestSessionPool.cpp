@@ -0,0 +1,381 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "TestUtils.h"
+#include "gwcSessionPool.h"
+#include "fields.h"
+
+#include <sstream>
+
+using namespace neueda;
+using namespace ::testing;
+
+/* Connector that sends nothing and counts what the pool gives it, its
+   callbacks are driven by the test */
+class PoolConnector : public gwcConnector
+{
+public:
+    PoolConnector (logger* log) :
+        gwcConnector (log),
+        mFail (false),
+        mOrders (0),
+        mCancels (0),
+        mModifies (0)
+    { }
+
+    bool init (gwcSessionCallbacks* sessionCbs,
+               gwcMessageCallbacks* messageCbs,
+               const properties& props)
+    {
+        mSessionsCbs = sessionCbs;
+        mMessageCbs = messageCbs;
+        return true;
+    }
+
+    bool start (bool reset) { return true; }
+    bool stop () { return true; }
+    bool traderLogon (const cdr* msg) { return false; }
+
+    bool sendOrder (cdr& order)
+    {
+        if (mFail)
+            return false;
+        mOrders++;
+        return true;
+    }
+
+    bool sendOrder (gwcOrder& order)
+    {
+        return sendOrder ((cdr&)order);
+    }
+
+    bool sendCancel (cdr& cancel)
+    {
+        mCancels++;
+        return true;
+    }
+
+    bool sendCancel (gwcOrder& cancel)
+    {
+        return sendCancel ((cdr&)cancel);
+    }
+
+    bool sendModify (cdr& modify)
+    {
+        mModifies++;
+        return true;
+    }
+
+    bool sendModify (gwcOrder& modify)
+    {
+        return sendModify ((cdr&)modify);
+    }
+
+    bool sendMsg (cdr& msg) { return false; }
+    bool sendRaw (void* data, size_t len) { return false; }
+
+    bool getClOrdId (const cdr& msg, bool orig, std::string& id) const
+    {
+        return msg.getString (orig ? OrigClOrdID : ClOrdID, id);
+    }
+
+    void getOrderFields (const cdr& msg, gwcOrderFields& fields) const
+    {
+        int64_t leaves;
+        fields.mHasLeavesQty = msg.getInteger (LeavesQty, leaves);
+        fields.mLeavesQty = (double)leaves;
+    }
+
+    void logon ()
+    {
+        cdr msg;
+        mSessionsCbs->onLoggedOn (1, msg);
+    }
+
+    void logoff ()
+    {
+        cdr msg;
+        mSessionsCbs->onLoggedOff (1, msg);
+    }
+
+    void fill (const std::string& clOrdId, int64_t leaves)
+    {
+        cdr msg;
+        msg.setString (ClOrdID, clOrdId);
+        msg.setInteger (LeavesQty, leaves);
+        mMessageCbs->onOrderFill (1, msg);
+    }
+
+    void done (const std::string& clOrdId)
+    {
+        cdr msg;
+        msg.setString (ClOrdID, clOrdId);
+        mMessageCbs->onOrderDone (1, msg);
+    }
+
+    void sendFailed (const std::string& clOrdId, const std::string& origClOrdId)
+    {
+        cdr msg;
+        msg.setString (ClOrdID, clOrdId);
+        if (!origClOrdId.empty ())
+            msg.setString (OrigClOrdID, origClOrdId);
+        mMessageCbs->onSendFailed (msg);
+    }
+
+    void modifyAck (const std::string& clOrdId, const std::string& origClOrdId)
+    {
+        cdr msg;
+        reply (msg, clOrdId, origClOrdId);
+        mMessageCbs->onModifyAck (1, msg);
+    }
+
+    void modifyRejected (const std::string& clOrdId, const std::string& origClOrdId)
+    {
+        cdr msg;
+        reply (msg, clOrdId, origClOrdId);
+        mMessageCbs->onModifyRejected (1, msg);
+    }
+
+    void cancelRejected (const std::string& clOrdId, const std::string& origClOrdId)
+    {
+        cdr msg;
+        reply (msg, clOrdId, origClOrdId);
+        mMessageCbs->onCancelRejected (1, msg);
+    }
+
+    void reply (cdr& msg, const std::string& clOrdId, const std::string& origClOrdId)
+    {
+        msg.setString (ClOrdID, clOrdId);
+        if (!origClOrdId.empty ())
+            msg.setString (OrigClOrdID, origClOrdId);
+    }
+
+    bool mFail;
+    int  mOrders;
+    int  mCancels;
+    int  mModifies;
+};
+
+class SessionPoolTestHarness : public ::testing::Test
+{
+protected:
+    virtual void SetUp ()
+    {
+        mLogger = logService::getLogger ("TEST_POOL");
+        mPool = new gwcSessionPool (mLogger, &mSessionCbs, &mMessageCbs);
+
+        properties props;
+        for (int i = 0; i < 2; i++)
+        {
+            mConnectors[i] = new PoolConnector (mLogger);
+            ASSERT_TRUE (mPool->add (mConnectors[i], props));
+            mConnectors[i]->logon ();
+        }
+    }
+
+    virtual void TearDown ()
+    {
+        delete mPool;
+    }
+
+    bool sendOrder (const std::string& clOrdId)
+    {
+        cdr order;
+        order.setString (ClOrdID, clOrdId);
+        return mPool->sendOrder (order);
+    }
+
+    bool sendCancel (const std::string& clOrdId, const std::string& origClOrdId)
+    {
+        cdr cancel;
+        cancel.setString (ClOrdID, clOrdId);
+        cancel.setString (OrigClOrdID, origClOrdId);
+        return mPool->sendCancel (cancel);
+    }
+
+    bool sendModify (const std::string& clOrdId, const std::string& origClOrdId)
+    {
+        cdr modify;
+        modify.setString (ClOrdID, clOrdId);
+        modify.setString (OrigClOrdID, origClOrdId);
+        return mPool->sendModify (modify);
+    }
+
+    NiceMock<MockSessionCallbacks> mSessionCbs;
+    NiceMock<MockMessageCallbacks> mMessageCbs;
+    logger*                        mLogger;
+    gwcSessionPool*                mPool;
+    PoolConnector*                 mConnectors[2];
+};
+
+// TESTS
+
+TEST_F(SessionPoolTestHarness, TEST_THAT_NEW_ORDERS_ARE_SPREAD_OVER_SESSIONS)
+{
+    // do test
+    for (int i = 0; i < 4; i++)
+    {
+        std::stringstream clOrdId;
+        clOrdId << "order-" << i;
+        ASSERT_TRUE (sendOrder (clOrdId.str ()));
+    }
+
+    // check
+    ASSERT_EQ (2u, mPool->getReady ());
+    ASSERT_EQ (2, mConnectors[0]->mOrders);
+    ASSERT_EQ (2, mConnectors[1]->mOrders);
+}
+
+TEST_F(SessionPoolTestHarness, TEST_THAT_CANCEL_AND_MODIFY_GO_TO_THE_SESSION_THAT_SENT_THE_ORDER)
+{
+    // setup
+    ASSERT_TRUE (sendOrder ("order-1"));
+    PoolConnector* owner = (PoolConnector*)mPool->getOwner ("order-1");
+    ASSERT_TRUE (owner != NULL);
+    PoolConnector* other = owner == mConnectors[0] ? mConnectors[1] : mConnectors[0];
+
+    // do test
+    cdr modify;
+    modify.setString (ClOrdID, std::string ("order-2"));
+    modify.setString (OrigClOrdID, std::string ("order-1"));
+    ASSERT_TRUE (mPool->sendModify (modify));
+    ASSERT_TRUE (sendCancel ("order-3", "order-2"));
+
+    // check, the replacement id belongs to the same session
+    ASSERT_EQ (1, owner->mModifies);
+    ASSERT_EQ (1, owner->mCancels);
+    ASSERT_EQ (0, other->mModifies);
+    ASSERT_EQ (0, other->mCancels);
+    ASSERT_EQ (owner, mPool->getOwner ("order-2"));
+}
+
+TEST_F(SessionPoolTestHarness, TEST_THAT_ORDER_FAILS_OVER_TO_ANOTHER_SESSION)
+{
+    // setup
+    mConnectors[0]->mFail = true;
+
+    // do test
+    bool sent = sendOrder ("order-1");
+
+    // check
+    ASSERT_TRUE (sent);
+    ASSERT_EQ (0, mConnectors[0]->mOrders);
+    ASSERT_EQ (1, mConnectors[1]->mOrders);
+    ASSERT_EQ (mConnectors[1], mPool->getOwner ("order-1"));
+
+    // and nothing is sent once no session will take it
+    mConnectors[1]->mFail = true;
+    ASSERT_FALSE (sendOrder ("order-2"));
+    ASSERT_TRUE (mPool->getOwner ("order-2") == NULL);
+}
+
+TEST_F(SessionPoolTestHarness, TEST_THAT_LOGGED_OFF_SESSION_GETS_NO_ORDERS_AND_KEEPS_ITS_OWN)
+{
+    // setup
+    ASSERT_TRUE (sendOrder ("order-1"));
+    PoolConnector* owner = (PoolConnector*)mPool->getOwner ("order-1");
+    PoolConnector* other = owner == mConnectors[0] ? mConnectors[1] : mConnectors[0];
+    owner->logoff ();
+
+    // do test
+    ASSERT_TRUE (sendOrder ("order-2"));
+    ASSERT_TRUE (sendOrder ("order-3"));
+    bool cancelled = sendCancel ("order-4", "order-1");
+
+    // check, the venue only knows order-1 on the session that sent it
+    ASSERT_EQ (1u, mPool->getReady ());
+    ASSERT_EQ (1, owner->mOrders);
+    ASSERT_EQ (2, other->mOrders);
+    ASSERT_FALSE (cancelled);
+    ASSERT_EQ (0, owner->mCancels);
+
+    owner->logon ();
+    ASSERT_TRUE (sendCancel ("order-4", "order-1"));
+    ASSERT_EQ (1, owner->mCancels);
+}
+
+TEST_F(SessionPoolTestHarness, TEST_THAT_ORDER_IS_RELEASED_WHEN_FILLED_WITH_NOTHING_LEFT)
+{
+    // setup
+    ASSERT_TRUE (sendOrder ("order-1"));
+    ASSERT_TRUE (sendOrder ("order-2"));
+    PoolConnector* owner1 = (PoolConnector*)mPool->getOwner ("order-1");
+    PoolConnector* owner2 = (PoolConnector*)mPool->getOwner ("order-2");
+    EXPECT_CALL (mMessageCbs, onOrderFill (_, _)).Times (2);
+    EXPECT_CALL (mMessageCbs, onOrderDone (_, _)).Times (1);
+
+    // do test
+    owner1->fill ("order-1", 50);
+    gwcConnector* partlyFilled = mPool->getOwner ("order-1");
+    owner1->fill ("order-1", 0);
+    owner2->done ("order-2");
+
+    // check
+    ASSERT_EQ (owner1, partlyFilled);
+    ASSERT_TRUE (mPool->getOwner ("order-1") == NULL);
+    ASSERT_TRUE (mPool->getOwner ("order-2") == NULL);
+    ASSERT_FALSE (sendCancel ("order-3", "order-1"));
+}
+
+TEST_F(SessionPoolTestHarness, TEST_THAT_ORDER_NEVER_SENT_IS_RELEASED_BUT_NOT_FOR_ITS_CANCEL)
+{
+    // setup
+    ASSERT_TRUE (sendOrder ("order-1"));
+    ASSERT_TRUE (sendOrder ("order-2"));
+    PoolConnector* owner1 = (PoolConnector*)mPool->getOwner ("order-1");
+    PoolConnector* owner2 = (PoolConnector*)mPool->getOwner ("order-2");
+
+    // do test, the throttle dropped a cancel of order-1 and order-2
+    owner1->sendFailed ("order-3", "order-1");
+    owner2->sendFailed ("order-2", "");
+
+    // check
+    ASSERT_EQ (owner1, mPool->getOwner ("order-1"));
+    ASSERT_TRUE (mPool->getOwner ("order-2") == NULL);
+}
+
+TEST_F(SessionPoolTestHarness, TEST_THAT_MODIFY_ACK_RELEASES_THE_REPLACED_ID)
+{
+    // setup
+    ASSERT_TRUE (sendOrder ("order-1"));
+    ASSERT_TRUE (sendOrder ("order-3"));
+    PoolConnector* owner1 = (PoolConnector*)mPool->getOwner ("order-1");
+    PoolConnector* owner3 = (PoolConnector*)mPool->getOwner ("order-3");
+    ASSERT_TRUE (sendModify ("order-2", "order-1"));
+    ASSERT_TRUE (sendModify ("order-4", "order-3"));
+
+    // do test, the second ack doesn't carry the id it replaced
+    owner1->modifyAck ("order-2", "order-1");
+    owner3->modifyAck ("order-4", "");
+
+    // check
+    ASSERT_TRUE (mPool->getOwner ("order-1") == NULL);
+    ASSERT_EQ (owner1, mPool->getOwner ("order-2"));
+    ASSERT_TRUE (mPool->getOwner ("order-3") == NULL);
+    ASSERT_EQ (owner3, mPool->getOwner ("order-4"));
+}
+
+TEST_F(SessionPoolTestHarness, TEST_THAT_REJECTED_MODIFY_RELEASES_ONLY_ITS_OWN_ID)
+{
+    // setup
+    ASSERT_TRUE (sendOrder ("order-1"));
+    ASSERT_TRUE (sendOrder ("order-3"));
+    PoolConnector* owner1 = (PoolConnector*)mPool->getOwner ("order-1");
+    PoolConnector* owner3 = (PoolConnector*)mPool->getOwner ("order-3");
+    ASSERT_TRUE (sendModify ("order-2", "order-1"));
+    ASSERT_TRUE (sendModify ("order-4", "order-3"));
+    ASSERT_TRUE (sendModify ("order-1", "order-1"));
+
+    // do test, the amend of order-3 is rejected with a cancel reject
+    // carrying only its own id as millennium does
+    owner1->modifyRejected ("order-2", "order-1");
+    owner3->cancelRejected ("order-4", "");
+    owner1->modifyRejected ("order-1", "order-1");
+    owner3->cancelRejected ("order-3", "");
+
+    // check
+    ASSERT_TRUE (mPool->getOwner ("order-2") == NULL);
+    ASSERT_TRUE (mPool->getOwner ("order-4") == NULL);
+    ASSERT_EQ (owner1, mPool->getOwner ("order-1"));
+    ASSERT_EQ (owner3, mPool->getOwner ("order-3"));
+}
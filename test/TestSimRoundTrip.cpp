@@ -0,0 +1,261 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "gwcConnector.h"
+#include "gwcSimVenue.h"
+#include "gwcFix.h"
+
+#include <time.h>
+#include <unistd.h>
+
+using namespace neueda;
+using namespace ::testing;
+
+#ifdef GWC_STATIC_CONNECTORS
+GWC_REGISTER_CONNECTOR (millennium);
+GWC_REGISTER_CONNECTOR (fix);
+GWC_REGISTER_CONNECTOR (eti);
+GWC_REGISTER_CONNECTOR (optiq);
+GWC_REGISTER_CONNECTOR (swx);
+#endif
+
+/* Seconds to wait for the simulator to answer */
+#define SIM_TIMEOUT 10
+
+class SimSessionCallbacks : public gwcSessionCallbacks
+{
+public:
+    SimSessionCallbacks (gwcSimVenue* venue) :
+        mVenue (venue),
+        mLoggedOn (0),
+        mLoggedOff (0),
+        mError (0)
+    { }
+
+    void onLoggingOn (cdr& msg)
+    {
+        mVenue->onLoggingOn (msg);
+    }
+
+    bool onError (const std::string& error)
+    {
+        __sync_fetch_and_add (&mError, 1);
+        return false;
+    }
+
+    void onLoggedOn (uint64_t seqno, const cdr& msg)
+    {
+        __sync_lock_test_and_set (&mLoggedOn, 1);
+    }
+
+    void onLoggedOff (uint64_t seqno, const cdr& msg)
+    {
+        __sync_lock_test_and_set (&mLoggedOff, 1);
+    }
+
+    gwcSimVenue* mVenue;
+    volatile int mLoggedOn;
+    volatile int mLoggedOff;
+    volatile int mError;
+};
+
+class SimMessageCallbacks : public gwcMessageCallbacks
+{
+public:
+    SimMessageCallbacks (gwcSimVenue* venue) :
+        mVenue (venue),
+        mAcks (0),
+        mAckId (0),
+        mRejects (0)
+    { }
+
+    void onOrderAck (uint64_t seqno, const cdr& msg)
+    {
+        mAckId = mVenue->id (msg);
+        __sync_fetch_and_add (&mAcks, 1);
+    }
+
+    void onOrderRejected (uint64_t seqno, const cdr& msg)
+    {
+        __sync_fetch_and_add (&mRejects, 1);
+    }
+
+    gwcSimVenue*      mVenue;
+    volatile int      mAcks;
+    volatile uint64_t mAckId;
+    volatile int      mRejects;
+};
+
+class SimFixTypedCallbacks : public gwcFixTypedCallbacks
+{
+public:
+    SimFixTypedCallbacks () :
+        mReports (0)
+    { }
+
+    void onExecutionReport (uint64_t seqno, const gwcFixMessage& msg)
+    {
+        msg.getString (ClOrdID, mClOrdId);
+        msg.getString (ExecType, mExecType);
+        __sync_fetch_and_add (&mReports, 1);
+    }
+
+    std::string  mClOrdId;
+    std::string  mExecType;
+    volatile int mReports;
+};
+
+class SimRoundTripTestHarness : public Test
+{
+protected:
+    virtual void SetUp ()
+    {
+        mLogger = logService::getLogger ("TEST_SIM");
+        mVenue = NULL;
+    }
+
+    virtual void TearDown ()
+    {
+        delete mVenue;
+    }
+
+    /* Wait for flag to be set, false on timeout */
+    static bool waitFor (volatile int& flag)
+    {
+        time_t deadline = time (NULL) + SIM_TIMEOUT;
+        while (!flag)
+        {
+            if (time (NULL) > deadline)
+                return false;
+            usleep (1000);
+        }
+        return true;
+    }
+
+    /* Logon to the simulator, send one order and wait for its ack. With
+       typedCbs the fix ack is waited for there instead */
+    void roundTrip (const std::string& name,
+                    properties& opts,
+                    SimFixTypedCallbacks* typedCbs = NULL)
+    {
+        properties props (mProps, "gwc", name, "test");
+        std::string cache = "sim-" + name + ".cache";
+        std::string err;
+
+        ::remove (cache.c_str ());
+        opts.setProperty ("auto_fill", "false");
+        props.setProperty ("seqno_cache", cache);
+        props.setProperty ("applMsgId_cache", cache);
+        ASSERT_TRUE (mVenue->start (opts, props, err)) << err;
+
+        SimSessionCallbacks sessionCbs (mVenue);
+        SimMessageCallbacks messageCbs (mVenue);
+        gwcConnector* gwc = gwcConnectorFactory::get (mLogger, mVenue->type (), props);
+        ASSERT_TRUE (gwc != NULL);
+        ASSERT_TRUE (gwc->init (&sessionCbs, &messageCbs, props));
+        if (typedCbs != NULL)
+        {
+            gwcFix* fix = dynamic_cast<gwcFix*> (gwc);
+            ASSERT_TRUE (fix != NULL);
+            fix->setTypedCallbacks (typedCbs);
+        }
+        ASSERT_TRUE (gwc->start (false));
+
+        // logon
+        ASSERT_TRUE (waitFor (sessionCbs.mLoggedOn));
+        int errors = sessionCbs.mError;
+        ASSERT_EQ (0, errors);
+
+        // order
+        gwcOrder order;
+        order.setPrice (1234);
+        order.setQty (100);
+        order.setTif (GWC_TIF_DAY);
+        order.setSide (GWC_SIDE_BUY);
+        order.setOrderType (GWC_ORDER_TYPE_LIMIT);
+        mVenue->order (order, 1);
+        ASSERT_TRUE (gwc->sendOrder (order));
+
+        // ack
+        if (typedCbs != NULL)
+        {
+            ASSERT_TRUE (waitFor (typedCbs->mReports));
+            int reports = typedCbs->mReports;
+            int acks = messageCbs.mAcks;
+            ASSERT_EQ (1, reports);
+            ASSERT_EQ ("1", typedCbs->mClOrdId);
+            ASSERT_EQ ("0", typedCbs->mExecType);
+            ASSERT_EQ (0, acks);
+
+            gwc->stop ();
+            delete gwc;
+            ::remove (cache.c_str ());
+            return;
+        }
+        ASSERT_TRUE (waitFor (messageCbs.mAcks));
+        int      acks = messageCbs.mAcks;
+        uint64_t ackId = messageCbs.mAckId;
+        int      rejects = messageCbs.mRejects;
+        ASSERT_EQ (1, acks);
+        ASSERT_EQ (1u, ackId);
+        ASSERT_EQ (0, rejects);
+
+        gwc->stop ();
+        delete gwc;
+        ::remove (cache.c_str ());
+    }
+
+    properties   mProps;
+    logger*      mLogger;
+    gwcSimVenue* mVenue;
+};
+
+// TESTS
+
+TEST_F(SimRoundTripTestHarness, TEST_THAT_MILLENNIUM_ORDER_IS_ACKED_BY_SIMULATOR)
+{
+    properties opts (mProps, "sim", "lse", "test");
+    mVenue = new gwcSimVenueMillennium (mLogger);
+    roundTrip ("lse", opts);
+}
+
+TEST_F(SimRoundTripTestHarness, TEST_THAT_ETI_ORDER_IS_ACKED_BY_SIMULATOR)
+{
+    properties opts (mProps, "sim", "xetra", "test");
+    mVenue = new gwcSimVenueEti (mLogger);
+    roundTrip ("xetra", opts);
+}
+
+TEST_F(SimRoundTripTestHarness, TEST_THAT_OPTIQ_ORDER_IS_ACKED_BY_SIMULATOR)
+{
+    properties opts (mProps, "sim", "optiq", "test");
+    mVenue = new gwcSimVenueOptiq (mLogger);
+    roundTrip ("optiq", opts);
+}
+
+TEST_F(SimRoundTripTestHarness, TEST_THAT_SWX_ORDER_IS_ACKED_BY_SIMULATOR)
+{
+    properties opts (mProps, "sim", "swx", "test");
+    mVenue = new gwcSimVenueSwx (mLogger);
+    roundTrip ("swx", opts);
+}
+
+#ifdef GWC_TEST_FIX_DATA_DICTIONARY
+TEST_F(SimRoundTripTestHarness, TEST_THAT_FIX_ORDER_IS_ACKED_BY_SIMULATOR)
+{
+    properties opts (mProps, "sim", "fix", "test");
+    opts.setProperty ("data_dictionary", GWC_TEST_FIX_DATA_DICTIONARY);
+    mVenue = new gwcSimVenueFix (mLogger);
+    roundTrip ("fix", opts);
+}
+
+TEST_F(SimRoundTripTestHarness, TEST_THAT_FIX_ACK_GOES_TO_TYPED_CALLBACKS)
+{
+    properties opts (mProps, "sim", "fix", "test");
+    opts.setProperty ("data_dictionary", GWC_TEST_FIX_DATA_DICTIONARY);
+    mVenue = new gwcSimVenueFix (mLogger);
+
+    SimFixTypedCallbacks typedCbs;
+    roundTrip ("fix", opts, &typedCbs);
+}
+#endif
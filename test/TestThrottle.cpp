@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "gwcThrottle.h"
+#include "fields.h"
+
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+using namespace neueda;
+using namespace ::testing;
+
+/* Delegate that records what the throttle does, sends fail while mFail */
+class TestThrottleDelegate : public gwcThrottleDelegate
+{
+public:
+    TestThrottleDelegate () :
+        mFail (false),
+        mSent (0),
+        mArmed (false)
+    { }
+
+    bool onSend (cdr** msgs, size_t n)
+    {
+        if (mFail)
+            return false;
+        mSent += n;
+        return true;
+    }
+
+    void onQueued (uint64_t interval)
+    {
+        mArmed = true;
+    }
+
+    void onDrained ()
+    {
+        mArmed = false;
+    }
+
+    void onFailed (const cdr& msg)
+    {
+        std::string clOrdId;
+        msg.getString (ClOrdID, clOrdId);
+        mFailed.push_back (clOrdId);
+    }
+
+    bool                     mFail;
+    size_t                   mSent;
+    bool                     mArmed;
+    std::vector<std::string> mFailed;
+};
+
+class ThrottleTestHarness : public ::testing::Test
+{
+protected:
+    virtual void SetUp ()
+    {
+        /* one token every millisecond, one held at most */
+        mThrottle = new gwcThrottle (GWC_THROTTLE_QUEUE,
+                                     1,
+                                     1000000,
+                                     1,
+                                     GWC_THROTTLE_QUEUE_SIZE,
+                                     &mDelegate);
+    }
+
+    virtual void TearDown ()
+    {
+        delete mThrottle;
+    }
+
+    gwcThrottleResult send (const std::string& clOrdId)
+    {
+        cdr  msg;
+        cdr* msgs = &msg;
+        msg.setString (ClOrdID, clOrdId);
+        return mThrottle->send (&msgs, 1);
+    }
+
+    TestThrottleDelegate mDelegate;
+    gwcThrottle*         mThrottle;
+};
+
+// TESTS
+
+TEST_F(ThrottleTestHarness, TEST_THAT_QUEUED_SEND_THAT_FAILS_IS_COUNTED_AND_REPORTED)
+{
+    // setup
+    ASSERT_EQ (GWC_THROTTLE_SENT, send ("order-1"));
+    ASSERT_EQ (GWC_THROTTLE_QUEUED, send ("order-2"));
+    ASSERT_TRUE (mDelegate.mArmed);
+    mDelegate.mFail = true;
+
+    // do test
+    usleep (2000);
+    mThrottle->drain ();
+
+    // check
+    gwcThrottleStats stats = mThrottle->snapshot ();
+    ASSERT_EQ (1u, stats.mFailed);
+    ASSERT_EQ (0u, stats.mQueued);
+    ASSERT_EQ (1u, mDelegate.mFailed.size ());
+    ASSERT_EQ ("order-2", mDelegate.mFailed[0]);
+    ASSERT_FALSE (mDelegate.mArmed);
+}
+
+TEST_F(ThrottleTestHarness, TEST_THAT_CLEAR_DROPS_THE_QUEUE_AND_REPORTS_EACH_MESSAGE)
+{
+    // setup
+    ASSERT_EQ (GWC_THROTTLE_SENT, send ("order-1"));
+    ASSERT_EQ (GWC_THROTTLE_QUEUED, send ("order-2"));
+    ASSERT_EQ (GWC_THROTTLE_QUEUED, send ("order-3"));
+
+    // do test
+    mThrottle->clear ();
+
+    // check
+    gwcThrottleStats stats = mThrottle->snapshot ();
+    ASSERT_EQ (2u, stats.mFailed);
+    ASSERT_EQ (0u, stats.mQueued);
+    ASSERT_EQ (2u, mDelegate.mFailed.size ());
+    ASSERT_EQ ("order-2", mDelegate.mFailed[0]);
+    ASSERT_EQ ("order-3", mDelegate.mFailed[1]);
+    ASSERT_FALSE (mDelegate.mArmed);
+
+    // and nothing cleared goes out once tokens come back
+    usleep (2000);
+    mThrottle->drain ();
+    ASSERT_EQ (1u, mDelegate.mSent);
+    ASSERT_EQ (GWC_THROTTLE_SENT, send ("order-4"));
+    ASSERT_EQ (2u, mDelegate.mSent);
+}
@@ -2,8 +2,14 @@
 #include <gmock/gmock.h>
 
 #include "gwcEti.h"
+#include "gwcReplay.h"
 #include "TestUtils.h"
 
+#include <pthread.h>
+#include <map>
+#include <sstream>
+#include <vector>
+
 using namespace neueda;
 using namespace ::testing;
 
@@ -19,6 +25,9 @@ public:
     
     MOCK_METHOD0 (reset, void());
 
+    using gwcConnector::setQueueProperties;
+    using gwcConnector::prepareDispatchThread;
+
     void setTcpConnection (SbfTcpConnection** connection)
     {
         if (mTcpConnection)
@@ -42,6 +51,33 @@ public:
     }
 };
 
+/* Names each message callback in the order they are made */
+class RecordingMessageCallbacks : public gwcMessageCallbacks
+{
+public:
+    void onAdmin (uint64_t seqno, const cdr& msg) { record ("admin", msg); }
+    void onOrderAck (uint64_t seqno, const cdr& msg) { record ("orderAck", msg); }
+    void onOrderRejected (uint64_t seqno, const cdr& msg) { record ("orderRejected", msg); }
+    void onOrderDone (uint64_t seqno, const cdr& msg) { record ("orderDone", msg); }
+    void onOrderFill (uint64_t seqno, const cdr& msg) { record ("orderFill", msg); }
+    void onModifyAck (uint64_t seqno, const cdr& msg) { record ("modifyAck", msg); }
+    void onModifyRejected (uint64_t seqno, const cdr& msg) { record ("modifyRejected", msg); }
+    void onCancelRejected (uint64_t seqno, const cdr& msg) { record ("cancelRejected", msg); }
+    void onMsg (uint64_t seqno, const cdr& msg) { record ("msg", msg); }
+
+    void record (const char* name, const cdr& msg)
+    {
+        int64_t templateId = 0;
+        msg.getInteger (TemplateID, templateId);
+
+        std::stringstream call;
+        call << name << " " << templateId;
+        mCalls.push_back (call.str ());
+    }
+
+    std::vector<std::string> mCalls;
+};
+
 class XetraEtiTestHarness : public Test
 {
 protected:
@@ -289,6 +325,32 @@ protected:
         mMockConnectionActive = true;
     }
 
+    /* Every outbound message type sent once through the api, so min is the
+       time the message reached each stage */
+    void checkOutboundStageOrder (size_t types)
+    {
+        std::map<std::string, std::vector<uint64_t> > at;
+        gwcLatencyStats stats = mConnector->getLatencyStats ();
+        for (size_t i = 0; i < stats.size (); i++)
+        {
+            if (stats[i].mMsgType.empty () || stats[i].mStage < GWC_LATENCY_OUT_SEQUENCED)
+                continue;
+            ASSERT_EQ (1u, stats[i].mCount);
+            at[stats[i].mMsgType].resize (GWC_LATENCY_STAGES);
+            at[stats[i].mMsgType][stats[i].mStage] = stats[i].mMin;
+        }
+
+        ASSERT_EQ (types, at.size ());
+        std::map<std::string, std::vector<uint64_t> >::iterator it;
+        for (it = at.begin (); it != at.end (); ++it)
+        {
+            std::vector<uint64_t>& t = it->second;
+            ASSERT_GT (t[GWC_LATENCY_OUT_SEQUENCED], 0u);
+            ASSERT_LE (t[GWC_LATENCY_OUT_SEQUENCED], t[GWC_LATENCY_OUT_ENCODED]);
+            ASSERT_LE (t[GWC_LATENCY_OUT_ENCODED], t[GWC_LATENCY_OUT_WRITTEN]);
+        }
+    }
+
     gwcOrder getMockNewOrder ()
     {
         gwcOrder order;
@@ -362,6 +424,261 @@ TEST_F(XetraEtiTestHarness, TEST_THAT_INIT_SUCCEEDS_ON_VALID_PARAMS)
     sleep(1);
 }
 
+TEST_F(XetraEtiTestHarness, TEST_THAT_INIT_FAILS_ON_INVALID_DISPATCH_MODE)
+{
+    mProps->setProperty ("host", "127.0.0.1:9899");
+    mProps->setProperty ("partition", "31");
+    mProps->setProperty ("venue", "xetra");
+    mProps->setProperty ("dispatch_mode", "poll");
+    bool ok = mConnector->init(mSessionCallbacks, mMessageCallbacks, *mProps);
+    ASSERT_FALSE(ok);
+}
+
+TEST_F(XetraEtiTestHarness, TEST_THAT_INIT_SUCCEEDS_WITH_HYBRID_DISPATCH)
+{
+    mProps->setProperty ("host", "127.0.0.1:9899");
+    mProps->setProperty ("partition", "31");
+    mProps->setProperty ("venue", "xetra");
+    mProps->setProperty ("dispatch_mode", "hybrid");
+    mProps->setProperty ("dispatch_spin_usecs", "10");
+    mProps->setProperty ("dispatch_cpu", "0");
+    bool ok = mConnector->init(mSessionCallbacks, mMessageCallbacks, *mProps);
+    ASSERT_TRUE(ok);
+
+    // helps give chance for sbf_queue to cleanup properly
+    sleep(1);
+}
+
+TEST_F(XetraEtiTestHarness, TEST_THAT_BLOCK_DISPATCH_LEAVES_QUEUE_BLOCKING)
+{
+    // setup
+    mProps->setProperty ("host", "127.0.0.1:9899");
+    mProps->setProperty ("partition", "31");
+    mProps->setProperty ("venue", "xetra");
+    ASSERT_TRUE(mConnector->init(mSessionCallbacks, mMessageCallbacks, *mProps));
+    sbfKeyValue kv = sbfKeyValue_create ();
+
+    // do test
+    mConnector->setQueueProperties (kv);
+
+    // check
+    ASSERT_TRUE(sbfKeyValue_get (kv, "queue.spin") == NULL);
+    ASSERT_TRUE(sbfKeyValue_get (kv, "queue.spin_usecs") == NULL);
+    sbfKeyValue_destroy (kv);
+
+    // helps give chance for sbf_queue to cleanup properly
+    sleep(1);
+}
+
+TEST_F(XetraEtiTestHarness, TEST_THAT_SPIN_DISPATCH_SPINS_QUEUE_WITHOUT_LIMIT)
+{
+    // setup
+    mProps->setProperty ("host", "127.0.0.1:9899");
+    mProps->setProperty ("partition", "31");
+    mProps->setProperty ("venue", "xetra");
+    mProps->setProperty ("dispatch_mode", "spin");
+    ASSERT_TRUE(mConnector->init(mSessionCallbacks, mMessageCallbacks, *mProps));
+    sbfKeyValue kv = sbfKeyValue_create ();
+
+    // do test
+    mConnector->setQueueProperties (kv);
+
+    // check
+    ASSERT_STREQ("true", sbfKeyValue_get (kv, "queue.spin"));
+    ASSERT_STREQ("-1", sbfKeyValue_get (kv, "queue.spin_usecs"));
+    sbfKeyValue_destroy (kv);
+
+    // helps give chance for sbf_queue to cleanup properly
+    sleep(1);
+}
+
+TEST_F(XetraEtiTestHarness, TEST_THAT_HYBRID_DISPATCH_SPINS_QUEUE_FOR_SPIN_USECS)
+{
+    // setup
+    mProps->setProperty ("host", "127.0.0.1:9899");
+    mProps->setProperty ("partition", "31");
+    mProps->setProperty ("venue", "xetra");
+    mProps->setProperty ("dispatch_mode", "hybrid");
+    mProps->setProperty ("dispatch_spin_usecs", "25");
+    ASSERT_TRUE(mConnector->init(mSessionCallbacks, mMessageCallbacks, *mProps));
+    sbfKeyValue kv = sbfKeyValue_create ();
+
+    // do test
+    mConnector->setQueueProperties (kv);
+
+    // check
+    ASSERT_STREQ("true", sbfKeyValue_get (kv, "queue.spin"));
+    ASSERT_STREQ("25", sbfKeyValue_get (kv, "queue.spin_usecs"));
+    sbfKeyValue_destroy (kv);
+
+    // helps give chance for sbf_queue to cleanup properly
+    sleep(1);
+}
+
+#ifdef __linux__
+static void*
+prepareDispatchThreadCb (void* closure)
+{
+    MockXetraConnector* connector = reinterpret_cast<MockXetraConnector*>(closure);
+    connector->prepareDispatchThread ();
+
+    cpu_set_t* set = new cpu_set_t;
+    CPU_ZERO (set);
+    pthread_getaffinity_np (pthread_self (), sizeof *set, set);
+    return set;
+}
+
+TEST_F(XetraEtiTestHarness, TEST_THAT_DISPATCH_THREAD_IS_PINNED_TO_DISPATCH_CPU)
+{
+    // setup
+    mProps->setProperty ("host", "127.0.0.1:9899");
+    mProps->setProperty ("partition", "31");
+    mProps->setProperty ("venue", "xetra");
+    mProps->setProperty ("dispatch_cpu", "0");
+    ASSERT_TRUE(mConnector->init(mSessionCallbacks, mMessageCallbacks, *mProps));
+
+    // do test
+    pthread_t thread;
+    void*     result = NULL;
+    ASSERT_EQ(0, pthread_create (&thread, NULL, prepareDispatchThreadCb, mConnector));
+    pthread_join (thread, &result);
+
+    // check
+    cpu_set_t* set = reinterpret_cast<cpu_set_t*>(result);
+    ASSERT_EQ(1, CPU_COUNT (set));
+    ASSERT_TRUE(CPU_ISSET (0, set));
+    delete set;
+
+    // helps give chance for sbf_queue to cleanup properly
+    sleep(1);
+}
+#endif
+
+TEST_F(XetraEtiTestHarness, TEST_THAT_INIT_FAILS_ON_INVALID_SEQNO_DURABILITY)
+{
+    mProps->setProperty ("host", "127.0.0.1:9899");
+    mProps->setProperty ("partition", "31");
+    mProps->setProperty ("venue", "xetra");
+    mProps->setProperty ("seqno_durability", "never");
+    bool ok = mConnector->init(mSessionCallbacks, mMessageCallbacks, *mProps);
+    ASSERT_FALSE(ok);
+}
+
+TEST_F(XetraEtiTestHarness, TEST_THAT_INIT_SUCCEEDS_WITH_GROUP_SEQNO_DURABILITY)
+{
+    mProps->setProperty ("host", "127.0.0.1:9899");
+    mProps->setProperty ("partition", "31");
+    mProps->setProperty ("venue", "xetra");
+    mProps->setProperty ("seqno_durability", "group");
+    mProps->setProperty ("seqno_commit_interval_usecs", "500");
+    mProps->setProperty ("seqno_commit_count", "16");
+    bool ok = mConnector->init(mSessionCallbacks, mMessageCallbacks, *mProps);
+    ASSERT_TRUE(ok);
+
+    // helps give chance for sbf_queue to cleanup properly
+    sleep(1);
+}
+
+TEST_F(XetraEtiTestHarness, TEST_THAT_INIT_SUCCEEDS_WITH_STATE_SEGMENT)
+{
+    mProps->setProperty ("host", "127.0.0.1:9899");
+    mProps->setProperty ("partition", "31");
+    mProps->setProperty ("venue", "xetra");
+    mProps->setProperty ("state_segment", "xetra.state");
+    mProps->setProperty ("state_segment_slots", "16");
+    bool ok = mConnector->init(mSessionCallbacks, mMessageCallbacks, *mProps);
+    ASSERT_TRUE(ok);
+
+    // helps give chance for sbf_queue to cleanup properly
+    sleep(1);
+}
+
+TEST_F(XetraEtiTestHarness, TEST_THAT_INIT_FAILS_ON_INVALID_LOG_LEVEL)
+{
+    mProps->setProperty ("host", "127.0.0.1:9899");
+    mProps->setProperty ("partition", "31");
+    mProps->setProperty ("venue", "xetra");
+    mProps->setProperty ("log_level", "verbose");
+    bool ok = mConnector->init(mSessionCallbacks, mMessageCallbacks, *mProps);
+    ASSERT_FALSE(ok);
+}
+
+TEST_F(XetraEtiTestHarness, TEST_THAT_INIT_SUCCEEDS_WITH_ASYNC_LOG)
+{
+    mProps->setProperty ("host", "127.0.0.1:9899");
+    mProps->setProperty ("partition", "31");
+    mProps->setProperty ("venue", "xetra");
+    mProps->setProperty ("log_level", "debug");
+    mProps->setProperty ("async_log", "true");
+    mProps->setProperty ("async_log_size", "64");
+    bool ok = mConnector->init(mSessionCallbacks, mMessageCallbacks, *mProps);
+    ASSERT_TRUE(ok);
+
+    // helps give chance for sbf_queue to cleanup properly
+    sleep(1);
+}
+
+TEST_F(XetraEtiTestHarness, TEST_THAT_LATENCY_STATS_ARE_RECORDED_FOR_INBOUND_MESSAGES)
+{
+    // setup
+    mProps->setProperty ("latency_stats", "true");
+    mockInitilizeConnector ();
+    ASSERT_TRUE(mConnector->getLatencyStats ().empty ());
+
+    // test
+    EXPECT_CALL(*mSessionCallbacks, onLoggingOn(_)).Times(1);
+    mConnector->mockTcpConnectionReady ();
+
+    EXPECT_CALL(*mMessageCallbacks, onAdmin(_, _)).Times (1);
+    EXPECT_CALL(*mSessionCallbacks, onLoggedOn(_, _)).Times(1);
+    mockLogonReply ();
+    mMockConnectionActive = true;
+
+    bool decoded = false;
+    bool callback = false;
+    gwcLatencyStats stats = mConnector->getLatencyStats ();
+    for (size_t i = 0; i < stats.size (); i++)
+    {
+        if (!stats[i].mMsgType.empty ())
+            continue;
+        if (stats[i].mStage == GWC_LATENCY_IN_DECODED)
+            decoded = stats[i].mCount == 1;
+        if (stats[i].mStage == GWC_LATENCY_IN_CALLBACK)
+            callback = stats[i].mCount == 1;
+    }
+    ASSERT_TRUE(decoded);
+    ASSERT_TRUE(callback);
+}
+
+TEST_F(XetraEtiTestHarness, TEST_THAT_OUTBOUND_LATENCY_STAGES_ARE_MARKED_IN_ORDER)
+{
+    // setup
+    mProps->setProperty ("latency_stats", "true");
+    mockFullInitilizedConnector ();
+
+    // do test
+    gwcOrder mockOrder = getMockNewOrder ();
+    ASSERT_TRUE (mConnector->sendOrder (mockOrder));
+
+    // check
+    checkOutboundStageOrder (1);
+}
+
+TEST_F(XetraEtiTestHarness, TEST_THAT_OUTBOUND_RING_LATENCY_STAGES_ARE_MARKED_IN_ORDER)
+{
+    // setup
+    mProps->setProperty ("latency_stats", "true");
+    mProps->setProperty ("outbound_ring", "true");
+    mockFullInitilizedConnector ();
+
+    // do test
+    gwcOrder mockOrder = getMockNewOrder ();
+    ASSERT_TRUE (mConnector->sendOrder (mockOrder));
+
+    // check
+    checkOutboundStageOrder (1);
+}
+
 TEST_F(XetraEtiTestHarness, TEST_THAT_ON_CONNECTION_READY_ONLOGGINGON_IS_CALLED)
 {
     // setup
@@ -505,3 +822,209 @@ TEST_F(XetraEtiTestHarness, TEST_THAT_ON_ORDER_BOOK_EXECUTION_ON_ORDER_FILL_CALL
     EXPECT_CALL(*mMessageCallbacks, onOrderFill(_, _)).Times(1);
     mockOrderBookExecution ("2");
 }
+
+TEST_F(XetraEtiTestHarness, TEST_THAT_CANNOT_SEND_ORDER_ON_OUTBOUND_RING_IF_NOT_LOGGED_ON)
+{
+    // setup
+    mProps->setProperty ("outbound_ring", "true");
+    mockInitilizeConnector ();
+    EXPECT_CALL(*mSessionCallbacks, onLoggingOn(_)).Times(1);
+
+    mConnector->mockTcpConnectionReady ();
+
+    // do test
+    gwcOrder mockOrder = getMockNewOrder ();
+    bool ok = mConnector->sendOrder (mockOrder);
+
+    // check
+    ASSERT_FALSE (ok);
+}
+
+TEST_F(XetraEtiTestHarness, TEST_THAT_OUTBOUND_RING_ASSIGNS_CONTIGUOUS_SEQNUMS)
+{
+    // setup
+    mProps->setProperty ("outbound_ring", "true");
+    mProps->setProperty ("outbound_ring_size", "4");
+    mockFullInitilizedConnector ();
+
+    gwcOrder first = getMockNewOrder ();
+    gwcOrder orders[8];
+    for (int i = 0; i < 8; i++)
+        orders[i] = getMockNewOrder ();
+
+    // do test, batch is bigger than the ring
+    bool ok = mConnector->sendOrder (first);
+    bool batchOk = mConnector->sendOrders (orders, 8);
+
+    // check
+    ASSERT_TRUE (ok);
+    ASSERT_TRUE (batchOk);
+
+    int64_t seqNo = 0;
+    ASSERT_TRUE (first.getInteger (MsgSeqNum, seqNo));
+    for (int i = 0; i < 8; i++)
+    {
+        int64_t next = 0;
+        ASSERT_TRUE (orders[i].getInteger (MsgSeqNum, next));
+        ASSERT_EQ (seqNo + 1, next);
+        seqNo = next;
+    }
+}
+
+TEST_F(XetraEtiTestHarness, TEST_THAT_THROTTLE_REJECTS_ORDERS_OVER_THE_RATE)
+{
+    // setup
+    mProps->setProperty ("throttle_rate", "2");
+    mProps->setProperty ("throttle_window_ms", "60000");
+    mockFullInitilizedConnector ();
+
+    // do test
+    gwcOrder orders[3];
+    bool ok[3];
+    for (int i = 0; i < 3; i++)
+    {
+        orders[i] = getMockNewOrder ();
+        ok[i] = mConnector->sendOrder (orders[i]);
+    }
+
+    // check
+    ASSERT_TRUE (ok[0]);
+    ASSERT_TRUE (ok[1]);
+    ASSERT_FALSE (ok[2]);
+
+    gwcThrottleStats stats = mConnector->getThrottleStats ();
+    ASSERT_EQ (2u, stats.mSent);
+    ASSERT_EQ (1u, stats.mRejected);
+    ASSERT_EQ (0u, stats.mTokens);
+}
+
+TEST_F(XetraEtiTestHarness, TEST_THAT_THROTTLE_QUEUES_ORDERS_OVER_THE_RATE)
+{
+    // setup
+    mProps->setProperty ("throttle_rate", "1");
+    mProps->setProperty ("throttle_window_ms", "60000");
+    mProps->setProperty ("throttle_mode", "queue");
+    mProps->setProperty ("throttle_queue_size", "2");
+    mockFullInitilizedConnector ();
+
+    // do test
+    gwcOrder orders[4];
+    bool ok[4];
+    for (int i = 0; i < 4; i++)
+    {
+        orders[i] = getMockNewOrder ();
+        ok[i] = mConnector->sendOrder (orders[i]);
+    }
+
+    // check, one sent, two queued and the last over the queue size
+    ASSERT_TRUE (ok[0]);
+    ASSERT_TRUE (ok[1]);
+    ASSERT_TRUE (ok[2]);
+    ASSERT_FALSE (ok[3]);
+
+    gwcThrottleStats stats = mConnector->getThrottleStats ();
+    ASSERT_EQ (1u, stats.mSent);
+    ASSERT_EQ (2u, stats.mQueued);
+    ASSERT_EQ (2u, stats.mMaxQueued);
+    ASSERT_EQ (1u, stats.mRejected);
+}
+
+TEST_F(XetraEtiTestHarness, TEST_THAT_ORDER_CACHE_KEEPS_ACKED_ORDERS_UNTIL_DONE)
+{
+    // setup
+    mProps->setProperty ("order_cache", "true");
+    mockFullInitilizedConnector ();
+
+    // do test
+    EXPECT_CALL(*mMessageCallbacks, onOrderAck(_, _)).Times(2);
+    EXPECT_CALL(*mMessageCallbacks, onOrderDone(_, _)).Times(1);
+    mockOrderAck ("0");
+
+    // check
+    gwcOpenOrder order;
+    ASSERT_TRUE (mConnector->getOrderCache ()->find ("12345", order));
+    ASSERT_STREQ ("12345", order.mOrderId);
+    ASSERT_EQ (GWC_ORDER_STATE_NEW, order.mState);
+    ASSERT_EQ (1u, mConnector->getOrderCache ()->getCount ());
+
+    mockOrderAck ("4");
+    ASSERT_FALSE (mConnector->getOrderCache ()->find ("12345", order));
+    ASSERT_EQ (0u, mConnector->getOrderCache ()->getCount ());
+}
+
+TEST_F(XetraEtiTestHarness, TEST_THAT_RISK_CHECKS_REJECT_ORDERS_OUTSIDE_THE_PRICE_COLLAR)
+{
+    // setup
+    mProps->setProperty ("risk_checks", "true");
+    mProps->setProperty ("risk_price_collar_pct", "10");
+    mockFullInitilizedConnector ();
+
+    // do test
+    mConnector->getRisk ()->setReferencePrice ("485241", 1000);
+    gwcOrder outside = getMockNewOrder ();
+    bool rejected = mConnector->sendOrder (outside);
+
+    mConnector->getRisk ()->setReferencePrice ("485241", 1234);
+    gwcOrder inside = getMockNewOrder ();
+    bool sent = mConnector->sendOrder (inside);
+
+    // check
+    ASSERT_FALSE (rejected);
+    ASSERT_TRUE (sent);
+
+    gwcRiskStats stats = mConnector->getRisk ()->snapshot ();
+    ASSERT_EQ (1u, stats.mPassed);
+    ASSERT_EQ (1u, stats.mRejected);
+    ASSERT_EQ (1u, stats.mOpenOrders);
+}
+
+TEST_F(XetraEtiTestHarness, TEST_THAT_REPLAYED_JOURNAL_MAKES_THE_RECORDED_CALLBACKS_IN_ORDER)
+{
+    // setup, record a session to a journal
+    const char* journal = "xetra-replay.journal";
+    ::remove (journal);
+    ::remove ("xetra-replay.journal.1");
+
+    RecordingMessageCallbacks recorded;
+    mProps->setProperty ("host", "127.0.0.1:9899");
+    mProps->setProperty ("partition", "31");
+    mProps->setProperty ("venue", "xetra");
+    mProps->setProperty ("journal", journal);
+    ASSERT_TRUE (mConnector->init (mSessionCallbacks, &recorded, *mProps));
+    setupMockTcpConnection ();
+
+    EXPECT_CALL(*mSessionCallbacks, onLoggingOn(_)).Times(1);
+    EXPECT_CALL(*mSessionCallbacks, onLoggedOn(_, _)).Times(AnyNumber ());
+    EXPECT_CALL(*mSessionCallbacks, onLoggedOff(_, _)).Times(AnyNumber ());
+    mConnector->mockTcpConnectionReady ();
+    mockLogonReply ();
+    mockOrderAck ("0");
+    mockModifyAck ("0");
+    mockImmediateExecution ("1");
+    mockOrderBookExecution ("2");
+    mockOrderAck ("4");
+
+    /* the journal is written out when its last user goes */
+    mConnector->stop ();
+    delete mConnector;
+
+    // do test, through a connector that is never started
+    RecordingMessageCallbacks replayed;
+    mConnector = new MockXetraConnector (mLogger);
+    mProps->setProperty ("journal", "");
+    ASSERT_TRUE (mConnector->init (mSessionCallbacks, &replayed, *mProps));
+
+    gwcReplay      replayer (mConnector);
+    gwcReplayStats stats;
+    std::string    err;
+    ASSERT_TRUE (replayer.load (std::vector<std::string> (1, journal), "", err)) << err;
+    replayer.run (0, stats);
+
+    // check
+    ASSERT_EQ (6u, stats.mMessages);
+    ASSERT_EQ (0u, stats.mErrors);
+    ASSERT_FALSE (recorded.mCalls.empty ());
+    ASSERT_EQ (recorded.mCalls, replayed.mCalls);
+
+    ::remove (journal);
+}